@@ -284,7 +284,9 @@ def export_scene(depsgraph, is_preview, fs):
     total_prim_cnt = 0
     # export meshes
     for obj in all_objs:
-        fs.serialize(SID('VisualEntity'))
+        # every triangle of an emissive mesh is a light source
+        mesh_light = obj.sort_mesh_light
+        fs.serialize(SID('MeshLightEntity') if mesh_light.emissive else SID('VisualEntity'))
         fs.serialize( matrix_to_tuple( MatrixBlenderToSort() @ obj.matrix_world ) )
         fs.serialize( 1 )   # only one mesh for each mesh entity
         stat = None
@@ -302,6 +304,11 @@ def export_scene(depsgraph, is_preview, fs):
         total_vert_cnt += stat[0]
         total_prim_cnt += stat[1]
 
+        # emission of the mesh light, it follows the same layout as other lights
+        if mesh_light.emissive:
+            fs.serialize(mesh_light.energy)
+            fs.serialize(mesh_light.color[:])
+
     # output hair/fur exporting
     for obj in all_objs:
         evaluted_obj = obj.evaluated_get(depsgraph)
@@ -400,6 +407,10 @@ def export_scene(depsgraph, is_preview, fs):
         fs.serialize( SID('Obvh') )
         fs.serialize( int(sort_data.obvh_max_node_depth) )
         fs.serialize( int(sort_data.obvh_max_pri_in_leaf) )
+    elif accelerator_type == "Hbvh":
+        fs.serialize( SID('Hbvh') )
+        fs.serialize( int(sort_data.hbvh_max_node_depth) )
+        fs.serialize( int(sort_data.hbvh_max_pri_in_leaf) )
     elif accelerator_type == "UniGrid":
         fs.serialize( SID('UniGrid') )
     elif accelerator_type == "Embree":
@@ -456,7 +467,7 @@ def export_smoke(obj, fs):
         fs.serialize( SID('no_volume') )
         return
 
-    fs.serialize( SID('has_volume') )
+    fs.serialize( SID('has_sparse_volume') )
     
     # dimension of the volume data
     x, y, z = domain.domain_resolution
@@ -468,15 +479,22 @@ def export_smoke(obj, fs):
     # color_grid = np.fromiter(domain.color_grid, dtype=np.float32)
     # fs.serialize(color_grid)
 
-    FLTFMT = struct.Struct('=f')
-
-    # the density itself
-    density_data = bytearray()
-    density_grid = np.fromiter(domain.density_grid, dtype=np.float32)
-    for density in density_grid:
-        density_data += FLTFMT.pack(density)
-
-    fs.serialize(density_data)
+    # the density is split into bricks and only non-empty bricks are exported
+    BRICK_SIZE = 8
+    bx, by, bz = [ (d + BRICK_SIZE - 1) // BRICK_SIZE for d in (x, y, z) ]
+    density_grid = np.fromiter(domain.density_grid, dtype=np.float32).reshape(z, y, x)
+    padded_grid = np.zeros((bz * BRICK_SIZE, by * BRICK_SIZE, bx * BRICK_SIZE), dtype=np.float32)
+    padded_grid[:z, :y, :x] = density_grid
+    bricks = padded_grid.reshape(bz, BRICK_SIZE, by, BRICK_SIZE, bx, BRICK_SIZE).transpose(0, 2, 4, 1, 3, 5)
+    occupied = np.argwhere(np.any(bricks != 0.0, axis=(3, 4, 5)))
+
+    fs.serialize(BRICK_SIZE)
+    fs.serialize(int(len(occupied)))
+    for k, j, i in occupied:
+        fs.serialize(int(i))
+        fs.serialize(int(j))
+        fs.serialize(int(k))
+        fs.serialize(np.ascontiguousarray(bricks[k, j, i]).tobytes())
 
 # export a mesh
 def export_mesh(obj, mesh, fs):
@@ -927,9 +945,5 @@ def export_materials(depsgraph, fs):
         fs.serialize( bool(has_transparent_node) )
         fs.serialize( bool(has_sss_node) )
 
-        # volume step size and step count
-        fs.serialize( material.sort_material.volume_step )
-        fs.serialize( material.sort_material.volume_step_cnt )
-
     # indicate the end of material parsing
     fs.serialize(SID('End of Material'))
\ No newline at end of file
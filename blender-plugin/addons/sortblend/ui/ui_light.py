@@ -52,3 +52,37 @@ class LIGHT_PT_SORTPanel(SORTLightPanel, bpy.types.Panel):
                 self.layout.prop( light , "size_y" )
             elif shape == 'DISK':
                 self.layout.prop( light , "size" )
+
+# attach emission properties to mesh objects, an emissive mesh is exported as a mesh light
+@base.register_class
+class SORTMeshLightData(bpy.types.PropertyGroup):
+    emissive : bpy.props.BoolProperty( name='Emissive', default=False, description='Export every triangle of the mesh as a light source')
+    color : bpy.props.FloatVectorProperty( name='Color', subtype='COLOR', default=(1.0, 1.0, 1.0), min=0.0, max=1.0)
+    energy : bpy.props.FloatProperty( name='Strength', min=0.0, default=1.0)
+    @classmethod
+    def register(cls):
+        bpy.types.Object.sort_mesh_light = bpy.props.PointerProperty(name="SORT Mesh Light", type=cls)
+    @classmethod
+    def unregister(cls):
+        del bpy.types.Object.sort_mesh_light
+
+@base.register_class
+class OBJECT_PT_SORTMeshLightPanel(bpy.types.Panel):
+    bl_space_type = "PROPERTIES"
+    bl_region_type = "WINDOW"
+    bl_context = "object"
+    bl_label = 'Mesh Light'
+
+    COMPAT_ENGINES = {'SORT'}
+    @classmethod
+    def poll(cls, context):
+        return context.object is not None and context.object.type == 'MESH' and context.scene.render.engine in cls.COMPAT_ENGINES
+
+    def draw_header(self, context):
+        self.layout.prop(context.object.sort_mesh_light, "emissive", text="")
+
+    def draw(self, context):
+        mesh_light = context.object.sort_mesh_light
+        self.layout.active = mesh_light.emissive
+        self.layout.prop(mesh_light, "color")
+        self.layout.prop(mesh_light, "energy")
@@ -63,7 +63,8 @@ class SORTRenderData(bpy.types.PropertyGroup):
                           ("KDTree", "SAH KDTree", "K-dimentional Tree", 3),
                           ("UniGrid", "Uniform Grid", "This is not quite practical in all cases.", 4),
                           ("OcTree" , "OcTree" , "This is not quite practical in all cases." , 5),
-                          ("Embree", "Embree", "This is Intel Embree (Experimental)", 6)]
+                          ("Embree", "Embree", "This is Intel Embree (Experimental)", 6),
+                          ("Hbvh", "HBVH", "SIMD(AVX512) Optimized BVH" , 7 )]
     accelerator_type_prop : bpy.props.EnumProperty(items=accelerator_types, name='Accelerator')
 
     # bvh properties
@@ -78,6 +79,10 @@ class SORTRenderData(bpy.types.PropertyGroup):
     obvh_max_node_depth : bpy.props.IntProperty(name='Maximum Recursive Depth', default=28, min=8)
     obvh_max_pri_in_leaf : bpy.props.IntProperty(name='Maximum Primitives in Leaf Node.', default=16, min=8, max=64)
 
+    # hbvh properties
+    hbvh_max_node_depth : bpy.props.IntProperty(name='Maximum Recursive Depth', default=28, min=8)
+    hbvh_max_pri_in_leaf : bpy.props.IntProperty(name='Maximum Primitives in Leaf Node.', default=32, min=16, max=64)
+
     # kdtree properties
     kdtree_max_node_depth : bpy.props.IntProperty(name='Maximum Recursive Depth', default=28, min=8)
     kdtree_max_pri_in_leaf : bpy.props.IntProperty(name='Maximum Primitives in Leaf Node.', default=8, min=8, max=64)
@@ -174,6 +179,9 @@ class RENDER_PT_AcceleratorPanel(SORTRenderPanel,bpy.types.Panel):
         elif accelerator_type == "Obvh":
             self.layout.prop(data,"obvh_max_node_depth")
             self.layout.prop(data,"obvh_max_pri_in_leaf")
+        elif accelerator_type == "Hbvh":
+            self.layout.prop(data,"hbvh_max_node_depth")
+            self.layout.prop(data,"hbvh_max_pri_in_leaf")
         elif accelerator_type == "KDTree":
             self.layout.prop(data,"kdtree_max_node_depth")
             self.layout.prop(data,"kdtree_max_pri_in_leaf")
@@ -140,4 +140,9 @@ void Accelerator::GetIntersect(const Ray& r, BSSRDFIntersections& intersect, Ren
         // we know for a fact we have a valid intersection, at this point
         intersect.cnt++;
     }
+}
+
+void Accelerator::GetIntersectPacket(const Ray* rays, BSSRDFIntersections* intersects, const unsigned cnt, RenderContext& rc, const StringID matID) const {
+    for (auto i = 0u; i < cnt; ++i)
+        GetIntersect(rays[i], intersects[i], rc, matID);
 }
\ No newline at end of file
@@ -121,6 +121,17 @@ public:
     //! @param  matID       We are only interested in intersection with the same material, whose material id should be set to matID.
     virtual void GetIntersect(const Ray& r, BSSRDFIntersections& intersect, RenderContext& rc, const StringID matID = INVALID_SID) const;
 
+    //! @brief Get multiple intersections of a packet of rays in one go.
+    //!
+    //! This is the packet version of the above interface. SSS casts a few probe rays around the same spot at a time, tracing them
+    //! together allows sharing the cost of fetching nodes. By default, rays are traced one after another.
+    //!
+    //! @param  rays        The input rays to be tested.
+    //! @param  intersects  The intersection results, one for each ray.
+    //! @param  cnt         Number of rays in the packet, it can't be larger than SSS_PACKET_MAX_CNT.
+    //! @param  matID       We are only interested in intersection with the same material, whose material id should be set to matID.
+    virtual void GetIntersectPacket(const Ray* rays, BSSRDFIntersections* intersects, const unsigned cnt, RenderContext& rc, const StringID matID = INVALID_SID) const;
+
     //! @brief Build the acceleration structure.
     //!
     //! @param primitives       A vector holding all primitives.
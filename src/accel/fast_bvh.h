@@ -21,11 +21,11 @@
 #include "bvh_utils.h"
 #include "core/primitive.h"
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
 static_assert(false, "More than one SIMD version is defined before including fast_bvh.h");
 #endif
 
-#if defined(QBVH_IMPLEMENTATION) || defined(OBVH_IMPLEMENTATION)
+#if defined(QBVH_IMPLEMENTATION) || defined(OBVH_IMPLEMENTATION) || defined(HBVH_IMPLEMENTATION)
 
 #if defined(QBVH_IMPLEMENTATION)
 #define Fast_Bvh_Node   Qbvh_Node
@@ -37,6 +37,11 @@ static_assert(false, "More than one SIMD version is defined before including fas
 #define FBVH_CHILD_CNT  8
 #endif
 
+#if defined(HBVH_IMPLEMENTATION)
+#define Fast_Bvh_Node   Hbvh_Node
+#define FBVH_CHILD_CNT  16
+#endif
+
 #ifdef SIMD_BVH_IMPLEMENTATION
 struct Fast_Bvh_Node_Deallocator{
     void operator()(void* p){
@@ -97,6 +102,7 @@ struct Fast_Bvh_Node {
  * a binary tree. It easily opens the door for SSE/AVX optimization during BVH traversal since we can do ray-AABB intersection 
  * four/eight times more efficient. And also we can do the same to primitive ray intersection, instead of doing it one at a time,
  * QBVH/OBVH will check four/eight primitives at a time, boosting the performance of ray intersection test.
+ * HBVH goes one step further with sixteen children per node on CPUs supporting AVX512.
  */
 class Fbvh : public Accelerator{
 public:
@@ -106,6 +112,9 @@ public:
 #ifdef OBVH_IMPLEMENTATION
     DEFINE_RTTI( Obvh , Accelerator );
 #endif
+#ifdef HBVH_IMPLEMENTATION
+    DEFINE_RTTI( Hbvh , Accelerator );
+#endif
 
     //! @brief Get intersection between the ray and the primitive set using QBVH/OBVH.
     //!
@@ -146,6 +155,18 @@ public:
     //! @param  matID       We are only interested in intersection with the same material, whose material id should be set to matID.
     void    GetIntersect( const Ray& r , BSSRDFIntersections& intersect , RenderContext& rc, const StringID matID = INVALID_SID ) const override;
 
+    //! @brief Get multiple intersections of a packet of rays in one go.
+    //!
+    //! Rays in the packet traverse the tree together, a node is fetched once for all rays interested in it. Each ray keeps
+    //! its nearest hits sorted in a small buffer during traversal so that nodes beyond all of them can be culled. Full
+    //! intersections are only setup for the hits that survive the traversal.
+    //!
+    //! @param  rays        The input rays to be tested.
+    //! @param  intersects  The intersection results, one for each ray.
+    //! @param  cnt         Number of rays in the packet, it can't be larger than SSS_PACKET_MAX_CNT.
+    //! @param  matID       We are only interested in intersection with the same material, whose material id should be set to matID.
+    void    GetIntersectPacket( const Ray* rays , BSSRDFIntersections* intersects , const unsigned cnt , RenderContext& rc, const StringID matID = INVALID_SID ) const override;
+
     //! @brief Build BVH structure in O(N*lg(N)).
     //!
     //! @param primitives       A vector holding all primitives.
@@ -212,4 +233,7 @@ private:
 #ifdef OBVH_IMPLEMENTATION
     SORT_STATS_ENABLE( "Spatial-Structure(OBVH)" )
 #endif
+#ifdef HBVH_IMPLEMENTATION
+    SORT_STATS_ENABLE( "Spatial-Structure(HBVH)" )
+#endif
 };
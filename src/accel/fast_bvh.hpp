@@ -41,7 +41,7 @@ SORT_STATIC_FORCEINLINE std::unique_ptr<T[]> makePrimitiveList( unsigned int cnt
 #endif
 }
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
 static_assert(false, "More than one SIMD version is defined before including fast_bvh.hpp");
 #endif
 
@@ -97,6 +97,35 @@ SORT_STATS_AVG_COUNT("Spatial-Structure(OBVH)", "Average Primitive Tested per Ra
 
 #endif
 
+#ifdef HBVH_IMPLEMENTATION
+
+SORT_STATS_DEFINE_COUNTER(sHbvhNodeCount)
+SORT_STATS_DEFINE_COUNTER(sHbvhLeafNodeCount)
+SORT_STATS_DEFINE_COUNTER(sHbvhDepth)
+SORT_STATS_DEFINE_COUNTER(sHbvhMaxPriCountInLeaf)
+SORT_STATS_DEFINE_COUNTER(sHbvhPrimitiveCount)
+
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "Total Ray Count", sRayCount);
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "Shadow Ray Count", sShadowRayCount);
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "Intersection Test", sIntersectionTest );
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "Node Count", sHbvhNodeCount);
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "Leaf Node Count", sHbvhLeafNodeCount);
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "BVH Depth", sHbvhDepth);
+SORT_STATS_COUNTER("Spatial-Structure(HBVH)", "Maximum Primitive in Leaf", sHbvhMaxPriCountInLeaf);
+SORT_STATS_AVG_COUNT("Spatial-Structure(HBVH)", "Average Primitive Count in Leaf", sHbvhPrimitiveCount , sHbvhLeafNodeCount );
+SORT_STATS_AVG_COUNT("Spatial-Structure(HBVH)", "Average Primitive Tested per Ray", sIntersectionTest, sRayCount);
+
+#define sFbvhNodeCount          sHbvhNodeCount
+#define sFbvhLeafNodeCount      sHbvhLeafNodeCount
+#define sFbvhDepth              sHbvhDepth
+#define sFbvhMaxPriCountInLeaf  sHbvhMaxPriCountInLeaf
+#define sFbvhPrimitiveCount     sHbvhPrimitiveCount
+
+#endif
+
+// Everything below is only shared by the translation unit of this spatial accelerator, it is fine to use wider SIMD.
+#include "simd/simd_target_begin.h"
+
 SORT_STATIC_FORCEINLINE BBox calcBoundingBox(const Fbvh_Node* const node , const Bvh_Primitive* const primitives ) {
     BBox node_bbox;
     if (!node)
@@ -313,6 +342,9 @@ bool Fbvh::GetIntersect( RenderContext& rc, const Ray& ray , SurfaceInteraction&
 #ifdef OBVH_IMPLEMENTATION
     SORT_PROFILE("Traverse Obvh");
 #endif
+#ifdef HBVH_IMPLEMENTATION
+    SORT_PROFILE("Traverse Hbvh");
+#endif
 
     SORT_STATS(++sRayCount);
 
@@ -515,6 +547,9 @@ bool  Fbvh::IsOccluded(const Ray& ray) const{
 #ifdef QBVH_IMPLEMENTATION
     SORT_PROFILE("Traverse Obvh");
 #endif
+#ifdef HBVH_IMPLEMENTATION
+    SORT_PROFILE("Traverse Hbvh");
+#endif
 
     SORT_STATS(++sRayCount);
     SORT_STATS(++sShadowRayCount);
@@ -594,7 +629,7 @@ bool  Fbvh::IsOccluded(const Ray& ray) const{
                     bvh_stack[si++] = node->children[k1].get();
                     bvh_stack[si++] = node->children[k0].get();
                 }else{
-#if defined(SIMD_8WAY_IMPLEMENTATION)
+#if defined(SIMD_8WAY_IMPLEMENTATION) || defined(SIMD_16WAY_IMPLEMENTATION)
                     for (auto i = 0u; i < node->child_cnt; ++i) {
                         auto k = -1;
                         auto maxDist = -1.0f;
@@ -654,6 +689,10 @@ bool  Fbvh::IsOccluded(const Ray& ray) const{
 #endif
 
 void Fbvh::GetIntersect( const Ray& ray , BSSRDFIntersections& intersect , RenderContext& rc, const StringID matID ) const{
+#ifdef SIMD_BVH_IMPLEMENTATION
+    // a single ray is nothing but a packet with only one ray in it
+    GetIntersectPacket(&ray, &intersect, 1, rc, matID);
+#else
     auto& bvh_stack = rc.m_fast_bvh_stack;
     if(UNLIKELY(IS_PTR_INVALID(bvh_stack)))
         bvh_stack = std::make_unique<std::pair<Fbvh_Node*, float>[]>(m_depth * FBVH_CHILD_CNT);
@@ -661,17 +700,16 @@ void Fbvh::GetIntersect( const Ray& ray , BSSRDFIntersections& intersect , Rende
 #ifdef QBVH_IMPLEMENTATION
     SORT_PROFILE("Traverse Qbvh");
 #endif
-#ifdef QBVH_IMPLEMENTATION
+#ifdef OBVH_IMPLEMENTATION
     SORT_PROFILE("Traverse Obvh");
 #endif
+#ifdef HBVH_IMPLEMENTATION
+    SORT_PROFILE("Traverse Hbvh");
+#endif
 
     SORT_STATS(++sRayCount);
 
     ray.Prepare();
-#ifdef SIMD_BVH_IMPLEMENTATION
-    Simd_Ray_Data   simd_ray;
-    resolveRayData( ray , simd_ray );
-#endif
 
     intersect.cnt = 0;
     intersect.maxt = FLT_MAX;
@@ -692,68 +730,6 @@ void Fbvh::GetIntersect( const Ray& ray , BSSRDFIntersections& intersect , Rende
         if (intersect.maxt < fmin)
             continue;
 
-#ifdef SIMD_BVH_IMPLEMENTATION
-        if (0 == node->child_cnt) {
-            // Note, only triangle shape support SSS here. This is the only big difference between AVX and non-AVX version implementation.
-            // There are only two major primitives in SORT, line and triangle.
-            // Line is usually used for hair, which has its own hair shader.
-            // Triangle is the only major primitive that has SSS.
-            for ( auto i = 0u ; i < node->tri_cnt ; ++i )
-                intersectTriangleMulti_SIMD(ray, simd_ray, node->tri_list[i] , matID, rc, intersect);
-            SORT_STATS(sIntersectionTest += node->tri_cnt);
-            continue;
-        }
-
-        simd_data sse_f_min;
-        auto m = IntersectBBox_SIMD(ray, simd_ray, node->bbox, sse_f_min);
-        if (0 == m)
-            continue;
-
-        const int k0 = __bsf(m);
-        const auto t0 = sse_f_min[k0];
-        m &= m - 1;
-        if (LIKELY(0 == m)) {
-            sAssert(t0 >= 0.0f, SPATIAL_ACCELERATOR);
-            bvh_stack[si++] = std::make_pair(node->children[k0].get(), t0);
-        }
-        else {
-            const int k1 = __bsf(m);
-            m &= m - 1;
-
-            if (LIKELY(0 == m)) {
-                const auto t1 = sse_f_min[k1];
-                sAssert(t1 >= 0.0f, SPATIAL_ACCELERATOR);
-
-                if (t0 < t1) {
-                    bvh_stack[si++] = std::make_pair(node->children[k1].get(), t1);
-                    bvh_stack[si++] = std::make_pair(node->children[k0].get(), t0);
-                }
-                else {
-                    bvh_stack[si++] = std::make_pair(node->children[k0].get(), t0);
-                    bvh_stack[si++] = std::make_pair(node->children[k1].get(), t1);
-                }
-            }
-            else {
-                // fall back to the worst case
-                for (auto i = 0u; i < node->child_cnt; ++i) {
-                    auto k = -1;
-                    auto maxDist = -1.0f;
-                    for (auto j = 0u; j < node->child_cnt; ++j) {
-                        if (sse_f_min[j] > maxDist) {
-                            maxDist = sse_f_min[j];
-                            k = j;
-                        }
-                    }
-
-                    if (k == -1)
-                        break;
-
-                    sse_f_min[k] = -1.0f;
-                    bvh_stack[si++] = std::make_pair(node->children[k].get(), maxDist);
-                }
-            }
-        }
-#else
         // check if it is a leaf node, to be optimized by SSE/AVX
         if (0 == node->child_cnt) {
             auto _start = node->pri_offset;
@@ -814,8 +790,120 @@ void Fbvh::GetIntersect( const Ray& ray , BSSRDFIntersections& intersect , Rende
             f_min[k] = -1.0f;
             bvh_stack[si++] = std::make_pair(node->children[k].get(), maxDist);
         }
+    }
+#endif
+}
+
+void Fbvh::GetIntersectPacket( const Ray* rays , BSSRDFIntersections* intersects , const unsigned cnt , RenderContext& rc, const StringID matID ) const{
+#ifndef SIMD_BVH_IMPLEMENTATION
+    Accelerator::GetIntersectPacket(rays, intersects, cnt, rc, matID);
+#else
+    sAssert(cnt <= SSS_PACKET_MAX_CNT, SPATIAL_ACCELERATOR);
+
+    auto& bvh_stack = rc.m_fast_bvh_stack_packet;
+    if(UNLIKELY(IS_PTR_INVALID(bvh_stack)))
+        bvh_stack = std::make_unique<std::pair<Fbvh_Node*, unsigned>[]>(m_depth * FBVH_CHILD_CNT);
+
+#ifdef QBVH_IMPLEMENTATION
+    SORT_PROFILE("Traverse Qbvh");
+#endif
+#ifdef OBVH_IMPLEMENTATION
+    SORT_PROFILE("Traverse Obvh");
 #endif
+#ifdef HBVH_IMPLEMENTATION
+    SORT_PROFILE("Traverse Hbvh");
+#endif
+
+    Simd_Ray_Data   simd_rays[SSS_PACKET_MAX_CNT];
+    Simd_Sss_Hits   hits[SSS_PACKET_MAX_CNT];
+
+    // each bit indicates whether a ray in the packet is still interested in the node
+    auto active_rays = 0u;
+    for (auto i = 0u; i < cnt; ++i) {
+        SORT_STATS(++sRayCount);
+
+        rays[i].Prepare();
+        resolveRayData(rays[i], simd_rays[i]);
+
+        intersects[i].cnt = 0;
+        intersects[i].maxt = FLT_MAX;
+
+        if (Intersect(rays[i], m_bbox) >= 0.0f)
+            active_rays |= 1u << i;
     }
+
+    // stack index
+    auto si = 0;
+    if (active_rays)
+        bvh_stack[si++] = std::make_pair(m_root.get(), active_rays);
+
+    while (si > 0) {
+        const auto top = bvh_stack[--si];
+
+        const auto node = top.first;
+        auto ray_mask = top.second;
+
+        if (0 == node->child_cnt) {
+            // Note, only triangle shape support SSS here. This is the only big difference between AVX and non-AVX version implementation.
+            // There are only two major primitives in SORT, line and triangle.
+            // Line is usually used for hair, which has its own hair shader.
+            // Triangle is the only major primitive that has SSS.
+            while (ray_mask) {
+                const auto r = __bsf(ray_mask);
+                ray_mask &= ray_mask - 1;
+
+                for (auto i = 0u; i < node->tri_cnt; ++i)
+                    intersectTriangleMulti_SIMD(rays[r], simd_rays[r], node->tri_list[i], matID, hits[r]);
+                SORT_STATS(sIntersectionTest += node->tri_cnt);
+            }
+            continue;
+        }
+
+        // Gather the rays hitting each child. A child further than all hits kept by a ray is of no interest to the ray.
+        unsigned    child_rays[FBVH_CHILD_CNT] = { 0 };
+        float       child_t[FBVH_CHILD_CNT];
+        for (auto k = 0u; k < FBVH_CHILD_CNT; ++k)
+            child_t[k] = FLT_MAX;
+
+        while (ray_mask) {
+            const auto r = __bsf(ray_mask);
+            ray_mask &= ray_mask - 1;
+
+            simd_data sse_f_min;
+            auto m = IntersectBBox_SIMD(rays[r], simd_rays[r], node->bbox, sse_f_min);
+            m &= simd_movemask_ps(simd_cmplt_ps(sse_f_min, simd_set_ps1(hits[r].maxt)));
+            while (m) {
+                const auto k = __bsf(m);
+                m &= m - 1;
+
+                child_rays[k] |= 1u << r;
+                child_t[k] = std::min(child_t[k], sse_f_min[k]);
+            }
+        }
+
+        // push the children from the farthest to the nearest so that the nearest one gets visited first
+        for (auto i = 0u; i < node->child_cnt; ++i) {
+            auto k = -1;
+            auto maxDist = -1.0f;
+            for (auto j = 0u; j < node->child_cnt; ++j) {
+                if (child_rays[j] && child_t[j] > maxDist) {
+                    maxDist = child_t[j];
+                    k = j;
+                }
+            }
+
+            if (k == -1)
+                break;
+
+            bvh_stack[si++] = std::make_pair(node->children[k].get(), child_rays[k]);
+            child_rays[k] = 0;
+        }
+    }
+
+    // intersections are only setup for the hits that survive the traversal
+    for (auto i = 0u; i < cnt; ++i)
+        hits[i].Resolve(rays[i], intersects[i], rc);
+#endif
 }
 
 std::unique_ptr<Accelerator> Fbvh::Clone() const {
@@ -824,4 +912,6 @@ std::unique_ptr<Accelerator> Fbvh::Clone() const {
     ret->m_maxPriInLeaf = m_maxPriInLeaf;
 
     return ret;
-}
\ No newline at end of file
+}
+
+#include "simd/simd_target_end.h"
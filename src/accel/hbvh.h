@@ -0,0 +1,44 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "core/define.h"
+
+#define HBVH_IMPLEMENTATION
+#define Fbvh        Hbvh
+#define Fbvh_Node   Hbvh_Node
+
+#ifdef SIMD_16WAY_ENABLED
+#define SIMD_16WAY_IMPLEMENTATION
+#define SIMD_BVH_IMPLEMENTATION
+#endif
+
+#include "simd/simd_ray_utils.h"
+#include "simd/avx512_bbox.h"
+#include "simd/avx512_triangle.h"
+#include "simd/avx512_line.h"
+#include "fast_bvh.h"
+
+#ifdef SIMD_16WAY_ENABLED
+#undef SIMD_BVH_IMPLEMENTATION
+#undef SIMD_16WAY_IMPLEMENTATION
+#endif
+
+#undef HBVH_IMPLEMENTATION
+#undef Fbvh
+#undef Fbvh_Node
\ No newline at end of file
@@ -22,6 +22,7 @@
 #define Fbvh_Node               Obvh_Node
 #define m_fast_bvh_stack        m_fast_obvh_stack
 #define m_fast_bvh_stack_simple m_fast_obvh_stack_simple
+#define m_fast_bvh_stack_packet m_fast_obvh_stack_packet
 
 #ifdef SIMD_8WAY_ENABLED
 #define SIMD_8WAY_IMPLEMENTATION
@@ -38,4 +39,5 @@
 #undef  Fbvh
 #undef  Fbvh_Node
 #undef  m_fast_bvh_stack
-#undef  m_fast_bvh_stack_simple
\ No newline at end of file
+#undef  m_fast_bvh_stack_simple
+#undef  m_fast_bvh_stack_packet
\ No newline at end of file
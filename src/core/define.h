@@ -70,6 +70,11 @@
     #endif
 #endif
 
+// AVX512 is only available on x64
+#if !defined(SORT_X64_TARGET) && defined(SIMD_16WAY_ENABLED)
+    #undef SIMD_16WAY_ENABLED
+#endif
+
 #if defined(_MSC_VER)
     #define DISABLE_WARNING_PUSH           __pragma(warning( push ))
     #define DISABLE_WARNING_POP            __pragma(warning( pop )) 
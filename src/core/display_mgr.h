@@ -55,7 +55,7 @@ struct DisplayTile : public DisplayItemBase {
         }
     }
 
-    inline void UpdatePixel(int coord_x, int coord_y, const Spectrum& r) {
+    inline void UpdatePixel(int coord_x, int coord_y, const RGBSpectrum& r) {
         if (is_blender_mode) {
             auto local_index = coord_x + (h - 1 - coord_y) * w;
             m_data[0][4 * local_index] = r[0];
@@ -74,7 +74,7 @@ struct DisplayTile : public DisplayItemBase {
 
 protected:
     // data of the tile per channel, we have R/G/B
-    std::unique_ptr<float[]>     m_data[SPECTRUM_SAMPLE];
+    std::unique_ptr<float[]>     m_data[RGBSPECTRUM_SAMPLE];
     // the position of the tile
     const int x, y;
 };
@@ -0,0 +1,159 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "live_stats.h"
+#include "core/timer.h"
+#include "core/log.h"
+
+thread_local LiveStatsSlot* g_live_stats_slot = nullptr;
+
+// Counters of slots are never cleared, a thread that is gone still contributes to the totals. Slots of threads
+// that are gone are handed over to new threads, threads coming and going never run out of slots.
+static LiveStatsSlot                g_live_stats_slots[LIVE_STATS_MAX_SLOT];
+static std::atomic<unsigned>        g_live_stats_slot_cnt{0};
+static std::mutex                   g_live_stats_free_mutex;
+static std::vector<LiveStatsSlot*>  g_live_stats_free_slots;
+
+// The slot owned by the current thread, it is released once the thread exits.
+struct LiveStatsSlotOwner {
+    LiveStatsSlot*  slot = nullptr;     /**< The slot of the thread, nullptr if the thread shares the last slot. */
+
+    ~LiveStatsSlotOwner() {
+        if (!slot)
+            return;
+
+        std::lock_guard<std::mutex> lock(g_live_stats_free_mutex);
+        g_live_stats_free_slots.push_back(slot);
+        g_live_stats_slot = nullptr;
+    }
+};
+static thread_local LiveStatsSlotOwner g_live_stats_slot_owner;
+
+// The sampler thread publishing snapshots.
+static struct LiveStatsSampler {
+    std::thread             thread;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    bool                    quit = false;
+    FILE*                   file = nullptr;
+} g_live_stats_sampler;
+
+LiveStatsSlot* AcquireLiveStatsSlot() {
+    auto& owner = g_live_stats_slot_owner;
+    {
+        std::lock_guard<std::mutex> lock(g_live_stats_free_mutex);
+        if (!g_live_stats_free_slots.empty()) {
+            owner.slot = g_live_stats_free_slots.back();
+            g_live_stats_free_slots.pop_back();
+            return owner.slot;
+        }
+    }
+
+    // the last slot is shared once all slots are taken, it is never released
+    const auto index = g_live_stats_slot_cnt.fetch_add(1, std::memory_order_relaxed);
+    if (index >= LIVE_STATS_MAX_SLOT)
+        return &g_live_stats_slots[LIVE_STATS_MAX_SLOT - 1];
+
+    owner.slot = &g_live_stats_slots[index];
+    return owner.slot;
+}
+
+LiveStatsSnapshot TakeLiveStatsSnapshot() {
+    LiveStatsSnapshot snapshot;
+
+    const auto slot_cnt = std::min(g_live_stats_slot_cnt.load(std::memory_order_relaxed), LIVE_STATS_MAX_SLOT);
+    for (auto i = 0u; i < slot_cnt; ++i) {
+        for (auto j = 0u; j < (unsigned)LiveStatsCounter::Count; ++j)
+            snapshot.counters[j] += g_live_stats_slots[i].counters[j].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+// Write a snapshot as a line of JSON, throughput is evaluated since the previous snapshot.
+static void publishSnapshot(FILE* file, const LiveStatsSnapshot& cur, const LiveStatsSnapshot& prev) {
+    const auto duration = cur.time > prev.time ? (cur.time - prev.time) / 1000.0 : 0.0;
+    const auto per_second = [&](const LiveStatsCounter counter) {
+        return duration > 0.0 ? (cur[counter] - prev[counter]) / duration : 0.0;
+    };
+
+    const auto ray_cnt = cur[LiveStatsCounter::Ray];
+    const auto shadow_ray_ratio = ray_cnt ? (double)cur[LiveStatsCounter::ShadowRay] / ray_cnt : 0.0;
+
+    fprintf(file, "{\"time_ms\":%llu,\"rays\":%llu,\"rays_per_sec\":%.1f,\"paths\":%llu,\"paths_per_sec\":%.1f,"
+                  "\"shadow_ray_ratio\":%.4f,\"arena_bytes\":%llu}\n",
+            cur.time, ray_cnt, per_second(LiveStatsCounter::Ray), cur[LiveStatsCounter::Path], per_second(LiveStatsCounter::Path),
+            shadow_ray_ratio, cur[LiveStatsCounter::ArenaBytes]);
+
+    // make the line visible right away for whoever is tailing the file
+    fflush(file);
+}
+
+void StartLiveStatsSampler(const unsigned interval, const std::string& filename) {
+    auto& sampler = g_live_stats_sampler;
+    if (sampler.thread.joinable())
+        return;
+
+    sampler.file = fopen(filename.c_str(), "w");
+    if (!sampler.file) {
+        slog(WARNING, GENERAL, "Failed to open %s for live stats.", filename.c_str());
+        return;
+    }
+    slog(INFO, GENERAL, "Live stats are published to %s every %d (ms).", filename.c_str(), interval);
+
+    sampler.quit = false;
+    sampler.thread = std::thread([interval]() {
+        auto& sampler = g_live_stats_sampler;
+
+        Timer timer;
+        LiveStatsSnapshot prev;
+
+        std::unique_lock<std::mutex> lock(sampler.mutex);
+        while (true) {
+            const auto quit = sampler.cv.wait_for(lock, std::chrono::milliseconds(interval), [&]() { return sampler.quit; });
+
+            auto cur = TakeLiveStatsSnapshot();
+            cur.time = timer.GetElapsedTime();
+            publishSnapshot(sampler.file, cur, prev);
+            prev = cur;
+
+            if (quit)
+                break;
+        }
+    });
+}
+
+void StopLiveStatsSampler() {
+    auto& sampler = g_live_stats_sampler;
+    if (!sampler.thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(sampler.mutex);
+        sampler.quit = true;
+    }
+    sampler.cv.notify_one();
+    sampler.thread.join();
+
+    fclose(sampler.file);
+    sampler.file = nullptr;
+}
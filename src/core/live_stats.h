@@ -0,0 +1,103 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include "core/define.h"
+
+//! @brief  Counters that can be observed while rendering.
+enum class LiveStatsCounter : unsigned {
+    Ray = 0,            /**< All rays tested against the scene, shadow rays included. */
+    ShadowRay,          /**< Rays only for occlusion tests. */
+    Path,               /**< Paths started from the camera. */
+    ArenaBytes,         /**< Memory reserved by memory arenas. */
+    Count
+};
+
+//! @brief  Maximum number of threads that have their own slots.
+/**
+ * Slots of threads that are gone are reused by new threads, only threads running at the same time count
+ * towards the limit. Threads beyond this limit share the last slot, counters of them may lose a few updates.
+ * This is not a problem in practice since there are far less rendering threads than this.
+ */
+static constexpr unsigned LIVE_STATS_MAX_SLOT = 256;
+
+//! @brief  Counters of a single thread.
+/**
+ * Each slot is only written by the thread owning it, so there is no need for atomic read-modify-write
+ * operations. The counters are atomics only to make it safe for the sampler thread to read them.
+ * Slots are padded to a cache line so that threads never fight for the same cache line.
+ */
+struct alignas(64) LiveStatsSlot {
+    std::atomic<unsigned long long> counters[(unsigned)LiveStatsCounter::Count] = {};
+};
+
+//! @brief  Totals of all counters at a specific moment.
+struct LiveStatsSnapshot {
+    unsigned long long  counters[(unsigned)LiveStatsCounter::Count] = {};  /**< Sum of counters of all slots. */
+    unsigned long long  time = 0;                                           /**< Time since the sampler starts, in milli second. */
+
+    //! @brief  Get the value of a counter.
+    unsigned long long operator [](const LiveStatsCounter counter) const {
+        return counters[(unsigned)counter];
+    }
+};
+
+//! @brief  Assign a slot for the current thread, it is released once the thread exits.
+LiveStatsSlot*      AcquireLiveStatsSlot();
+
+//! @brief  Sum up counters of all slots.
+LiveStatsSnapshot   TakeLiveStatsSnapshot();
+
+//! @brief  Start a thread publishing snapshots periodically.
+//!
+//! Each snapshot is written as a line of JSON, with accumulated counters and the throughput since the previous
+//! snapshot, so that it is easy to feed dashboards by tailing the file.
+//!
+//! @param  interval    Interval between two snapshots, in milli second.
+//! @param  filename    The file to write snapshots to, it is created if it doesn't exist.
+void                StartLiveStatsSampler(const unsigned interval, const std::string& filename);
+
+//! @brief  Stop the sampler thread, a last snapshot is published before it returns.
+void                StopLiveStatsSampler();
+
+// The slot of the current thread, it is nullptr until the thread updates any counter.
+extern thread_local LiveStatsSlot* g_live_stats_slot;
+
+//! @brief  Get the slot of the current thread, a new slot is assigned the first time a thread asks for it.
+SORT_FORCEINLINE LiveStatsSlot& GetLiveStatsSlot() {
+    if (UNLIKELY(!g_live_stats_slot))
+        g_live_stats_slot = AcquireLiveStatsSlot();
+    return *g_live_stats_slot;
+}
+
+//! @brief  Increase a counter of the current thread.
+//!
+//! @param  counter     The counter to increase.
+//! @param  n           The number to add to the counter.
+SORT_FORCEINLINE void AddLiveStats(const LiveStatsCounter counter, const unsigned long long n = 1) {
+    auto& c = GetLiveStatsSlot().counters[(unsigned)counter];
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+#ifdef SORT_ENABLE_LIVE_STATS
+    #define SORT_LIVE_STATS(counter, n)     AddLiveStats(LiveStatsCounter::counter, n)
+#else
+    #define SORT_LIVE_STATS(counter, n)
+#endif
@@ -0,0 +1,69 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+#pragma once
+
+#include <string>
+#include "core/define.h"
+
+//! @brief  Read-only memory mapped file.
+/**
+ * The content of the file is paged in by the OS on demand instead of being read into a heap buffer first, which avoids
+ * holding an extra copy of large files that get converted to a different representation anyway.
+ */
+class MappedFile {
+public:
+    //! @brief  Default constructor.
+    MappedFile() = default;
+
+    //! @brief  The file is unmapped on destruction.
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //! @brief  Map a file into memory.
+    //!
+    //! @param  filename    Name of the file to map.
+    //! @return             Whether the file is successfully mapped.
+    bool Open(const std::string& filename);
+
+    //! @brief  Unmap the file, this is also done automatically on destruction.
+    void Close();
+
+    //! @brief  Get the content of the file.
+    //!
+    //! @return             Pointer to the first byte of the file, nullptr if nothing is mapped.
+    const unsigned char* GetData() const {
+        return m_data;
+    }
+
+    //! @brief  Get the size of the file in bytes.
+    //!
+    //! @return             Size of the mapped file.
+    size_t GetSize() const {
+        return m_size;
+    }
+
+private:
+    const unsigned char*    m_data = nullptr;       /**< Mapped content of the file. */
+    size_t                  m_size = 0;             /**< Size of the file in bytes. */
+
+#ifdef SORT_IN_WINDOWS
+    void*                   m_file = nullptr;       /**< Handle of the file. */
+    void*                   m_mapping = nullptr;    /**< Handle of the file mapping object. */
+#endif
+};
@@ -20,6 +20,7 @@
 #include <list>
 #include <memory>
 #include "core/sassert.h"
+#include "core/live_stats.h"
 
 // 32KB memory for each memory block by default.
 #define MEM_BLOCK_SIZE                  32768
@@ -51,26 +52,36 @@ class MemoryAllocator {
 public:
     //! @brief  Allocate memory from memory pool.
     //!
+    //! The memory is aligned to what the type requires, blocks are allocated through 'new', types can't
+    //! require more alignment than what 'new' guarantees.
+    //!
     //! @param  cnt     Number of instance it needs allocate.
     //! @return         The pointer pointing to memory that could hold the instance(s).
     template<class T>
     T*  Allocate(unsigned int cnt = 1u) {
+        static_assert( alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ , "Memory blocks are not aligned enough for the type." );
+        constexpr unsigned int alignment = alignof(T) > MEM_ALIGN_SIZE ? (unsigned int)alignof(T) : MEM_ALIGN_SIZE;
+
         unsigned int size_to_allocate = (unsigned int)(sizeof(T) * cnt);
         sAssert( size_to_allocate <= MEM_BLOCK_SIZE , MEMORY );
         MemoryBlock* currentBlock = m_availableBlocks.size() ? m_availableBlocks.front().get() : nullptr;
-        if (IS_PTR_INVALID(currentBlock) || (currentBlock->m_start + size_to_allocate > MEM_BLOCK_SIZE)) {
+        auto start = currentBlock ? ( ( currentBlock->m_start + alignment - 1 ) & ~( alignment - 1 ) ) : 0u;
+        if (IS_PTR_INVALID(currentBlock) || (start + size_to_allocate > MEM_BLOCK_SIZE)) {
             if (currentBlock) {
                 auto block = std::move(m_availableBlocks.front());
                 m_availableBlocks.pop_front();
                 m_usedBlocks.push_back(std::move(block));
             }
 
-            if( m_availableBlocks.empty() )
+            if( m_availableBlocks.empty() ){
                 m_availableBlocks.push_front(std::make_unique<MemoryBlock>());
+                SORT_LIVE_STATS(ArenaBytes, MEM_BLOCK_SIZE);
+            }
             currentBlock = m_availableBlocks.front().get();
+            start = 0;
         }
-        auto ret = currentBlock->m_data.get() + currentBlock->m_start;
-        currentBlock->m_start += MEM_SIZE_ALIGNED(size_to_allocate);
+        auto ret = currentBlock->m_data.get() + start;
+        currentBlock->m_start = start + MEM_SIZE_ALIGNED(size_to_allocate);
         return (T*)ret;
     }
 
@@ -143,14 +143,18 @@ void Mesh::Serialize(IStreamBase& stream) {
     }
 
     static const StringID has_volume_sid("has_volume");
+    static const StringID has_sparse_volume_sid("has_sparse_volume");
     static const StringID no_volume_sid("no_volume");
 
     // serialize volume data if needed
     StringID volume_sid;
     stream >> volume_sid;
-    if (volume_sid == has_volume_sid){
+    if (volume_sid == has_volume_sid || volume_sid == has_sparse_volume_sid){
         m_volumeDensity = std::make_unique<MediumDensity>();
-        m_volumeDensity->Serialize(stream);
+        if (volume_sid == has_sparse_volume_sid)
+            m_volumeDensity->SerializeSparse(stream);
+        else
+            m_volumeDensity->Serialize(stream);
 
         m_volumeColor = std::make_unique<MediumColor>();
         m_volumeColor->Serialize(stream);
@@ -89,6 +89,20 @@ public:
     //! @return         The color of the volume.
     Spectrum    SampleVolumeColor(const Point& pos) const;
 
+    //! @brief      Get the volume density data inside this mesh.
+    //!
+    //! @return         The density data, nullptr if there is no volume data attached.
+    const MediumDensity* GetVolumeDensity() const {
+        return m_volumeDensity.get();
+    }
+
+    //! @brief      Get the transformation from world space to volume texture space.
+    //!
+    //! @return         The transformation from world space to volume texture space.
+    const Matrix& GetWorldToVolume() const {
+        return m_world2Volume;
+    }
+
 private:
     //! @brief      Generate tangent for the triangles.
     //!
@@ -0,0 +1,211 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "perf_counters.h"
+
+#ifdef SORT_PERF_COUNTERS_SUPPORTED
+
+#include <cstring>
+#include <mutex>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "core/stats.h"
+#include "core/log.h"
+
+// Hardware events counted in each region.
+enum PerfEvent : unsigned {
+    PERF_EVENT_CYCLES = 0,
+    PERF_EVENT_INSTRUCTIONS,
+    PERF_EVENT_L1D_MISSES,
+    PERF_EVENT_LLC_MISSES,
+    PERF_EVENT_BRANCH_MISSES,
+    PERF_EVENT_CNT
+};
+
+#define SORT_PERF_COUNTER_STATS( cat , prefix ) \
+    SORT_STATS_DEFINE_COUNTER(prefix##Cycles) \
+    SORT_STATS_DEFINE_COUNTER(prefix##Instructions) \
+    SORT_STATS_DEFINE_COUNTER(prefix##L1DMisses) \
+    SORT_STATS_DEFINE_COUNTER(prefix##LLCMisses) \
+    SORT_STATS_DEFINE_COUNTER(prefix##BranchMisses) \
+    SORT_STATS_COUNTER(cat, "CPU Cycles", prefix##Cycles) \
+    SORT_STATS_COUNTER(cat, "Instructions", prefix##Instructions) \
+    SORT_STATS_AVG_COUNT(cat, "Instructions per Cycle", prefix##Instructions, prefix##Cycles) \
+    SORT_STATS_COUNTER(cat, "L1 Data Cache Misses", prefix##L1DMisses) \
+    SORT_STATS_RATIO(cat, "L1 Data Cache Misses per Instruction", prefix##L1DMisses, prefix##Instructions) \
+    SORT_STATS_COUNTER(cat, "Last Level Cache Misses", prefix##LLCMisses) \
+    SORT_STATS_RATIO(cat, "Last Level Cache Misses per Instruction", prefix##LLCMisses, prefix##Instructions) \
+    SORT_STATS_COUNTER(cat, "Branch Misses", prefix##BranchMisses) \
+    SORT_STATS_RATIO(cat, "Branch Misses per Instruction", prefix##BranchMisses, prefix##Instructions)
+
+SORT_PERF_COUNTER_STATS("Hardware-Counters(Traversal)", sPerfTraversal)
+SORT_PERF_COUNTER_STATS("Hardware-Counters(Shading)", sPerfShading)
+SORT_PERF_COUNTER_STATS("Hardware-Counters(Light Sampling)", sPerfLightSampling)
+
+#define SORT_PERF_COUNTER_ACCUMULATE( prefix , delta ) \
+    prefix##Cycles += delta[PERF_EVENT_CYCLES]; \
+    prefix##Instructions += delta[PERF_EVENT_INSTRUCTIONS]; \
+    prefix##L1DMisses += delta[PERF_EVENT_L1D_MISSES]; \
+    prefix##LLCMisses += delta[PERF_EVENT_LLC_MISSES]; \
+    prefix##BranchMisses += delta[PERF_EVENT_BRANCH_MISSES];
+
+// Counters of a thread, all events are in one group so that they are read with a single system call.
+struct PerfCounterThreadState {
+    int                 fds[PERF_EVENT_CNT];            /**< File descriptors of events, -1 if an event is not available. */
+    int                 index[PERF_EVENT_CNT];          /**< Position of events in the group, -1 if an event is not available. */
+    unsigned            event_cnt = 0;                  /**< Number of events in the group. */
+    bool                initialized = false;            /**< Whether counters are opened already. */
+    bool                valid = false;                  /**< Whether counters can be read at all. */
+    PerfCounterRegion   current = PerfCounterRegion::None;  /**< The region counters are accumulated to. */
+    StatsInt            last[PERF_EVENT_CNT] = {};      /**< Counters when the current region is entered or resumed. */
+
+    ~PerfCounterThreadState() {
+        if (!initialized)
+            return;
+
+        // members of the group are closed before the leader
+        for (auto i = (int)PERF_EVENT_CNT - 1; i >= 0; --i) {
+            if (fds[i] >= 0)
+                close(fds[i]);
+        }
+    }
+};
+
+static thread_local PerfCounterThreadState g_perf_counter_state;
+
+// Open a counter of the current thread, only what happens in user space is counted.
+static int openEvent(const unsigned type, const unsigned long long config, const int group_fd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void openCounters(PerfCounterThreadState& state) {
+    static const struct {
+        unsigned            type;
+        unsigned long long  config;
+    } events[PERF_EVENT_CNT] = {
+        { PERF_TYPE_HARDWARE , PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE , PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE , PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE , PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE , PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    state.initialized = true;
+    for (auto i = 0u; i < PERF_EVENT_CNT; ++i)
+        state.fds[i] = state.index[i] = -1;
+
+    // cycles lead the group, nothing is counted without it
+    state.fds[0] = openEvent(events[0].type, events[0].config, -1);
+    for (auto i = 1u; i < PERF_EVENT_CNT && state.fds[0] >= 0; ++i)
+        state.fds[i] = openEvent(events[i].type, events[i].config, state.fds[0]);
+
+    for (auto i = 0u; i < PERF_EVENT_CNT; ++i) {
+        if (state.fds[i] >= 0)
+            state.index[i] = (int)state.event_cnt++;
+    }
+
+    state.valid = state.fds[0] >= 0;
+
+    // Warn only once instead of once per thread, hardware counters are commonly not accessible in virtual
+    // machines and containers or with a strict perf_event_paranoid setting.
+    static std::once_flag flag;
+    std::call_once(flag, [&]() {
+        if (!state.valid) {
+            slog(WARNING, PERFORMANCE, "Hardware performance counters are not accessible, check /proc/sys/kernel/perf_event_paranoid.");
+            return;
+        }
+        if (state.event_cnt < PERF_EVENT_CNT)
+            slog(WARNING, PERFORMANCE, "Only %d of %d hardware performance counters are available.", state.event_cnt, PERF_EVENT_CNT);
+
+        SortStatsEnableCategory("Hardware-Counters(Traversal)");
+        SortStatsEnableCategory("Hardware-Counters(Shading)");
+        SortStatsEnableCategory("Hardware-Counters(Light Sampling)");
+    });
+}
+
+static bool readCounters(const PerfCounterThreadState& state, StatsInt values[PERF_EVENT_CNT]) {
+    // the layout is the number of events followed by the value of each event
+    unsigned long long data[1 + PERF_EVENT_CNT];
+    if (read(state.fds[0], data, sizeof(data)) < (ssize_t)((1 + state.event_cnt) * sizeof(unsigned long long)))
+        return false;
+
+    for (auto i = 0u; i < PERF_EVENT_CNT; ++i)
+        values[i] = state.index[i] >= 0 ? (StatsInt)data[1 + state.index[i]] : 0;
+    return true;
+}
+
+// Accumulate counters since the current region is entered or resumed, the current region is then switched.
+static void switchRegion(PerfCounterThreadState& state, const PerfCounterRegion region) {
+    StatsInt now[PERF_EVENT_CNT];
+    if (readCounters(state, now)) {
+        StatsInt delta[PERF_EVENT_CNT];
+        for (auto i = 0u; i < PERF_EVENT_CNT; ++i)
+            delta[i] = now[i] - state.last[i];
+
+        switch (state.current) {
+        case PerfCounterRegion::Traversal:
+            SORT_PERF_COUNTER_ACCUMULATE(sPerfTraversal, delta);
+            break;
+        case PerfCounterRegion::Shading:
+            SORT_PERF_COUNTER_ACCUMULATE(sPerfShading, delta);
+            break;
+        case PerfCounterRegion::LightSampling:
+            SORT_PERF_COUNTER_ACCUMULATE(sPerfLightSampling, delta);
+            break;
+        default:
+            break;
+        }
+
+        memcpy(state.last, now, sizeof(now));
+    }
+
+    state.current = region;
+}
+
+PerfCounterScope::PerfCounterScope(const PerfCounterRegion region) : m_parent(g_perf_counter_state.current) {
+    auto& state = g_perf_counter_state;
+    if (UNLIKELY(!state.initialized))
+        openCounters(state);
+    if (state.valid)
+        switchRegion(state, region);
+}
+
+PerfCounterScope::~PerfCounterScope() {
+    auto& state = g_perf_counter_state;
+    if (state.valid)
+        switchRegion(state, m_parent);
+}
+
+#else
+
+PerfCounterScope::PerfCounterScope(const PerfCounterRegion region) : m_parent(region) {
+    // there is no hardware counter to read on this platform
+}
+
+PerfCounterScope::~PerfCounterScope() {
+}
+
+#endif
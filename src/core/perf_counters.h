@@ -0,0 +1,63 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "core/define.h"
+
+// Hardware counters are read through perf_event_open, which is only available on Linux. They are reported
+// through the stats system, there is no point counting them without it.
+#if defined(SORT_ENABLE_PERF_COUNTERS) && defined(SORT_IN_LINUX) && defined(SORT_ENABLE_STATS_COLLECTION)
+    #define SORT_PERF_COUNTERS_SUPPORTED
+#endif
+
+//! @brief  Regions of the renderer that hardware counters are accumulated for.
+enum class PerfCounterRegion : unsigned {
+    Traversal = 0,      /**< Spatial structure traversal, both intersection and occlusion tests. */
+    Shading,            /**< Executing materials to get the BXDFs at an interaction. */
+    LightSampling,      /**< Sampling lights and evaluating their contribution to an interaction. */
+    Count,
+    None = Count        /**< Not inside any region. */
+};
+
+//! @brief  Accumulate hardware counters of the current thread to a region until it goes out of scope.
+/**
+ * Counters are attributed exclusively. A region nested in another one, like tracing a shadow ray while
+ * sampling a light, pauses the outer region, so that cache misses of traversal never show up in light
+ * sampling. Counters are read through a system call when entering and leaving a region, which costs more
+ * than a lot of the work in these regions. Rendering time is heavily affected with counters enabled, ratios
+ * like instructions per cycle or cache misses per instruction are what to look at.
+ */
+class PerfCounterScope {
+public:
+    //! @brief  Start accumulating counters to a region, the enclosing region is paused.
+    //!
+    //! @param  region      The region to accumulate counters to.
+    PerfCounterScope(const PerfCounterRegion region);
+
+    //! @brief  Stop accumulating counters to the region, the enclosing region is resumed.
+    ~PerfCounterScope();
+
+private:
+    PerfCounterRegion   m_parent;       /**< The region enclosing this one. */
+};
+
+#ifdef SORT_PERF_COUNTERS_SUPPORTED
+    #define SORT_PERF_COUNTER_SCOPE(region)     PerfCounterScope perf_counter_scope(PerfCounterRegion::region)
+#else
+    #define SORT_PERF_COUNTER_SCOPE(region)
+#endif
@@ -102,6 +102,10 @@ public:
     SORT_FORCEINLINE Light* GetLight() const {
         return m_light;
     }
+
+    SORT_FORCEINLINE void SetLight( class Light* light ) {
+        m_light = light;
+    }
     
     //! @brief  Get the type of the shape attached to the primitive.
     //!
@@ -21,6 +21,11 @@
 
 // SORT used to use easy profiler as default one.
 // It is a open-source cross-platform project, which is available on git https://github.com/yse/easy_profiler
+// Without it, SORT falls back to its built-in profiler, which dumps Chrome trace files that can be loaded in
+// chrome://tracing or https://ui.perfetto.dev without installing anything.
+
+#define SORT_PROFILE_CAT_PROXY(v0, v1)  v0 ## v1
+#define SORT_PROFILE_CAT(v0, v1)        SORT_PROFILE_CAT_PROXY(v0, v1)
 
 #ifdef SORT_ENABLE_PROFILER
 
@@ -30,8 +35,25 @@
 #define SORT_PROFILE_DISABLE        EASY_PROFILER_DISABLE
 #define SORT_PROFILE_ISENABLED      ::profiler::isEnabled()
 #define SORT_PROFILE(e)             EASY_BLOCK((e))
-#define SORT_PROFILE_END            EASY_END_BLOCK
+#define SORT_PROFILE_THREAD(name)   EASY_THREAD((name))
+#define SORT_PROFILE_TASK_RESUME(id, scopes)
+#define SORT_PROFILE_TASK_SUSPEND(scopes)
 #define SORT_PROFILE_DUMP(file)     profiler::dumpBlocksToFile(file)
+#define SORT_PROFILE_FILE           "sort.prof"
+
+#elif defined(SORT_ENABLE_TRACE_PROFILER)
+
+#include "core/trace_profiler.h"
+
+#define SORT_PROFILE_ENABLE         TraceProfilerEnable(true)
+#define SORT_PROFILE_DISABLE        TraceProfilerEnable(false)
+#define SORT_PROFILE_ISENABLED      TraceProfilerIsEnabled()
+#define SORT_PROFILE(e)             TraceScope SORT_PROFILE_CAT(sort_trace_scope_, __LINE__)(e)
+#define SORT_PROFILE_THREAD(name)   TraceProfilerSetThreadName(name)
+#define SORT_PROFILE_TASK_RESUME(id, scopes)    TraceProfilerResumeTask(id, scopes)
+#define SORT_PROFILE_TASK_SUSPEND(scopes)       scopes = TraceProfilerSuspendTask()
+#define SORT_PROFILE_DUMP(file)     TraceProfilerDump(file)
+#define SORT_PROFILE_FILE           "sort_trace.json"
 
 #else
 
@@ -39,7 +61,10 @@
 #define SORT_PROFILE_DISABLE        {}
 #define SORT_PROFILE_ISENABLED      false
 #define SORT_PROFILE(e)
-#define SORT_PROFILE_END
+#define SORT_PROFILE_THREAD(name)
+#define SORT_PROFILE_TASK_RESUME(id, scopes)
+#define SORT_PROFILE_TASK_SUSPEND(scopes)
 #define SORT_PROFILE_DUMP(file)     0
+#define SORT_PROFILE_FILE           ""
 
 #endif
@@ -29,12 +29,15 @@ public:
     // Generate a random unsigned number
     unsigned    rand();
 
+    // Restart the sequence from a seed, the same seed always generates the same sequence of numbers.
+    void        Seed( unsigned seed );
+
 private:
     unsigned long mt[MT_CNT]; /* the array for the state vector  */
     int mti;
     bool seed_setup = false;
 
-    void init();
+    void init( unsigned seed );
 };
 
 template<class T>
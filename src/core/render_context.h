@@ -24,6 +24,7 @@
 
 struct Qbvh_Node;
 struct Obvh_Node;
+struct Hbvh_Node;
 
 //! @brief  Render context is the context for rendering for each fiber/thread
 /**
@@ -42,9 +43,15 @@ struct RenderContext{
 
     std::unique_ptr<std::pair<Qbvh_Node*, float>[]> m_fast_qbvh_stack;
     std::unique_ptr<Qbvh_Node*[]>                   m_fast_qbvh_stack_simple;
+    std::unique_ptr<std::pair<Qbvh_Node*, unsigned>[]>  m_fast_qbvh_stack_packet;
 
     std::unique_ptr<std::pair<Obvh_Node*, float>[]> m_fast_obvh_stack;
     std::unique_ptr<Obvh_Node*[]>                   m_fast_obvh_stack_simple;
+    std::unique_ptr<std::pair<Obvh_Node*, unsigned>[]>  m_fast_obvh_stack_packet;
+
+    std::unique_ptr<std::pair<Hbvh_Node*, float>[]> m_fast_hbvh_stack;
+    std::unique_ptr<Hbvh_Node*[]>                   m_fast_hbvh_stack_simple;
+    std::unique_ptr<std::pair<Hbvh_Node*, unsigned>[]>  m_fast_hbvh_stack_packet;
 
     std::unique_ptr<RandomNumberGenerator>          m_random_num_generator;
 
@@ -55,8 +62,13 @@ struct RenderContext{
 
         m_fast_qbvh_stack = nullptr;
         m_fast_qbvh_stack_simple = nullptr;
+        m_fast_qbvh_stack_packet = nullptr;
         m_fast_obvh_stack = nullptr;
         m_fast_obvh_stack_simple = nullptr;
+        m_fast_obvh_stack_packet = nullptr;
+        m_fast_hbvh_stack = nullptr;
+        m_fast_hbvh_stack_simple = nullptr;
+        m_fast_hbvh_stack_packet = nullptr;
     }
 
     //! @brief  If the render context is initialized
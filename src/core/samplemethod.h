@@ -288,3 +288,204 @@ private:
         m_nv = nv;
     }
 };
+
+// one dimensional discrete distribution sampled in constant time with an alias table
+// the table is built with Vose's method, each bin holds the probability of keeping itself and the alias to fall back to.
+// unlike Distribution1D, neighbouring canonical random variables don't map to neighbouring buckets.
+class AliasTable{
+public:
+    // constructor
+    AliasTable( const float* f , unsigned n ){
+        sum = 0.0f;
+        if( f == 0 || n == 0 )
+            return;
+
+        bins.resize( n );
+        sum = buildBins( f , n , bins.data() );
+    }
+
+    // get a discrete sample
+    // para 'u' : a canonical random variable
+    // para 'pdf' : probability of the sampled bucket
+    // para 'remapped' : a new canonical random variable that is uniformly distributed within the sampled bucket
+    // result   : the sampled bucket, -1 if there is no data in the distribution
+    int SampleDiscrete( float u , float* pdf , float* remapped = nullptr ) const{
+        sAssert( u <= 1.0f && u >= 0.0f , SAMPLING );
+        if( bins.empty() ){
+            if( pdf ) *pdf = 0.0f;
+            return -1;
+        }
+        return sampleBins( bins.data() , (unsigned)bins.size() , u , pdf , remapped );
+    }
+
+    // get the sum of the original data
+    float GetSum() const{
+        return sum;
+    }
+
+    // get the count
+    unsigned GetCount() const{
+        return (unsigned)bins.size();
+    }
+
+    // get property of the unit
+    float GetProperty( unsigned i ) const{
+        sAssert( i < bins.size() , GENERAL );
+        return bins[i].pdf;
+    }
+
+private:
+    struct AliasBin{
+        float       q = 0.0f;       // probability of keeping the bin itself, scaled by the number of bins
+        unsigned    alias = 0;      // the bin to fall back to, relative to the first bin of the table
+        float       pdf = 0.0f;     // normalized probability of the bin
+    };
+    std::vector<AliasBin>   bins;
+    float                   sum;
+
+    // build the bins of a table from the original data, 'bins' needs to have room for 'n' bins
+    // result   : the sum of the original data
+    static float buildBins( const float* f , unsigned n , AliasBin* bins ){
+        // the table is built in double, probabilities of millions of bins are lost in the rounding error of float otherwise.
+        auto total = 0.0;
+        for( unsigned i = 0 ; i < n ; ++i )
+            total += std::max( 0.0f , f[i] );
+
+        std::vector<double> q( n );
+        for( unsigned i = 0 ; i < n ; ++i ){
+            const auto pdf = total != 0.0 ? std::max( 0.0f , f[i] ) / total : 1.0 / (double)n;
+            bins[i].pdf = (float)pdf;
+            q[i] = pdf * n;
+        }
+
+        // split the bins into the ones below and above average probability
+        std::vector<unsigned> under , over;
+        for( unsigned i = 0 ; i < n ; ++i ){
+            if( q[i] < 1.0 )
+                under.push_back( i );
+            else
+                over.push_back( i );
+        }
+
+        // fill each under-full bin with the probability of an over-full one
+        while( !under.empty() && !over.empty() ){
+            const auto small = under.back();
+            under.pop_back();
+            const auto large = over.back();
+            over.pop_back();
+
+            bins[small].alias = large;
+            q[large] -= 1.0 - q[small];
+            if( q[large] < 1.0 )
+                under.push_back( large );
+            else
+                over.push_back( large );
+        }
+
+        // the rest is only off by numerical error
+        for( const auto i : under )
+            q[i] = 1.0;
+        for( const auto i : over )
+            q[i] = 1.0;
+
+        for( unsigned i = 0 ; i < n ; ++i )
+            bins[i].q = (float)q[i];
+
+        return (float)total;
+    }
+
+    // sample the bins of a table, there has to be at least one bin
+    static int sampleBins( const AliasBin* bins , unsigned n , float u , float* pdf , float* remapped ){
+        // the bits of 'u' left after picking the bin are both the threshold and the remapped variable, they are
+        // kept in double so that nothing is lost in scaling.
+        const auto scaled = (double)u * n;
+        const auto offset = std::min( (unsigned)scaled , n - 1 );
+        const auto up = std::min( scaled - offset , 0x1.fffffffffffffp-1 );
+
+        const auto& bin = bins[offset];
+        if( up < bin.q ){
+            if( pdf ) *pdf = bin.pdf;
+            if( remapped ) *remapped = std::min( (float)( up / bin.q ) , 0x1.fffffep-1f );
+            return offset;
+        }
+
+        if( pdf ) *pdf = bins[bin.alias].pdf;
+        if( remapped ) *remapped = std::min( (float)( ( up - bin.q ) / ( 1.0 - bin.q ) ) , 0x1.fffffep-1f );
+        return bin.alias;
+    }
+
+    friend class AliasDistribution2D;
+};
+
+// two dimensional piecewise constant distribution sampled in constant time
+// just like Distribution2D, a row is picked from the marginal distribution and a column from the conditional
+// distribution of the row, both are alias tables instead of cdfs so that there is no binary search. each
+// random variable only picks among one row or one column, enough of its bits are left to locate the sample
+// within the cell even for large images.
+// bins of all conditional distributions live in one flat array, row after row, so that sampling a row touches
+// one contiguous range instead of chasing a pointer per row. all rows have the same size, the offset of a row
+// is simply its index times the width.
+class AliasDistribution2D{
+public:
+    // default constructor
+    AliasDistribution2D( const float* data , unsigned nu , unsigned nv ):
+        m_nu( nu ) , m_nv( nv ) , m_bins( (size_t)nu * nv ) , m_row_sums( nv ){
+        for( unsigned i = 0 ; i < nv && nu > 0 ; i++ )
+            m_row_sums[i] = AliasTable::buildBins( &data[(size_t)i*nu] , nu , row( i ) );
+        marginal = AliasTable( m_row_sums.data() , nv );
+    }
+
+    // get a sample point
+    void SampleContinuous( float u , float v , float uv[2] , float* pdf ) const{
+        float pdf0 = 0.0f , pdf1 = 0.0f , du = 0.0f , dv = 0.0f;
+        const auto iv = marginal.GetSum() == 0.0f ? -1 : marginal.SampleDiscrete( v , &pdf1 , &dv );
+        const auto iu = iv < 0 || m_nu == 0 ? -1 : AliasTable::sampleBins( row( iv ) , m_nu , u , &pdf0 , &du );
+        if( iu < 0 || pdf0 == 0.0f || pdf1 == 0.0f ){
+            uv[0] = uv[1] = 0.0f;
+            if( pdf ) *pdf = 0.0f;
+            return;
+        }
+
+        uv[0] = cellCoordinate( iu , du , m_nu );
+        uv[1] = cellCoordinate( iv , dv , m_nv );
+
+        if( pdf )
+            *pdf = pdf0 * m_nu * pdf1 * m_nv;
+    }
+
+    // get pdf
+    float Pdf( float u , float v ) const{
+        if( marginal.GetSum() == 0.0f )
+            return 0.0f;
+
+        const auto iu = std::min( (unsigned)( clamp( u , 0.0f , 1.0f ) * m_nu ) , m_nu - 1 );
+        const auto iv = std::min( (unsigned)( clamp( v , 0.0f , 1.0f ) * m_nv ) , m_nv - 1 );
+        return row( iv )[iu].pdf * m_nu * marginal.GetProperty( iv ) * m_nv;
+    }
+
+private:
+    // the size for the two dimensions
+    unsigned m_nu , m_nv;
+    // bins of the distribution in each row, row after row
+    std::vector<AliasTable::AliasBin>   m_bins;
+    // the sum of the original data in each row
+    std::vector<float>                  m_row_sums;
+    // the marginal sampling distribution
+    AliasTable  marginal{ nullptr , 0 };
+
+    // the first bin of a row
+    AliasTable::AliasBin* row( unsigned i ){
+        return m_bins.data() + (size_t)i * m_nu;
+    }
+    const AliasTable::AliasBin* row( unsigned i ) const{
+        return m_bins.data() + (size_t)i * m_nu;
+    }
+
+    // coordinate of a position within a cell, it is kept inside the cell since float rounding could push it to the next one
+    static float cellCoordinate( unsigned i , float d , unsigned n ){
+        auto x = (float)( ( i + (double)d ) / n );
+        while( x > 0.0f && (unsigned)( x * n ) > i )
+            x = std::nextafter( x , 0.0f );
+        return x;
+    }
+};
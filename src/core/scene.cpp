@@ -25,6 +25,8 @@
 #include "core/sassert.h"
 #include "core/sassert.h"
 #include "core/stats.h"
+#include "core/live_stats.h"
+#include "core/perf_counters.h"
 #include "core/strid.h"
 #include "core/primitive.h"
 #include "entity/visual_entity.h"
@@ -32,6 +34,39 @@
 #include "stream/fstream.h"
 #include "light/light.h"
 #include "shape/shape.h"
+#include "simd/simd_dispatch.h"
+#include "job/scheduler.h"
+#include "job/numa.h"
+
+// QBVH, OBVH and HBVH only differ in SIMD width. By default, any of them is upgraded to the widest one the CPU and the
+// build support, so that a scene exported as QBVH runs on AVX512 where it is available, and a scene exported on a
+// machine with AVX512 won't pick an accelerator that crashes on older CPUs. With upgrading disabled, the requested
+// one is respected as long as it is able to run.
+static StringID pickFastBvh( const StringID accelType , const bool upgrade ){
+    unsigned requested = 0;
+    if( accelType == SID("Qbvh") )
+        requested = 4;
+    else if( accelType == SID("Obvh") )
+        requested = 8;
+    else if( accelType == SID("Hbvh") )
+        requested = 16;
+    else
+        return accelType;
+
+    // without any SIMD support, all of them fall back to the same scalar implementation
+    const auto width = GetSimdWidth();
+    if( width == 1 || width == requested || ( !upgrade && IsSimdWidthSupported( requested ) ) )
+        return accelType;
+
+    const auto name = []( const unsigned w ){
+        return w == 16 ? "HBVH" : ( w == 8 ? "OBVH" : "QBVH" );
+    };
+    if( width > requested )
+        slog(INFO, SPATIAL_ACCELERATOR, "Upgrading spatial accelerator from %s to %s based on CPU features.", name(requested), name(width));
+    else
+        slog(WARNING, SPATIAL_ACCELERATOR, "%s is not supported by the CPU or this build, switching spatial accelerator to %s.", name(requested), name(width));
+    return width == 16 ? SID("Hbvh") : ( width == 8 ? SID("Obvh") : SID("Qbvh") );
+}
 
 SORT_STATS_DEFINE_COUNTER(sScenePrimitiveCount)
 SORT_STATS_DEFINE_COUNTER(sSceneLightCount)
@@ -39,6 +74,9 @@ SORT_STATS_DEFINE_COUNTER(sSceneLightCount)
 SORT_STATS_COUNTER("Statistics", "Total Primitive Count", sScenePrimitiveCount);
 SORT_STATS_COUNTER("Statistics", "Total Light Count", sSceneLightCount);
 
+// Number of lights whose power is evaluated in one task while building the light distribution.
+static constexpr unsigned LIGHT_POWER_BATCH = 4096;
+
 ScenePrimitiveIterator::ScenePrimitiveIterator(const Scene& scene):m_scene(scene){
     Reset();
 }
@@ -109,26 +147,65 @@ const Visual* SceneVisualIterator::Next(){
     return nullptr;
 }
 
-bool Scene::LoadScene( IStreamBase& stream ){
+bool Scene::LoadScene( IStreamBase& stream , const bool upgrade_accelerator , const bool numa_interleave ){
     const StringID verificationBit( "verification bits" );
 
     StringID checkingBit;
     stream >> checkingBit;
     sAssertMsg( checkingBit == verificationBit , RESOURCE , "Serialization is broken." );
 
-    while( true ){
-        StringID class_id;
-        stream >> class_id;
-        if( SID("End of Entities") == class_id )
-            break;
+    {
+        // Meshes are read by threads on all NUMA nodes during rendering. Reading entities never yields, the memory
+        // policy of the thread can't leak to other tasks picked up by it.
+        NumaInterleaveScope interleave( numa_interleave );
+        while( true ){
+            StringID class_id;
+            stream >> class_id;
+            if( SID("End of Entities") == class_id )
+                break;
+
+            auto entity = MakeUniqueInstance<Entity>( class_id );
+            sAssertMsg( entity , RESOURCE , "Serialization is broken." );
+
+            entity->Serialize(stream);
+            m_entities.push_back(std::move(entity));
+        }
+    }
 
-        auto entity = MakeUniqueInstance<Entity>( class_id );
-        sAssertMsg( entity , RESOURCE , "Serialization is broken." );
+    populate();
 
-        entity->Serialize(stream);
-        m_entities.push_back(std::move(entity));
+    // parse the acceleration structure configuration
+    StringID accelType;
+    stream >> accelType;
+    m_accelerator = MakeUniqueInstance<Accelerator>(pickFastBvh(accelType, upgrade_accelerator));
+    if (m_accelerator)
+        m_accelerator->Serialize(stream);
+
+    if (!m_accelerator) {
+#if SIMD_4WAY_ENABLED
+        slog(WARNING, SPATIAL_ACCELERATOR, "Acceleration structure not supported. Use QBVH instead.");
+        m_accelerator = MakeUniqueInstance<Accelerator>(SID("Qbvh"));
+#else
+        slog(WARNING, SPATIAL_ACCELERATOR, "Acceleration structure not supported. Use BVH instead.");
+        m_accelerator = MakeUniqueInstance<Accelerator>(SID("Bvh"));
+#endif
     }
 
+    return true;
+}
+
+void Scene::AddEntity( std::unique_ptr<Entity> entity ){
+    m_entities.push_back(std::move(entity));
+}
+
+bool Scene::SetupScene( const StringID accelType ){
+    populate();
+
+    m_accelerator = MakeUniqueInstance<Accelerator>(accelType);
+    return m_accelerator != nullptr;
+}
+
+void Scene::populate(){
     // this will populate data in the scene
     for( auto& entity : m_entities )
         entity->FillScene(*this);
@@ -158,42 +235,35 @@ bool Scene::LoadScene( IStreamBase& stream ){
 
     SORT_STATS(sScenePrimitiveCount=(StatsInt)GetPrimitiveCount());
     SORT_STATS(sSceneLightCount=(StatsInt)m_lights.size());
-
-    // parse the acceleration structure configuration
-    StringID accelType;
-    stream >> accelType;
-    m_accelerator = MakeUniqueInstance<Accelerator>(accelType);
-    if (m_accelerator)
-        m_accelerator->Serialize(stream);
-
-    if (!m_accelerator) {
-#if SIMD_4WAY_ENABLED
-        slog(WARNING, SPATIAL_ACCELERATOR, "Acceleration structure not supported. Use QBVH instead.");
-        m_accelerator = MakeUniqueInstance<Accelerator>(SID("Qbvh"));
-#else
-        slog(WARNING, SPATIAL_ACCELERATOR, "Acceleration structure not supported. Use BVH instead.");
-        m_accelerator = MakeUniqueInstance<Accelerator>(SID("Bvh"));
-#endif
-    }
-
-    return true;
 }
 
 bool Scene::GetIntersect( RenderContext& rc, const Ray& r , SurfaceInteraction& intersect ) const{
+    SORT_LIVE_STATS(Ray, 1);
+    SORT_PERF_COUNTER_SCOPE(Traversal);
+
     intersect.t = FLT_MAX;
     return m_accelerator->GetIntersect( rc, r , intersect );
 }
 
 #ifndef ENABLE_TRANSPARENT_SHADOW
 bool Scene::IsOccluded(const Ray& r) const{
+    SORT_LIVE_STATS(Ray, 1);
+    SORT_LIVE_STATS(ShadowRay, 1);
+    SORT_PERF_COUNTER_SCOPE(Traversal);
+
     return m_accelerator->IsOccluded(r);
 }
 #else
 Spectrum Scene::GetAttenuation( const Ray& const_ray , RenderContext& rc , MediumStack* ms ) const{
+    SORT_PERF_COUNTER_SCOPE(Traversal);
+
     auto ray = const_ray;
 
     Spectrum attenuation( 1.0f );
     while( !attenuation.IsBlack() ){
+        SORT_LIVE_STATS(Ray, 1);
+        SORT_LIVE_STATS(ShadowRay, 1);
+
         Spectrum att;
         if( !m_accelerator->GetAttenuation(ray, att, rc, ms) )
             break;
@@ -219,19 +289,43 @@ void Scene::RestoreMediumStack( const Point& p , RenderContext& rc, MediumStack&
 }
 
 void Scene::GetIntersect( const Ray& r , BSSRDFIntersections& intersect , RenderContext& rc, const StringID matID ) const{
+    SORT_LIVE_STATS(Ray, 1);
+    SORT_PERF_COUNTER_SCOPE(Traversal);
+
     // no brute force support in BSSRDF
     if(IS_PTR_VALID(m_accelerator))
         m_accelerator->GetIntersect( r , intersect , rc , matID );
 }
 
+void Scene::GetIntersectPacket( const Ray* rays , BSSRDFIntersections* intersects , const unsigned cnt , RenderContext& rc, const StringID matID ) const{
+    SORT_LIVE_STATS(Ray, cnt);
+    SORT_PERF_COUNTER_SCOPE(Traversal);
+
+    // no brute force support in BSSRDF
+    if(IS_PTR_VALID(m_accelerator))
+        m_accelerator->GetIntersectPacket( rays , intersects , cnt , rc , matID );
+}
+
 void Scene::genLightDistribution(){
     unsigned count = (unsigned)m_lights.size();
     if( count == 0 )
         return ;
 
+    // evaluate the power of lights in parallel, mesh lights could easily bring millions of lights in the scene.
     std::unique_ptr<float[]> pdf = std::make_unique<float[]>(count);
-    for( unsigned i = 0 ; i < count ; i++ )
-        pdf[i] = m_lights[i]->Power().GetIntensity();
+    const auto batch_cnt = ( count + LIGHT_POWER_BATCH - 1 ) / LIGHT_POWER_BATCH;
+    WaitGroup power_done(batch_cnt);
+    for( unsigned i = 0 ; i < batch_cnt ; ++i ){
+        // only capture what is needed, a task has no room for more
+        schedule_parallel([this, pdf_data = pdf.get(), &power_done](const unsigned start) {
+            const auto end = std::min( start + LIGHT_POWER_BATCH , (unsigned)m_lights.size() );
+            for( auto j = start ; j < end ; ++j )
+                pdf_data[j] = m_lights[j]->Power().GetIntensity();
+
+            power_done.Done();
+        }, i * LIGHT_POWER_BATCH);
+    }
+    power_done.Wait();
 
     float total_pdf = 0.0f;
     for( unsigned i = 0 ; i < count ; i++ )
@@ -240,7 +334,9 @@ void Scene::genLightDistribution(){
     for( unsigned i = 0 ; i < count ; i++ )
         m_lights[i]->SetPickPDF( pdf[i] / total_pdf );
 
-    m_lightsDis = std::make_unique<Distribution1D>( pdf.get() , count );
+    m_lightsDis = std::make_unique<AliasTable>( pdf.get() , count );
+
+    m_lightTree.Build( m_lights );
 }
 
 const Light* Scene::SampleLight( float u , float* pdf ) const{
@@ -261,6 +357,21 @@ float Scene::LightProperbility( unsigned i ) const{
     return m_lightsDis->GetProperty( i );
 }
 
+const Light* Scene::SampleLight( const Point& p , const Vector& n , float u , float* pdf ) const{
+    sAssert( u >= 0.0f && u <= 1.0f , SAMPLING );
+
+    // fall back to the power based distribution if no light could be organized in the light tree
+    if( m_lightTree.IsEmpty() )
+        return SampleLight( u , pdf );
+    return m_lightTree.Sample( p , n , std::min( u , 0x1.fffffep-1f ) , pdf );
+}
+
+float Scene::LightProperbility( const Point& p , const Vector& n , const Light* light ) const{
+    if( m_lightTree.IsEmpty() )
+        return light->PickPDF();
+    return m_lightTree.Pdf( p , n , light );
+}
+
 Spectrum Scene::Le( const Ray& ray ) const{
     if( m_skyLight ){
         Spectrum r;
@@ -30,6 +30,7 @@
 #include "core/samplemethod.h"
 #include "core/render_context.h"
 #include "accel/accelerator.h"
+#include "light/lighttree.h"
 
 class Light;
 struct BSSRDFIntersections;
@@ -74,9 +75,30 @@ class   Scene{
 public:
     //! @brief Serialize scene from stream.
     //!
-    //! @param  stream      The streaming source where scene information is loaded from.
-    //! @return             Whether the scene is loaded correctly.
-    bool    LoadScene( class IStreamBase& stream );
+    //! @param  stream              The streaming source where scene information is loaded from.
+    //! @param  upgrade_accelerator Whether QBVH, OBVH and HBVH are switched to the widest one the CPU supports. If it is
+    //!                             disabled, the requested one is only switched when the CPU can't run it.
+    //! @param  numa_interleave     Whether memory of entities read from the stream is interleaved across NUMA nodes.
+    //! @return                     Whether the scene is loaded correctly.
+    bool    LoadScene( class IStreamBase& stream , const bool upgrade_accelerator = true , const bool numa_interleave = false );
+
+    //! @brief  Add an entity to the scene.
+    //!
+    //! This is for scenes generated in code instead of being loaded from a stream, SetupScene needs to be
+    //! called once all entities are added.
+    //!
+    //! @param  entity      The entity to be added.
+    void    AddEntity( std::unique_ptr<Entity> entity );
+
+    //! @brief  Populate the scene with entities added through AddEntity.
+    //!
+    //! Unlike LoadScene, the acceleration structure is created with its default configuration and it is exactly
+    //! the requested one. It is up to the caller to make sure the CPU supports it. Same as LoadScene, this needs
+    //! to be called in a task and BuildAccelerationStructure still needs to be called after it.
+    //!
+    //! @param  accelType   Type of the acceleration structure.
+    //! @return             Whether the acceleration structure is supported.
+    bool    SetupScene( const StringID accelType );
 
     //! @brief  Find the first intersection between a ray and the whole scene.
     //!
@@ -128,6 +150,14 @@ public:
     //! @param  matID       We are only interested in intersection with the same material, whose material id should be set to matID.
     void    GetIntersect( const Ray& r , BSSRDFIntersections& intersect , RenderContext& rc, const StringID matID = INVALID_SID ) const;
 
+    //! @brief Get multiple intersections of a packet of rays in one go, this is the packet version of the above interface.
+    //!
+    //! @param  rays        The input rays to be tested.
+    //! @param  intersects  The intersection results, one for each ray.
+    //! @param  cnt         Number of rays in the packet, it can't be larger than SSS_PACKET_MAX_CNT.
+    //! @param  matID       We are only interested in intersection with the same material, whose material id should be set to matID.
+    void    GetIntersectPacket( const Ray* rays , BSSRDFIntersections* intersects , const unsigned cnt , RenderContext& rc, const StringID matID = INVALID_SID ) const;
+
     // get light
     const Light* GetLight( unsigned i ) const{
         sAssert( i < m_lights.size() , LIGHT );
@@ -147,6 +177,26 @@ public:
     const Light* SampleLight( float u , float* pdf ) const;
     // get the properbility of the sample
     float LightProperbility( unsigned i ) const;
+
+    //! @brief  Pick a light source with respect to a shading point.
+    //!
+    //! Unlike the above version, lights are picked with the light tree so that lights that are close to
+    //! the shading point and facing it are more likely to be picked.
+    //!
+    //! @param  p           The shading point.
+    //! @param  n           The normal at the shading point. A zero vector means there is no orientation, like in a medium.
+    //! @param  u           A canonical random number.
+    //! @param  pdf         The probability of picking the returned light.
+    //! @return             The picked light, 'nullptr' if no light is picked.
+    const Light* SampleLight( const Point& p , const Vector& n , float u , float* pdf ) const;
+
+    //! @brief  The probability of picking a light source with respect to a shading point.
+    //!
+    //! @param  p           The shading point.
+    //! @param  n           The normal at the shading point. A zero vector means there is no orientation, like in a medium.
+    //! @param  light       The light source to be evaluated.
+    //! @return             The probability of picking the light source with the point-aware 'SampleLight'.
+    float LightProperbility( const Point& p , const Vector& n , const Light* light ) const;
     // get the number of lights
     unsigned LightNum() const{
         return (unsigned)m_lights.size();
@@ -187,7 +237,10 @@ private:
     Camera*                 m_camera = nullptr;     /**< Camera of the scene. */
 
     /**< distribution of light power */
-    std::unique_ptr<Distribution1D>             m_lightsDis = nullptr;
+    std::unique_ptr<AliasTable>                 m_lightsDis = nullptr;
+
+    /**< light tree for picking lights with respect to a shading point */
+    LightTree                                   m_lightTree;
 
     // bounding box for the scene
     BBox    m_bbox;
@@ -195,6 +248,9 @@ private:
     // compute light cdf
     void    genLightDistribution();
 
+    // fill the scene with its entities once they are all loaded
+    void    populate();
+
     friend class MeshVisual;
     friend class ScenePrimitiveIterator;
     friend class SceneVisualIterator;
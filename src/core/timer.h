@@ -52,6 +52,15 @@ public:
         return (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - m_start).count();
     }
 
+    //! @brief  Get elapsed time in micro second since last time the timer is reset.
+    //!
+    //! This is for evaluating short operations, like rendering a single tile, where milli second is too coarse.
+    //!
+    //! @return Get the elapsed time in micro second since last time the timer is reset.
+    SORT_FORCEINLINE unsigned long long GetElapsedTimeInMicroSecond() const {
+        return (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - m_start).count();
+    }
+
 private:
     std::chrono::time_point<clock>  m_start;        /**< Start point of last time timer is triggered. */
 };
@@ -0,0 +1,183 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <unordered_set>
+#include "trace_profiler.h"
+
+std::atomic<bool>               g_trace_profiler_enabled{false};
+thread_local TraceEventBuffer*  g_trace_event_buffer = nullptr;
+thread_local TraceScope*        g_trace_scope = nullptr;
+thread_local unsigned int       g_trace_task_id = 0;
+thread_local unsigned int       g_trace_thread_id = 0;
+
+// Scopes open on the thread itself while it is executing a task, they are not part of the task.
+static thread_local TraceScope* g_trace_thread_scope = nullptr;
+
+// All event buffers, buffers left by threads that are gone, names of threads and interned strings. They are
+// only touched the first time a thread records an event or a scope with a runtime name starts.
+static std::mutex                                       g_trace_mutex;
+static std::vector<std::unique_ptr<TraceEventBuffer>>   g_trace_buffers;
+static std::vector<TraceEventBuffer*>                   g_trace_free_buffers;
+static std::vector<std::string>                         g_trace_thread_names;
+static std::unordered_set<std::string>                  g_trace_strings;
+
+// Name of the current thread, its buffer is handed over to the next thread recording events once it exits.
+struct TraceThreadState {
+    std::string     name;
+
+    ~TraceThreadState() {
+        if (!g_trace_event_buffer)
+            return;
+
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        g_trace_free_buffers.push_back(g_trace_event_buffer);
+        g_trace_event_buffer = nullptr;
+    }
+};
+static thread_local TraceThreadState g_trace_thread_state;
+
+static const auto g_trace_epoch = std::chrono::steady_clock::now();
+
+unsigned long long TraceProfilerNow() {
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_trace_epoch).count();
+}
+
+void TraceProfilerEnable(const bool enabled) {
+    g_trace_profiler_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+TraceEventBuffer* TraceProfilerAcquireBuffer() {
+    // touching the state of the thread makes sure the buffer is handed over once the thread exits
+    auto& state = g_trace_thread_state;
+
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+
+    // the thread only shows up in the trace once it records an event
+    if (!g_trace_thread_id) {
+        g_trace_thread_names.push_back(state.name.empty() ? "Thread " + std::to_string(g_trace_thread_names.size() + 1) : state.name);
+        g_trace_thread_id = (unsigned int)g_trace_thread_names.size();
+    }
+
+    if (!g_trace_free_buffers.empty()) {
+        auto buffer = g_trace_free_buffers.back();
+        g_trace_free_buffers.pop_back();
+        return buffer;
+    }
+
+    g_trace_buffers.push_back(std::make_unique<TraceEventBuffer>());
+    return g_trace_buffers.back().get();
+}
+
+unsigned int TraceProfilerBufferCount() {
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    return (unsigned int)g_trace_buffers.size();
+}
+
+void TraceProfilerSetThreadName(const std::string& name) {
+    g_trace_thread_state.name = name;
+    if (!g_trace_thread_id)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    g_trace_thread_names[g_trace_thread_id - 1] = name;
+}
+
+void TraceProfilerResumeTask(const unsigned int task, TraceScope* scopes) {
+    g_trace_thread_scope = g_trace_scope;
+    g_trace_scope = scopes;
+    g_trace_task_id = task;
+
+    // scopes of the task start over, the time it spent suspended doesn't belong to them
+    if (scopes) {
+        const auto now = TraceProfilerNow();
+        for (auto scope = scopes; scope; scope = scope->m_parent)
+            scope->m_begin = now;
+    }
+}
+
+TraceScope* TraceProfilerSuspendTask() {
+    const auto scopes = g_trace_scope;
+    if (scopes) {
+        const auto now = TraceProfilerNow();
+        for (auto scope = scopes; scope; scope = scope->m_parent)
+            TraceProfilerRecord(scope->m_name, scope->m_begin, now);
+    }
+
+    g_trace_scope = g_trace_thread_scope;
+    g_trace_thread_scope = nullptr;
+    g_trace_task_id = 0;
+    return scopes;
+}
+
+const char* TraceProfilerIntern(const std::string& str) {
+    // elements in an unordered_set never move, the pointer stays valid after rehashing
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    return g_trace_strings.insert(str).first->c_str();
+}
+
+// Write a string as a JSON string.
+static void writeJsonString(FILE* file, const char* str) {
+    fputc('"', file);
+    for (; *str; ++str) {
+        const auto c = *str;
+        if (c == '"' || c == '\\')
+            fputc('\\', file);
+        if ((unsigned char)c >= 0x20)
+            fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+unsigned int TraceProfilerDump(const char* filename) {
+    auto file = fopen(filename, "w");
+    if (!file)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+
+    // Complete events('X') in micro second, which is what the trace event format expects.
+    auto event_cnt = 0u;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (auto i = 0u; i < g_trace_thread_names.size(); ++i) {
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", event_cnt ? "," : "", i + 1);
+        writeJsonString(file, g_trace_thread_names[i].c_str());
+        fprintf(file, "}}");
+        ++event_cnt;
+    }
+
+    // a buffer may hold events of several threads that used it one after another
+    for (const auto& buffer : g_trace_buffers) {
+        const auto cnt = buffer->cnt.load(std::memory_order_acquire);
+        const auto first = cnt > TRACE_EVENT_BUFFER_SIZE ? cnt - TRACE_EVENT_BUFFER_SIZE : 0;
+        for (auto i = first; i < cnt; ++i) {
+            const auto& event = buffer->events[i & (TRACE_EVENT_BUFFER_SIZE - 1)];
+            fprintf(file, "%s\n{\"name\":", event_cnt ? "," : "");
+            writeJsonString(file, event.name);
+            fprintf(file, ",\"cat\":\"sort\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"task\":%u}}",
+                    event.tid, event.begin / 1000.0, (event.end - event.begin) / 1000.0, event.task);
+            ++event_cnt;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return event_cnt;
+}
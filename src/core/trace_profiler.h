@@ -0,0 +1,158 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include "core/define.h"
+
+//! @brief  Number of events each thread keeps, older events are overwritten once the buffer is full.
+static constexpr unsigned TRACE_EVENT_BUFFER_SIZE = 1u << 16;
+
+//! @brief  A profiled scope that is done.
+struct TraceEvent {
+    const char*         name;       /**< Name of the scope, it is either a string literal or an interned string. */
+    unsigned long long  begin;      /**< Time the scope starts, in nano second since the profiler is loaded. */
+    unsigned long long  end;        /**< Time the scope ends, in nano second since the profiler is loaded. */
+    unsigned int        task;       /**< Id of the task the scope belongs to, 0 if it is not in a task. */
+    unsigned int        tid;        /**< Id of the thread recording the event in the trace. */
+};
+
+//! @brief  Events recorded by a single thread.
+/**
+ * Only the owning thread writes to the buffer, it is a ring buffer without any locks. A buffer is only created
+ * once a thread records its first event. It is handed over to the next thread recording events when its thread
+ * exits, so that threads coming and going don't keep allocating buffers. Events of threads that are gone stay
+ * in the buffer until they are overwritten and can still be dumped.
+ */
+struct TraceEventBuffer {
+    std::unique_ptr<TraceEvent[]>       events = std::make_unique<TraceEvent[]>(TRACE_EVENT_BUFFER_SIZE);
+    std::atomic<unsigned long long>     cnt{0};     /**< Number of events ever recorded, including the overwritten ones. */
+};
+
+class TraceScope;
+
+//! @brief  Enable or disable recording, scopes starting while it is disabled are not recorded.
+void                TraceProfilerEnable(const bool enabled);
+
+//! @brief  Name the current thread in the trace, nothing is allocated until the thread records an event.
+void                TraceProfilerSetThreadName(const std::string& name);
+
+//! @brief  Keep a copy of a string that lives until the end of the program.
+const char*         TraceProfilerIntern(const std::string& str);
+
+//! @brief  Get an event buffer for the current thread, a buffer left by a thread that is gone is reused if there is any.
+TraceEventBuffer*   TraceProfilerAcquireBuffer();
+
+//! @brief  Number of event buffers ever created.
+unsigned int        TraceProfilerBufferCount();
+
+//! @brief  Start or resume executing a task on the current thread.
+//!
+//! Scopes that were open in the task when it got suspended are reopened, the time the task spends suspended
+//! doesn't show up in any of them.
+//!
+//! @param  task        Id of the task.
+//! @param  scopes      Innermost scope open in the task when it got suspended, nullptr for a task that just starts.
+void                TraceProfilerResumeTask(const unsigned int task, TraceScope* scopes);
+
+//! @brief  Stop executing the current task on the thread.
+//!
+//! Scopes still open in the task are recorded as events ending now, so that events of whatever the thread
+//! executes next never partially overlap with them.
+//!
+//! @return             Innermost scope still open in the task, it needs to be passed in when the task resumes.
+TraceScope*         TraceProfilerSuspendTask();
+
+//! @brief  Dump events of all threads as a Chrome trace file, which can be loaded in chrome://tracing or Perfetto.
+//!
+//! This should only be called when no other threads are recording events.
+//!
+//! @param  filename    Name of the file to dump events to.
+//! @return             Number of events dumped.
+unsigned int        TraceProfilerDump(const char* filename);
+
+extern std::atomic<bool>    g_trace_profiler_enabled;
+extern thread_local         TraceEventBuffer* g_trace_event_buffer;
+extern thread_local         TraceScope* g_trace_scope;
+extern thread_local         unsigned int g_trace_task_id;
+extern thread_local         unsigned int g_trace_thread_id;
+
+//! @brief  Whether the profiler is recording.
+SORT_FORCEINLINE bool TraceProfilerIsEnabled() {
+    return g_trace_profiler_enabled.load(std::memory_order_relaxed);
+}
+
+//! @brief  Current time in nano second since the profiler is loaded.
+unsigned long long  TraceProfilerNow();
+
+//! @brief  Set the id of the task executing on the current thread, 0 means no task.
+SORT_FORCEINLINE void TraceProfilerSetTask(const unsigned int task) {
+    g_trace_task_id = task;
+}
+
+//! @brief  Record an event on the current thread.
+SORT_FORCEINLINE void TraceProfilerRecord(const char* name, const unsigned long long begin, const unsigned long long end) {
+    if (UNLIKELY(!g_trace_event_buffer))
+        g_trace_event_buffer = TraceProfilerAcquireBuffer();
+
+    auto& buffer = *g_trace_event_buffer;
+    const auto index = buffer.cnt.load(std::memory_order_relaxed);
+    buffer.events[index & (TRACE_EVENT_BUFFER_SIZE - 1)] = { name, begin, end, g_trace_task_id, g_trace_thread_id };
+    buffer.cnt.store(index + 1, std::memory_order_release);
+}
+
+//! @brief  Scope that is recorded as an event once it ends.
+class TraceScope {
+public:
+    //! @brief  Start a scope named by a string literal.
+    explicit TraceScope(const char* name) {
+        if (UNLIKELY(TraceProfilerIsEnabled()))
+            begin(name);
+    }
+
+    //! @brief  Start a scope with a name that is only known at runtime, the name is interned.
+    explicit TraceScope(const std::string& name) {
+        if (UNLIKELY(TraceProfilerIsEnabled()))
+            begin(TraceProfilerIntern(name));
+    }
+
+    //! @brief  Record the scope if it was started with the profiler enabled.
+    ~TraceScope() {
+        if (UNLIKELY(m_name != nullptr)) {
+            TraceProfilerRecord(m_name, m_begin, TraceProfilerNow());
+            g_trace_scope = m_parent;
+        }
+    }
+
+private:
+    const char*         m_name = nullptr;
+    unsigned long long  m_begin = 0;
+    TraceScope*         m_parent = nullptr;     /**< The scope enclosing this one in the same task or on the same thread. */
+
+    void begin(const char* name) {
+        m_name = name;
+        m_parent = g_trace_scope;
+        g_trace_scope = this;
+        m_begin = TraceProfilerNow();
+    }
+
+    friend void         TraceProfilerResumeTask(const unsigned int task, TraceScope* scopes);
+    friend TraceScope*  TraceProfilerSuspendTask();
+};
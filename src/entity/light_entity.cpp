@@ -21,6 +21,7 @@
 #include "shape/quad.h"
 #include "shape/disk.h"
 #include "core/primitive.h"
+#include "job/scheduler.h"
 
 void PointLightEntity::Serialize( IStreamBase& stream ){
     stream >> m_light->m_light2world;
@@ -74,7 +75,7 @@ SkyLightEntity::SkyLightEntity() {
 void SkyLightEntity::Serialize(IStreamBase& stream) {
     stream >> m_light->m_light2world;
     auto sky_intensity = 1.0f;
-    auto sky_color = Spectrum();
+    auto sky_color = RGBSpectrum();
     stream >> sky_intensity >> sky_color;
     sky_color *= sky_intensity;
 
@@ -156,4 +157,50 @@ void AreaLightEntity::Serialize(IStreamBase& stream) {
 
 void AreaLightEntity::FillScene(class Scene& scene) {
     scene.AddLight(m_light.get());
-}
\ No newline at end of file
+}
+
+// Number of triangle lights set up in one task during scene loading.
+static constexpr unsigned MESH_LIGHT_SETUP_BATCH = 1024;
+
+void MeshLightEntity::Serialize(IStreamBase& stream) {
+    VisualEntity::Serialize(stream);
+
+    auto energy = 0.0f;
+    RGBSpectrum radiance;
+    stream >> energy;
+    stream >> radiance;
+    radiance *= energy;
+
+    // attach a light to each emissive triangle
+    for( auto& visual : m_visuals ){
+        auto mesh = dynamic_cast<MeshVisual*>(visual.get());
+        if( IS_PTR_INVALID(mesh) )
+            continue;
+
+        sAssert( mesh->m_triangles.size() == mesh->GetPrimitiveCount() , LIGHT );
+        for( auto i = 0u ; i < mesh->GetPrimitiveCount() ; ++i ){
+            m_lights.push_back( std::make_unique<TriangleLight>( mesh->m_triangles[i].get() , radiance ) );
+            mesh->GetPrimitive(i)->SetLight( m_lights.back().get() );
+        }
+    }
+}
+
+void MeshLightEntity::FillScene(class Scene& scene) {
+    // cache area and orientation of all triangles in parallel, there could be millions of them in a dense mesh.
+    const auto light_cnt = (unsigned)m_lights.size();
+    const auto batch_cnt = ( light_cnt + MESH_LIGHT_SETUP_BATCH - 1 ) / MESH_LIGHT_SETUP_BATCH;
+    WaitGroup setup_done(batch_cnt);
+    for( auto i = 0u ; i < batch_cnt ; ++i ){
+        schedule_parallel([&](const unsigned start) {
+            const auto end = std::min( start + MESH_LIGHT_SETUP_BATCH , light_cnt );
+            for( auto j = start ; j < end ; ++j )
+                m_lights[j]->Setup();
+
+            setup_done.Done();
+        }, i * MESH_LIGHT_SETUP_BATCH);
+    }
+    setup_done.Wait();
+
+    for( auto& light : m_lights )
+        scene.AddLight(light.get());
+}
@@ -18,11 +18,13 @@
 #pragma once
 
 #include "entity.h"
+#include "visual_entity.h"
 #include "light/pointlight.h"
 #include "light/distant.h"
 #include "light/spot.h"
 #include "light/ambientlight.h"
 #include "light/area.h"
+#include "light/meshlight.h"
 
 //! @brief Light entity definition.
 /**
@@ -148,4 +150,32 @@ public:
 
 protected:
     std::unique_ptr<SkyLight>  m_light = std::make_unique<AmbientLight>();    /**< Light in the entity. */
-};
\ No newline at end of file
+};
+
+//! @brief  Mesh light entity.
+/**
+ * A mesh light entity is a triangle mesh whose triangles all emit light. Each triangle is attached with
+ * a light source so that it can be picked by the integrators as any other light source, instead of only
+ * contributing when hit by chance.
+ */
+class MeshLightEntity : public VisualEntity {
+public:
+    DEFINE_RTTI( MeshLightEntity , Entity );
+
+    //! @brief  Serialization interface. Loading data from stream.
+    //!
+    //! Serialize the entity. Loading from an IStreamBase, which could be coming from file, memory or network.
+    //!
+    //! @param  stream      Input stream for data.
+    void    Serialize(IStreamBase& stream) override;
+
+    //! @brief  Fill the scene with primitives.
+    //!
+    //! Fill the scene with a light source for each emissive triangle.
+    //!
+    //! @param  scene       The scene to be filled.
+    void    FillScene(class Scene& scene) override;
+
+protected:
+    std::vector<std::unique_ptr<TriangleLight>>  m_lights;    /**< Lights of the emissive triangles. */
+};
@@ -23,9 +23,16 @@
 #include "accel/embree.h"
 
 void MeshVisual::Serialize( IStreamBase& stream ){
-    m_memory = std::make_unique<Mesh>();
-    m_memory->Serialize(stream);
+    auto mesh = std::make_unique<Mesh>();
+    mesh->Serialize(stream);
 
+    SetMesh(std::move(mesh));
+}
+
+void MeshVisual::SetMesh( std::unique_ptr<Mesh> mesh ){
+    m_memory = std::move(mesh);
+
+    // triangles keep a reference to their index, the index buffer can't be touched after this.
     for (const auto& mi : m_memory->m_indices){
         m_triangles.push_back( std::make_unique<Triangle>( this , mi ) );
         m_primitives.push_back(std::make_unique<Primitive>(m_memory.get(), mi.m_mat, m_triangles.back().get()));
@@ -53,44 +60,53 @@ void HairVisual::Serialize( IStreamBase& stream ){
         if (UNLIKELY(0u == hair_step))
             continue;
 
-        // There is no guarrantee that the line segements will be the same length.
-        // It is necessary to evaluate the total length of the hair before pushing them into the list to get correct UV and width data.
         std::vector<Point>  point_cache;
-        std::vector<float>  len_cache(hair_step);
         for (auto j = 0u; j <= hair_step; ++j) {
             Point curP;
             stream >> curP;
             point_cache.push_back(curP);
         }
-        for (auto j = 0u; j < point_cache.size() - 1; ++j)
-            len_cache[j] += distance(point_cache[j], point_cache[j + 1]);
 
-        // this means that the data is ill-defined, it shouldn't happen at all.
-        const auto total_length = std::accumulate(len_cache.begin(), len_cache.end(), 0.0f);
-        if (UNLIKELY(total_length <= 0.0f))
-            continue;
+        AddHair(point_cache, width_bottom, width_tip, mat_id);
+    }
+}
 
-        auto prev_v = 0.0f;
-        auto prev_w = width_bottom;
-        auto cur_len = 0.0f;
-        for (auto j = 1u; j <= hair_step; ++j) {
-            cur_len += len_cache[j-1];
+void HairVisual::AddHair( const std::vector<Point>& points , const float width_bottom , const float width_tip , const int mat_id ){
+    if (UNLIKELY(points.size() < 2))
+        return;
+    const auto hair_step = (unsigned)points.size() - 1;
 
-            const auto& prevP = point_cache[j - 1];
-            const auto& curP  = point_cache[j];
+    // There is no guarrantee that the line segements will be the same length.
+    // It is necessary to evaluate the total length of the hair before pushing them into the list to get correct UV and width data.
+    std::vector<float>  len_cache(hair_step);
+    for (auto j = 0u; j < points.size() - 1; ++j)
+        len_cache[j] += distance(points[j], points[j + 1]);
 
-            const auto t = cur_len / total_length;
-            const auto cur_w = slerp(width_bottom, width_tip, t);
-            const auto cur_v = slerp(0.0f, 1.0f, t);
+    // this means that the data is ill-defined, it shouldn't happen at all.
+    const auto total_length = std::accumulate(len_cache.begin(), len_cache.end(), 0.0f);
+    if (UNLIKELY(total_length <= 0.0f))
+        return;
 
-            m_lines.push_back(std::make_unique<Line>(prevP, curP, prev_v, cur_v, prev_w, cur_w, mat_id));
+    auto prev_v = 0.0f;
+    auto prev_w = width_bottom;
+    auto cur_len = 0.0f;
+    for (auto j = 1u; j <= hair_step; ++j) {
+        cur_len += len_cache[j-1];
 
-            auto mat = MatManager::GetSingleton().GetMaterial(m_lines.back()->GetMaterialId());
-            m_primitives.push_back(std::make_unique<Primitive>(nullptr, mat, m_lines.back().get()));
+        const auto& prevP = points[j - 1];
+        const auto& curP  = points[j];
 
-            prev_w = cur_w;
-            prev_v = cur_v;
-        }
+        const auto t = cur_len / total_length;
+        const auto cur_w = slerp(width_bottom, width_tip, t);
+        const auto cur_v = slerp(0.0f, 1.0f, t);
+
+        m_lines.push_back(std::make_unique<Line>(prevP, curP, prev_v, cur_v, prev_w, cur_w, mat_id));
+
+        auto mat = MatManager::GetSingleton().GetMaterial(m_lines.back()->GetMaterialId());
+        m_primitives.push_back(std::make_unique<Primitive>(nullptr, mat, m_lines.back().get()));
+
+        prev_w = cur_w;
+        prev_v = cur_v;
     }
 }
 
@@ -47,6 +47,14 @@ public:
         return (unsigned)m_primitives.size();
     }
 
+    //! @brief  Get a primitive in this visual
+    //!
+    //! @param  i           Index of the primitive.
+    //! @return             The primitive.
+    Primitive*          GetPrimitive( unsigned i ) const{
+        return m_primitives[i].get();
+    }
+
     #if INTEL_EMBREE_ENABLED
         //! @brief  Process embree data.
         virtual void BuildEmbreeGeometry(RTCDevice device, Embree& embree) const;
@@ -75,6 +83,11 @@ public:
     //! @param  stream      Input stream for data.
     void        Serialize( IStreamBase& stream ) override;
 
+    //! @brief  Set the triangle mesh of the visual, one primitive is created for each triangle.
+    //!
+    //! @param  mesh        The mesh in local space, its index buffer shouldn't be touched afterwards.
+    void        SetMesh( std::unique_ptr<Mesh> mesh );
+
     //! @brief  Some visual will apply transformation earlier for better performance.
     //!
     //! @param  transform   The transform of the visual to be applied.
@@ -112,6 +125,14 @@ public:
     //! @param  stream      Input stream for data.
     void        Serialize( IStreamBase& stream ) override;
 
+    //! @brief  Add a strand of hair, it is split into one line per segment.
+    //!
+    //! @param  points          Points along the strand from its root to its tip, there needs to be at least two of them.
+    //! @param  width_bottom    Width of the strand at its root.
+    //! @param  width_tip       Width of the strand at its tip.
+    //! @param  mat_id          Id of the material of the strand.
+    void        AddHair( const std::vector<Point>& points , const float width_bottom , const float width_tip , const int mat_id );
+
     //! @brief  Some visual will apply transformation earlier for better performance.
     //!
     //! @param  transform   The transform of the visual to be applied.
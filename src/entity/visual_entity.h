@@ -47,10 +47,24 @@ public:
             auto visual = MakeUniqueInstance<Visual>( class_name );
             visual->Serialize( stream );
 
-            // Apply transform, some Visual applies transformation eariler for better performance.
-            visual->ApplyTransform( m_transform );
-
-            m_visuals.push_back( std::move(visual) );
+            AddVisual( std::move(visual) );
         }
     }
+
+    //! @brief  Set the transform of the entity, it only affects visuals added after it.
+    //!
+    //! @param  transform   Transform from local space to world space.
+    void    SetTransform( const Transform& transform ){
+        m_transform = transform;
+    }
+
+    //! @brief  Attach a visual to the entity, this is also how visuals generated in code get into the entity.
+    //!
+    //! @param  visual      The visual to be attached.
+    void    AddVisual( std::unique_ptr<Visual> visual ){
+        // Apply transform, some Visual applies transformation eariler for better performance.
+        visual->ApplyTransform( m_transform );
+
+        m_visuals.push_back( std::move(visual) );
+    }
 };
\ No newline at end of file
@@ -74,6 +74,10 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
         vcm /= MIS( cosIn );
         vc /= MIS( cosIn );
 
+        // the light sample connected from this vertex is picked with respect to the vertex, not with the light power
+        if( light_path.empty() )
+            vcm *= MIS( scene.LightProperbility( vert.inter.intersect , vert.inter.normal , light ) / pdf );
+
         rr = 1.0f;
         if (throughput.GetIntensity() < 0.01f)
             rr = 0.5f;
@@ -132,6 +136,8 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
     vc = 0.0f;
     vcm = MIS(total_pixel / ray.m_fPdfW);
     rr = 1.0f;
+    Point   prev_p;
+    Vector  prev_n;
     while (light_path_len <= (int)max_recursive_depth){
         SORT_STATS(++sTotalLengthPathFromEye);
 
@@ -144,6 +150,7 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
                     float emissionPdf;
                     float directPdfA;
                     Spectrum _li = light->Le( vert.inter, -wi.m_Dir , &directPdfA , &emissionPdf ) * throughput / light->PickPDF();
+                    directPdfA *= scene.LightProperbility( prev_p , prev_n , light ) / light->PickPDF();
                     const auto weight = (float)(1.0f / (1.0f + MIS(directPdfA) * vcm + MIS(emissionPdf) * vc));
                     li += _li * weight;
                 }
@@ -168,6 +175,7 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
                 float emissionPdf;
                 float directPdfA;
                 Spectrum _li = vert.inter.Le(-wi.m_Dir , &directPdfA , &emissionPdf ) * throughput / pdf;
+                directPdfA *= scene.LightProperbility( prev_p , prev_n , light ) / pdf;
                 li += _li / (float)( 1.0f + MIS( directPdfA ) * vcm + MIS( emissionPdf ) * vc );
             }
             else if( vert.depth == 0 )
@@ -194,7 +202,7 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
 
         //-----------------------------------------------------------------------------------------------------
         // Path evaluation: connect light sample first
-        li += _ConnectLight(vert, light, scene, rc) / pdf;
+        li += _ConnectLight(vert, scene, rc);
 
         //-----------------------------------------------------------------------------------------------------
         // Path evaluation: connect vertices
@@ -202,6 +210,8 @@ Spectrum BidirPathTracing::Li( const Ray& ray , const PixelSample& ps , const Sc
             li += _ConnectVertices( light_path[j] , vert , light , scene , rc);
 
         ++light_path_len;
+        prev_p = vert.p;
+        prev_n = vert.n;
 
         // Russian Roulette
         if (sort_rand<float>(rc) > rr)
@@ -280,10 +290,17 @@ Spectrum BidirPathTracing::_ConnectVertices( const BDPT_Vertex& p0 , const BDPT_
 }
 
 // connect light sample
-Spectrum BidirPathTracing::_ConnectLight(const BDPT_Vertex& eye_vertex , const Light* light , const Scene& scene , RenderContext& rc) const{
+Spectrum BidirPathTracing::_ConnectLight(const BDPT_Vertex& eye_vertex , const Scene& scene , RenderContext& rc) const{
     if( eye_vertex.depth >= max_recursive_depth )
         return 0.0f;
 
+    // pick a light with respect to the eye vertex, other strategies pick the light with its power.
+    float pick_pdf = 0.0f;
+    const auto light = scene.SampleLight( eye_vertex.p , eye_vertex.n , sort_rand<float>(rc) , &pick_pdf );
+    if( IS_PTR_INVALID(light) || 0.0f == pick_pdf )
+        return 0.0f;
+    const double pick_ratio = MIS( light->PickPDF() / pick_pdf );
+
     // drop the light vertex, take a new sample here
     const LightSample sample(rc);
     Vector wi;
@@ -297,7 +314,7 @@ Spectrum BidirPathTracing::_ConnectLight(const BDPT_Vertex& eye_vertex , const L
         return 0.0f;
     
     const auto cosAtEyeVertex = absDot(eye_vertex.n, wi);
-    li *= eye_vertex.throughput * eye_vertex.se->Evaluate_BSDF( eye_vertex.wi , wi ) / directPdfW;
+    li *= eye_vertex.throughput * eye_vertex.se->Evaluate_BSDF( eye_vertex.wi , wi ) / ( directPdfW * pick_pdf );
 
     if (li.IsBlack())
         return 0.0f;
@@ -314,8 +331,8 @@ Spectrum BidirPathTracing::_ConnectLight(const BDPT_Vertex& eye_vertex , const L
     const auto eye_bsdf_pdfw = eye_vertex.se->Pdf_BSDF( eye_vertex.wi , wi ) * eye_vertex.rr;
     const auto eye_bsdf_rev_pdfw = eye_vertex.se->Pdf_BSDF( wi , eye_vertex.wi ) * eye_vertex.rr;
 
-    const double mis0 = light->IsDelta()?0.0f:MIS(eye_bsdf_pdfw / directPdfW);
-    const double mis1 = MIS( cosAtEyeVertex * emissionPdfW / ( cosAtLight * directPdfW ) ) * ( eye_vertex.vcm + eye_vertex.vc * MIS( eye_bsdf_rev_pdfw ) );
+    const double mis0 = light->IsDelta()?0.0f:MIS(eye_bsdf_pdfw / directPdfW) * pick_ratio;
+    const double mis1 = MIS( cosAtEyeVertex * emissionPdfW / ( cosAtLight * directPdfW ) ) * ( eye_vertex.vcm + eye_vertex.vc * MIS( eye_bsdf_rev_pdfw ) ) * pick_ratio;
 
     const auto weight = (float)(1.0f / (mis0 + mis1 + 1.0f));
 
@@ -386,5 +403,5 @@ void BidirPathTracing::_ConnectCamera(const BDPT_Vertex& light_vertex, int len ,
 
     // update image sensor
     if(evaluation)
-        evaluation->UpdateImage(coord , radiance);
+        evaluation->UpdateImage(coord , ToRGBSpectrum(radiance));
 }
@@ -101,8 +101,8 @@ protected:
     // compute G term
     Spectrum    _Gterm( const BDPT_Vertex& p0 , const BDPT_Vertex& p1 ) const;
 
-    // connect light sample
-    Spectrum    _ConnectLight(const BDPT_Vertex& eye_vertex, const Light* light , const Scene& scene , RenderContext& rc) const;
+    // connect light sample, the light is picked with respect to the eye vertex
+    Spectrum    _ConnectLight(const BDPT_Vertex& eye_vertex, const Scene& scene , RenderContext& rc) const;
 
     // connect camera point
     void        _ConnectCamera(const BDPT_Vertex& light_vertex , int len , const Light* light , const Scene& scene , RenderContext& rc ) const;
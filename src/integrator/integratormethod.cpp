@@ -24,12 +24,15 @@
 #include "material/material.h"
 #include "light/light.h"
 #include "medium/phasefunction.h"
+#include "core/perf_counters.h"
 
 SORT_FORCEINLINE float MisFactor( float f, float g ){
     return (f*f) / (f*f + g*g);
 }
 
 Spectrum    EvaluateDirect( const ScatteringEvent& se , const Ray& r , const Scene& scene , const Light* light , const LightSample& ls ,const BsdfSample& bs, RenderContext& rc ){
+    SORT_PERF_COUNTER_SCOPE(LightSampling);
+
     const auto& ip = se.GetInteraction();
     Spectrum radiance;
     Visibility visibility(scene);
@@ -98,6 +101,8 @@ Spectrum    EvaluateDirect( const ScatteringEvent& se , const Ray& r , const Sce
 }
 
 Spectrum    EvaluateDirect(const ScatteringEvent& se, const Ray& r, const Scene& scene, const Light* light, const LightSample& ls, const BsdfSample& bs, const MaterialBase* material , const MediumStack& ms, RenderContext& rc ) {
+    SORT_PERF_COUNTER_SCOPE(LightSampling);
+
     const auto& ip = se.GetInteraction();
     Spectrum radiance;
     Visibility visibility(scene);
@@ -192,6 +197,8 @@ Spectrum    EvaluateDirect(const ScatteringEvent& se, const Ray& r, const Scene&
 }
 
 Spectrum    EvaluateDirect(const Point& ip, const PhaseFunction* ph, const Vector& wo, const Scene& scene, const Light* light, MediumStack ms, RenderContext& rc) {
+    SORT_PERF_COUNTER_SCOPE(LightSampling);
+
     Spectrum radiance;
     Visibility visibility(scene);
     float light_pdf;
@@ -218,10 +225,12 @@ Spectrum    EvaluateDirect(const Point& ip, const PhaseFunction* ph, const Vecto
 
 // This is only used by SSS for now, since it is a smooth BRDF, there is no need to do MIS.
 Spectrum SampleOneLight( const ScatteringEvent& se , const Ray& r, const SurfaceInteraction& inter, const Scene& scene, const MaterialBase* material, const MediumStack& ms, RenderContext& rc) {
-    // Uniformly choose a light, this may not be the optimal solution in case of more lights, need more research in this topic later.
+    SORT_PERF_COUNTER_SCOPE(LightSampling);
+
+    // Pick a light with respect to the shading point.
     float light_pick_pdf = 0.0f;
-    const auto light = scene.SampleLight( sort_rand<float>(rc) , &light_pick_pdf );
-    if(IS_PTR_INVALID(light))
+    const auto light = scene.SampleLight( inter.intersect , inter.normal , sort_rand<float>(rc) , &light_pick_pdf );
+    if(IS_PTR_INVALID(light) || light_pick_pdf == 0.0f)
         return 0.0f;
 
     Spectrum radiance;
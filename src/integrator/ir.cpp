@@ -21,6 +21,8 @@
 #include "core/scene.h"
 #include "light/light.h"
 #include "scatteringevent/scatteringevent.h"
+#include "material/material.h"
+#include "core/render_context.h"
 
 SORT_STATS_DECLARE_COUNTER(sPrimaryRayCount)
 SORT_STATS_DEFINE_COUNTER(sVPLCount)
@@ -28,6 +30,9 @@ SORT_STATS_DEFINE_COUNTER(sVPLCount)
 SORT_STATS_COUNTER("Instant Radiosity", "Primary Ray Count" , sPrimaryRayCount);
 SORT_STATS_COUNTER("Instant Radiosity", "Virtual Point Lights Count" , sVPLCount);
 
+// Maximum number of virtual light sources whose scattering events are evaluated in one batch.
+static constexpr unsigned VPL_SHADING_BATCH_SIZE = 32;
+
 // Preprocess
 void InstantRadiosity::PreProcess( const Scene& scene , RenderContext& rc )
 {
@@ -37,6 +42,11 @@ void InstantRadiosity::PreProcess( const Scene& scene , RenderContext& rc )
 
     for( int k = 0 ; k < m_nLightPathSet ; ++k ){
         for( int i = 0 ; i < m_nLightPaths ; ++i ){
+#ifdef SORT_SPECTRAL_RENDERING
+            // each light path carries its own wavelengths, the power of the virtual lights is kept in RGB
+            SampledWavelengths::SetCurrent(SampledWavelengths::Sample(sort_rand<float>(rc)));
+#endif
+
             // pick a light first
             float light_pick_pdf;
             const Light* light = scene.SampleLight( sort_rand<float>(rc) , &light_pick_pdf );
@@ -57,7 +67,7 @@ void InstantRadiosity::PreProcess( const Scene& scene , RenderContext& rc )
                     break;
 
                 VirtualLightSource ls;
-                ls.power = throughput;
+                ls.power = ToRGBSpectrum(throughput);
                 ls.intersect = intersect;
                 ls.wi = -ray.m_Dir;
                 ls.depth = ++current_depth;
@@ -87,6 +97,11 @@ void InstantRadiosity::PreProcess( const Scene& scene , RenderContext& rc )
             }
         }
 
+        // group virtual light sources by material so that their scattering events can be evaluated in batches later
+        m_pVirtualLightSources[k].sort([](const VirtualLightSource& vls0, const VirtualLightSource& vls1) {
+            return vls0.intersect.primitive->GetMaterial() < vls1.intersect.primitive->GetMaterial();
+        });
+
         SORT_STATS(sVPLCount+=m_pVirtualLightSources[k].size());
     }
 }
@@ -110,60 +125,82 @@ Spectrum InstantRadiosity::_li( const Ray& r , const Scene& scene, RenderContext
 
     // evaluate light path less than two vertices
     Spectrum radiance = ignoreLe?0.0f:ip.Le( -r.m_Dir );
-    unsigned light_num = scene.LightNum();
-    for( unsigned i = 0 ; i < light_num ; ++i ){
-        const auto light = scene.GetLight(i);
-        radiance += EvaluateDirect( r , scene , light , ip , LightSample(rc) , BsdfSample(rc) , rc, true );
-    }
+    float light_pick_pdf = 0.0f;
+    const auto light = scene.SampleLight( ip.intersect , ip.normal , sort_rand<float>(rc) , &light_pick_pdf );
+    if( light_pick_pdf > 0.0f )
+        radiance += EvaluateDirect( r , scene , light , ip , LightSample(rc) , BsdfSample(rc) , rc, true ) / light_pick_pdf;
 
     if( first_intersect_dist )
         *first_intersect_dist = ip.t;
 
     // pick a virtual light source randomly
     const unsigned lps_id = std::min( m_nLightPathSet - 1 , (int)(sort_rand<float>(rc) * m_nLightPathSet) );
-    std::list<VirtualLightSource> vps = m_pVirtualLightSources[lps_id];
+    const std::list<VirtualLightSource>& vps = m_pVirtualLightSources[lps_id];
 
     ScatteringEvent se( ip , SE_EVALUATE_ALL_NO_SSS );
     ip.primitive->GetMaterial()->UpdateScatteringEvent(se, rc);
 
     // evaluate indirect illumination
     Spectrum indirectIllum;
-    std::list<VirtualLightSource>::const_iterator it = vps.begin();
-    while( it != vps.end() ){
-        if( r.m_Depth + it->depth > max_recursive_depth ){
-            ++it;
-            continue;
-        }
+    const VirtualLightSource*   batch_vls[VPL_SHADING_BATCH_SIZE];
+    ScatteringEvent*            batch_se[VPL_SHADING_BATCH_SIZE];
+    const MaterialBase*         batch_material = nullptr;
+    unsigned                    batch_cnt = 0;
+
+    auto evaluate_batch = [&](){
+        if( 0 == batch_cnt )
+            return;
 
-        const auto  delta = ip.intersect - it->intersect.intersect;
-        const auto  sqrLen = delta.SquaredLength();
-        const auto  len = sqrt( sqrLen );
-        const auto  n_delta = delta / len;
+        // virtual light sources are sorted by material, the batch shares the same material.
+        batch_material->UpdateScatteringEvents( batch_se , batch_cnt , rc );
 
-        ScatteringEvent se1( it->intersect , SE_EVALUATE_ALL_NO_SSS );
-        it->intersect.primitive->GetMaterial()->UpdateScatteringEvent(se1, rc);
+        for( auto i = 0u ; i < batch_cnt ; ++i ){
+            const auto& vls = *batch_vls[i];
 
-        const auto    gterm = 1.0f / std::max( m_fMinSqrDist , sqrLen );
-        const auto    f0 = se.Evaluate_BSDF( -r.m_Dir , -n_delta );
-        const auto    f1 = se1.Evaluate_BSDF( n_delta , it->wi );
+            const auto  delta = ip.intersect - vls.intersect.intersect;
+            const auto  sqrLen = delta.SquaredLength();
+            const auto  len = sqrt( sqrLen );
+            const auto  n_delta = delta / len;
 
-        Spectrum    contr = gterm * f0 * f1 * it->power;
-        if( !contr.IsBlack() ){
-            Visibility vis(scene);
-            vis.ray = Ray( it->intersect.intersect , n_delta , 0 , 0.001f , len - 0.001f );
+            const auto    gterm = 1.0f / std::max( m_fMinSqrDist , sqrLen );
+            const auto    f0 = se.Evaluate_BSDF( -r.m_Dir , -n_delta );
+            const auto    f1 = batch_se[i]->Evaluate_BSDF( n_delta , vls.wi );
+
+            Spectrum    contr = gterm * f0 * f1 * vls.power;
+            if( !contr.IsBlack() ){
+                Visibility vis(scene);
+                vis.ray = Ray( vls.intersect.intersect , n_delta , 0 , 0.001f , len - 0.001f );
 
 #ifndef ENABLE_TRANSPARENT_SHADOW
-            if( vis.IsVisible() )
-                indirectIllum += contr;
+                if( vis.IsVisible() )
+                    indirectIllum += contr;
 #else
-            const auto attenuation = vis.GetAttenuation(rc);
-            if( !attenuation.IsBlack() )
-                indirectIllum += contr * attenuation;
+                const auto attenuation = vis.GetAttenuation(rc);
+                if( !attenuation.IsBlack() )
+                    indirectIllum += contr * attenuation;
 #endif
+            }
+        }
+
+        batch_cnt = 0;
+    };
+
+    for( const auto& vls : vps ){
+        if( r.m_Depth + vls.depth > max_recursive_depth )
+            continue;
+
+        const auto material = vls.intersect.primitive->GetMaterial();
+        if( material != batch_material || batch_cnt == VPL_SHADING_BATCH_SIZE ){
+            evaluate_batch();
+            batch_material = material;
         }
 
-        ++it;
+        batch_vls[batch_cnt] = &vls;
+        batch_se[batch_cnt] = SORT_MALLOC(rc.m_memory_arena, ScatteringEvent)( vls.intersect , SE_EVALUATE_ALL_NO_SSS );
+        ++batch_cnt;
     }
+    evaluate_batch();
+
     radiance += indirectIllum / (float)m_nLightPaths;
 
     if( m_fMinDist > 0.0f ){
@@ -24,7 +24,7 @@
 struct VirtualLightSource{
     SurfaceInteraction  intersect;
     Vector              wi;
-    Spectrum            power;
+    RGBSpectrum         power;
     int                 depth;
 };
 
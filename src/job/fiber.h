@@ -15,6 +15,8 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#pragma once
+
 #include <functional>
 #include "core/define.h"
 #include "core/memory.h"
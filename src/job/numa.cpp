@@ -0,0 +1,192 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "numa.h"
+
+#if defined(SORT_IN_WINDOWS)
+    #include <windows.h>
+#elif defined(SORT_IN_LINUX)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
+
+//! @brief  NUMA topology of the machine.
+struct NumaTopology {
+    /**< Logical processors of each node, nodes without any processor are skipped. */
+    std::vector<std::vector<unsigned int>>  processors;
+
+    /**< Index of each node in the OS. */
+    std::vector<unsigned int>               os_index;
+
+    NumaTopology();
+};
+
+#if defined(SORT_IN_LINUX)
+// Parse lists like '0-7,16-23' in sysfs.
+static std::vector<unsigned int> parseList(const std::string& list) {
+    std::vector<unsigned int> ret;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        auto end = list.find(',', pos);
+        if (end == std::string::npos)
+            end = list.size();
+
+        const auto range = list.substr(pos, end - pos);
+        const auto dash = range.find('-');
+        if (!range.empty()) {
+            const auto first = (unsigned int)std::stoul(range.substr(0, dash));
+            const auto last = dash == std::string::npos ? first : (unsigned int)std::stoul(range.substr(dash + 1));
+            for (auto i = first; i <= last; ++i)
+                ret.push_back(i);
+        }
+        pos = end + 1;
+    }
+    return ret;
+}
+#endif
+
+NumaTopology::NumaTopology() {
+#if defined(SORT_IN_LINUX)
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (online.is_open() && std::getline(online, nodes)) {
+        for (const auto node : parseList(nodes)) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!file.is_open() || !std::getline(file, list))
+                continue;
+
+            auto cpus = parseList(list);
+            if (cpus.empty())
+                continue;
+            processors.push_back(std::move(cpus));
+            os_index.push_back(node);
+        }
+    }
+#elif defined(SORT_IN_WINDOWS)
+    ULONG highest_node = 0;
+    if (GetNumaHighestNodeNumber(&highest_node)) {
+        for (auto node = 0u; node <= highest_node; ++node) {
+            GROUP_AFFINITY affinity = {};
+            if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity))
+                continue;
+
+            // processors are flattened across groups of 64
+            std::vector<unsigned int> cpus;
+            for (auto i = 0u; i < 64; ++i) {
+                if (affinity.Mask & (KAFFINITY(1) << i))
+                    cpus.push_back(affinity.Group * 64 + i);
+            }
+            if (cpus.empty())
+                continue;
+            processors.push_back(std::move(cpus));
+            os_index.push_back(node);
+        }
+    }
+#endif
+
+    // machines without NUMA are treated as a single node holding all processors
+    if (processors.empty()) {
+        processors.emplace_back();
+        os_index.push_back(0);
+
+        const auto cnt = std::max(std::thread::hardware_concurrency(), 1u);
+        for (auto i = 0u; i < cnt; ++i)
+            processors.back().push_back(i);
+    }
+}
+
+static const NumaTopology& getTopology() {
+    static const NumaTopology topology;
+    return topology;
+}
+
+static thread_local unsigned int g_current_numa_node = 0;
+
+unsigned int GetNumaNodeCount() {
+    return (unsigned int)getTopology().processors.size();
+}
+
+const std::vector<unsigned int>& GetNumaNodeProcessors(unsigned int node) {
+    const auto& processors = getTopology().processors;
+    return processors[node % processors.size()];
+}
+
+bool PinThreadToNumaNode(unsigned int node) {
+    const auto& cpus = GetNumaNodeProcessors(node);
+    auto ret = false;
+
+#if defined(SORT_IN_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus)
+        CPU_SET(cpu, &set);
+    ret = 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(SORT_IN_WINDOWS)
+    // a thread can only be pinned to one processor group, nodes don't span groups in practice
+    GROUP_AFFINITY affinity = {};
+    affinity.Group = (WORD)(cpus.front() / 64);
+    for (const auto cpu : cpus) {
+        if (cpu / 64 == affinity.Group)
+            affinity.Mask |= KAFFINITY(1) << (cpu % 64);
+    }
+    ret = 0 != SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+#endif
+
+    if (ret)
+        g_current_numa_node = node % GetNumaNodeCount();
+    return ret;
+}
+
+unsigned int GetCurrentNumaNode() {
+    return g_current_numa_node;
+}
+
+#if defined(SORT_IN_LINUX) && defined(SYS_set_mempolicy)
+// Values defined in linux/mempolicy.h, there is no need to depend on libnuma just for them.
+static constexpr int SORT_MPOL_DEFAULT = 0;
+static constexpr int SORT_MPOL_INTERLEAVE = 3;
+#endif
+
+NumaInterleaveScope::NumaInterleaveScope(const bool enabled) {
+    if (!enabled || GetNumaNodeCount() <= 1)
+        return;
+
+#if defined(SORT_IN_LINUX) && defined(SYS_set_mempolicy)
+    const auto& os_index = getTopology().os_index;
+    constexpr auto bits = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(*std::max_element(os_index.begin(), os_index.end()) / bits + 1, 0ul);
+    for (const auto node : os_index)
+        mask[node / bits] |= 1ul << (node % bits);
+    m_enabled = 0 == syscall(SYS_set_mempolicy, SORT_MPOL_INTERLEAVE, mask.data(), (unsigned long)(mask.size() * bits + 1));
+#endif
+}
+
+NumaInterleaveScope::~NumaInterleaveScope() {
+    if (!m_enabled)
+        return;
+
+#if defined(SORT_IN_LINUX) && defined(SYS_set_mempolicy)
+    syscall(SYS_set_mempolicy, SORT_MPOL_DEFAULT, nullptr, 0ul);
+#endif
+}
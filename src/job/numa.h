@@ -0,0 +1,73 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <vector>
+#include "core/define.h"
+
+//! @brief  Number of NUMA nodes available.
+//!
+//! It is always one on platforms without NUMA support or machines with a single node.
+//!
+//! @return     Number of NUMA nodes.
+unsigned int GetNumaNodeCount();
+
+//! @brief  Logical processors belonging to a NUMA node.
+//!
+//! @param  node    Index of the NUMA node.
+//! @return         Indices of the logical processors in the node.
+const std::vector<unsigned int>& GetNumaNodeProcessors(unsigned int node);
+
+//! @brief  Pin the current thread to all processors of a NUMA node.
+//!
+//! Memory pages are committed on the node of the thread touching them first by default on most OS, pinning
+//! threads is the first step to keep memory and the threads accessing them on the same node.
+//!
+//! @param  node    Index of the NUMA node.
+//! @return         Whether the thread is pinned successfully.
+bool PinThreadToNumaNode(unsigned int node);
+
+//! @brief  NUMA node of the current thread.
+//!
+//! @return         The node the current thread is pinned to, zero if it is not pinned.
+unsigned int GetCurrentNumaNode();
+
+//! @brief  Interleave pages first touched by the current thread across all NUMA nodes in the scope.
+/**
+ * Read-only data shared by all threads, like acceleration structures and meshes, is accessed by threads on
+ * all nodes. Instead of replicating it on each node, which multiplies the memory usage and construction time,
+ * its pages are distributed across nodes so that no node bears all the remote accesses.
+ * Only pages touched by the thread are affected, tasks spawned on other threads still follow the default
+ * policy. The policy belongs to the thread instead of the task, the scope must not span anything that yields
+ * or waits in a task, otherwise other tasks picked up by the thread meanwhile allocate with it too. It does
+ * nothing on platforms without memory policy support.
+ */
+class NumaInterleaveScope {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  enabled     Whether the memory policy is changed at all.
+    explicit NumaInterleaveScope(const bool enabled = true);
+
+    //! @brief  Destructor, restore the default memory policy.
+    ~NumaInterleaveScope();
+
+private:
+    /**< Whether the memory policy is changed. */
+    bool    m_enabled = false;
+};
@@ -16,7 +16,9 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include "scheduler.h"
+#include "core/profile.h"
 
 //! @brief  Threaded based data for slave worker context.
 //! 
@@ -34,26 +36,78 @@ struct SlaveWorkerContext {
 
     /**< Thread fiber. */
     Fiber* thread_fiber = nullptr;
+
+    /**< The slave worker running on this thread, nullptr if the thread is not a slave worker. */
+    Scheduler::SlaveWorker* worker = nullptr;
+
+    /**< The task context being executed, nullptr if it is not in a task. */
+    TaskContext*    current_tc = nullptr;
 };
 thread_local SlaveWorkerContext   g_slaveworker_context;
 
+// Number of rounds a slave worker yields for tasks before going to sleep.
+static constexpr unsigned int IDLE_SPIN_CNT = 64;
+// Longest time a slave worker sleeps for tasks, it also covers new tasks that show up right before sleeping.
+static constexpr auto IDLE_SLEEP_TIME = std::chrono::milliseconds(1);
+
+void TaskPool::grow() {
+    m_chunks.push_back(std::make_unique<Task[]>(CHUNK_SIZE));
+
+    auto chunk = m_chunks.back().get();
+    for (auto i = 0u; i < CHUNK_SIZE; ++i) {
+        chunk[i].pool = this;
+        Free(chunk + i, true);
+    }
+}
+
 void Scheduler::SlaveWorker::InitializeSlaveWorker(Scheduler* scheduler) {
+    // Pin the thread before allocating anything so that fiber stacks and task pools stay on its node.
+    if (scheduler->m_config.numa_aware)
+        PinThreadToNumaNode(numa_node);
+
+    SORT_PROFILE_THREAD("Slave Worker " + std::to_string(index));
+
     // The first thing each thread would do is to conver the current thread into a fiber
     thread_fiber = createFiberFromThread();
 
     // Create the back ground fiber that pulls task all the time
     background_fiber = createFiber(scheduler->m_config.slave_fiber_stack_size, 
         [this, scheduler](){
-            while(auto task = scheduler->pullTask()){
-                auto tc = scheduler->acquireTaskContext();
-                tc->task = task.get();
-
+            while(auto tc = scheduler->pullTaskContext(*this)){
                 // switch to the fiber for execution
+                tc->status = TaskContext::TCStatus::Executing;
+                g_slaveworker_context.current_tc = tc;
+                SORT_PROFILE_TASK_RESUME(tc->id, tc->profile_scopes);
                 scheduler->switchToFiber(tc->fiber.get());
-
-                // if the tc is in idle status, release the lock
-                if(tc->status == TaskContext::TCStatus::Idle)
-                    scheduler->m_tc_pool_mutex.unlock();
+                SORT_PROFILE_TASK_SUSPEND(tc->profile_scopes);
+                g_slaveworker_context.current_tc = nullptr;
+
+                // Anything that makes the task context visible to others can only happen here since we are no longer on its fiber.
+                switch(tc->status){
+                case TaskContext::TCStatus::Idle:
+                    {
+                        auto task = tc->task;
+                        tc->task = nullptr;
+                        scheduler->recycleTaskContext(*this, tc);
+
+                        task->Release();
+                        TaskPool::Free(task, task->pool == &task_pool);
+
+                        // everyone quits once all tasks are done
+                        if (--scheduler->m_total_task_cnt == 0)
+                            scheduler->wakeSleepingWorkers(true);
+                    }
+                    break;
+                case TaskContext::TCStatus::Paused:
+                    scheduler->registerWaiter(tc);
+                    break;
+                case TaskContext::TCStatus::Pending:
+                    scheduler->resumeTaskContext(tc);
+                    break;
+                default:
+                    sAssertMsg(false, SCHEDULER, "Task context switched back while executing.");
+                    break;
+                }
             }
             scheduler->switchToFiber(g_slaveworker_context.thread_fiber);
         }
@@ -63,9 +117,13 @@ void Scheduler::SlaveWorker::InitializeSlaveWorker(Scheduler* scheduler) {
     g_slaveworker_context.current_fiber = thread_fiber.get();
     g_slaveworker_context.background_fiber = background_fiber.get();
     g_slaveworker_context.thread_fiber = thread_fiber.get();
+    g_slaveworker_context.worker = this;
 
     // switch to a fiber for tasks
     scheduler->switchToFiber(background_fiber.get());
+
+    // the main thread may enqueue tasks for the next scheduler, they should not go to this worker
+    g_slaveworker_context.worker = nullptr;
 }
 
 SchedulerConfig::SchedulerConfig() {
@@ -75,6 +133,8 @@ SchedulerConfig::SchedulerConfig() {
 
     // By default each slave thread fiber has 4k memory.
     slave_fiber_stack_size = 4 * 1024;
+
+    numa_aware = false;
 }
 
 Scheduler::~Scheduler() {
@@ -96,14 +156,38 @@ void Scheduler::Unbind() {
 }
 
 void Scheduler::Begin() {
-    // Allocate the slave workers
-    m_slaves.resize(m_config.slave_thread_cnt);
+    // Allocate the slave workers, all of them have to be ready before any thread starts stealing.
+    m_slave_cnt = std::max(m_config.slave_thread_cnt, 1u);
+    m_slaves = std::make_unique<SlaveWorker[]>(m_slave_cnt);
+    for (auto i = 0u; i < m_slave_cnt; ++i) {
+        m_slaves[i].scheduler = this;
+        m_slaves[i].index = i;
+        m_slaves[i].rand_state = i * 0x9e3779b9u + 1u;
+    }
+
+    // Spread slave workers across NUMA nodes proportional to the number of processors, consecutive
+    // slave workers are on the same node.
+    m_numa_node_cnt = 1;
+    if (m_config.numa_aware && GetNumaNodeCount() > 1) {
+        std::vector<unsigned int> processor_nodes;
+        for (auto node = 0u; node < GetNumaNodeCount(); ++node)
+            processor_nodes.insert(processor_nodes.end(), GetNumaNodeProcessors(node).size(), node);
+
+        for (auto i = 0u; i < m_slave_cnt; ++i) {
+            m_slaves[i].numa_node = processor_nodes[(size_t)i * processor_nodes.size() / m_slave_cnt];
+            m_numa_node_cnt = std::max(m_numa_node_cnt, m_slaves[i].numa_node + 1);
+        }
+        m_node_queues = std::make_unique<NodeTaskQueue[]>(m_numa_node_cnt);
+    }
 
     // Spawning new thread starting from the second slave worker, the first one is reserved
     // for the main thread, which will be converted to a slave worker as well.
-    for (auto i = 1u; i < m_slaves.size(); ++i) {
+    for (auto i = 1u; i < m_slave_cnt; ++i) {
         m_slaves[i].thread = std::thread([this, i]() {
             m_slaves[i].InitializeSlaveWorker(this);
+
+            if (m_config.slave_thread_shutdown)
+                m_config.slave_thread_shutdown();
         });
     }
 
@@ -112,60 +196,99 @@ void Scheduler::Begin() {
 }
 
 void Scheduler::Stop() {
-    for (auto i = 1u; i < m_slaves.size(); ++i)
+    for (auto i = 1u; i < m_slave_cnt; ++i)
         m_slaves[i].thread.join();
 }
 
-void Scheduler::Enqueue(Task&& task) {
-    std::lock_guard<std::mutex> lock(m_task_mutex);
-    m_pending_task_pool.emplace_back(std::make_unique<Task>(std::move(task)));
+Task* Scheduler::allocateTask() {
+    auto worker = g_slaveworker_context.worker;
+    if (IS_PTR_VALID(worker) && worker->scheduler == this)
+        return worker->task_pool.Allocate();
 
+    std::lock_guard<std::mutex> lock(m_external_task_mutex);
+    return m_external_task_pool.Allocate();
+}
+
+void Scheduler::submitTask(Task* task) {
+    // this has to happen before the task is visible to others, otherwise the counter could drop to zero before it is enqueued
     ++m_total_task_cnt;
-    ++m_total_pending_task;
+
+    auto worker = g_slaveworker_context.worker;
+    if (IS_PTR_VALID(worker) && worker->scheduler == this) {
+        worker->task_queue.Push(task);
+    } else {
+        std::lock_guard<std::mutex> lock(m_external_task_mutex);
+        m_external_tasks.push_back(task);
+        ++m_external_task_cnt;
+    }
+
+    wakeSleepingWorkers(false);
 }
 
-TaskContext* Scheduler::acquireTaskContext() {
-    std::lock_guard<std::mutex> lock(m_tc_pool_mutex);
+void Scheduler::submitTaskToNode(Task* task, unsigned int node) {
+    if (m_numa_node_cnt <= 1) {
+        submitTask(task);
+        return;
+    }
+
+    ++m_total_task_cnt;
+
+    {
+        auto& queue = m_node_queues[node % m_numa_node_cnt];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+        ++queue.task_cnt;
+    }
+
+    wakeSleepingWorkers(false);
+}
+
+Task* Scheduler::popNodeTask(unsigned int node) {
+    auto& queue = m_node_queues[node];
+    if (queue.task_cnt.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return nullptr;
 
-    if (m_idle_tc_pool.empty()) {
+    auto task = queue.tasks.front();
+    queue.tasks.pop_front();
+    --queue.task_cnt;
+    return task;
+}
+
+TaskContext* Scheduler::acquireTaskContext(SlaveWorker& worker) {
+    if (worker.idle_tc_pool.empty()) {
         std::unique_ptr<TaskContext>    tc = std::make_unique<TaskContext>();
         auto tc_ptr = tc.get();
+        tc->scheduler = this;
+        tc->worker = worker.index;
         tc->fiber = createFiber(m_config.slave_fiber_stack_size, [this, tc_ptr](){
             while(true){
-                tc_ptr->status = TaskContext::TCStatus::Executing;
-
-                if(tc_ptr->task->function)
-                    tc_ptr->task->function();
+                (*tc_ptr->task)();
                 
                 // reset the task context state to prevent reuse
                 tc_ptr->status = TaskContext::TCStatus::Idle;
 
-                // Since the task is done, feed task context back to the pool for reuse
-                // before doing that acquire the mutex first.
-                // Note, this can't be done inside recycleTaskContext as the mutex has to
-                // be held after the fiber switch. Otherwise, it is possible that before
-                // the fiber switch happens, some other threads take away this idle 
-                // task context and cause incorrect fiber switch first.
-                Scheduler::GetBound()->m_tc_pool_mutex.lock();
-                Scheduler::GetBound()->recycleTaskContext(tc_ptr);
-
-                // we are done with the task, now return
-                Scheduler::GetBound()->switchToFiber(g_slaveworker_context.background_fiber);
+                // Note, the task context can't be recycled here. Otherwise, it is possible that before
+                // the fiber switch happens, some other fibers take away this idle task context and cause
+                // incorrect fiber switch first. The background fiber will recycle it.
+                switchToFiber(g_slaveworker_context.background_fiber);
             }
         });
 
-        m_tc_pool.push_back(std::move(tc));
-
-        m_idle_tc_pool.push_back(m_tc_pool.back().get());
+        worker.tc_pool.push_back(std::move(tc));
+        worker.idle_tc_pool.push_back(tc_ptr);
     }
 
-    auto ret = m_idle_tc_pool.back();
-    m_idle_tc_pool.pop_back();
+    auto ret = worker.idle_tc_pool.back();
+    worker.idle_tc_pool.pop_back();
     return ret;
 }
 
-void Scheduler::recycleTaskContext(TaskContext* tc){
-    m_idle_tc_pool.push_back(tc);
+void Scheduler::recycleTaskContext(SlaveWorker& worker, TaskContext* tc){
+    worker.idle_tc_pool.push_back(tc);
 }
 
 void Scheduler::switchToFiber(Fiber* fiber) {
@@ -177,15 +300,202 @@ void Scheduler::switchToFiber(Fiber* fiber) {
     switchFiber(source_fiber, fiber);
 }
 
-std::unique_ptr<Task> Scheduler::pullTask() {
-    std::lock_guard<std::mutex> lock(m_task_mutex);
-    if (m_total_task_cnt == 0)
+TaskContext* Scheduler::pullTaskContext(SlaveWorker& worker) {
+    const auto start_task = [&](Task* task) {
+        auto tc = acquireTaskContext(worker);
+        tc->task = task;
+        // ids are unique across slave workers without any synchronization
+        tc->id = ++worker.started_task_cnt * m_slave_cnt + worker.index;
+        return tc;
+    };
+
+    auto idle_cnt = 0u;
+    while (true) {
+        // the most recently enqueued task of its own is the most cache friendly one
+        if (auto task = worker.task_queue.Pop())
+            return start_task(task);
+
+        if (auto tc = popReadyTaskContext(worker))
+            return tc;
+
+        if (auto task = stealTask(worker))
+            return start_task(task);
+
+        // Since a task is counted before it is enqueued and only uncounted after it is done, no more task
+        // will show up once the counter drops to zero, unless a thread other than slave workers enqueues one.
+        if (m_total_task_cnt.load(std::memory_order_acquire) == 0)
+            return nullptr;
+
+        // Some tasks are still running on other slave workers, they may spawn more tasks. Long running tasks
+        // would keep the slave worker spinning, it goes to sleep after a while.
+        if (++idle_cnt < IDLE_SPIN_CNT)
+            std::this_thread::yield();
+        else
+            sleepForTasks();
+    }
+}
+
+void Scheduler::sleepForTasks() {
+    std::unique_lock<std::mutex> lock(m_sleep_mutex);
+    if (m_total_task_cnt.load(std::memory_order_acquire) == 0)
+        return;
+
+    ++m_sleeping_worker_cnt;
+    m_sleep_cv.wait_for(lock, IDLE_SLEEP_TIME);
+    --m_sleeping_worker_cnt;
+}
+
+void Scheduler::wakeSleepingWorkers(const bool all) {
+    if (m_sleeping_worker_cnt.load(std::memory_order_acquire) == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    if (all)
+        m_sleep_cv.notify_all();
+    else
+        m_sleep_cv.notify_one();
+}
+
+TaskContext* Scheduler::popReadyTaskContext(SlaveWorker& worker) {
+    if (worker.ready_tc_cnt.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(worker.ready_tc_mutex);
+    if (worker.ready_tcs.empty())
+        return nullptr;
+
+    auto tc = worker.ready_tcs.front();
+    worker.ready_tcs.pop_front();
+    --worker.ready_tc_cnt;
+    return tc;
+}
+
+void Scheduler::resumeTaskContext(TaskContext* tc) {
+    auto& worker = m_slaves[tc->worker];
+    tc->status = TaskContext::TCStatus::Pending;
+    tc->wait_group = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(worker.ready_tc_mutex);
+        worker.ready_tcs.push_back(tc);
+        ++worker.ready_tc_cnt;
+    }
+
+    // Only the slave worker owning the task context can resume it, there is no telling which one is woken up.
+    // A yielding task is put back by its own slave worker, which is awake already.
+    if (g_slaveworker_context.worker != &worker)
+        wakeSleepingWorkers(true);
+}
+
+void Scheduler::registerWaiter(TaskContext* tc) {
+    auto& wait_group = *tc->wait_group;
+    {
+        std::lock_guard<std::mutex> lock(wait_group.m_mutex);
+        if (wait_group.m_cnt.load(std::memory_order_relaxed) > 0) {
+            wait_group.m_waiters.push_back(tc);
+            return;
+        }
+    }
+
+    // the wait group was done before the task got registered
+    resumeTaskContext(tc);
+}
+
+void Scheduler::waitInTask(WaitGroup& wait_group) {
+    auto tc = g_slaveworker_context.current_tc;
+    tc->wait_group = &wait_group;
+    tc->status = TaskContext::TCStatus::Paused;
+
+    // the background fiber registers the task in the wait group, it will be switched back once the wait group is done
+    switchToFiber(g_slaveworker_context.background_fiber);
+}
+
+void Scheduler::Yield() {
+    auto tc = g_slaveworker_context.current_tc;
+    if (IS_PTR_INVALID(tc)) {
+        std::this_thread::yield();
+        return;
+    }
+
+    tc->status = TaskContext::TCStatus::Pending;
+    tc->scheduler->switchToFiber(g_slaveworker_context.background_fiber);
+}
+
+Task* Scheduler::stealTask(SlaveWorker& worker) {
+    // Start from a random victim so that thieves don't all hit the same slave worker. Victims on the same
+    // NUMA node come first, tasks from other nodes are only taken when the whole node runs out of tasks.
+    worker.rand_state ^= worker.rand_state << 13;
+    worker.rand_state ^= worker.rand_state >> 17;
+    worker.rand_state ^= worker.rand_state << 5;
+    const auto offset = worker.rand_state % m_slave_cnt;
+
+    for (auto local = 1; local >= 0; --local) {
+        for (auto i = 0u; i < m_slave_cnt; ++i) {
+            auto& victim = m_slaves[(offset + i) % m_slave_cnt];
+            if (&victim == &worker || (victim.numa_node == worker.numa_node) != (local == 1) || victim.task_queue.IsEmpty())
+                continue;
+            if (auto task = victim.task_queue.Steal())
+                return task;
+        }
+
+        if (m_numa_node_cnt > 1) {
+            for (auto node = 0u; node < m_numa_node_cnt; ++node) {
+                if ((node == worker.numa_node) != (local == 1))
+                    continue;
+                if (auto task = popNodeTask(node))
+                    return task;
+            }
+        }
+    }
+
+    if (m_external_task_cnt.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_external_task_mutex);
+    if (m_external_tasks.empty())
         return nullptr;
-    --m_total_task_cnt;
 
-    std::unique_ptr<Task> ptr = std::move(m_pending_task_pool.back());
-    auto tt = std::move(m_pending_task_pool.back());
-    m_pending_task_pool.pop_back();
+    // tasks enqueued from outside are executed in order
+    auto task = m_external_tasks.front();
+    m_external_tasks.pop_front();
+    --m_external_task_cnt;
+    return task;
+}
+
+void WaitGroup::Add(unsigned int cnt) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cnt += (int)cnt;
+}
 
-    return std::move(ptr);
-}
\ No newline at end of file
+void WaitGroup::Done() {
+    std::vector<TaskContext*> waiters;
+    {
+        // Everything touching the wait group happens with the lock held, the owner is free to destroy it once
+        // the counter drops to zero and the lock is released.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sAssertMsg(m_cnt > 0, SCHEDULER, "Wait group is done more times than expected.");
+        if (--m_cnt > 0)
+            return;
+
+        waiters.swap(m_waiters);
+        m_cv.notify_all();
+    }
+
+    for (auto tc : waiters)
+        tc->scheduler->resumeTaskContext(tc);
+}
+
+void WaitGroup::Wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_cnt == 0)
+        return;
+
+    auto tc = g_slaveworker_context.current_tc;
+    if (IS_PTR_VALID(tc)) {
+        lock.unlock();
+        tc->scheduler->waitInTask(*this);
+        return;
+    }
+
+    m_cv.wait(lock, [this]() { return m_cnt == 0; });
+}
@@ -15,15 +15,24 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#pragma once
+
 #include <atomic>
 #include <thread>
 #include <memory>
 #include <vector>
-#include <list>
+#include <deque>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <new>
+#include <tuple>
+#include <type_traits>
 #include "core/define.h"
 #include "core/sassert.h"
 #include "fiber.h"
+#include "work_stealing_deque.h"
+#include "numa.h"
 
 //! @brief  Data structure to config the scheduler
 struct SchedulerConfig {
@@ -36,20 +45,128 @@ struct SchedulerConfig {
 
     /* Stack size for regular slave. */
     unsigned int    slave_fiber_stack_size;
+
+    /* Callback right before a slave thread quits, it is not called on the main thread. */
+    std::function<void()>   slave_thread_shutdown;
+
+    /* Pin slave threads to NUMA nodes, the number of slave threads on each node is proportional to
+       its number of processors. Slave workers steal tasks from the same node first. */
+    bool            numa_aware;
 };
 
 //! @brief  Task
-struct Task {
-    using Function = std::function<void()>;
+/**
+ * Tasks are fixed size objects recycled through task pools, the function to execute is stored
+ * in place. Unlike std::function, there is no heap allocation no matter what the function is,
+ * functions that don't fit in the storage are rejected during compilation. A task occupies
+ * exactly one cache line so that two tasks never share one.
+ */
+class TaskPool;
+struct alignas(64) Task {
+    /**< Size of the storage of the function, the rest of the cache line is for the function pointers and the pool.
+         The storage is 16 bytes aligned, its size is rounded down to a multiple of 16 so that the union isn't padded. */
+    static constexpr unsigned int STORAGE_SIZE = (64 - 3 * sizeof(void*)) & ~15u;
+
+    union {
+        /**< Storage of the function object. */
+        alignas(16) unsigned char   storage[STORAGE_SIZE];
+
+        /**< Next task in the pool, this is only valid when the task is not in use. */
+        Task*                       next;
+    };
 
-    SORT_FORCEINLINE Task() : function(nullptr) {}
-    SORT_FORCEINLINE Task(const Function& function) : function(function) {}
-    SORT_FORCEINLINE Task(Function&& function) : function(std::move(function)) {}
+    /**< Invoke the function stored in the task. */
+    void (*invoke)(void*) = nullptr;
+
+    /**< Destroy the function stored in the task. */
+    void (*destroy)(void*) = nullptr;
+
+    /**< The pool the task is allocated from, it is fed back to the same pool once it is done. */
+    TaskPool*   pool = nullptr;
+
+    SORT_FORCEINLINE Task() : next(nullptr) {}
+
+    //! @brief  Store a function in the task.
+    //!
+    //! @param  function    The function to be executed by the task.
+    template<typename Function>
+    SORT_FORCEINLINE void Bind(Function&& function) {
+        using Func = typename std::decay<Function>::type;
+        static_assert(sizeof(Func) <= STORAGE_SIZE, "Function is too large for a task, capture a pointer to the data instead.");
+        static_assert(alignof(Func) <= 16, "Function alignment is not supported by task.");
+
+        new (storage) Func(std::forward<Function>(function));
+        invoke = [](void* p) { (*reinterpret_cast<Func*>(p))(); };
+        destroy = [](void* p) { reinterpret_cast<Func*>(p)->~Func(); };
+    }
 
-    SORT_FORCEINLINE void operator()() const { function(); }
+    //! @brief  Execute the task.
+    SORT_FORCEINLINE void operator()() { invoke(storage); }
 
-    /**< Target function. */
-    Function   function;
+    //! @brief  Destroy the function stored in the task so that the task can be recycled.
+    SORT_FORCEINLINE void Release() {
+        destroy(storage);
+        invoke = nullptr;
+        destroy = nullptr;
+    }
+};
+
+static_assert(sizeof(Task) == 64, "A task should occupy exactly one cache line.");
+
+//! @brief  Pool of tasks.
+/**
+ * Tasks are allocated in chunks and recycled through an intrusive free list, which only the thread
+ * owning the pool touches. Tasks are often finished by other slave workers, those are fed back through
+ * a lock free list and taken back in one go once the pool runs out of free tasks. This way tasks always
+ * return to the pool they come from, a slave worker spawning tasks that others finish doesn't keep
+ * allocating new chunks.
+ */
+class TaskPool {
+public:
+    //! @brief  Allocate a task from the pool, it can only be called by the thread owning the pool.
+    SORT_FORCEINLINE Task* Allocate() {
+        if (IS_PTR_INVALID(m_free)) {
+            m_free = m_remote_free.exchange(nullptr, std::memory_order_acquire);
+            if (IS_PTR_INVALID(m_free))
+                grow();
+        }
+        auto task = m_free;
+        m_free = task->next;
+        return task;
+    }
+
+    //! @brief  Feed a task back to its pool.
+    //!
+    //! @param  task        The task to recycle.
+    //! @param  owner       Whether the current thread owns the pool of the task.
+    static SORT_FORCEINLINE void Free(Task* task, const bool owner) {
+        auto pool = task->pool;
+        if (owner) {
+            task->next = pool->m_free;
+            pool->m_free = task;
+            return;
+        }
+
+        // The list is only ever taken as a whole by the owner, there is no ABA problem with pushing like this.
+        task->next = pool->m_remote_free.load(std::memory_order_relaxed);
+        while (!pool->m_remote_free.compare_exchange_weak(task->next, task, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    /**< Number of tasks allocated each time the pool is empty. */
+    static constexpr unsigned int CHUNK_SIZE = 256;
+
+    /**< Chunks of tasks, for keeping their life time. */
+    std::vector<std::unique_ptr<Task[]>>    m_chunks;
+
+    /**< The first free task. */
+    Task*                                   m_free = nullptr;
+
+    /**< The first task fed back by threads other than the owner. */
+    std::atomic<Task*>                      m_remote_free = nullptr;
+
+    //! @brief  Allocate a new chunk of tasks.
+    void    grow();
 };
 
 //! @brief TaskContext is the place that task runs on.
@@ -62,11 +179,14 @@ struct Task {
  * Task context is reused once a task is done executing and the context can be 
  * shared with a next task that the scheduler picks up.
  */
+class Scheduler;
+class WaitGroup;
+class TraceScope;
 struct TaskContext {
     /**< The fiber the task will run on. */
     std::unique_ptr<Fiber>  fiber;
 
-    /**< Status of the context. */
+    /**< Status of the context. Pending means it is ready to be resumed, Paused means it is waiting for a wait group. */
     enum class TCStatus : unsigned char {
         Idle,
         Executing,
@@ -76,7 +196,62 @@ struct TaskContext {
     TCStatus status = TCStatus::Idle;
 
     /**< The task the context will be executing. */
-    const Task* task = nullptr;
+    Task*   task = nullptr;
+
+    /**< The wait group the task is waiting for, only valid when it is paused. */
+    WaitGroup*  wait_group = nullptr;
+
+    /**< The scheduler owning the context. */
+    Scheduler*  scheduler = nullptr;
+
+    /**< Index of the slave worker owning the context, a paused task is always resumed on the same slave worker. */
+    unsigned int    worker = 0;
+
+    /**< Id of the task being executed, it is only for profiling. */
+    unsigned int    id = 0;
+
+    /**< Innermost profiling scope open in the task when it got suspended, it is only for profiling. */
+    TraceScope*     profile_scopes = nullptr;
+};
+
+//! @brief  Counter that tasks or threads can wait for.
+/**
+ * Waiting in a task doesn't block the thread. The fiber of the task is paused and the slave worker
+ * picks up other tasks in the meantime. The task resumes on the same slave worker once the counter
+ * drops to zero. Waiting on a thread other than slave workers simply blocks the thread.
+ */
+class WaitGroup {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  cnt     Initial value of the counter.
+    explicit WaitGroup(unsigned int cnt = 0) : m_cnt((int)cnt) {}
+
+    //! @brief  Increase the counter.
+    void    Add(unsigned int cnt = 1);
+
+    //! @brief  Decrease the counter by one, waiting tasks and threads resume when it drops to zero.
+    void    Done();
+
+    //! @brief  Wait until the counter drops to zero.
+    void    Wait();
+
+    //! @brief  Whether the counter is zero already.
+    bool    IsDone() const {
+        return m_cnt.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    /**< The counter, it is only modified with the mutex held. */
+    std::atomic<int>            m_cnt;
+    /**< Mutex to guard the counter and the waiting tasks. */
+    std::mutex                  m_mutex;
+    /**< Condition variable for threads other than slave workers to wait. */
+    std::condition_variable     m_cv;
+    /**< Tasks waiting for the counter. */
+    std::vector<TaskContext*>   m_waiters;
+
+    friend class Scheduler;
 };
 
 //! @brief  Scheduler of the job system in SORT
@@ -126,7 +301,43 @@ public:
     void Stop();
 
     //! @brief  Enqueue a task
-    void Enqueue(Task&& task);
+    //!
+    //! A task enqueued in a task goes to the deque of the current slave worker, other slave workers
+    //! can steal it when they run out of tasks. Tasks enqueued by other threads go to a shared queue.
+    //!
+    //! @param  function    The function to be executed by the task.
+    template<typename Function>
+    SORT_FORCEINLINE void Enqueue(Function&& function) {
+        auto task = allocateTask();
+        task->Bind(std::forward<Function>(function));
+        submitTask(task);
+    }
+
+    //! @brief  Enqueue a task preferably executed on a NUMA node.
+    //!
+    //! Slave workers on the node pick it up before stealing tasks from other nodes. Slave workers on other
+    //! nodes only take it when there is nothing else to do. It is the same as Enqueue if the scheduler is
+    //! not NUMA aware.
+    //!
+    //! @param  node        The NUMA node the task should be executed on.
+    //! @param  function    The function to be executed by the task.
+    template<typename Function>
+    SORT_FORCEINLINE void EnqueueOnNode(unsigned int node, Function&& function) {
+        auto task = allocateTask();
+        task->Bind(std::forward<Function>(function));
+        submitTaskToNode(task, node);
+    }
+
+    //! @brief  Number of NUMA nodes the slave workers are spread across, it is one if the scheduler is not NUMA aware.
+    unsigned int GetActiveNumaNodeCount() const {
+        return m_numa_node_cnt;
+    }
+
+    //! @brief  Yield the current task so that other tasks can run on the slave worker.
+    //!
+    //! The task is resumed once the slave worker runs out of its own tasks. It simply yields the thread
+    //! if it is not called in a task.
+    static void Yield();
 
     //! @brief  Get the currently bound scheduler
     static Scheduler* GetBound() {
@@ -151,6 +362,37 @@ public:
         /**< Dedicated thread for this slaveworker. */
         std::thread             thread;
 
+        /**< Tasks enqueued by this slave worker, other slave workers steal tasks from its top. */
+        WorkStealingDeque<Task> task_queue;
+
+        /**< Tasks allocated or recycled by this slave worker. */
+        TaskPool                task_pool;
+
+        /**< Task context pool for keeping its life time. */
+        std::vector<std::unique_ptr<TaskContext>>   tc_pool;
+
+        /**< Available task contexts. Only the slave worker itself touches it, there is no need for a lock. */
+        std::vector<TaskContext*>                   idle_tc_pool;
+
+        /**< Task contexts ready to be resumed on this slave worker. */
+        std::deque<TaskContext*>                    ready_tcs;
+        /**< Number of ready task contexts, this avoids taking the lock when there is none. */
+        std::atomic<int>                            ready_tc_cnt = 0;
+        /**< Mutex to guard the ready task contexts, other slave workers may resume tasks here. */
+        std::mutex                                  ready_tc_mutex;
+
+        /**< Index of the slave worker. */
+        unsigned int            index = 0;
+
+        /**< NUMA node of the slave worker, it is always zero if the scheduler is not NUMA aware. */
+        unsigned int            numa_node = 0;
+
+        /**< State of the random number generator for picking victims to steal tasks from. */
+        unsigned int            rand_state = 0;
+
+        /**< Number of tasks started on this slave worker, it is for generating task ids. */
+        unsigned int            started_task_cnt = 0;
+
         //! @brief  Initialize the slave worker.
         void InitializeSlaveWorker(Scheduler* scheduler);
     };
@@ -159,25 +401,41 @@ private:
     /**< A copy of the configuration of the current fiber. */
     SchedulerConfig                     m_config;
 
-    /**< Slave workers. */
-    std::vector<SlaveWorker>            m_slaves;
-
-    /**< Task context pool for keeping its life time. */
-    std::list<std::unique_ptr<TaskContext>> m_tc_pool;
-
-    /**< Available task context pool. */
-    std::list<TaskContext*>             m_idle_tc_pool;
-    /**< Mutex to guard fiber pool. */
-    std::mutex                          m_tc_pool_mutex;
+    /**< Slave workers, they are not movable because of the deques. */
+    std::unique_ptr<SlaveWorker[]>      m_slaves;
+    /**< Number of slave workers. */
+    unsigned int                        m_slave_cnt = 0;
+
+    /**< Tasks enqueued by threads other than slave workers. */
+    std::deque<Task*>                   m_external_tasks;
+    /**< Pool of tasks enqueued by threads other than slave workers. */
+    TaskPool                            m_external_task_pool;
+    /**< Number of tasks in the external queue, this avoids taking the lock when it is empty. */
+    std::atomic<int>                    m_external_task_cnt = 0;
+    /**< Mutex to guard the external queue and its pool. */
+    std::mutex                          m_external_task_mutex;
+
+    //! @brief  Tasks preferably executed on one NUMA node.
+    struct NodeTaskQueue {
+        std::deque<Task*>       tasks;              /**< Tasks to be executed on the node. */
+        std::atomic<int>        task_cnt = 0;       /**< Number of tasks, this avoids taking the lock when it is empty. */
+        std::mutex              mutex;              /**< Mutex to guard the tasks. */
+    };
 
-    /**< Task pool. */
-    std::list<std::unique_ptr<Task>>    m_pending_task_pool;
-    /**< Mutex to guard task pool. */
-    std::mutex                          m_task_mutex;
+    /**< Task queues of all NUMA nodes, it is only allocated if the scheduler is NUMA aware. */
+    std::unique_ptr<NodeTaskQueue[]>    m_node_queues;
+    /**< Number of NUMA nodes with slave workers. */
+    unsigned int                        m_numa_node_cnt = 1;
 
-    /**< Task number. */
+    /**< Number of tasks enqueued but not finished yet. Slave workers quit when it drops to zero. */
     std::atomic<int>                    m_total_task_cnt = 0;
-    std::atomic<int>                    m_total_pending_task = 0;
+
+    /**< Number of slave workers sleeping for tasks, this avoids taking the lock when nobody sleeps. */
+    std::atomic<int>                    m_sleeping_worker_cnt = 0;
+    /**< Mutex for slave workers to sleep on. */
+    std::mutex                          m_sleep_mutex;
+    /**< Condition variable to wake up sleeping slave workers. */
+    std::condition_variable             m_sleep_cv;
 
     /**< IO thread. */
     std::thread                         m_io_thread;
@@ -185,24 +443,77 @@ private:
     /**< The currently bound scheduler. */
     inline static Scheduler*            s_bound_scheduler = nullptr;
 
+    friend class WaitGroup;
+
     //! @brief      Helper function to acquire a task context.
-    TaskContext*    acquireTaskContext();
+    TaskContext*    acquireTaskContext(SlaveWorker& worker);
 
-    //! @brief      Recycle task context, this is not guarded by mutex, the caller should do it
-    void            recycleTaskContext(TaskContext* tc);
+    //! @brief      Recycle task context, it has to be called after switching away from the fiber of the task context.
+    void            recycleTaskContext(SlaveWorker& worker, TaskContext* tc);
 
     //! @brief      Helper function to switch to a new fiber
     void            switchToFiber(Fiber* fiber);
 
-    //! @brief      Pop a task that is pending
-    std::unique_ptr<Task>   pullTask();
+    //! @brief      Allocate a task from the pool of the current thread.
+    Task*           allocateTask();
+
+    //! @brief      Push a task in the deque of the current slave worker or the external queue.
+    void            submitTask(Task* task);
+
+    //! @brief      Push a task in the queue of a NUMA node.
+    void            submitTaskToNode(Task* task, unsigned int node);
+
+    //! @brief      Pop a task from the queue of a NUMA node.
+    Task*           popNodeTask(unsigned int node);
+
+    //! @brief      Pick the next task context to execute.
+    //!
+    //! A new task from the worker's own deque comes first, then paused tasks that are ready to resume. Tasks
+    //! are stolen from others if there is nothing else to do.
+    //!
+    //! @return     nullptr if all tasks are done.
+    TaskContext*    pullTaskContext(SlaveWorker& worker);
+
+    //! @brief      Pop a task context that is ready to resume on the slave worker.
+    TaskContext*    popReadyTaskContext(SlaveWorker& worker);
+
+    //! @brief      Mark a paused task context ready to resume on the slave worker owning it.
+    void            resumeTaskContext(TaskContext* tc);
+
+    //! @brief      Register a task context paused in a wait group, it has to be called after switching away from its fiber.
+    void            registerWaiter(TaskContext* tc);
+
+    //! @brief      Pause the current task until the wait group is done.
+    void            waitInTask(WaitGroup& wait_group);
+
+    //! @brief      Try stealing a task from other slave workers or the external queue.
+    Task*           stealTask(SlaveWorker& worker);
+
+    //! @brief      Sleep until there may be new tasks or all tasks are done, the sleep is short anyway.
+    void            sleepForTasks();
+
+    //! @brief      Wake up slave workers sleeping for tasks.
+    //!
+    //! @param      all     Whether to wake up all of them, otherwise only one of them is woken up.
+    void            wakeSleepingWorkers(const bool all);
 };
 
 //! @brief  Schedule a task in the job system
 template <typename Function, typename... Args>
 SORT_FORCEINLINE void schedule_parallel(Function&& f, Args&&... args) {
     Scheduler::GetBound()->Enqueue(
-        Task(std::bind(std::forward<Function>(f), 
-                       std::forward<Args>(args)...))
+        [f = std::forward<Function>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            std::apply(f, args);
+        }
+    );
+}
+
+//! @brief  Schedule a task in the job system, which is preferably executed on a NUMA node
+template <typename Function, typename... Args>
+SORT_FORCEINLINE void schedule_on_node(unsigned int node, Function&& f, Args&&... args) {
+    Scheduler::GetBound()->EnqueueOnNode(node,
+        [f = std::forward<Function>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            std::apply(f, args);
+        }
     );
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "task_graph.h"
+#include "core/profile.h"
+
+TaskGraph::Node TaskGraph::AddTask(std::function<void()> function, const std::string& name) {
+    sAssertMsg(m_done.IsDone(), SCHEDULER, "Can't change a task graph while it is running.");
+
+    auto node = std::make_unique<TaskNode>();
+    node->function = std::move(function);
+    node->name = name;
+    m_nodes.push_back(std::move(node));
+    return (Node)(m_nodes.size() - 1);
+}
+
+void TaskGraph::Precede(const Node before, const Node after) {
+    sAssertMsg(m_done.IsDone(), SCHEDULER, "Can't change a task graph while it is running.");
+    sAssert(before < m_nodes.size() && after < m_nodes.size() && before != after, SCHEDULER);
+
+    m_nodes[before]->successors.push_back(after);
+    ++m_nodes[after]->dependency_cnt;
+}
+
+void TaskGraph::Run() {
+    sAssertMsg(m_done.IsDone(), SCHEDULER, "The task graph is running already.");
+    if (m_nodes.empty())
+        return;
+
+    m_done.Add((unsigned int)m_nodes.size());
+    for (auto& node : m_nodes)
+        node->pending_cnt = (int)node->dependency_cnt;
+
+    // the roots have to be collected before enqueuing any of them, the counters may change once a task starts
+    std::vector<Node> roots;
+    for (auto i = 0u; i < m_nodes.size(); ++i) {
+        if (m_nodes[i]->dependency_cnt == 0)
+            roots.push_back(i);
+    }
+    sAssertMsg(!roots.empty(), SCHEDULER, "There is a cycle in the task graph.");
+
+    for (const auto node : roots)
+        schedule_parallel([this](const Node node) { execute(node); }, node);
+}
+
+void TaskGraph::Wait() {
+    m_done.Wait();
+}
+
+void TaskGraph::execute(const Node node) {
+    auto& task = *m_nodes[node];
+    if (task.function) {
+        SORT_PROFILE(task.name);
+        task.function();
+    }
+
+    for (const auto successor : task.successors) {
+        if (--m_nodes[successor]->pending_cnt == 0)
+            schedule_parallel([this](const Node node) { execute(node); }, successor);
+    }
+
+    m_done.Done();
+}
@@ -0,0 +1,92 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "scheduler.h"
+
+//! @brief  A graph of tasks with dependencies between them.
+/**
+ * A task in the graph is only enqueued once all tasks it depends on are done, there is no thread or
+ * fiber blocked in the meantime. Independent branches of the graph run in parallel without any extra
+ * effort, which is the whole point of expressing things as a graph instead of waiting at each step.
+ * Tasks in the graph are allowed to spawn more tasks and wait for them with a wait group.
+ *
+ * Unlike the tasks enqueued in the scheduler, which are meant to be tiny, nodes in the graph are
+ * relatively heavy and few, std::function is good enough for them.
+ */
+class TaskGraph {
+public:
+    /**< Handle of a task in the graph. */
+    using Node = unsigned int;
+
+    //! @brief  Add a task in the graph.
+    //!
+    //! @param  function    The function to be executed.
+    //! @param  name        Name of the task, mainly for debugging purpose.
+    //! @return             Handle of the task.
+    Node    AddTask(std::function<void()> function, const std::string& name = "");
+
+    //! @brief  Make sure one task is done before the other one starts.
+    //!
+    //! @param  before      The task to be done first.
+    //! @param  after       The task depending on the first one.
+    void    Precede(const Node before, const Node after);
+
+    //! @brief  Enqueue all tasks without any dependency in the bound scheduler.
+    //!
+    //! The rest tasks are enqueued once all of their dependencies are done. The graph can't be changed
+    //! until all tasks are done.
+    void    Run();
+
+    //! @brief  Wait for all tasks in the graph to be done.
+    void    Wait();
+
+    //! @brief  Whether all tasks in the graph are done.
+    bool    IsDone() const {
+        return m_done.IsDone();
+    }
+
+    //! @brief  Get the name of a task.
+    const std::string& GetName(const Node node) const {
+        return m_nodes[node]->name;
+    }
+
+private:
+    //! @brief  Task in the graph.
+    struct TaskNode {
+        std::function<void()>   function;           /**< The function to be executed. */
+        std::string             name;               /**< Name of the task. */
+        std::vector<Node>       successors;         /**< Tasks depending on this one. */
+        unsigned int            dependency_cnt = 0; /**< Number of tasks this one depends on. */
+        std::atomic<int>        pending_cnt = 0;    /**< Number of dependencies not done yet during execution. */
+    };
+
+    /**< All tasks in the graph. */
+    std::vector<std::unique_ptr<TaskNode>>  m_nodes;
+
+    /**< Wait group for all tasks in the graph. */
+    WaitGroup                               m_done;
+
+    //! @brief  Execute a task and enqueue the tasks depending on it if they are ready.
+    void    execute(const Node node);
+};
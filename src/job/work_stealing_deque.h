@@ -0,0 +1,148 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "core/define.h"
+
+//! @brief  Lock-free work stealing deque.
+/**
+ * Correct and Efficient Work-Stealing for Weak Memory Models
+ * https://fzn.fr/readings/ppopp13.pdf
+ *
+ * Only the owner thread of the deque is allowed to push and pop elements, which happens at the bottom
+ * of the deque in a LIFO manner so that the most recently spawned task, whose data is likely still in
+ * cache, runs first. Any other thread can steal elements from the top of the deque. An owner thread
+ * only competes with thieves when there is exactly one element left, which makes the common path free
+ * of atomic read-modify-write operations.
+ * The buffer grows when it is full. Since thieves may still be reading the old buffer, old buffers
+ * are only released when the deque is destroyed.
+ */
+template<class T>
+class WorkStealingDeque {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  capacity    Initial capacity of the deque, it has to be a power of two.
+    explicit WorkStealingDeque(const std::int64_t capacity = 1024) {
+        m_buffers.push_back(std::make_unique<Buffer>(capacity));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    //! @brief  Push an element at the bottom of the deque, only the owner thread can call it.
+    //!
+    //! @param  element     The element to be pushed.
+    void Push(T* element) {
+        const auto b = m_bottom.load(std::memory_order_relaxed);
+        const auto t = m_top.load(std::memory_order_acquire);
+        auto buffer = m_buffer.load(std::memory_order_relaxed);
+        if (b - t > buffer->capacity - 1) {
+            m_buffers.push_back(buffer->Grow(b, t));
+            buffer = m_buffers.back().get();
+            m_buffer.store(buffer, std::memory_order_release);
+        }
+        buffer->Put(b, element);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    //! @brief  Pop the element at the bottom of the deque, only the owner thread can call it.
+    //!
+    //! @return The most recently pushed element, nullptr if the deque is empty.
+    T* Pop() {
+        const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+        const auto buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // the deque is empty, restore the bottom
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto element = buffer->Get(b);
+        if (t == b) {
+            // this is the last element, compete with thieves for it
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                element = nullptr;
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return element;
+    }
+
+    //! @brief  Steal the element at the top of the deque, any thread can call it.
+    //!
+    //! @return The least recently pushed element, nullptr if the deque is empty or another thread won the race.
+    T* Steal() {
+        auto t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        // the buffer needs to be loaded after the indices so that it is never older than the element
+        const auto buffer = m_buffer.load(std::memory_order_acquire);
+        const auto element = buffer->Get(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return element;
+    }
+
+    //! @brief  Whether the deque looks empty, the result is only a hint if it is not called by the owner thread.
+    bool IsEmpty() const {
+        const auto t = m_top.load(std::memory_order_relaxed);
+        const auto b = m_bottom.load(std::memory_order_relaxed);
+        return t >= b;
+    }
+
+private:
+    //! @brief  Circular buffer holding the elements.
+    struct Buffer {
+        const std::int64_t                  capacity;   /**< Capacity of the buffer, it is always power of two. */
+        std::unique_ptr<std::atomic<T*>[]>  elements;   /**< Elements in the buffer. */
+
+        explicit Buffer(const std::int64_t cap) : capacity(cap), elements(new std::atomic<T*>[cap]) {}
+
+        SORT_FORCEINLINE T* Get(const std::int64_t i) const {
+            return elements[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        SORT_FORCEINLINE void Put(const std::int64_t i, T* element) {
+            elements[i & (capacity - 1)].store(element, std::memory_order_relaxed);
+        }
+
+        std::unique_ptr<Buffer> Grow(const std::int64_t bottom, const std::int64_t top) const {
+            auto buffer = std::make_unique<Buffer>(capacity * 2);
+            for (auto i = top; i < bottom; ++i)
+                buffer->Put(i, Get(i));
+            return buffer;
+        }
+    };
+
+    /**< Indices are on separate cache lines since the top one is shared with thieves while the bottom one is mostly touched by the owner. */
+    alignas(64) std::atomic<std::int64_t>   m_top = 0;
+    alignas(64) std::atomic<std::int64_t>   m_bottom = 0;
+    alignas(64) std::atomic<Buffer*>        m_buffer = nullptr;
+
+    /**< All buffers ever allocated, only the owner thread touches it. */
+    std::vector<std::unique_ptr<Buffer>>    m_buffers;
+};
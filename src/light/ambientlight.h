@@ -50,7 +50,7 @@ public:
     //! @brief  Get average sky color
     //!
     //! @return     Get The average sky color
-    Spectrum GetAverage() const override{
+    RGBSpectrum GetAverage() const override{
         return intensity;
     }
 
@@ -74,7 +74,7 @@ float AreaLight::Pdf( const Point& p , const Vector& wi ) const{
     return m_shape->Pdf( p , wi );
 }
 
-Spectrum AreaLight::Power() const{
+RGBSpectrum AreaLight::Power() const{
     sAssert(IS_PTR_VALID(m_shape), LIGHT );
     return m_shape->SurfaceArea() * intensity.GetIntensity() * TWO_PI;
 }
@@ -105,3 +105,13 @@ bool AreaLight::Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& r
 
     return result;
 }
+
+bool AreaLight::GetBounds( LightBounds& bounds ) const{
+    sAssert(IS_PTR_VALID(m_shape), LIGHT );
+    bounds.bbox = m_shape->GetBBox();
+    bounds.axis = Vector( 0.0f , 1.0f , 0.0f );
+    bounds.cos_theta_o = -1.0f;
+    bounds.cos_theta_e = 0.0f;
+    bounds.phi = Power().GetIntensity();
+    return true;
+}
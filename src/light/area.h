@@ -86,7 +86,7 @@ public:
     //! only used to pick a light for importance sampling, it is fine to be biased.
     //!
     //! @return     Approximation of the light power.
-    Spectrum Power() const override;
+    RGBSpectrum Power() const override;
 
     //! @brief  Whether area light is a delta light.
     //!
@@ -95,6 +95,14 @@ public:
         return false;
     }
 
+    //! @brief  Get the spatial and directional bounds of the light emission.
+    //!
+    //! The shape could be in any orientation, a full sphere of normals is used to keep it conservative.
+    //!
+    //! @param  bounds  The bounds of the light source.
+    //! @return         Always 'True' for area light.
+    bool GetBounds( LightBounds& bounds ) const override;
+
     //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
     //!
     //! @param  p       The point in world space to be shaded.
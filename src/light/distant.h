@@ -49,7 +49,7 @@ public:
     //! only used to pick a light for importance sampling, it is fine to be biased.
     //!
     //! @return     Approximation of the light power.
-    Spectrum Power() const override{
+    RGBSpectrum Power() const override{
         sAssert( m_scene != 0 , LIGHT );
         const BBox& box = m_scene->GetBBox();
         float delta = (box.m_Max - box.m_Min).SquaredLength();
@@ -23,12 +23,12 @@ bool HdrSkyLight::Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum&
     if( intersect && intersect->t != FLT_MAX )
         return false;
 
-    radiance = sky.Evaluate( m_light2world.GetInversed().TransformVector(ray.m_Dir) ) * intensity;
+    radiance = sky.Evaluate( m_light2world.invMatrix.TransformVector(ray.m_Dir) ) * intensity;
     return true;
 }
 
 float HdrSkyLight::Pdf( const Point& p , const Vector& wi ) const{
-    return sky.Pdf( m_light2world.GetInversed().TransformVector(wi) );
+    return sky.Pdf( m_light2world.invMatrix.TransformVector(wi) );
 }
 
 bool HdrSkyLight::LoadHdrImage(const std::string& filepath){
@@ -48,7 +48,7 @@ public:
     //! @brief  Get average sky color
     //!
     //! @return     Get The average sky color
-    Spectrum GetAverage() const override{
+    RGBSpectrum GetAverage() const override{
         return sky.GetAverage() * intensity;
     }
 
@@ -92,7 +92,7 @@ protected:
     //! @param world_dir    Direction in world space.
     //! @return             Direction in local space.
     Vector LocalDirFromWorldDir(const Vector& world_dir) const override {
-        return m_light2world.GetInversed().TransformVector(world_dir);
+        return m_light2world.invMatrix.TransformVector(world_dir);
     }
 
     friend class SkyLightEntity;
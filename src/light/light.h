@@ -86,7 +86,7 @@ public:
     //! only used to pick a light for importance sampling, it is fine to be biased.
     //!
     //! @return     Approximation of the light power.
-    virtual Spectrum    Power() const = 0;
+    virtual RGBSpectrum Power() const = 0;
 
     //! @brief  Whether the light is a delta light source.
     //!
@@ -111,6 +111,17 @@ public:
         return nullptr;
     }
 
+    //! @brief  Get the spatial and directional bounds of the light emission.
+    //!
+    //! The bounds are used to organize lights in the light tree so that lights can be picked with respect to
+    //! a shading point. Lights without a finite extent, like sky light, don't have bounds.
+    //!
+    //! @param  bounds  The bounds of the light source.
+    //! @return         Whether the light has finite bounds.
+    virtual bool        GetBounds( LightBounds& bounds ) const {
+        return false;
+    }
+
     //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
     //!
     //! @param  p       The point in world space to be shaded.
@@ -196,7 +207,8 @@ protected:
     /**< The rendering scene. */
     const Scene* m_scene = nullptr;
 
-    Spectrum    intensity;
+    /**< Emitted radiance or intensity of the light, it is kept in RGB so that it is upsampled with the wavelengths of each path in spectral mode. */
+    RGBSpectrum intensity;
 
     /**< The transformation transform vertices from light space to world space. */
     Transform   m_light2world;
@@ -0,0 +1,309 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include "lighttree.h"
+#include "light.h"
+#include "core/sassert.h"
+#include "math/utils.h"
+
+// cos( max( 0 , theta_a - theta_b ) ) without evaluating any angle.
+SORT_STATIC_FORCEINLINE float cosSubClamped( float sin_a , float cos_a , float sin_b , float cos_b ){
+    if( cos_a > cos_b )
+        return 1.0f;
+    return cos_a * cos_b + sin_a * sin_b;
+}
+
+// sin( max( 0 , theta_a - theta_b ) ) without evaluating any angle.
+SORT_STATIC_FORCEINLINE float sinSubClamped( float sin_a , float cos_a , float sin_b , float cos_b ){
+    if( cos_a > cos_b )
+        return 0.0f;
+    return sin_a * cos_b - cos_a * sin_b;
+}
+
+SORT_STATIC_FORCEINLINE float safeSqrt( float x ){
+    return sqrt( std::max( 0.0f , x ) );
+}
+
+SORT_STATIC_FORCEINLINE float safeACos( float x ){
+    return acos( clamp( x , -1.0f , 1.0f ) );
+}
+
+// Rotate vector 'v' around normalized axis 'k' by 'theta' radians.
+SORT_STATIC_FORCEINLINE Vector rotate( const Vector& v , const Vector& k , float theta ){
+    const auto cos_t = cos( theta );
+    const auto sin_t = sin( theta );
+    return v * cos_t + cross( k , v ) * sin_t + k * dot( k , v ) * ( 1.0f - cos_t );
+}
+
+// The largest float smaller than one, random numbers are remapped during traversal and need to stay in [0,1).
+static constexpr float ONE_MINUS_EPSILON = 0x1.fffffep-1f;
+
+float LightBounds::Importance( const Point& p , const Vector& n ) const{
+    // clamp the distance to the bounding box size to avoid singularity when the point is close to the emitter
+    const auto pc = ( bbox.m_Min + bbox.m_Max ) * 0.5f;
+    const auto radius_sq = ( bbox.m_Max - bbox.m_Min ).SquaredLength() * 0.25f;
+    const auto delta = p - pc;
+    const auto len_sq = delta.SquaredLength();
+    const auto dist_sq = std::max( len_sq , std::max( sqrt( radius_sq ) , 1e-6f ) );
+
+    // direction from the emitter to the shading point
+    const auto wi = len_sq > 0.0f ? delta / sqrt( len_sq ) : Vector( 0.0f , 1.0f , 0.0f );
+
+    // angle between the emitter axis and the direction to the shading point
+    const auto cos_theta_w = dot( axis , wi );
+    const auto sin_theta_w = safeSqrt( 1.0f - cos_theta_w * cos_theta_w );
+
+    // angle subtended by the bounding sphere of the emitter
+    const auto cos_theta_b = len_sq <= radius_sq ? -1.0f : safeSqrt( 1.0f - radius_sq / len_sq );
+    const auto sin_theta_b = safeSqrt( 1.0f - cos_theta_b * cos_theta_b );
+
+    // minimum angle between the direction and any normal of the emitter, taking the spread of the emitter into account
+    const auto sin_theta_o = safeSqrt( 1.0f - cos_theta_o * cos_theta_o );
+    const auto cos_theta_x = cosSubClamped( sin_theta_w , cos_theta_w , sin_theta_o , cos_theta_o );
+    const auto sin_theta_x = sinSubClamped( sin_theta_w , cos_theta_w , sin_theta_o , cos_theta_o );
+    const auto cos_theta_p = cosSubClamped( sin_theta_x , cos_theta_x , sin_theta_b , cos_theta_b );
+    if( cos_theta_p <= cos_theta_e )
+        return 0.0f;
+
+    auto importance = phi * cos_theta_p / dist_sq;
+
+    // account for the cosine factor at the shading point, both sides are considered to support transmission
+    if( n.x != 0.0f || n.y != 0.0f || n.z != 0.0f ){
+        const auto cos_theta_i = absDot( wi , n );
+        const auto sin_theta_i = safeSqrt( 1.0f - cos_theta_i * cos_theta_i );
+        importance *= cosSubClamped( sin_theta_i , cos_theta_i , sin_theta_b , cos_theta_b );
+    }
+
+    return std::max( importance , 0.0f );
+}
+
+LightBounds Union( const LightBounds& lb0 , const LightBounds& lb1 ){
+    if( lb0.phi == 0.0f )
+        return lb1;
+    if( lb1.phi == 0.0f )
+        return lb0;
+
+    LightBounds ret;
+    ret.bbox = Union( lb0.bbox , lb1.bbox );
+    ret.phi = lb0.phi + lb1.phi;
+    ret.cos_theta_e = std::min( lb0.cos_theta_e , lb1.cos_theta_e );
+
+    // merge the two normal cones, the result is a full sphere whenever the merged cone is not well defined
+    ret.cos_theta_o = -1.0f;
+    ret.axis = lb0.axis;
+    if( lb0.cos_theta_o == -1.0f || lb1.cos_theta_o == -1.0f )
+        return ret;
+
+    const auto theta_a = safeACos( lb0.cos_theta_o );
+    const auto theta_b = safeACos( lb1.cos_theta_o );
+    const auto theta_d = safeACos( dot( lb0.axis , lb1.axis ) );
+    if( std::min( theta_d + theta_b , PI ) <= theta_a ){
+        ret.axis = lb0.axis;
+        ret.cos_theta_o = lb0.cos_theta_o;
+        return ret;
+    }
+    if( std::min( theta_d + theta_a , PI ) <= theta_b ){
+        ret.axis = lb1.axis;
+        ret.cos_theta_o = lb1.cos_theta_o;
+        return ret;
+    }
+
+    const auto theta_o = ( theta_a + theta_d + theta_b ) * 0.5f;
+    if( theta_o >= PI )
+        return ret;
+
+    const auto wr = cross( lb0.axis , lb1.axis );
+    if( wr.SquaredLength() == 0.0f )
+        return ret;
+
+    ret.axis = normalize( rotate( lb0.axis , normalize( wr ) , theta_o - theta_a ) );
+    ret.cos_theta_o = cos( theta_o );
+    return ret;
+}
+
+void LightTree::Build( const std::vector<Light*>& lights ){
+    m_nodes.clear();
+    m_boundedLights.clear();
+    m_infiniteLights.clear();
+    m_trails.clear();
+
+    std::vector<BoundedLight> bounded_lights;
+    for( const auto light : lights ){
+        LightBounds bounds;
+        if( !light->GetBounds( bounds ) ){
+            m_infiniteLights.push_back( light );
+            continue;
+        }
+
+        // lights emitting nothing are never picked
+        if( bounds.phi <= 0.0f )
+            continue;
+
+        BoundedLight bl;
+        bl.light = light;
+        bl.bounds = bounds;
+        bounded_lights.push_back( bl );
+    }
+
+    if( bounded_lights.empty() )
+        return;
+
+    m_nodes.reserve( 2 * bounded_lights.size() - 1 );
+    m_boundedLights.reserve( bounded_lights.size() );
+    buildRecursive( bounded_lights , 0 , (unsigned)bounded_lights.size() , LightTreeTrail() );
+}
+
+unsigned LightTree::buildRecursive( std::vector<BoundedLight>& lights , unsigned start , unsigned end , LightTreeTrail trail ){
+    sAssert( start < end , LIGHT );
+
+    const auto node_index = (unsigned)m_nodes.size();
+    m_nodes.push_back( LightTreeNode() );
+
+    if( end - start == 1 ){
+        const auto& bl = lights[start];
+        auto& node = m_nodes[node_index];
+        node.bounds = bl.bounds;
+        node.offset = (unsigned)m_boundedLights.size();
+        node.is_leaf = true;
+
+        m_boundedLights.push_back( bl.light );
+        m_trails[bl.light] = trail;
+        return node_index;
+    }
+
+    // split along the longest axis of the centroids
+    BBox centroid_bbox;
+    for( auto i = start ; i < end ; ++i ){
+        const auto& bbox = lights[i].bounds.bbox;
+        centroid_bbox.Union( ( bbox.m_Min + bbox.m_Max ) * 0.5f );
+    }
+    const auto axis = centroid_bbox.MaxAxisId();
+    const auto mid = ( start + end ) / 2;
+    std::nth_element( lights.begin() + start , lights.begin() + mid , lights.begin() + end ,
+                      [axis]( const BoundedLight& bl0 , const BoundedLight& bl1 ){
+                          return bl0.bounds.bbox.m_Min[axis] + bl0.bounds.bbox.m_Max[axis] < bl1.bounds.bbox.m_Min[axis] + bl1.bounds.bbox.m_Max[axis];
+                      } );
+
+    sAssertMsg( trail.depth < 64 , LIGHT , "Light tree is too deep." );
+
+    auto left_trail = trail;
+    ++left_trail.depth;
+    auto right_trail = left_trail;
+    right_trail.bits |= 1ull << trail.depth;
+
+    const auto left = buildRecursive( lights , start , mid , left_trail );
+    const auto right = buildRecursive( lights , mid , end , right_trail );
+
+    auto& node = m_nodes[node_index];
+    node.bounds = Union( m_nodes[left].bounds , m_nodes[right].bounds );
+    node.offset = right;
+    node.is_leaf = false;
+    return node_index;
+}
+
+float LightTree::treePickPdf() const{
+    if( m_nodes.empty() )
+        return 0.0f;
+    return 1.0f / (float)( m_infiniteLights.size() + 1 );
+}
+
+const Light* LightTree::Sample( const Point& p , const Vector& n , float u , float* pdf ) const{
+    if( pdf )
+        *pdf = 0.0f;
+
+    // pick between infinite lights and the tree first
+    const auto tree_pdf = treePickPdf();
+    if( u >= tree_pdf ){
+        if( m_infiniteLights.empty() )
+            return nullptr;
+
+        const auto infinite_pdf = ( 1.0f - tree_pdf ) / (float)m_infiniteLights.size();
+        const auto index = std::min( (unsigned)( ( u - tree_pdf ) / infinite_pdf ) , (unsigned)m_infiniteLights.size() - 1 );
+        if( pdf )
+            *pdf = infinite_pdf;
+        return m_infiniteLights[index];
+    }
+    u = std::min( u / tree_pdf , ONE_MINUS_EPSILON );
+
+    // traverse down the tree, picking a child proportional to its importance
+    auto prob = tree_pdf;
+    auto node_index = 0u;
+    while( !m_nodes[node_index].is_leaf ){
+        const auto& node = m_nodes[node_index];
+        const auto ci0 = m_nodes[node_index + 1].bounds.Importance( p , n );
+        const auto ci1 = m_nodes[node.offset].bounds.Importance( p , n );
+        if( ci0 == 0.0f && ci1 == 0.0f )
+            return nullptr;
+
+        const auto p0 = ci0 / ( ci0 + ci1 );
+        if( u < p0 ){
+            node_index = node_index + 1;
+            prob *= p0;
+            u = std::min( u / p0 , ONE_MINUS_EPSILON );
+        }else{
+            node_index = node.offset;
+            prob *= 1.0f - p0;
+            u = std::min( ( u - p0 ) / ( 1.0f - p0 ) , ONE_MINUS_EPSILON );
+        }
+    }
+
+    // a single light in the tree still needs to be able to light the shading point
+    const auto& leaf = m_nodes[node_index];
+    if( node_index == 0 && leaf.bounds.Importance( p , n ) == 0.0f )
+        return nullptr;
+
+    if( pdf )
+        *pdf = prob;
+    return m_boundedLights[leaf.offset];
+}
+
+float LightTree::Pdf( const Point& p , const Vector& n , const Light* light ) const{
+    const auto tree_pdf = treePickPdf();
+
+    const auto it = m_trails.find( light );
+    if( it == m_trails.end() ){
+        if( std::find( m_infiniteLights.begin() , m_infiniteLights.end() , light ) == m_infiniteLights.end() )
+            return 0.0f;
+        return ( 1.0f - tree_pdf ) / (float)m_infiniteLights.size();
+    }
+
+    // follow the trail of the light down to its leaf
+    const auto& trail = it->second;
+    auto prob = tree_pdf;
+    auto node_index = 0u;
+    for( auto level = 0u ; level < trail.depth ; ++level ){
+        const auto& node = m_nodes[node_index];
+        const auto ci0 = m_nodes[node_index + 1].bounds.Importance( p , n );
+        const auto ci1 = m_nodes[node.offset].bounds.Importance( p , n );
+        if( ci0 == 0.0f && ci1 == 0.0f )
+            return 0.0f;
+
+        if( trail.bits & ( 1ull << level ) ){
+            prob *= ci1 / ( ci0 + ci1 );
+            node_index = node.offset;
+        }else{
+            prob *= ci0 / ( ci0 + ci1 );
+            node_index = node_index + 1;
+        }
+    }
+
+    if( node_index == 0 && m_nodes[0].bounds.Importance( p , n ) == 0.0f )
+        return 0.0f;
+
+    return prob;
+}
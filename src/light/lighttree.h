@@ -0,0 +1,124 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "math/bbox.h"
+#include "math/vector3.h"
+#include "math/point.h"
+
+class Light;
+
+//! @brief  Spatial and directional bounds of emission of a light source.
+/**
+ * The orientation is described by a cone of normals around 'axis', whose spread is 'cos_theta_o',
+ * and an extra spread of emission beyond the normal cone, 'cos_theta_e'. A point light, for example,
+ * has a full sphere of normals and emits within a hemisphere of each of them. A spot light has a
+ * single normal and emits within the cone of its total range.
+ */
+struct LightBounds{
+    BBox    bbox;                   /**< Bounding box of the emitter. */
+    Vector  axis = Vector( 0.0f , 1.0f , 0.0f );/**< Principal direction of emission. */
+    float   cos_theta_o = 1.0f;     /**< Cosine of the spread of normals around the axis. */
+    float   cos_theta_e = 0.0f;     /**< Cosine of the spread of emission around each normal. */
+    float   phi = 0.0f;             /**< Approximation of the power of the emitter. */
+
+    //! @brief  Conservative importance of the emitter for a shading point.
+    //!
+    //! @param  p       The shading point.
+    //! @param  n       The normal at the shading point. A zero vector means no orientation, like in a medium.
+    //! @return         The importance of the emitter, it is zero if the emitter can't light the shading point.
+    float   Importance( const Point& p , const Vector& n ) const;
+};
+
+//! @brief  Union of the bounds of two emitters.
+LightBounds Union( const LightBounds& lb0 , const LightBounds& lb1 );
+
+//! @brief  A bounding volume hierarchy over light sources.
+/**
+ * Lights with finite extent, like area lights, point lights and spot lights, are organized in a binary
+ * tree whose nodes hold the merged bounds of their children. Picking a light for a shading point is a
+ * single top-down traversal, where each child is chosen proportional to its importance relative to the
+ * shading point. Lights without bounds, like sky light and distant light, are picked uniformly out of
+ * the tree.
+ * The tree is built with a median split along the longest axis of the light centroids, it is a lot
+ * cheaper than a surface area orientation heuristic and good enough to cull lights far away.
+ */
+class LightTree{
+public:
+    //! @brief  Build the tree.
+    //!
+    //! @param  lights      All lights in the scene.
+    void            Build( const std::vector<Light*>& lights );
+
+    //! @brief  Pick a light with probability proportional to its importance for a shading point.
+    //!
+    //! @param  p           The shading point.
+    //! @param  n           The normal at the shading point. A zero vector means no orientation.
+    //! @param  u           A canonical random number.
+    //! @param  pdf         The probability of picking the returned light.
+    //! @return             The picked light, 'nullptr' if no light could contribute to the shading point.
+    const Light*    Sample( const Point& p , const Vector& n , float u , float* pdf ) const;
+
+    //! @brief  Probability of picking a specific light with 'Sample'.
+    //!
+    //! @param  p           The shading point.
+    //! @param  n           The normal at the shading point. A zero vector means no orientation.
+    //! @param  light       The light to be evaluated.
+    //! @return             The probability of picking the light.
+    float           Pdf( const Point& p , const Vector& n , const Light* light ) const;
+
+    //! @brief  Whether there is no light in the tree at all.
+    bool            IsEmpty() const {
+        return m_nodes.empty() && m_infiniteLights.empty();
+    }
+
+private:
+    //! @brief  Node of the light tree.
+    struct LightTreeNode{
+        LightBounds     bounds;             /**< Merged bounds of all lights under the node. */
+        unsigned        offset = 0;         /**< Index of the light for a leaf node, index of the second child for an interior node. */
+        bool            is_leaf = false;    /**< Whether the node is a leaf. The first child of an interior node is right next to it. */
+    };
+
+    //! @brief  Path from the root to the leaf of a light, one bit per level, set bit means the second child.
+    struct LightTreeTrail{
+        unsigned long long  bits = 0;       /**< Choices at each level, starting from the least significant bit. */
+        unsigned            depth = 0;      /**< Depth of the leaf. */
+    };
+
+    //! @brief  Emitter with its bounds during construction.
+    struct BoundedLight{
+        const Light*    light = nullptr;    /**< The light source. */
+        LightBounds     bounds;             /**< Bounds of the light source. */
+    };
+
+    std::vector<LightTreeNode>                              m_nodes;            /**< Flattened nodes in depth first order. */
+    std::vector<const Light*>                               m_boundedLights;    /**< Lights referenced by leaf nodes. */
+    std::vector<const Light*>                               m_infiniteLights;   /**< Lights without finite bounds. */
+    std::unordered_map<const Light*, LightTreeTrail>        m_trails;           /**< Trail to the leaf of each bounded light. */
+
+    //! @brief  Recursively build the sub-tree of a range of lights.
+    //!
+    //! @return     Index of the root node of the sub-tree.
+    unsigned        buildRecursive( std::vector<BoundedLight>& lights , unsigned start , unsigned end , LightTreeTrail trail );
+
+    //! @brief  Probability of picking the tree instead of an infinite light.
+    float           treePickPdf() const;
+};
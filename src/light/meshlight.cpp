@@ -0,0 +1,127 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "meshlight.h"
+#include "sampler/sample.h"
+#include "core/samplemethod.h"
+
+TriangleLight::TriangleLight( Triangle* triangle , const RGBSpectrum& radiance ):m_triangle(triangle){
+    intensity = radiance;
+}
+
+void TriangleLight::Setup(){
+    sAssert(IS_PTR_VALID(m_triangle), LIGHT );
+    m_area = m_triangle->SurfaceArea();
+    m_normal = m_triangle->FaceNormal();
+}
+
+Spectrum TriangleLight::sample_l(const Point& ip, const LightSample* ls , Vector& dirToLight , float* distance , float* pdfW , float* emissionPdf , float* cosAtLight , Visibility& visibility ) const{
+    sAssert(IS_PTR_VALID(ls), LIGHT );
+
+    // sample a point from light
+    Vector normal;
+    const Point ps = m_triangle->Sample_l( *ls , ip , dirToLight , normal , pdfW );
+
+    // return if pdf is zero
+    if( pdfW && *pdfW == 0.0f )
+        return 0.0f;
+
+    const Vector dlt = ps - ip;
+    const float len = dlt.Length();
+
+    if(cosAtLight)
+        *cosAtLight = dot( -dirToLight , normal );
+
+    if( distance )
+        *distance = len;
+
+    // product of pdf of sampling a point w.r.t surface area and a direction w.r.t direction
+    if( emissionPdf )
+        *emissionPdf = UniformHemispherePdf() / m_area;
+
+    // setup visibility tester
+    const float delta = 0.01f;
+    visibility.ray = Ray( ip , dirToLight , 0 , delta , len - delta );
+
+    return intensity;
+}
+
+Spectrum TriangleLight::sample_l( RenderContext& rc, const LightSample& ls , Ray& r , float* pdfW , float* pdfA , float* cosAtLight ) const{
+    Vector n;
+    m_triangle->Sample_l( rc, ls , r , n , pdfW );
+
+    if( pdfA )
+        *pdfA = 1.0f / m_area;
+
+    if( cosAtLight )
+        *cosAtLight = satDot( r.m_Dir , n );
+
+    // to avoid self intersection
+    r.m_fMin = 0.01f;
+
+    return intensity;
+}
+
+Spectrum TriangleLight::Le( const SurfaceInteraction& intersect , const Vector& wo , float* directPdfA , float* emissionPdf ) const{
+    // only the front side of the triangle emits light
+    if( dot( wo , m_normal ) <= 0.0f )
+        return 0.0f;
+
+    if( directPdfA )
+        *directPdfA = 1.0f / m_area;
+
+    if( emissionPdf )
+        *emissionPdf = UniformHemispherePdf() / m_area;
+
+    return intensity;
+}
+
+bool TriangleLight::Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& radiance ) const{
+    // the triangle intersection needs the ray to be prepared, which is usually done by the spatial accelerator.
+    ray.Prepare();
+
+    const auto result = m_triangle->GetIntersect( ray , intersect );
+    if( result && IS_PTR_VALID(intersect) )
+        radiance = Le( *intersect , -ray.m_Dir , 0 , 0 );
+    return result;
+}
+
+float TriangleLight::Pdf( const Point& p , const Vector& wi ) const{
+    const Ray ray( p , wi );
+    ray.Prepare();
+
+    SurfaceInteraction inter;
+    if( !m_triangle->GetIntersect( ray , &inter ) )
+        return 0.0f;
+
+    // it has to be consistent with the pdf of the sampled direction, which uses the face normal.
+    const auto delta = p - inter.intersect;
+    const auto d = dot( normalize( delta ) , m_normal );
+    if( d <= 0.0f )
+        return 0.0f;
+    return delta.SquaredLength() / ( m_area * d );
+}
+
+bool TriangleLight::GetBounds( LightBounds& bounds ) const{
+    // a single normal emitting within the hemisphere around it.
+    bounds.bbox = m_triangle->GetBBox();
+    bounds.axis = m_normal;
+    bounds.cos_theta_o = 1.0f;
+    bounds.cos_theta_e = 0.0f;
+    bounds.phi = Power().GetIntensity();
+    return true;
+}
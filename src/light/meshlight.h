@@ -0,0 +1,121 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "light.h"
+#include "core/sassert.h"
+#include "shape/triangle.h"
+
+//! @brief  Light source of one emissive triangle in a triangle mesh.
+/**
+ * Each emissive triangle of a mesh light is an individual light source so that it can be picked
+ * by its power, or by its importance to a shading point with the light tree, just like any other
+ * light source. The triangle itself is owned by the mesh visual, the light only references it.
+ */
+class   TriangleLight : public Light{
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  triangle    The emissive triangle.
+    //! @param  radiance    The radiance emitted from the front side of the triangle.
+    TriangleLight( Triangle* triangle , const RGBSpectrum& radiance );
+
+    //! @brief  Cache the area and the orientation of the triangle.
+    //!
+    //! It needs to be called after the mesh is transformed to world space and before rendering. It is
+    //! safe to be called for different lights in parallel.
+    void    Setup();
+
+    //! @brief  Sample a direction given the intersection.
+    //!
+    //! @param  ip              The point where we are interested in shading at.
+    //! @param  ls              The light sample information.
+    //! @param  dirToLight      The resulting direction goes from the intersection to light source.
+    //! @param  distance        The distance from the intersected point to the sampled point.
+    //! @param  pdfw            The resulting pdf w.r.t solid angle to pick such a direction.
+    //! @param  emissionPdf     The pdf w.r.t solid angle if such a direction and position is picked by the light source.
+    //! @param  cosAtLight      The cos of the angle between the light out-going direction, the opposite of 'dirToLight'.
+    //! @param  visibility      The visibility data structured filled by the light source.
+    //! @return                 The radiance goes from the light source to the intersected point.
+    Spectrum sample_l(const Point& ip, const LightSample* ls , Vector& dirToLight , float* distance , float* pdfw , float* emissionPdf , float* cosAtLight , Visibility& visibility ) const override;
+
+    //! @brief      Sample a point and light out-going direction.
+    //!
+    //! @param  ls              The light sample.
+    //! @param  r               The resulting sampled ray.
+    //! @param  pdfA            The pdf w.r.t area of picking such a light out-going ray.
+    //! @param  cosAtLight      The cos of the angle between the light out-going direction and the normal.
+    //! @return                 The radiance goes from the light source to the intersected point.
+    Spectrum sample_l( RenderContext& rc, const LightSample& ls , Ray& r , float* pdfW , float* pdfA , float* cosAtLight ) const override;
+
+    //! @brief  Get the radiance light starting from the light source and ending at the intersection point.
+    //!
+    //! @param  intersect       The intersection information.
+    //! @param  wo              The direction goes from the light source to the intersecion.
+    //! @param  directPdfA      The pdf w.r.t area to pick the point, intersection between the direction and the light source.
+    //! @param  emissionPdf     The pdf w.r.t solid angle to pick to sample such a position and direction goes to the intersection.
+    //! @return                 The radiance goes from the light source to the intersection, black if there is no intersection.
+    Spectrum Le( const SurfaceInteraction& intersect , const Vector& wo , float* directPdfA , float* emissionPdf ) const override;
+
+    //! @brief  Given a ray, sample the light source if there is any intersection between the ray and the light source.
+    //!
+    //! @param  ray             The ray to be evaluated.
+    //! @param  intersect       The intersection between the ray and the light source.
+    //! @param  radiance        The radiance goes from the light source to the ray origin.
+    //! @return                 Whether there is an intersection between the ray and the light source.
+    bool Le( const Ray& ray , SurfaceInteraction* intersect , Spectrum& radiance ) const override;
+
+    //! @brief  Total power of the triangle.
+    //!
+    //! @return     Power of the light.
+    RGBSpectrum Power() const override {
+        return m_area * intensity.GetIntensity() * TWO_PI;
+    }
+
+    //! @brief  Whether the light is a delta light.
+    //!
+    //! @return     Always return 'False' for mesh light.
+    bool    IsDelta() const override{
+        return false;
+    }
+
+    //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
+    //!
+    //! @param  p       The point in world space to be shaded.
+    //! @param  wi      The direction pointing from the point.
+    //! @return         The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
+    float Pdf( const Point& p , const Vector& wi ) const override;
+
+    //! @brief  Get the spatial and directional bounds of the light emission.
+    //!
+    //! @param  bounds  The bounds of the light source.
+    //! @return         Always 'True' for mesh light.
+    bool GetBounds( LightBounds& bounds ) const override;
+
+    //! @brief  Get the emissive triangle.
+    //!
+    //! @return     The triangle of the light.
+    Shape* GetShape() const override {
+        return m_triangle;
+    }
+
+private:
+    Triangle*   m_triangle = nullptr;               /**< The emissive triangle, it is owned by the mesh visual. */
+    float       m_area = 0.0f;                      /**< Cached area of the triangle. */
+    Vector      m_normal;                           /**< Cached normal of the emissive side of the triangle. */
+};
@@ -76,3 +76,15 @@ Spectrum PointLight::sample_l( RenderContext& rc, const LightSample& ls , Ray& r
 
     return intensity;
 }
+
+bool PointLight::GetBounds( LightBounds& bounds ) const{
+    const auto light_pos = Point( m_light2world.matrix.m[3] , m_light2world.matrix.m[7] , m_light2world.matrix.m[11] );
+
+    // a point light emits in all directions, which is a full sphere of normals each emitting in a hemisphere.
+    bounds.bbox = BBox( light_pos , light_pos );
+    bounds.axis = Vector( 0.0f , 1.0f , 0.0f );
+    bounds.cos_theta_o = -1.0f;
+    bounds.cos_theta_e = 0.0f;
+    bounds.phi = Power().GetIntensity();
+    return true;
+}
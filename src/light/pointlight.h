@@ -59,10 +59,16 @@ public:
     //! only used to pick a light for importance sampling, it is fine to be biased.
     //!
     //! @return     Approximation of the light power.
-    Spectrum Power() const override {
+    RGBSpectrum Power() const override {
         return 4 * PI * intensity;
     }
 
+    //! @brief  Get the spatial and directional bounds of the light emission.
+    //!
+    //! @param  bounds  The bounds of the light source.
+    //! @return         Always 'True' for point light.
+    bool GetBounds( LightBounds& bounds ) const override;
+
     //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.'
     //!
     //! Instead of checking whether p and wi is valid, it always returns 1.0. It is higher level code's responsibility to
@@ -96,6 +96,6 @@ Spectrum SkyLight::Le(const SurfaceInteraction& intersect, const Vector& wo, flo
     if (emissionPdf)
         *emissionPdf = directPdf * positionPdf;
 
-    const auto local_dir = m_light2world.GetInversed().TransformVector(flipped_wo);
+    const auto local_dir = m_light2world.invMatrix.TransformVector(flipped_wo);
     return RadianceFromDirection(local_dir);
 }
\ No newline at end of file
@@ -83,7 +83,7 @@ public:
     //! only used to pick a light for importance sampling, it is fine to be biased.
     //!
     //! @return     Approximation of the light power.
-    Spectrum Power() const override{
+    RGBSpectrum Power() const override{
         sAssert(IS_PTR_VALID(m_scene), LIGHT );
         const BBox box = m_scene->GetBBox();
         const float radius = (box.m_Max - box.m_Min).Length() * 0.5f;
@@ -101,7 +101,7 @@ public:
     //! @brief  Get the average color of the sky
     //!
     //! @return     Average color of the sky
-    virtual Spectrum GetAverage() const = 0;
+    virtual RGBSpectrum GetAverage() const = 0;
 
     friend class SkyLightEntity;
 
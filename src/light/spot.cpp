@@ -99,4 +99,17 @@ Spectrum SpotLight::sample_l( RenderContext& rc, const LightSample& ls , Ray& r
         return 0.0f;
 
     return intensity * d * d;
-}
\ No newline at end of file
+}
+
+bool SpotLight::GetBounds( LightBounds& bounds ) const{
+    const auto light_dir = Vector3f( m_light2world.matrix.m[1] , m_light2world.matrix.m[5] , m_light2world.matrix.m[9] );
+    const auto light_pos = Point( m_light2world.matrix.m[3] , m_light2world.matrix.m[7] , m_light2world.matrix.m[11] );
+
+    // a single normal emitting within the total range of the spot light.
+    bounds.bbox = BBox( light_pos , light_pos );
+    bounds.axis = normalize( light_dir );
+    bounds.cos_theta_o = 1.0f;
+    bounds.cos_theta_e = cos_total_range;
+    bounds.phi = Power().GetIntensity();
+    return true;
+}
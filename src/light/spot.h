@@ -49,7 +49,7 @@ public:
     //! only used to pick a light for importance sampling, it is fine to be biased.
     //!
     //! @return     Approximation of the light power.
-    Spectrum Power() const override {
+    RGBSpectrum Power() const override {
         return 4 * PI * intensity * ( 1.0f - 0.5f * ( cos_falloff_start + cos_total_range ) ) ;
     }
 
@@ -64,6 +64,12 @@ public:
     //! @return                 The radiance goes from the light source to the intersected point.
     Spectrum sample_l( RenderContext& rc, const LightSample& ls , Ray& r , float* pdfW , float* pdfA , float* cosAtLight ) const override;
 
+    //! @brief  Get the spatial and directional bounds of the light emission.
+    //!
+    //! @param  bounds  The bounds of the light source.
+    //! @return         Always 'True' for spot light.
+    bool GetBounds( LightBounds& bounds ) const override;
+
     //! @brief  The pdf w.r.t solid angle if the ray starting from 'p', tracing through 'wi' hits the light source.
     //!
     //! Instead of checking whether p and wi is valid, it always returns 1.0. It is higher level code's responsibility to
@@ -30,18 +30,21 @@ int main(int argc, char* argv[])
 {
     // enable profiler
     SORT_PROFILE_ENABLE;
-    SORT_PROFILE("Main Thread");
+    SORT_PROFILE_THREAD("Main Thread");
 
     addLogDispatcher(std::make_unique<StdOutLogDispatcher>());
     addLogDispatcher(std::make_unique<FileLogDispatcher>("log.txt"));
 
-    const auto ret = RunSORT(argc, argv);
-
-    SORT_PROFILE_END; // Main Thread
+    auto ret = 0;
+    {
+        // the scope needs to be closed before dumping profile data
+        SORT_PROFILE("Main Thread");
+        ret = RunSORT(argc, argv);
+    }
 
     // dump profile data
     if (SORT_PROFILE_ISENABLED && ret == 0 ){
-        const std::string filename("sort.prof");
+        const std::string filename(SORT_PROFILE_FILE);
         SORT_PROFILE_DUMP(filename.c_str());
         slog(INFO, GENERAL, "Profiling file: \"%s\"", GetFilePathInExeFolder(filename).c_str());
     }
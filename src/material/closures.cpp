@@ -186,7 +186,8 @@ namespace {
          void Process(const Tsl_Namespace::ClosureParamPtr param, const Tsl_Namespace::float3& w, ScatteringEvent& se, RenderContext& rc) const override {
              const auto weight = w;
              const auto sample_weight = ( weight.x + weight.y + weight.z ) / 3.0f;
-             auto& params = *(ClosureTypeDisney*)param;
+             // parameters are copied since they could be shared by all hits of a material without any dependency on tsl globals
+             auto params = *(const ClosureTypeDisney*)param;
              auto& mfp = params.scatterDistance;
 
              // Ignore SSS if necessary
@@ -201,7 +202,7 @@ namespace {
              auto total_channel_weight = 0.0f;
              auto addExtraLambert = false;
              auto baseColor = params.baseColor;
-             for (int i = 0; i < SPECTRUM_SAMPLE; ++i) {
+             for (int i = 0; i < RGBSPECTRUM_SAMPLE; ++i) {
                  auto& _baseColor = tsl_color_channel(baseColor, i);
                  auto& _mfp = tsl_color_channel(mfp, i);
 
@@ -235,7 +236,7 @@ namespace {
                  if( bxdf_sampling_weight > 0.0f )
                      se.AddBxdf(SORT_MALLOC(rc.m_memory_arena,DisneyBRDF)(rc, params, weight, bxdf_sampling_weight * sample_weight));
 
-                 const auto diffuseWeight = (Spectrum)( weight * (1.0f - params.metallic) * (1.0 - params.specTrans) );
+                 const auto diffuseWeight = Spectrum( weight ) * (1.0f - params.metallic) * (1.0 - params.specTrans);
                  if (!sssBaseColor.IsBlack() && bxdf_sampling_weight < 1.0f && !diffuseWeight.IsBlack() )
                      se.AddBssrdf( SORT_MALLOC(rc.m_memory_arena,DisneyBssrdf)(&se.GetInteraction(), sssBaseColor, params.scatterDistance, diffuseWeight , ( 1.0f - bxdf_sampling_weight ) * sample_weight * bssrdf_pdf ) );
 
@@ -456,7 +457,7 @@ namespace {
                  auto mfp = params.scatter_distance;
                  auto addExtraLambert = false;
                  auto baseColor = params.base_color;
-                 for (int i = 0; i < SPECTRUM_SAMPLE; ++i) {
+                 for (int i = 0; i < RGBSPECTRUM_SAMPLE; ++i) {
                      auto& base_color_channel_i = tsl_color_channel(baseColor, i);
                      auto& sss_base_color_channel_i = tsl_color_channel(sssBaseColor, i);
                      auto& mfp_channel_i = tsl_color_channel(mfp, i);
@@ -593,6 +594,38 @@ void ProcessSurfaceClosure(const ClosureTreeNodeBase* closure, const float3& w,
     }
 }
 
+void FlattenSurfaceClosure(const ClosureTreeNodeBase* closure, const float3& w, std::vector<FlattenedSurfaceClosure>& flattened) {
+    if (!closure)
+        return;
+
+    switch (closure->m_id) {
+        case Tsl_Namespace::CLOSURE_ADD:
+            {
+                const ClosureTreeNodeAdd* closure_add = (const ClosureTreeNodeAdd*)closure;
+                FlattenSurfaceClosure(closure_add->m_closure0, w, flattened);
+                FlattenSurfaceClosure(closure_add->m_closure1, w, flattened);
+            }
+            break;
+        case Tsl_Namespace::CLOSURE_MUL:
+            {
+                const ClosureTreeNodeMul* closure_mul = (const ClosureTreeNodeMul*)closure;
+                const float3 weight = make_float3(w.x * closure_mul->m_weight, w.y * closure_mul->m_weight, w.z * closure_mul->m_weight);
+                FlattenSurfaceClosure(closure_mul->m_closure, weight, flattened);
+            }
+            break;
+        default:
+            flattened.push_back({ closure->m_id, closure->m_params, w });
+            break;
+    }
+}
+
+void ProcessFlattenedSurfaceClosures(const FlattenedSurfaceClosure* closures, const unsigned int cnt, ScatteringEvent& se, RenderContext& rc) {
+    for (auto i = 0u; i < cnt; ++i) {
+        const auto& closure = closures[i];
+        getSurfaceClosureBase(closure.closure_id)->Process(closure.params, closure.weight, se, rc);
+    }
+}
+
 void ProcessVolumeClosure(const ClosureTreeNodeBase* closure, const float3& w, MediumStack& mediumStack, const SE_Interaction flag, const MaterialBase* material, const Mesh* mesh, RenderContext& rc) {
     if (!closure)
         return;
@@ -19,6 +19,7 @@
 
 #include <tsl_system.h>
 #include <tsl_args.h>
+#include <vector>
 #include "spectrum/spectrum.h"
 #include "medium/medium.h"
 
@@ -28,6 +29,21 @@ class MediumStack;
 class MaterialBase;
 class Mesh;
 
+//! @brief  A closure in a flattened closure tree.
+/**
+ * Closure trees without any dependency on tsl globals are flattened into a linear list of leaf closures during
+ * material building. Closure adding and weighting nodes are folded into the weight of each leaf, so that there is
+ * no need to walk the tree anymore when populating scattering events.
+ */
+struct FlattenedSurfaceClosure {
+    /**< Id of the closure type. */
+    Tsl_Namespace::ClosureID        closure_id;
+    /**< Parameters of the closure, the memory is owned by whoever evaluates the shader. */
+    Tsl_Namespace::ClosureParamPtr  params;
+    /**< Accumulated weight of the closure. */
+    Tsl_Namespace::float3           weight;
+};
+
 //! @brief  Register all closures supported by SORT.
 void RegisterClosures();
 
@@ -38,6 +54,20 @@ void RegisterClosures();
 //! @param  se              The result scattering event.
 void ProcessSurfaceClosure(const Tsl_Namespace::ClosureTreeNodeBase* closure, const Tsl_Namespace::float3& w, ScatteringEvent& se, RenderContext& rc);
 
+//! @brief  Flatten the closure tree into a list of leaf closures with accumulated weights.
+//!
+//! @param  closure         The closure tree in the tsl shader.
+//! @param  w               The weight of this closure tree, this also counts the weight inherits from the higher level tree nodes.
+//! @param  flattened       The flattened closures to be appended to.
+void FlattenSurfaceClosure(const Tsl_Namespace::ClosureTreeNodeBase* closure, const Tsl_Namespace::float3& w, std::vector<FlattenedSurfaceClosure>& flattened);
+
+//! @brief  Populate the BSDF with flattened closures.
+//!
+//! @param  closures        The flattened closures.
+//! @param  cnt             Number of flattened closures.
+//! @param  se              The result scattering event.
+void ProcessFlattenedSurfaceClosures(const FlattenedSurfaceClosure* closures, const unsigned int cnt, ScatteringEvent& se, RenderContext& rc);
+
 //! @brief  Process the closure tree result and populate the MediumStack.
 //!
 //! @param  closure         The closure tree in the tsl shader.
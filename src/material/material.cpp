@@ -16,6 +16,7 @@
  */
 
 #include <string.h>
+#include <mutex>
 #include <tsl_system.h>
 #include "material.h"
 #include "matmanager.h"
@@ -26,6 +27,10 @@
 #include "scatteringevent/bsdf/transparent.h"
 #include "texture/imagetexture2d.h"
 #include "core/profile.h"
+#include "core/perf_counters.h"
+#include "medium/medium.h"
+#include "core/mesh.h"
+#include "core/stats.h"
 
 USE_TSL_NAMESPACE
 
@@ -125,6 +130,38 @@ void Material::BuildMaterial(Tsl_Namespace::ShadingContext* context) {
     // build volume shader
     build_shader_type(m_volume_shader_data, surface_volume_root, "Volume", m_volume_shader_valid, tried_building_volume_shader, m_volume_shader_units, m_volume_shader);
 
+    // A surface shader reading no tsl global results in the same closure tree for all hits. Such a shader is evaluated
+    // only once here and its flattened closures are reused afterward, there is no need to execute the shader per hit.
+    auto depends_on_tsl_global = [](const TSL_ShaderData& shader_data) {
+        if (shader_data.m_depends_on_tsl_global)
+            return true;
+        for (const auto& shader : shader_data.m_sources) {
+            if (MatManager::GetSingleton().DependsOnTslGlobal(shader.type))
+                return true;
+        }
+        return false;
+    };
+    if (m_surface_shader_valid && !depends_on_tsl_global(m_surface_shader_data)) {
+        const auto closure = ExecuteConstantSurfaceShader(m_surface_shader.get(), m_constant_closure_arena);
+        FlattenSurfaceClosure(closure, make_float3(1.0f, 1.0f, 1.0f), m_constant_closures);
+
+        const auto opacity = ProcessOpacity(closure, make_float3(1.0f, 1.0f, 1.0f));
+        m_constant_transparency = Spectrum(1.0f - opacity).Clamp(0.0f, 1.0f);
+        m_constant_surface_shader = true;
+    }
+
+    // Density is the only tsl global available to volume shaders, the volume shader is tabulated over it once for all.
+    if (m_volume_shader_valid) {
+        const auto shader = m_volume_shader.get();
+        m_volume_table.Build([shader](const float density, MediumSample& ms) {
+            EvaluateVolumeSample(shader, density, ms);
+        });
+
+        // materials could be built in parallel, the category set is not thread safe
+        static std::once_flag stats_flag;
+        std::call_once(stats_flag, []() { SortStatsEnableCategory("Heterogeneous Medium"); });
+    }
+
     // if there is volume shader, but no surface shader, a special transparent material will be applied automatically
     // this will make the shader authoring a lot easier.
     if (!m_surface_shader_valid && m_volume_shader_valid && !tried_building_surface_shader)
@@ -155,7 +192,7 @@ void Material::Serialize(IStreamBase& stream){
     m_matID = StringID(m_name);
 
     const auto message = "Parsing Material '" + m_name + "'";
-    SORT_PROFILE(message.c_str());
+    SORT_PROFILE(message);
 
     auto parse_shader_type = [&](TSL_ShaderData& shader_data, bool& is_shader_valid) {
         is_shader_valid = true;
@@ -191,6 +228,7 @@ void Material::Serialize(IStreamBase& stream){
                     std::string str;
                     stream >> str;
                     default_value.default_value = make_tsl_global_ref(str);
+                    shader_data.m_depends_on_tsl_global = true;
                 }
 
                 m_paramDefaultValues.push_back(default_value);
@@ -222,38 +260,69 @@ void Material::Serialize(IStreamBase& stream){
 
     stream >> m_hasTransparentNode;
     stream >> m_hasSSSNode;
-
-    stream >> m_volumeStep;
-    stream >> m_volumeStepCnt;
 }
 
 void Material::UpdateScatteringEvent( ScatteringEvent& se, RenderContext& rc ) const {
+    SORT_PERF_COUNTER_SCOPE(Shading);
+
     // all lambert surfaces if the render is in no material mode.
     if (UNLIKELY(MatManager::GetSingleton().IsNoMaterialMode() || ( !m_surface_shader_valid && !m_special_transparent ))) {
         se.AddBxdf(SORT_MALLOC(rc.m_memory_arena, Lambert)(rc, WHITE_SPECTRUM, FULL_WEIGHT, DIR_UP));
         return;
     }
 
-    if( m_surface_shader_valid )
+    if( m_constant_surface_shader )
+        ProcessFlattenedSurfaceClosures(m_constant_closures.data(), (unsigned int)m_constant_closures.size(), se, rc);
+    else if( m_surface_shader_valid )
         ExecuteSurfaceShader(m_surface_shader.get() , se , rc);
     else if( m_special_transparent )
         se.AddBxdf(SORT_MALLOC(rc.m_memory_arena, Transparent)(rc));
 }
 
+void Material::UpdateScatteringEvents( ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc ) const {
+    SORT_PERF_COUNTER_SCOPE(Shading);
+
+    if (UNLIKELY(MatManager::GetSingleton().IsNoMaterialMode() || ( !m_surface_shader_valid && !m_special_transparent ))) {
+        for (auto i = 0u; i < cnt; ++i)
+            ses[i]->AddBxdf(SORT_MALLOC(rc.m_memory_arena, Lambert)(rc, WHITE_SPECTRUM, FULL_WEIGHT, DIR_UP));
+        return;
+    }
+
+    if( m_constant_surface_shader ){
+        for (auto i = 0u; i < cnt; ++i)
+            ProcessFlattenedSurfaceClosures(m_constant_closures.data(), (unsigned int)m_constant_closures.size(), *ses[i], rc);
+    }else if( m_surface_shader_valid ){
+        ExecuteSurfaceShader(m_surface_shader.get(), ses, cnt, rc);
+    }else if( m_special_transparent ){
+        for (auto i = 0u; i < cnt; ++i)
+            ses[i]->AddBxdf(SORT_MALLOC(rc.m_memory_arena, Transparent)(rc));
+    }
+}
+
 void Material::UpdateMediumStack( const MediumInteraction& mi , const SE_Interaction flag , MediumStack& ms, RenderContext& rc ) const {
     if (m_volume_shader_valid)
         ExecuteVolumeShader(m_volume_shader.get(), mi, ms, flag, this, rc);
 }
 
 void Material::EvaluateMediumSample(const MediumInteraction& mi, MediumSample& ms) const {
-    if (m_volume_shader_valid)
-        EvaluateVolumeSample(m_volume_shader.get(), mi, ms);
+    if (!m_volume_shader_valid)
+        return;
+
+    m_volume_table.Evaluate(mi.mesh->SampleVolumeDensity(mi.intersect), ms);
+}
+
+float Material::GetVolumeMajorant(const float max_density) const {
+    return m_volume_table.GetMajorant(max_density);
 }
 
 void MaterialProxy::UpdateScatteringEvent(ScatteringEvent& se, RenderContext& rc) const {
     return m_material.UpdateScatteringEvent(se, rc);
 }
 
+void MaterialProxy::UpdateScatteringEvents(ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc) const {
+    return m_material.UpdateScatteringEvents(ses, cnt, rc);
+}
+
 void MaterialProxy::UpdateMediumStack(const MediumInteraction& mi, const SE_Interaction flag, MediumStack& ms, RenderContext& rc) const {
     return m_material.UpdateMediumStack(mi, flag, ms, rc);
 }
@@ -284,10 +353,6 @@ bool MaterialProxy::HasVolumeAttached() const {
     return m_material.HasVolumeAttached();
 }
 
-float MaterialProxy::GetVolumeStep() const {
-    return m_material.GetVolumeStep();
-}
-
-unsigned int MaterialProxy::GetVolumeStepCnt() const {
-    return m_material.GetVolumeStepCnt();
+float MaterialProxy::GetVolumeMajorant(const float max_density) const {
+    return m_material.GetVolumeMajorant(max_density);
 }
\ No newline at end of file
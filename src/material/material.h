@@ -17,12 +17,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <unordered_map>
 #include <list>
 #include <vector>
 #include <string>
 #include "stream/stream.h"
 #include "tsl_system.h"
+#include "medium/medium.h"
+#include "volume_table.h"
 
 struct SurfaceInteraction;
 struct MediumInteraction;
@@ -50,6 +53,8 @@ struct TSL_ShaderData {
     std::vector<ShaderSource>           m_sources;
     /**< Shader connections. */
     std::vector<ShaderConnection>       m_connections;
+    /**< Whether any default input value refers to a tsl global. */
+    bool                                m_depends_on_tsl_global = false;
 };
 
 //! @brief  Base interface for material.
@@ -63,6 +68,15 @@ public:
     //! @param      se              Scattering event to be returned.
     virtual void       UpdateScatteringEvent(ScatteringEvent& se, RenderContext& rc) const = 0;
 
+    //! @brief      Parse scattering events of multiple interactions sharing this material in one go.
+    //!
+    //! This is the batched version of UpdateScatteringEvent. Integrators that can group hits by material
+    //! should prefer this interface since it amortizes the cost of shader invocation across all hits.
+    //!
+    //! @param      ses             Scattering events to be returned, all of them need to use this material.
+    //! @param      cnt             Number of scattering events.
+    virtual void       UpdateScatteringEvents(ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc) const = 0;
+
     //! @brief      Parse volume from the material shader.
     //!
     //! @param      mi              Interaction with the medium.
@@ -109,15 +123,11 @@ public:
     //! @return     Return true if the material is attached with a volume.
     virtual bool        HasVolumeAttached() const = 0;
 
-    //! @brief  Get volume ray matching step size.
-    //!
-    //! @return     Ray marching step size.
-    virtual float       GetVolumeStep() const = 0;
-
-    //! @brief  Get volume ray marching max step count.
+    //! @brief  Get an upper bound of the extinction coefficient of the volume.
     //!
-    //! @return     Maximum steps to march during ray marching.
-    virtual unsigned int GetVolumeStepCnt() const = 0;
+    //! @param  max_density     The maximum density of the region of interest.
+    //! @return                 An extinction coefficient no smaller than any channel inside the region.
+    virtual float       GetVolumeMajorant(const float max_density) const = 0;
 };
 
 //! @brief  A thin layer of material definition.
@@ -137,6 +147,12 @@ public:
     //! @param      se              Scattering event to be returned.
     void        UpdateScatteringEvent( ScatteringEvent& se, RenderContext& rc ) const override;
 
+    //! @brief      Parse scattering events of multiple interactions sharing this material in one go.
+    //!
+    //! @param      ses             Scattering events to be returned.
+    //! @param      cnt             Number of scattering events.
+    void        UpdateScatteringEvents( ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc ) const override;
+
     //! @brief      Parse volume from the material shader.
     //!
     //! @param      mi              Interaction with the medium.
@@ -161,6 +177,9 @@ public:
         if (!m_hasTransparentNode)
             return 0.0f;
         
+        if (m_constant_surface_shader)
+            return m_constant_transparency;
+
         return m_special_transparent ? 1.0f : (::EvaluateTransparency(m_surface_shader.get(), intersection));
     }
 
@@ -204,19 +223,13 @@ public:
         return m_volume_shader_valid;
     }
 
-    //! @brief  Get volume ray matching step size.
+    //! @brief  Get an upper bound of the extinction coefficient of the volume.
     //!
-    //! @return Ray marching step size.
-    float       GetVolumeStep() const override {
-        return m_volumeStep;
-    }
-
-    //! @brief  Get volume ray marching max step count.
+    //! The bound is exact for densities covered by the tabulated extinction, beyond that it is extrapolated.
     //!
-    //! @return Maximum steps to march during ray marching.
-    unsigned int GetVolumeStepCnt() const override{
-        return m_volumeStepCnt;
-    }
+    //! @param  max_density     The maximum density of the region of interest.
+    //! @return                 An extinction coefficient no smaller than any channel inside the region.
+    float       GetVolumeMajorant(const float max_density) const override;
 
 private:
     /**< Whether this is a valid material */
@@ -247,11 +260,20 @@ private:
     /**< Shader unit default values. */
     std::vector<ShaderParamDefaultValue>        m_paramDefaultValues;
 
+    /**< Whether the surface shader has no dependency on tsl globals, meaning it results in the same closures for all hits. */
+    bool                                        m_constant_surface_shader = false;
+    /**< Flattened closures of the constant surface shader, they are evaluated only once during material building. */
+    std::vector<FlattenedSurfaceClosure>        m_constant_closures;
+    /**< Memory holding the closure parameters of the constant surface shader. */
+    MemoryAllocator                             m_constant_closure_arena;
+    /**< Transparency of the constant surface shader. */
+    Spectrum                                    m_constant_transparency;
+
     bool                            m_hasTransparentNode = false;
     bool                            m_hasSSSNode = false;
 
-    float                           m_volumeStep = 0.1f;
-    unsigned int                    m_volumeStepCnt = 1024;
+    /**< Volume shader tabulated over density, majorants of tracking come from it. */
+    VolumeShaderTable               m_volume_table;
 };
 
 //! @brief  MaterialProxy is nothing but a thin wrapper of another existed material.
@@ -272,6 +294,12 @@ public:
     //! @param      se              Scattering event to be returned.
     void       UpdateScatteringEvent(ScatteringEvent& se, RenderContext& rc) const override;
 
+    //! @brief      Parse scattering events of multiple interactions sharing this material in one go.
+    //!
+    //! @param      ses             Scattering events to be returned.
+    //! @param      cnt             Number of scattering events.
+    void       UpdateScatteringEvents(ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc) const override;
+
     //! @brief      Parse volume from the material shader.
     //! @param      mi              Interaction with the medium.
     //! @param      flag            A flag indicates whether to add or remove the medium.
@@ -322,15 +350,11 @@ public:
     //! @return Return true if the material is attached with a volume.
     bool       HasVolumeAttached() const override;
 
-    //! @brief  Get volume ray matching step size.
-    //!
-    //! @return Ray marching step size.
-    float       GetVolumeStep() const override;
-
-    //! @brief  Get volume ray marching max step count.
+    //! @brief  Get an upper bound of the extinction coefficient of the volume.
     //!
-    //! @return Maximum steps to march during ray marching.
-    unsigned int GetVolumeStepCnt() const override;
+    //! @param  max_density     The maximum density of the region of interest.
+    //! @return                 An extinction coefficient no smaller than any channel inside the region.
+    float       GetVolumeMajorant(const float max_density) const override;
 
 private:
     /**< Material to be referred. */
@@ -140,6 +140,10 @@ std::vector<std::unique_ptr<MaterialBase>>& MatManager::ParseMatFile( IStreamBas
             // push it if it compiles the shader successful
             if( ret )
                 m_shader_units[shader_node_type] = shader_unit_template;
+
+            // keep track of shader units reading tsl globals, materials without any of them can be evaluated only once.
+            if (source_code.find("global_value") != std::string::npos)
+                m_tsl_global_dependent_units.insert(shader_node_type);
         }
         else if (material_type == SID("ShaderGroupTemplate")) {
             // The following logic is very similar with 
@@ -151,6 +155,9 @@ std::vector<std::unique_ptr<MaterialBase>>& MatManager::ParseMatFile( IStreamBas
 
             TSL_ShaderData shader_data;
 
+            // whether the shader group reads tsl global, either through its shader units or its default values.
+            auto depends_on_tsl_global = false;
+
             for (auto i = 0u; i < shader_unit_cnt; ++i) {
                 // parse surface shader
                 ShaderSource shader_source;
@@ -179,14 +186,19 @@ std::vector<std::unique_ptr<MaterialBase>>& MatManager::ParseMatFile( IStreamBas
                         std::string str;
                         stream >> str;
                         default_value.default_value = Tsl_Namespace::make_tsl_global_ref(str);
+                        depends_on_tsl_global = true;
                     }
 
                     m_paramDefaultValues.push_back(default_value);
                 }
 
+                depends_on_tsl_global |= DependsOnTslGlobal(shader_source.type);
                 shader_data.m_sources.push_back(shader_source);
             }
 
+            if (depends_on_tsl_global)
+                m_tsl_global_dependent_units.insert(shader_template_type);
+
             auto connection_cnt = 0u;
             stream >> connection_cnt;
             for (auto i = 0u; i < connection_cnt; ++i) {
@@ -288,6 +300,10 @@ std::vector<std::unique_ptr<MaterialBase>>& MatManager::ParseMatFile( IStreamBas
     return m_matPool;
 }
 
+bool MatManager::DependsOnTslGlobal(const std::string& name) const {
+    return m_tsl_global_dependent_units.count(name) > 0;
+}
+
 const Resource* MatManager::GetResource(const std::string& name) const {
     auto it = m_resources.find(name);
     if (it == m_resources.end())
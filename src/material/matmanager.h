@@ -21,6 +21,7 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include "core/singleton.h"
 #include "material/material.h"
 #include "core/resource.h"
@@ -75,12 +76,19 @@ public:
     //! @return             The shader unit template returned, nullptr if it doesn't exist.
     std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate> GetShaderUnitTemplate(const std::string& name) const;
 
+    //! @brief  Whether a shader unit template reads any tsl global, directly or through its children.
+    //!
+    //! @param  name        The name of the template.
+    //! @return             True if the output of the shader unit could vary from hit to hit.
+    bool        DependsOnTslGlobal(const std::string& name) const;
+
 private:
     std::vector<std::unique_ptr<MaterialBase>>       m_matPool;         /**< Material pool holding all materials. */
 
     std::unordered_map<std::string, std::unique_ptr<Resource>>  m_resources;       /**< Resources used during BXDF evaluation. */
 
     std::unordered_map<std::string, std::shared_ptr<Tsl_Namespace::ShaderUnitTemplate>>     m_shader_units;
+    std::unordered_set<std::string>  m_tsl_global_dependent_units;  /**< Shader unit templates that read tsl globals. */
 
     /**< Shader unit default values. */
     std::vector<ShaderParamDefaultValue>        m_paramDefaultValues;
@@ -45,6 +45,10 @@ IMPLEMENT_TSLGLOBAL_END()
 // this by myself. But it also looks like Marl doesn't voilate this assumption too.
 static thread_local MemoryAllocator g_memory_arena;
 
+// Number of hits to be shaded in one go during batched shading. All closure trees of a chunk need to stay alive
+// in the memory arena before they get processed, this number makes sure it won't take too much memory.
+static constexpr unsigned int SHADING_BATCH_SIZE = 64;
+
 class TSL_ShadingSystemInterface : public ShadingSystemInterface {
 public:
     void*   allocate(unsigned int size) const override {
@@ -70,13 +74,16 @@ public:
     }
 };
 
-void ExecuteSurfaceShader( Tsl_Namespace::ShaderInstance* shader , ScatteringEvent& se , RenderContext& rc){
-    const SurfaceInteraction& intersection = se.GetInteraction();
-    TslGlobal global;
+SORT_STATIC_FORCEINLINE void setupSurfaceGlobal(const SurfaceInteraction& intersection, TslGlobal& global) {
     global.uvw = make_float3(intersection.u, intersection.v, 0.0f);
     global.normal = make_float3(intersection.normal.x, intersection.normal.y, intersection.normal.z);
     global.I = make_float3(intersection.view.x, intersection.view.y, intersection.view.z);
     global.position = make_float3(intersection.intersect.x, intersection.intersect.y, intersection.intersect.z);
+}
+
+void ExecuteSurfaceShader( Tsl_Namespace::ShaderInstance* shader , ScatteringEvent& se , RenderContext& rc){
+    TslGlobal global;
+    setupSurfaceGlobal(se.GetInteraction(), global);
 
     // shader execution
     ClosureTreeNodeBase* closure = nullptr;
@@ -89,6 +96,49 @@ void ExecuteSurfaceShader( Tsl_Namespace::ShaderInstance* shader , ScatteringEve
     ProcessSurfaceClosure(closure, Tsl_Namespace::make_float3(1.0f, 1.0f, 1.0f) , se , rc);
 }
 
+void ExecuteSurfaceShader(Tsl_Namespace::ShaderInstance* shader, ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc) {
+    TslGlobal globals[SHADING_BATCH_SIZE];
+    ClosureTreeNodeBase* closures[SHADING_BATCH_SIZE];
+
+    // the function pointer is resolved only once for the whole batch
+    auto raw_function = (void(*)(ClosureTreeNodeBase**, TslGlobal*))shader->get_function();
+
+    for (auto offset = 0u; offset < cnt; offset += SHADING_BATCH_SIZE) {
+        const auto chunk = std::min(SHADING_BATCH_SIZE, cnt - offset);
+
+        for (auto i = 0u; i < chunk; ++i)
+            setupSurfaceGlobal(ses[offset + i]->GetInteraction(), globals[i]);
+
+        // closure trees of the whole chunk are kept alive in the arena until all of them are processed
+        g_memory_arena.Reset();
+        for (auto i = 0u; i < chunk; ++i) {
+            closures[i] = nullptr;
+            raw_function(&closures[i], &globals[i]);
+        }
+
+        // parse the surface shaders
+        for (auto i = 0u; i < chunk; ++i)
+            ProcessSurfaceClosure(closures[i], Tsl_Namespace::make_float3(1.0f, 1.0f, 1.0f), *ses[offset + i], rc);
+    }
+}
+
+const ClosureTreeNodeBase* ExecuteConstantSurfaceShader(Tsl_Namespace::ShaderInstance* shader, MemoryAllocator& arena) {
+    // none of the tsl globals is read by the shader, leaving them zero-initialized won't matter.
+    TslGlobal global = {};
+
+    ClosureTreeNodeBase* closure = nullptr;
+    auto raw_function = (void(*)(ClosureTreeNodeBase**, TslGlobal*))shader->get_function();
+
+    g_memory_arena.Reset();
+    raw_function(&closure, &global);
+
+    // hand the memory of the closure tree over to the caller, the thread local arena starts from scratch again.
+    arena = std::move(g_memory_arena);
+    g_memory_arena = MemoryAllocator();
+
+    return closure;
+}
+
 void ExecuteVolumeShader(Tsl_Namespace::ShaderInstance* shader, const MediumInteraction& mi, MediumStack& ms, const SE_Interaction flag, const MaterialBase* material , RenderContext& rc) {
     //const SurfaceInteraction& intersection = se.GetInteraction();
     TslGlobal global;
@@ -105,8 +155,12 @@ void ExecuteVolumeShader(Tsl_Namespace::ShaderInstance* shader, const MediumInte
 }
 
 void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const MediumInteraction& mi, MediumSample& ms) {
+    EvaluateVolumeSample(shader, mi.mesh->SampleVolumeDensity(mi.intersect), ms);
+}
+
+void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const float density, MediumSample& ms) {
     TslGlobal global;
-    global.density = mi.mesh->SampleVolumeDensity(mi.intersect);
+    global.density = density;
 
     ClosureTreeNodeBase* closure = nullptr;
     auto raw_function = (void(*)(ClosureTreeNodeBase**, TslGlobal*))shader->get_function();
@@ -119,11 +173,8 @@ void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const MediumInt
 
 Spectrum EvaluateTransparency(Tsl_Namespace::ShaderInstance* shader , const SurfaceInteraction& intersection ){
     TslGlobal global;
-    global.uvw = make_float3(intersection.u, intersection.v, 0.0f);
-    global.normal = make_float3(intersection.normal.x, intersection.normal.y, intersection.normal.z);
-    global.I = make_float3(intersection.view.x, intersection.view.y, intersection.view.z);
+    setupSurfaceGlobal(intersection, global);
     global.gnormal = make_float3(intersection.gnormal.x, intersection.gnormal.y, intersection.gnormal.z);
-    global.position = make_float3(intersection.intersect.x, intersection.intersect.y, intersection.intersect.z);
 
     // shader execution
     ClosureTreeNodeBase* closure = nullptr;
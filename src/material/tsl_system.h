@@ -23,6 +23,7 @@
 #include <tsl_system.h>
 #include <string>
 #include "core/define.h"
+#include "core/memory.h"
 #include "math/vector3.h"
 #include "spectrum/spectrum.h"
 #include "closures.h"
@@ -65,6 +66,27 @@ struct ShaderCompilingContext {
 //! @brief  Execute Jited shader code.
 void ExecuteSurfaceShader(Tsl_Namespace::ShaderInstance* shader, ScatteringEvent& se, RenderContext& rc);
 
+//! @brief  Execute Jited shader code for a batch of scattering events sharing the same shader.
+//!
+//! Instead of interleaving shader execution and closure processing for each hit, the shader is executed
+//! for a whole chunk of hits first and the closure trees are processed afterward. This amortizes the
+//! per-call setup and keeps the JIT code and the closure processing code hot in the instruction cache.
+//!
+//! @param  shader      The tsl shader to be evaluated.
+//! @param  ses         Scattering events to be populated, all of them need to share the shader.
+//! @param  cnt         Number of scattering events in the batch.
+void ExecuteSurfaceShader(Tsl_Namespace::ShaderInstance* shader, ScatteringEvent* const* ses, const unsigned int cnt, RenderContext& rc);
+
+//! @brief  Execute a surface shader that has no dependency on tsl globals and keep its closure tree alive.
+//!
+//! The closure tree of such a shader is the same for all hits. It is evaluated only once and the memory holding the
+//! closure tree is handed over to the caller so that it can be reused across all hits.
+//!
+//! @param  shader      The tsl shader to be evaluated.
+//! @param  arena       The memory arena that takes the ownership of the closure tree.
+//! @return             The root of the closure tree.
+const Tsl_Namespace::ClosureTreeNodeBase* ExecuteConstantSurfaceShader(Tsl_Namespace::ShaderInstance* shader, MemoryAllocator& arena);
+
 //! @brief  Execute a shader and populate the medium stack
 //!
 //! @param  shader      The tsl shader to be evaluated.
@@ -81,6 +103,13 @@ void ExecuteVolumeShader(Tsl_Namespace::ShaderInstance* shader, const MediumInte
 //! @param  ms          The medium sample to be returned.
 void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const MediumInteraction& mi, MediumSample& ms);
 
+//! @brief  Evaluate the properties of the volume given a density.
+//!
+//! @param  shader      The tsl shader to be executed.
+//! @param  density     The density of the volume.
+//! @param  ms          The medium sample to be returned.
+void EvaluateVolumeSample(Tsl_Namespace::ShaderInstance* shader, const float density, MediumSample& ms);
+
 //! @brief  Evaluate the transparency of the intersection.
 //!
 //! @param  shader          The tsl shader to be evaluated.
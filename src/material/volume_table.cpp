@@ -0,0 +1,116 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include "volume_table.h"
+#include "math/utils.h"
+
+// Multiples of the maximum tabulated density at which volume shaders are evaluated to extrapolate the extinction bound.
+static constexpr float VOLUME_MAJORANT_EXTRAPOLATION[] = { 1.5f, 2.0f, 4.0f, 8.0f, 16.0f, 64.0f };
+
+SORT_STATIC_FORCEINLINE float maxExtinction(const MediumSample& ms) {
+    return (ms.basecolor * ms.extinction).GetMaxComponent();
+}
+
+#ifdef SORT_ENABLE_VOLUME_SHADER_LUT
+// Maximum extinction of all channels between two entries as it is interpolated by lookups. Base color and extinction
+// are interpolated separately, their product is a quadratic along the segment that may peak between the entries.
+static float maxInterpolatedExtinction(const MediumSample& ms0, const MediumSample& ms1) {
+    auto ret = std::max(maxExtinction(ms0), maxExtinction(ms1));
+    const auto b0 = ms0.extinction, db = ms1.extinction - ms0.extinction;
+    for (auto c = 0; c < RGBSPECTRUM_SAMPLE; ++c) {
+        const auto a0 = ms0.basecolor[c], da = ms1.basecolor[c] - ms0.basecolor[c];
+        const auto curvature = da * db;
+        if (curvature >= 0.0f)
+            continue;
+
+        const auto t = -(a0 * db + b0 * da) / (2.0f * curvature);
+        if (t > 0.0f && t < 1.0f)
+            ret = std::max(ret, (a0 + t * da) * (b0 + t * db));
+    }
+    return ret;
+}
+
+SORT_STATIC_FORCEINLINE MediumSample lerpMediumSample(const MediumSample& ms0, const MediumSample& ms1, const float t) {
+    MediumSample ms;
+    ms.basecolor = slerp(ms0.basecolor, ms1.basecolor, t);
+    ms.emission = slerp(ms0.emission, ms1.emission, t);
+    ms.absorption = slerp(ms0.absorption, ms1.absorption, t);
+    ms.scattering = slerp(ms0.scattering, ms1.scattering, t);
+    ms.extinction = slerp(ms0.extinction, ms1.extinction, t);
+    ms.anisotropy = slerp(ms0.anisotropy, ms1.anisotropy, t);
+    return ms;
+}
+#endif
+
+void VolumeShaderTable::Build(const Evaluator& evaluate) {
+    m_evaluate = evaluate;
+
+    std::vector<MediumSample> samples(SIZE);
+    for (auto i = 0u; i < SIZE; ++i)
+        m_evaluate(MAX_DENSITY * i / (SIZE - 1), samples[i]);
+
+    // The running maximum of extinction bounds every density up to each entry. With the lookup table, it covers
+    // what lookups return between entries too, otherwise it is only as good as the sampling of the shader.
+    m_majorants.resize(SIZE);
+    auto majorant = 0.0f;
+    for (auto i = 0u; i < SIZE; ++i) {
+#ifdef SORT_ENABLE_VOLUME_SHADER_LUT
+        majorant = std::max(majorant, i > 0 ? maxInterpolatedExtinction(samples[i - 1], samples[i]) : maxExtinction(samples[i]));
+#else
+        majorant = std::max(majorant, maxExtinction(samples[i]));
+#endif
+        m_majorants[i] = majorant;
+    }
+
+    // the bound of higher densities is extrapolated linearly from a few shader evaluations
+    m_slope = 0.0f;
+    for (const auto scale : VOLUME_MAJORANT_EXTRAPOLATION) {
+        MediumSample ms;
+        m_evaluate(MAX_DENSITY * scale, ms);
+        m_slope = std::max(m_slope, (maxExtinction(ms) - majorant) / (MAX_DENSITY * (scale - 1.0f)));
+    }
+
+#ifdef SORT_ENABLE_VOLUME_SHADER_LUT
+    m_samples = std::move(samples);
+#endif
+}
+
+void VolumeShaderTable::Evaluate(const float density, MediumSample& ms) const {
+#ifdef SORT_ENABLE_VOLUME_SHADER_LUT
+    const auto x = std::max(density, 0.0f) * (SIZE - 1) / MAX_DENSITY;
+    if (x < SIZE - 1) {
+        const auto i = (unsigned int)x;
+        ms = lerpMediumSample(m_samples[i], m_samples[i + 1], x - i);
+        return;
+    }
+#endif
+
+    // densities out of the range of the table are evaluated by the shader
+    m_evaluate(density, ms);
+}
+
+float VolumeShaderTable::GetMajorant(const float max_density) const {
+    if (m_majorants.empty())
+        return 0.0f;
+
+    const auto density = std::max(max_density, 0.0f);
+    const auto x = density * (SIZE - 1) / MAX_DENSITY;
+    if (x <= SIZE - 1)
+        return m_majorants[std::min((unsigned int)std::ceil(x), SIZE - 1)];
+    return m_majorants.back() + m_slope * (density - MAX_DENSITY);
+}
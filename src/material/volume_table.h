@@ -0,0 +1,74 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "medium/medium.h"
+
+//! @brief  Volume shader results tabulated over density.
+/**
+ * Density is the only tsl global available to volume shaders, the rest of them are always zero. This means a volume
+ * shader is purely a function of density, which is tabulated once when the material is built. The table serves two
+ * purposes, a bound of extinction over density for the majorants of tracking, and a lookup table replacing shader
+ * execution in volumes, which is only kept with SORT_ENABLE_VOLUME_SHADER_LUT. Densities beyond the table are always
+ * evaluated by the shader.
+ */
+class VolumeShaderTable {
+public:
+    //! @brief  Evaluate the volume shader at a density.
+    using Evaluator = std::function<void(const float density, MediumSample& ms)>;
+
+    //! @brief  Number of densities the volume shader is tabulated at.
+    static constexpr unsigned int   SIZE = 1024;
+    //! @brief  Maximum density covered by the table.
+    static constexpr float          MAX_DENSITY = 4.0f;
+
+    //! @brief  Tabulate a volume shader.
+    //!
+    //! @param  evaluate    The volume shader, it has to outlive the table.
+    void    Build(const Evaluator& evaluate);
+
+    //! @brief  Whether there is a volume shader tabulated.
+    bool    IsValid() const {
+        return !m_majorants.empty();
+    }
+
+    //! @brief  Get the result of the volume shader at a density.
+    //!
+    //! @param  density     The density of interest.
+    //! @param  ms          The result of the volume shader.
+    void    Evaluate(const float density, MediumSample& ms) const;
+
+    //! @brief  Get an upper bound of the extinction coefficient of all channels up to a density.
+    //!
+    //! With the lookup table on, the bound is strict for densities covered by the table, it takes the interpolation of
+    //! base color and extinction between entries into account. Without it, it is a conservative estimate from sampling
+    //! the shader, shaders peaking between two entries could exceed it. The bound of higher densities is extrapolated,
+    //! which is an estimate as well. Tracking detects extinction above the bound and falls back to handle it.
+    //!
+    //! @param  max_density     The maximum density of the region of interest.
+    //! @return                 An extinction coefficient no smaller than any channel inside the region.
+    float   GetMajorant(const float max_density) const;
+
+private:
+    Evaluator                   m_evaluate;             /**< The volume shader. */
+    std::vector<MediumSample>   m_samples;              /**< Shader results at each density, it is empty without the lookup table. */
+    std::vector<float>          m_majorants;            /**< The maximum extinction of densities from zero up to each entry. */
+    float                       m_slope = 0.0f;         /**< How fast the extinction bound grows beyond the table. */
+};
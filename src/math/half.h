@@ -0,0 +1,83 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string.h>
+#include "core/define.h"
+
+// Conversion between single precision and IEEE 754 half precision floating point numbers, which is used to store
+// large tables of measured data in a compact way.
+
+//! @brief  Convert a single precision float to the nearest half precision float.
+//!
+//! Finite values out of the range of half precision are clamped to the largest finite half instead of overflowing
+//! to infinity, infinity and NaN are preserved. Values too small to be represented become zero with the same sign.
+//!
+//! @param  f       The single precision float.
+//! @return         Bits of the half precision float.
+SORT_FORCEINLINE uint16_t floatToHalf( const float f ){
+    uint32_t bits;
+    memcpy( &bits , &f , sizeof( bits ) );
+
+    const auto sign = ( bits >> 16 ) & 0x8000;
+    const auto exponent = (int)( ( bits >> 23 ) & 0xff ) - 127 + 15;
+    auto mantissa = bits & 0x7fffff;
+
+    // infinity stays infinity, NaN is always converted to a quiet NaN
+    if( exponent == 0xff - 127 + 15 )
+        return (uint16_t)( sign | 0x7c00 | ( mantissa ? 0x200 : 0 ) );
+
+    // too small to be represented as a denormalized half
+    if( exponent < -10 )
+        return (uint16_t)sign;
+
+    // denormalized half
+    if( exponent <= 0 ){
+        mantissa |= 0x800000;
+        const auto shift = 14 - exponent;
+        return (uint16_t)( sign | ( ( mantissa + ( 1u << ( shift - 1 ) ) ) >> shift ) );
+    }
+
+    // clamp to the largest finite half
+    if( exponent >= 31 )
+        return (uint16_t)( sign | 0x7bff );
+
+    // round to nearest, a carry into the exponent is still a correctly rounded result
+    return (uint16_t)std::min( sign | ( ( ( (uint32_t)exponent << 10 ) | ( mantissa >> 13 ) ) + ( ( mantissa >> 12 ) & 1 ) ) , sign | 0x7bff );
+}
+
+//! @brief  Convert a half precision float to single precision, the conversion is exact.
+//!
+//! @param  h       Bits of the half precision float.
+//! @return         The single precision float.
+SORT_FORCEINLINE float halfToFloat( const uint16_t h ){
+    // Shifting exponent and mantissa to their place in single precision and re-biasing the exponent through a multiply
+    // handles normalized and denormalized halfs alike, infinity and NaN need the exponent to be all ones instead.
+    auto bits = (uint32_t)( h & 0x7fff ) << 13;
+    float f;
+    if( ( h & 0x7c00 ) == 0x7c00 ){
+        bits |= 0x7f800000;
+        memcpy( &f , &bits , sizeof( f ) );
+    }else{
+        memcpy( &f , &bits , sizeof( f ) );
+        f *= 5.192296858534828e+33f;    // 2 ^ ( 127 - 15 )
+    }
+    return ( h & 0x8000 ) ? -f : f;
+}
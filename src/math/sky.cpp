@@ -33,7 +33,7 @@ Spectrum Sky::Evaluate( const Vector& wi ) const
 }
 
 // get the average radiance
-Spectrum Sky::GetAverage() const
+RGBSpectrum Sky::GetAverage() const
 {
     return m_sky.GetAverage();
 }
@@ -55,7 +55,7 @@ void Sky::_generateDistribution2D()
     }
 
     distribution.reset();
-    distribution = std::make_unique<Distribution2D>( data.get() , nu , nv );
+    distribution = std::make_unique<AliasDistribution2D>( data.get() , nu , nv );
 }
 
 // sample direction
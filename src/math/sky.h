@@ -33,7 +33,7 @@ public:
     Spectrum Evaluate(const Vector& r) const;
 
     // get the average radiance
-    Spectrum GetAverage() const;
+    RGBSpectrum GetAverage() const;
 
     // sample direction
     Vector sample_v(float u, float v, float* pdf, float* area_pdf) const;
@@ -51,7 +51,7 @@ public:
 
 private:
     ImageTexture2D    m_sky;
-    std::unique_ptr<class Distribution2D>   distribution = nullptr;
+    std::unique_ptr<class AliasDistribution2D>  distribution = nullptr;
 
     // generate 2d distribution
     void _generateDistribution2D();
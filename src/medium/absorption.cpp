@@ -25,7 +25,7 @@ IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeAbsorption, Tsl_float, absorption)
 IMPLEMENT_CLOSURE_TYPE_END(ClosureTypeAbsorption)
 
 Spectrum AbsorptionMedium::Tr( const Ray& ray , const float max_t , RenderContext& rc) const{
-    const auto e = m_globalMediumSample.basecolor * (m_globalMediumSample.absorption * -fmin(max_t, FLT_MAX ));
+    const auto e = Spectrum(m_globalMediumSample.basecolor) * (m_globalMediumSample.absorption * -fmin(max_t, FLT_MAX ));
     return e.Exp();
 }
 
@@ -21,6 +21,24 @@
 #include "core/render_context.h"
 #include "material/material.h"
 #include "phasefunction.h"
+#include "core/mesh.h"
+#include "core/stats.h"
+
+// Transmittance below which russian roulette kicks in during ratio tracking.
+static constexpr float RATIO_TRACKING_RR_THRESHOLD = 0.1f;
+// Probability to terminate ratio tracking in russian roulette.
+static constexpr float RATIO_TRACKING_RR_PROBABILITY = 0.75f;
+// Step size of ray marching in the unit of majorant cells, ray marching is only the fall back of tracking.
+static constexpr float RAY_MARCHING_STEP = 0.25f;
+// Maximum number of steps of ray marching, the step size grows for long rays.
+static constexpr unsigned int RAY_MARCHING_MAX_STEP_CNT = 4096;
+
+SORT_STATS_DEFINE_COUNTER(sTrackedRays)
+SORT_STATS_DEFINE_COUNTER(sMajorantViolations)
+
+SORT_STATS_COUNTER("Heterogeneous Medium", "Tracked Rays", sTrackedRays);
+SORT_STATS_COUNTER("Heterogeneous Medium", "Rays Falling Back to Ray Marching", sMajorantViolations);
+SORT_STATS_RATIO("Heterogeneous Medium", "Ray Marching Ratio", sMajorantViolations, sTrackedRays);
 
 IMPLEMENT_CLOSURE_TYPE_BEGIN(ClosureTypeHeterogenous)
 IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float3, base_color)
@@ -30,105 +48,339 @@ IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, scattering)
 IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeHeterogenous, Tsl_float, anisotropy)
 IMPLEMENT_CLOSURE_TYPE_END(ClosureTypeHeterogenous)
 
-Spectrum HeterogenousMedium::Tr(const Ray& ray, const float max_t, RenderContext& rc) const {
-    // get the step size and count
-    auto        step_size = m_material->GetVolumeStep();
-    const auto  step_cnt = m_material->GetVolumeStepCnt();
+// A segment along the ray with a constant majorant.
+struct MajorantSegment {
+    float t0 = 0.0f;            /**< Start of the segment. */
+    float t1 = 0.0f;            /**< End of the segment. */
+    float majorant = 0.0f;      /**< Upper bound of extinction coefficient of all channels inside the segment. */
+};
+
+//! @brief  Iterate through segments of a ray overlapping with cells of the majorant grid.
+/**
+ * The traversal happens in the space of the majorant grid, in which each cell is of unit size. Since the mapping
+ * from world space to volume space is affine, the ray parameter 't' remains the same in this space. Regions outside
+ * the volume have zero density, their extinction is bounded by the majorant of zero density.
+ */
+class MajorantIterator {
+public:
+    //! @brief  Constructor.
+    //!
+    //! @param  ray         The ray to traverse the volume.
+    //! @param  max_t       The maximum distance to be considered.
+    //! @param  mesh        The mesh holding the volume data.
+    //! @param  material    The material that spawns the medium.
+    MajorantIterator(const Ray& ray, const float max_t, const Mesh* mesh, const MaterialBase* material) :
+        m_max_t(max_t), m_material(material) {
+        m_empty_majorant = material->GetVolumeMajorant(0.0f);
+
+        m_density = mesh->GetVolumeDensity();
+        if (IS_PTR_INVALID(m_density) || !m_density->IsValid()) {
+            m_density = nullptr;
+            m_enter_t = m_exit_t = max_t;
+            return;
+        }
+
+        const auto& world2volume = mesh->GetWorldToVolume();
+        const auto ori = world2volume.TransformPoint(ray.m_Ori);
+        const auto dir = world2volume.TransformVector(ray.m_Dir);
+
+        // clip the ray against the bounding box of the grid
+        m_enter_t = 0.0f;
+        m_exit_t = max_t;
+        float o[3], d[3];
+        for (auto i = 0; i < 3; ++i) {
+            const auto extent = m_density->GetMajorantExtent(i);
+            o[i] = ori[i] * extent;
+            d[i] = dir[i] * extent;
+
+            if (d[i] == 0.0f) {
+                if (o[i] < 0.0f || o[i] > extent)
+                    m_enter_t = m_exit_t = max_t;
+                continue;
+            }
+
+            auto t_near = -o[i] / d[i];
+            auto t_far = (extent - o[i]) / d[i];
+            if (t_near > t_far)
+                std::swap(t_near, t_far);
+            m_enter_t = std::max(m_enter_t, t_near);
+            m_exit_t = std::min(m_exit_t, t_far);
+        }
+
+        if (m_enter_t >= m_exit_t) {
+            m_enter_t = m_exit_t = max_t;
+            return;
+        }
+
+        // setup the 3D-DDA
+        for (auto i = 0; i < 3; ++i) {
+            const auto res = (int)m_density->GetMajorantRes(i);
+            const auto p = o[i] + d[i] * m_enter_t;
+            m_cell[i] = clamp((int)p, 0, res - 1);
+
+            if (d[i] == 0.0f) {
+                m_next_t[i] = FLT_MAX;
+                m_delta_t[i] = FLT_MAX;
+                m_step[i] = 0;
+                m_out[i] = -1;
+            } else if (d[i] > 0.0f) {
+                m_next_t[i] = m_enter_t + (m_cell[i] + 1 - p) / d[i];
+                m_delta_t[i] = 1.0f / d[i];
+                m_step[i] = 1;
+                m_out[i] = res;
+            } else {
+                m_next_t[i] = m_enter_t + (m_cell[i] - p) / d[i];
+                m_delta_t[i] = -1.0f / d[i];
+                m_step[i] = -1;
+                m_out[i] = -1;
+            }
+        }
+    }
+
+    //! @brief  Get the next segment along the ray.
+    //!
+    //! @param  segment     The next segment to be returned.
+    //! @return             False if there is no segment left.
+    bool Next(MajorantSegment& segment) {
+        if (m_t >= m_max_t)
+            return false;
+
+        // the segment before entering or after leaving the grid
+        if (m_t < m_enter_t || m_t >= m_exit_t) {
+            segment.t0 = m_t;
+            segment.t1 = m_t < m_enter_t ? m_enter_t : m_max_t;
+            segment.majorant = m_empty_majorant;
+            m_t = segment.t1;
+            return true;
+        }
+
+        // the axis whose cell boundary is crossed first
+        const auto axis = (m_next_t[0] < m_next_t[1]) ? ((m_next_t[0] < m_next_t[2]) ? 0 : 2) : ((m_next_t[1] < m_next_t[2]) ? 1 : 2);
+
+        segment.t0 = m_t;
+        segment.t1 = std::min(m_next_t[axis], m_exit_t);
+        segment.majorant = m_material->GetVolumeMajorant(m_density->GetMaxDensity(m_cell[0], m_cell[1], m_cell[2]));
+        m_t = segment.t1;
+
+        m_cell[axis] += m_step[axis];
+        m_next_t[axis] += m_delta_t[axis];
+        if (m_cell[axis] == m_out[axis])
+            m_t = std::max(m_t, m_exit_t);
+        return true;
+    }
+
+    //! @brief  Get the distance along the ray to cross a majorant cell, it is the step size of ray marching.
+    //!
+    //! @return             The shortest distance between two cell boundaries along any axis.
+    float GetCellDistance() const {
+        if (IS_PTR_INVALID(m_density))
+            return m_max_t;
+        return std::min(std::min(m_delta_t[0], m_delta_t[1]), std::min(m_delta_t[2], m_max_t));
+    }
+
+private:
+    float                   m_t = 0.0f;             /**< Current position along the ray. */
+    float                   m_max_t;                /**< The maximum distance to be considered. */
+    float                   m_enter_t;              /**< Where the ray enters the grid. */
+    float                   m_exit_t;               /**< Where the ray exits the grid. */
+    float                   m_empty_majorant;       /**< Majorant outside the grid. */
+    int                     m_cell[3] = { 0, 0, 0 };/**< Current cell in the grid. */
+    int                     m_step[3] = { 0, 0, 0 };/**< Step of cell index when crossing a cell boundary. */
+    int                     m_out[3] = { 0, 0, 0 }; /**< Cell index indicating leaving the grid. */
+    float                   m_next_t[3];            /**< Where the next cell boundary is crossed along each axis. */
+    float                   m_delta_t[3];           /**< Distance between two cell boundaries along each axis. */
+    const MediumDensity*    m_density;              /**< Density data of the volume. */
+    const MaterialBase*     m_material;             /**< Material that spawns the medium. */
+};
+
+SORT_STATIC_FORCEINLINE float average(const Spectrum& s) {
+    auto sum = 0.0f;
+    for (auto i = 0; i < SPECTRUM_SAMPLE; ++i)
+        sum += s[i];
+    return sum / SPECTRUM_SAMPLE;
+}
+
+// The number of steps to march through a ray, along with the step size.
+SORT_STATIC_FORCEINLINE unsigned int rayMarchingSteps(const float max_t, float& step_size) {
+    step_size = std::max(step_size, max_t / RAY_MARCHING_MAX_STEP_CNT);
+    return std::min((unsigned int)std::ceil(max_t / step_size), RAY_MARCHING_MAX_STEP_CNT);
+}
+
+// Extinction bounds are exact for the tabulated densities only. Once extinction above the majorant is detected, tracking
+// is no longer unbiased and the whole ray is evaluated by ray marching instead, which doesn't depend on any bound.
+Spectrum HeterogenousMedium::rayMarchingTr(const Ray& ray, const float max_t, float step_size, RenderContext& rc) const {
+    const auto step_cnt = rayMarchingSteps(max_t, step_size);
 
     auto t = 0.0f;
     Spectrum exponent(0.0f);
-
-    // ray marching
-    for (auto i = 0u; i < step_cnt; ++i) {
-        const auto dt = t + step_size <= max_t ? step_size : max_t - t;
-        const auto new_t = t + dt * sort_rand<float>(rc);
+    for (auto i = 0u; i < step_cnt && t < max_t; ++i) {
+        const auto dt = std::min(step_size, max_t - t);
 
         // take a sample in the medium
         MediumSample ms;
         MediumInteraction tmp_mi;
-        tmp_mi.intersect = ray(new_t);
+        tmp_mi.intersect = ray(t + dt * sort_rand<float>(rc));
         tmp_mi.mesh = m_mesh;
         m_material->EvaluateMediumSample(tmp_mi, ms);
 
-        exponent -= ms.basecolor * ms.extinction * dt;
-
+        exponent -= Spectrum(ms.basecolor) * ms.extinction * dt;
         t += dt;
-
-        if (t >= max_t)
-            break;
     }
 
     return exponent.Exp();
 }
 
-Spectrum HeterogenousMedium::Sample(const Ray& ray, const float max_t, MediumInteraction*& mi, Spectrum& emission, RenderContext& rc) const {
+Spectrum HeterogenousMedium::rayMarchingSample(const Ray& ray, const float max_t, float step_size, MediumInteraction*& mi, Spectrum& emission, RenderContext& rc) const {
     // Distance Sample, Jan Novak
     // https://cs.dartmouth.edu/~wjarosz/publications/novak18monte-slides-3-distance-sampling.pdf
+    const auto step_cnt = rayMarchingSteps(max_t, step_size);
 
-    // get the step size and count
-    auto        step_size = m_material->GetVolumeStep();
-    const auto  step_cnt = m_material->GetVolumeStepCnt();
-
-    // always start from 0.0 regardless the min_t value setup in ray
     auto t = 0.0f;
-
-    // a random value
     auto r = sort_rand<float>(rc);
-
-    // accumulative transmittance
     auto accum_transmittance = Spectrum(1.0f);
+    const auto ch = clamp((int)(sort_rand<float>(rc) * SPECTRUM_SAMPLE), 0, SPECTRUM_SAMPLE - 1);
 
-    // maybe a better sampling algorithm for channel picking later
-    const auto ch = clamp((int)(sort_rand<float>(rc) * RGBSPECTRUM_SAMPLE), 0, RGBSPECTRUM_SAMPLE - 1);
-
-    // ray marching
-    for (auto i = 0u; i < step_cnt; ++i) {
-        const auto dt = t + step_size <= max_t ? step_size : max_t - t;
-        const auto new_t = t + dt * sort_rand<float>(rc);
+    for (auto i = 0u; i < step_cnt && t < max_t; ++i) {
+        const auto dt = std::min(step_size, max_t - t);
 
         // take a sample in the medium
         MediumSample ms;
         MediumInteraction tmp_mi;
-        tmp_mi.intersect = ray(new_t);
+        tmp_mi.intersect = ray(t + dt * sort_rand<float>(rc));
         tmp_mi.mesh = m_mesh;
         m_material->EvaluateMediumSample(tmp_mi, ms);
 
         // beam transmittance along the ray through the short distance
-        const auto extinction = ms.basecolor * ms.extinction;
-        const auto exponent = -dt * extinction;
-        const auto beam_transmitancy = exponent.Exp();
+        const auto basecolor = Spectrum(ms.basecolor);
+        const auto extinction = basecolor * ms.extinction;
+        const auto beam_transmittance = (-dt * extinction).Exp();
 
-        if (1.0f - r >= beam_transmitancy[ch]) {
+        if (1.0f - r >= beam_transmittance[ch]) {
             // sample a medium and scatter the ray
-            const auto new_dt = -log(1.0f - r) / extinction[ch];
+            const auto new_dt = -std::log(1.0f - r) / extinction[ch];
 
             mi = SORT_MALLOC(rc.m_memory_arena, MediumInteraction)();
             mi->intersect = ray(t + new_dt);
             mi->phaseFunction = SORT_MALLOC(rc.m_memory_arena, HenyeyGreenstein)(ms.anisotropy);
-            
-            const auto new_exponent = -new_dt * extinction;
-            const auto new_beam_transmitancy = new_exponent.Exp();
-            accum_transmittance *= new_beam_transmitancy;
-            const auto new_pdf = accum_transmittance * extinction;
-            const auto pdf = (new_pdf[0] + new_pdf[1] + new_pdf[2]) / 3.0f;
-            accum_transmittance /= pdf;
 
-            // This model is what is used in PBRT and different from 'Production Volume Rendering' by Disney.
-            emission = ms.emission * ms.basecolor * ms.absorption * accum_transmittance;
+            accum_transmittance *= (-new_dt * extinction).Exp();
+            const auto pdf = average(accum_transmittance * extinction);
+            accum_transmittance /= pdf;
 
-            return accum_transmittance * ms.scattering * ms.basecolor;
-        } else {
-            accum_transmittance *= beam_transmitancy;
-            r = 1.0f - (1.0f - r) / beam_transmitancy[ch];
+            emission = ms.emission * basecolor * ms.absorption * accum_transmittance;
+            return accum_transmittance * ms.scattering * basecolor;
         }
 
+        accum_transmittance *= beam_transmittance;
+        r = 1.0f - (1.0f - r) / beam_transmittance[ch];
         t += dt;
+    }
+
+    // sampling the surface behind the volume instead of the volume itself.
+    return accum_transmittance / average(accum_transmittance);
+}
+
+Spectrum HeterogenousMedium::Tr(const Ray& ray, const float max_t, RenderContext& rc) const {
+    // Ratio Tracking, Novak et al. 2014
+    // https://cs.dartmouth.edu/~wjarosz/publications/novak14residual.html
+    Spectrum tr(1.0f);
+
+    SORT_STATS(++sTrackedRays);
+
+    MajorantSegment segment;
+    MajorantIterator it(ray, max_t, m_mesh, m_material);
+    while (it.Next(segment)) {
+        auto t = segment.t0;
+        while (segment.majorant > 0.0f) {
+            t -= std::log(1.0f - sort_rand<float>(rc)) / segment.majorant;
+            if (t >= segment.t1)
+                break;
+
+            // take a sample in the medium
+            MediumSample ms;
+            MediumInteraction tmp_mi;
+            tmp_mi.intersect = ray(t);
+            tmp_mi.mesh = m_mesh;
+            m_material->EvaluateMediumSample(tmp_mi, ms);
+
+            const auto extinction = Spectrum(ms.basecolor) * ms.extinction;
+            if (UNLIKELY(extinction.GetMaxComponent() > segment.majorant)) {
+                SORT_STATS(++sMajorantViolations);
+                return rayMarchingTr(ray, max_t, it.GetCellDistance() * RAY_MARCHING_STEP, rc);
+            }
 
-        if (t >= max_t)
-            break;
+            tr *= 1.0f - extinction / segment.majorant;
+
+            // russian roulette once the transmittance is low enough
+            const auto max_tr = tr.GetMaxComponent();
+            if (max_tr < RATIO_TRACKING_RR_THRESHOLD) {
+                if (sort_rand<float>(rc) < RATIO_TRACKING_RR_PROBABILITY)
+                    return 0.0f;
+                tr /= 1.0f - RATIO_TRACKING_RR_PROBABILITY;
+            }
+        }
+    }
+
+    return tr;
+}
+
+Spectrum HeterogenousMedium::Sample(const Ray& ray, const float max_t, MediumInteraction*& mi, Spectrum& emission, RenderContext& rc) const {
+    // Spectral Tracking, Kutz et al. 2017
+    // https://s3-us-west-1.amazonaws.com/disneyresearch/wp-content/uploads/20170823124227/Spectral-and-Decomposition-Tracking-for-Rendering-Heterogeneous-Volumes-Paper1.pdf
+    // Extinction is different in each channel, while the majorant is shared by all channels. Real and null collisions
+    // are picked based on the path weight so far, which falls back to plain delta tracking in monochromatic media.
+    Spectrum weight(1.0f);
+
+    SORT_STATS(++sTrackedRays);
+
+    MajorantSegment segment;
+    MajorantIterator it(ray, max_t, m_mesh, m_material);
+    while (it.Next(segment)) {
+        auto t = segment.t0;
+        while (segment.majorant > 0.0f) {
+            t -= std::log(1.0f - sort_rand<float>(rc)) / segment.majorant;
+            if (t >= segment.t1)
+                break;
+
+            // take a sample in the medium
+            MediumSample ms;
+            MediumInteraction tmp_mi;
+            tmp_mi.intersect = ray(t);
+            tmp_mi.mesh = m_mesh;
+            m_material->EvaluateMediumSample(tmp_mi, ms);
+
+            const auto basecolor = Spectrum(ms.basecolor);
+            const auto extinction = basecolor * ms.extinction;
+            if (UNLIKELY(extinction.GetMaxComponent() > segment.majorant)) {
+                SORT_STATS(++sMajorantViolations);
+                return rayMarchingSample(ray, max_t, it.GetCellDistance() * RAY_MARCHING_STEP, mi, emission, rc);
+            }
+            const auto null_extinction = segment.majorant - extinction;
+
+            const auto real_weight = average(weight * extinction);
+            const auto null_weight = average(weight * null_extinction);
+            if (real_weight + null_weight <= 0.0f)
+                return 0.0f;
+            const auto real_pdf = real_weight / (real_weight + null_weight);
+
+            if (sort_rand<float>(rc) < real_pdf) {
+                // sample a medium and scatter the ray
+                mi = SORT_MALLOC(rc.m_memory_arena, MediumInteraction)();
+                mi->intersect = ray(t);
+                mi->phaseFunction = SORT_MALLOC(rc.m_memory_arena, HenyeyGreenstein)(ms.anisotropy);
+
+                weight /= segment.majorant * real_pdf;
+
+                // This model is what is used in PBRT and different from 'Production Volume Rendering' by Disney.
+                emission = ms.emission * basecolor * ms.absorption * weight;
+
+                return weight * ms.scattering * basecolor;
+            }
+
+            weight *= null_extinction / (segment.majorant * (1.0f - real_pdf));
+        }
     }
 
     // sampling the surface behind the volume instead of the volume itself.
-    const auto pdf = (accum_transmittance[0] + accum_transmittance[1] + accum_transmittance[2]) / 3.0f;
-    return accum_transmittance / pdf;
+    return weight;
 }
\ No newline at end of file
@@ -52,7 +52,8 @@ public:
     //! @brief  Evaluation of beam transmittance.
     //!
     //! Beam transmittance is how much percentage of radiance get attenuated during
-    //! traveling through the medium. It is a spectrum dependent attenuation.
+    //! traveling through the medium. It is a spectrum dependent attenuation, which is estimated
+    //! by ratio tracking here.
     //!
     //! @param  ray         The ray, which it uses to evaluate beam transmittance.
     //! @param  max_t       The maximum distance to be considered, usually this is the distance the ray travels before it hits a surface.
@@ -61,8 +62,8 @@ public:
 
     //! @brief  Importance sampling a point along the ray in the medium.
     //!
-    //! This is no way to use Delta-Tracking algorithm due to the lack of context of maximum density because
-    //! density is a shader driven property, there is no way to explictly evaluate the maximum value.
+    //! Distances are sampled with delta tracking against the majorant grid of the volume density. Cells with zero
+    //! majorant are skipped entirely.
     //!
     //! @param ray          The ray we use to take sample.
     //! @param max_t        The maximum distance to be considered, usually this is the distance the ray travels before it hits a surface.
@@ -73,4 +74,22 @@ public:
 
 private:
     const Mesh* m_mesh;
+
+    //! @brief  Evaluation of beam transmittance by ray marching, it is the fall back when the majorant is exceeded.
+    //!
+    //! @param  ray         The ray, which it uses to evaluate beam transmittance.
+    //! @param  max_t       The maximum distance to be considered.
+    //! @param  step_size   The distance between two samples along the ray.
+    //! @return             The attenuation of each spectrum channel.
+    Spectrum rayMarchingTr(const Ray& ray, const float max_t, float step_size, RenderContext& rc) const;
+
+    //! @brief  Sampling a point along the ray by ray marching, it is the fall back when the majorant is exceeded.
+    //!
+    //! @param ray          The ray we use to take sample.
+    //! @param max_t        The maximum distance to be considered.
+    //! @param step_size    The distance between two samples along the ray.
+    //! @param mi           The interaction sampled.
+    //! @param emission     The emission contribution in RTE.
+    //! @return             The beam transmittance between the ray origin and the interaction.
+    Spectrum rayMarchingSample(const Ray& ray, const float max_t, float step_size, MediumInteraction*& mi, Spectrum& emission, RenderContext& rc) const;
 };
\ No newline at end of file
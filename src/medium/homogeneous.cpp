@@ -30,16 +30,17 @@ IMPLEMENT_CLOSURE_TYPE_VAR(ClosureTypeHomogeneous, Tsl_float, anisotropy)
 IMPLEMENT_CLOSURE_TYPE_END(ClosureTypeHomogeneous)
 
 Spectrum HomogeneousMedium::Tr( const Ray& ray , const float max_t, RenderContext& rc) const{
-    const auto e = m_globalMediumSample.basecolor * m_globalMediumSample.extinction * (-fmin(max_t, FLT_MAX ));
+    const auto e = Spectrum(m_globalMediumSample.basecolor) * m_globalMediumSample.extinction * (-fmin(max_t, FLT_MAX ));
     return e.Exp();
 }
 
 Spectrum HomogeneousMedium::Sample( const Ray& ray , const float max_t , MediumInteraction*& mi , Spectrum& emission , RenderContext& rc) const{
-    const auto extinction = m_globalMediumSample.basecolor * m_globalMediumSample.extinction;
-    const auto scattering = m_globalMediumSample.basecolor * m_globalMediumSample.scattering;
-    const auto absorption = m_globalMediumSample.basecolor * m_globalMediumSample.absorption;
+    const auto basecolor = Spectrum(m_globalMediumSample.basecolor);
+    const auto extinction = basecolor * m_globalMediumSample.extinction;
+    const auto scattering = basecolor * m_globalMediumSample.scattering;
+    const auto absorption = basecolor * m_globalMediumSample.absorption;
 
-    const auto ch = clamp( (int)(sort_rand<float>(rc) * RGBSPECTRUM_SAMPLE) , 0 , RGBSPECTRUM_SAMPLE - 1 );
+    const auto ch = clamp( (int)(sort_rand<float>(rc) * SPECTRUM_SAMPLE) , 0 , SPECTRUM_SAMPLE - 1 );
     const auto d = fmin( -log( sort_rand<float>(rc) ) / extinction[ch] , max_t );
 
     const auto sample_medium = d < max_t;
@@ -55,9 +56,9 @@ Spectrum HomogeneousMedium::Sample( const Ray& ray , const float max_t , MediumI
     const auto density = sample_medium ? (extinction * tr) : tr;
 
     auto pdf = 0.0f;
-    for( auto i = 0u ; i < RGBSPECTRUM_SAMPLE ; ++i )
+    for( auto i = 0u ; i < SPECTRUM_SAMPLE ; ++i )
         pdf += density[i];
-    pdf /= RGBSPECTRUM_SAMPLE;
+    pdf /= SPECTRUM_SAMPLE;
 
     // This should rarely happen, though.
     if ( UNLIKELY(pdf == 0.0f) )
@@ -65,7 +66,7 @@ Spectrum HomogeneousMedium::Sample( const Ray& ray , const float max_t , MediumI
 
     // This model is what is used in PBRT and different from 'Production Volume Rendering' by Disney.
     if (sample_medium)
-        emission = m_globalMediumSample.basecolor * m_globalMediumSample.emission * m_globalMediumSample.absorption * tr / pdf;
+        emission = basecolor * m_globalMediumSample.emission * m_globalMediumSample.absorption * tr / pdf;
 
     return sample_medium ? ( tr * scattering / pdf ) : ( tr / pdf );
 }
\ No newline at end of file
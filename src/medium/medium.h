@@ -50,7 +50,7 @@ SORT_FORCEINLINE SE_Interaction update_interaction_flag(const float cos_theta_wi
 }
 
 struct MediumSample {
-    Spectrum      basecolor;             /**< Base color of the medium. */
+    RGBSpectrum   basecolor;             /**< Base color of the medium, it is upsampled where it is used in spectral mode. */
     float         emission   = 0.0f;     /**< Emission coefficient. */
     float         absorption = 0.0f;     /**< Absorption coefficient. */
     float         scattering = 0.0f;     /**< Scattering coefficient. */
@@ -59,7 +59,7 @@ struct MediumSample {
 
     MediumSample():anisotropy(0.0f){}
 
-    MediumSample(const Spectrum& baseColor, const float emission, const float absorption, const float scattering, const float anisotropy) :
+    MediumSample(const RGBSpectrum& baseColor, const float emission, const float absorption, const float scattering, const float anisotropy) :
         basecolor(baseColor), emission(emission), absorption(absorption), scattering(scattering), extinction(absorption + scattering), anisotropy(anisotropy) {}
 };
 
@@ -74,7 +74,7 @@ public:
     //! @param  scattering  Scattering of the volume.
     //! @param  anisotropy  Anisotropy of the phase function.
     //! @param    material    Material that spawns the medium.
-    Medium( RenderContext& rc, const Spectrum& baseColor , const float emission, const float absorption , const float scattering , const float anisotropy , const MaterialBase* material ) : 
+    Medium( RenderContext& rc, const RGBSpectrum& baseColor , const float emission, const float absorption , const float scattering , const float anisotropy , const MaterialBase* material ) : 
         rc(rc), m_material( material ) , m_globalMediumSample(baseColor, emission, absorption, scattering, anisotropy) {}
 
     //! @brief  Evaluation of beam transmittance.
@@ -15,32 +15,69 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <memory>
+#include <vector>
 #include "mediumdata.h"
 #include "math/point.h"
 #include "stream/stream.h"
 
 float MediumDensity::Sample(const Point& uvw) const {
-    return ImageTexture3D::Sample(uvw[0], uvw[1], uvw[2]);
+    return SparseTexture3D::Sample(uvw[0], uvw[1], uvw[2]);
 }
 
 void MediumDensity::Serialize(IStreamBase& stream) {
-    stream >> m_width >> m_height >> m_depth;
+    unsigned int width, height, depth;
+    stream >> width >> height >> depth;
 
     // make sure the dimension is valid.
-    if (m_width == 0 || m_height == 0 || m_depth == 0)
+    if (width == 0 || height == 0 || depth == 0)
         return;
 
-    const auto tex_cnt = m_width * m_height * m_depth;
+    // dense data is only used temporarily to build the sparse bricks
+    const auto tex_cnt = width * height * depth;
+    auto texels = std::make_unique<float[]>(tex_cnt);
+    stream.Load((char*)texels.get(), sizeof(float) * tex_cnt);
 
-    m_memory = std::make_unique<ImgMemory<float>>();
-    m_memory->m_texel = std::make_unique<float[]>(tex_cnt);
-    stream.Load((char*)m_memory->m_texel.get(), sizeof(float) * tex_cnt);
+    BuildFromDense(width, height, depth, texels.get());
+    UpdateBrickMaximum([](const float density) { return density; });
+}
+
+void MediumDensity::SerializeSparse(IStreamBase& stream) {
+    unsigned int width, height, depth, brick_size, brick_cnt;
+    stream >> width >> height >> depth >> brick_size >> brick_cnt;
+
+    // make sure the dimension is valid.
+    if (width == 0 || height == 0 || depth == 0)
+        return;
+
+    // Bricks in the stream don't need to be of the same size as the ones used in the renderer.
+    Reset(width, height, depth);
+    std::vector<float> brick(brick_size * brick_size * brick_size);
+    for (auto i = 0u; i < brick_cnt; ++i) {
+        unsigned int bx, by, bz;
+        stream >> bx >> by >> bz;
+        stream.Load((char*)brick.data(), sizeof(float) * brick.size());
+
+        for (auto lz = 0u; lz < brick_size; ++lz) {
+            for (auto ly = 0u; ly < brick_size; ++ly) {
+                for (auto lx = 0u; lx < brick_size; ++lx) {
+                    const auto density = brick[(lz * brick_size + ly) * brick_size + lx];
+                    const auto x = bx * brick_size + lx, y = by * brick_size + ly, z = bz * brick_size + lz;
+                    if (density == 0.0f || x >= width || y >= height || z >= depth)
+                        continue;
+
+                    auto* voxels = AllocateBrick(x / BRICK_SIZE, y / BRICK_SIZE, z / BRICK_SIZE);
+                    voxels[((z % BRICK_SIZE) * BRICK_SIZE + (y % BRICK_SIZE)) * BRICK_SIZE + (x % BRICK_SIZE)] = density;
+                }
+            }
+        }
+    }
+
+    UpdateBrickMaximum([](const float density) { return density; });
 }
 
 Spectrum MediumColor::Sample(const Point& uvw) const {
-    // pos needs to be transformed from world space to local space before taking a sample.
-    // to be implemented
-    return 0.0f;
+    return SparseTexture3D::Sample(uvw[0], uvw[1], uvw[2]);
 }
 
 void MediumColor::Serialize(IStreamBase& stream) {
@@ -18,16 +18,16 @@
 #pragma once
 
 #include "core/define.h"
-#include "texture/imagetexture3d.h"
+#include "texture/sparsetexture3d.h"
 
 struct Point;
 class IStreamBase;
 
 //! @brief  Medium density data structure allows variation of density inside a medium volume.
 /**
- * Medium density is essentially a 3D texture.
+ * Medium density is essentially a 3D texture. It is stored sparsely since most of the volume is usually empty.
  */
-class MediumDensity : public ImageTexture3D<float> {
+class MediumDensity : public SparseTexture3D<float> {
 public:
     //! @brief  Take a sample in 3D texture.
     //!
@@ -35,15 +35,56 @@ public:
     //! @return         The density at the position related to the object.
     float   Sample( const Point& uvw) const;
 
-    //! @brief      Serializing data from stream.
+    //! @brief      Serializing dense data from stream.
     //!
     //! @param  Stream  where the serialization data comes from. Depending on different situation,
     //!                 it could come from different places.
     void    Serialize(IStreamBase& stream);
+
+    //! @brief      Serializing sparse data from stream.
+    //!
+    //! Only non-empty bricks are in the stream, each of them starts with its brick coordinate followed by its voxels.
+    //!
+    //! @param  Stream  where the serialization data comes from. Depending on different situation,
+    //!                 it could come from different places.
+    void    SerializeSparse(IStreamBase& stream);
+
+    //! @brief  Get the resolution of the majorant grid along an axis.
+    //!
+    //! Each brick of the density is a cell in the majorant grid.
+    //!
+    //! @param  axis    The axis of interest, 0 for x, 1 for y and 2 for z.
+    //! @return         Number of majorant cells along the axis, 0 if there is no valid density data.
+    unsigned int GetMajorantRes(int axis) const {
+        return GetBrickRes(axis);
+    }
+
+    //! @brief  Get the extent of the majorant grid along an axis in the unit of majorant cells.
+    //!
+    //! The last cell along an axis may only be partially covered by voxels, this returns the exact extent.
+    //!
+    //! @param  axis    The axis of interest, 0 for x, 1 for y and 2 for z.
+    //! @return         Extent of the volume in the unit of majorant cells.
+    float   GetMajorantExtent(int axis) const {
+        const unsigned int res[] = { m_width, m_height, m_depth };
+        return (float)res[axis] / (float)BRICK_SIZE;
+    }
+
+    //! @brief  Get the maximum density inside a majorant cell.
+    //!
+    //! The value is conservative for the trilinear filtered lookup, voxels right outside the cell are considered too.
+    //!
+    //! @param  x       X coordinate of the majorant cell.
+    //! @param  y       Y coordinate of the majorant cell.
+    //! @param  z       Z coordinate of the majorant cell.
+    //! @return         The maximum density in the cell, zero if the cell is not occupied at all.
+    float   GetMaxDensity(unsigned int x, unsigned int y, unsigned int z) const {
+        return IsBrickOccupied(x, y, z) ? GetBrickMaximum(x, y, z) : 0.0f;
+    }
 };
 
 //! @brief  Medium color data structure allows variation of color inside a medium volume.
-class MediumColor : public ImageTexture3D<Spectrum> {
+class MediumColor : public SparseTexture3D<Spectrum> {
 public:
     //! @brief  Take a sample in 3D texture.
     //!
@@ -24,6 +24,7 @@
 #include "scatteringevent/scatteringunit.h"
 
 struct RenderContext;
+struct MicrofacetLobe;
 
 //! @brief BXDF type.
 enum BXDF_TYPE{
@@ -105,6 +106,17 @@ public:
         return pdf( bsdfToBxdf(wo) , bsdfToBxdf(wi) );
     }
 
+    //! @brief  Get the parameters of the bxdf as a microfacet reflection lobe.
+    //!
+    //! Microfacet reflection lobes could be evaluated together with other such lobes in a scattering event, which is
+    //! cheaper than evaluating them one by one. Bxdfs other than microfacet reflection don't need to override it.
+    //!
+    //! @param  lobe    Parameters of the lobe.
+    //! @return         Whether the bxdf could be evaluated as a microfacet reflection lobe.
+    virtual bool    GetMicrofacetLobe( MicrofacetLobe& lobe ) const {
+        return false;
+    }
+
     //! @brief  Check the type of the bxdf, it shouldn't be overridden by derived classes.
     //!
     //! @param type     The type to check.
@@ -189,7 +189,7 @@ Spectrum DisneyBRDF::f( const Vector& wo , const Vector& wi ) const {
     const auto luminance = basecolor.GetIntensity();
     const auto Ctint = luminance > 0.0f ? basecolor * (1.0f / luminance) : Spectrum(1.0f);
 
-    auto ret = RGBSpectrum(0.0f);
+    auto ret = Spectrum(0.0f);
 
     const auto evaluate_reflection = PointingUp( wo ) && PointingUp( wi );
 
@@ -442,9 +442,9 @@ float DisneyBRDF::pdf( const Vector& wo , const Vector& wi ) const {
 
      static const float YWeight[3] = { 0.212671f, 0.715160f, 0.072169f };
      const auto luminance = YWeight[0] * params.baseColor.x + YWeight[1] * params.baseColor.y + YWeight[2] * params.baseColor.z;
-     const auto Ctint = luminance > 0.0f ? params.baseColor * (1.0f / luminance) : Spectrum(1.0f);
+     const auto Ctint = luminance > 0.0f ? Spectrum(params.baseColor) * (1.0f / luminance) : Spectrum(1.0f);
      const auto min_specular_amount = SchlickR0FromEta(ior_ex / ior_in);
-     const auto Cspec0 = slerp(params.specular * min_specular_amount * slerp(Spectrum(1.0f), Ctint, params.specularTint), params.baseColor, params.metallic);
+     const auto Cspec0 = slerp(params.specular * min_specular_amount * slerp(Spectrum(1.0f), Ctint, params.specularTint), Spectrum(params.baseColor), params.metallic);
 
      const auto clearcoat_weight = params.clearcoat * 0.04f;
      const auto specular_reflection_weight = Cspec0.GetIntensity() * specularPdfScale( params.roughness );
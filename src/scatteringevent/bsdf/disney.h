@@ -186,6 +186,11 @@ public:
     //! @return     Sampled normal direction based on the NDF.
     Vector sample_f(const BsdfSample& bs) const override;
 
+    //! @brief Clearcoat NDF is not supported in batched evaluation.
+    bool GetBatchParams(MicrofacetLobe& lobe) const override {
+        return false;
+    }
+
 protected:
     //! @brief Smith shadow-masking function G1
     float G1(const Vector& v) const override;
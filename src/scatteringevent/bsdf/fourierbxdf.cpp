@@ -18,6 +18,12 @@
 #include <string.h>
 #include <fstream>
 #include "fourierbxdf.h"
+
+#ifdef SIMD_4WAY_ENABLED
+#define SIMD_4WAY_IMPLEMENTATION
+#include "simd/simd_wrapper.h"
+#endif
+
 #include "core/memory.h"
 #include "core/samplemethod.h"
 #include "sampler/sample.h"
@@ -65,24 +71,41 @@ bool FourierBxdfData::LoadResource( const std::string filename ){
     offsetAndLength = std::make_unique<int[]>(sqMu * 2);
     bsdfTable.m = std::make_unique<int[]>(sqMu);
     bsdfTable.aOffset = std::make_unique<int[]>(sqMu);
-    bsdfTable.a = std::make_unique<float[]>(coeff);
+    auto a = std::make_unique<float[]>(coeff);
     bsdfTable.a0 = std::make_unique<float[]>(sqMu);
-    bsdfTable.recip = std::make_unique<float[]>(bsdfTable.nMu);
 
     if(!ReadFile( (char*)bsdfTable.mu.get() , bsdfTable.nMu * sizeof(float) ) ||
        !ReadFile( (char*)bsdfTable.cdf.get() , sqMu * sizeof(float) ) ||
        !ReadFile( (char*)offsetAndLength.get() , 2 * sqMu * sizeof(int) ) ||
-       !ReadFile( (char*)bsdfTable.a.get() , coeff * sizeof( float ) ) )
+       !ReadFile( (char*)a.get() , coeff * sizeof( float ) ) )
         {file.close(); return false;}
 
-    for( int i = 0 ; i < bsdfTable.nMu * bsdfTable.nMu ; ++i ){
-        bsdfTable.aOffset[i] = offsetAndLength[2*i];
-        bsdfTable.m[i] = offsetAndLength[2*i+1];
-        bsdfTable.a0[i] = ( bsdfTable.m[i] > 0 )?bsdfTable.a[offsetAndLength[2*i]]:0.0f;
+    // Coefficients of each channel are repacked so that they are zero padded to a multiple of four.
+    auto paddedCoeff = 0;
+    for( int i = 0 ; i < sqMu ; ++i ){
+        const auto offset = offsetAndLength[2*i] , m = offsetAndLength[2*i+1];
+        if( m < 0 || m > bsdfTable.nMax || offset < 0 || offset + m * bsdfTable.nChannels > coeff )
+            {file.close(); return false;}
+        paddedCoeff += ( ( m + 3 ) & ~3 ) * bsdfTable.nChannels;
+    }
+
+    bsdfTable.nMaxPadded = ( bsdfTable.nMax + 3 ) & ~3;
+    bsdfTable.a = std::make_unique<float[]>(paddedCoeff);
+    paddedCoeff = 0;
+    for( int i = 0 ; i < sqMu ; ++i ){
+        const auto offset = offsetAndLength[2*i] , m = offsetAndLength[2*i+1];
+        const auto mPadded = ( m + 3 ) & ~3;
+        bsdfTable.aOffset[i] = paddedCoeff;
+        bsdfTable.m[i] = m;
+        bsdfTable.a0[i] = ( m > 0 ) ? a[offset] : 0.0f;
+        for( int c = 0 ; c < bsdfTable.nChannels ; ++c )
+            memcpy( bsdfTable.a.get() + paddedCoeff + c * mPadded , a.get() + offset + c * m , sizeof( float ) * m );
+        paddedCoeff += mPadded * bsdfTable.nChannels;
     }
 
+    bsdfTable.recip = std::make_unique<float[]>(bsdfTable.nMaxPadded);
     bsdfTable.recip[0] = 0.0f;
-    for( int i = 1 ; i < bsdfTable.nMu ; ++i )
+    for( int i = 1 ; i < bsdfTable.nMaxPadded ; ++i )
         bsdfTable.recip[i] = 1.0f / (float) i;
 
     file.close();
@@ -102,11 +125,15 @@ Spectrum FourierBxdfData::f( const Vector& wo , const Vector& wi , RenderContext
         !getCatmullRomWeights( muO , offsetO , weightsO ) )
         return 0.0f;
 
-    auto ak = (float*)SORT_MALLOC_ARRAY(rc.m_memory_arena, float, bsdfTable.nMax * bsdfTable.nChannels );
-    memset( ak , 0 , sizeof( float ) * bsdfTable.nMax * bsdfTable.nChannels );
+    auto ak = (float*)SORT_MALLOC_ARRAY(rc.m_memory_arena, float, bsdfTable.nMaxPadded * bsdfTable.nChannels );
+    memset( ak , 0 , sizeof( float ) * bsdfTable.nMaxPadded * bsdfTable.nChannels );
     auto nMax = blendCoefficients( ak , bsdfTable.nChannels , offsetI, offsetO, weightsI, weightsO );
 
-    auto Y = (float)(std::max(0.0f, fourier(ak, nMax, dPhi)));
+    // all channels share the same cosine terms, they are evaluated together
+    float yrb[3];
+    FourierPacked( ak , bsdfTable.nMaxPadded , nMax , dPhi , bsdfTable.nChannels , yrb );
+
+    auto Y = std::max( 0.0f , yrb[0] );
     auto scale = (float)((muI != 0.0f) ? (1.0f / fabs(muI)) : 0.0f);
     if( muI * muO > 0.0f ){
         auto eta = ( muI > 0.0f ) ? 1 / bsdfTable.eta : bsdfTable.eta;
@@ -116,8 +143,8 @@ Spectrum FourierBxdfData::f( const Vector& wo , const Vector& wi , RenderContext
     if( bsdfTable.nChannels == 1 )
         return scale * Y;
 
-    auto R = fourier( ak + 1 * bsdfTable.nMax , nMax , dPhi );
-    auto B = fourier( ak + 2 * bsdfTable.nMax , nMax , dPhi );
+    auto R = yrb[1];
+    auto B = yrb[2];
     auto G = 1.39829f * Y - 0.100913f * B - 0.297375f * R;
     return Spectrum( R * scale , G * scale , B * scale ).Clamp( 0.0f , FLT_MAX );
 }
@@ -136,12 +163,12 @@ Spectrum FourierBxdfData::sample_f( const Vector& wo , Vector& wi , const BsdfSa
         return 0.0f;
     }
 
-    auto ak = (float*)SORT_MALLOC_ARRAY(rc.m_memory_arena, float, bsdfTable.nMax * bsdfTable.nChannels );
-    memset( ak , 0 , sizeof( float ) * bsdfTable.nMax * bsdfTable.nChannels );
+    auto ak = (float*)SORT_MALLOC_ARRAY(rc.m_memory_arena, float, bsdfTable.nMaxPadded * bsdfTable.nChannels );
+    memset( ak , 0 , sizeof( float ) * bsdfTable.nMaxPadded * bsdfTable.nChannels );
     auto nMax = blendCoefficients( ak , bsdfTable.nChannels , offsetI, offsetO, weightsI, weightsO );
 
     float phi, pdfPhi;
-    auto Y = sampleFourier(ak, bsdfTable.recip.get(), nMax, bs.v, &pdfPhi, &phi);
+    auto Y = SampleFourierPacked(ak, bsdfTable.recip.get(), nMax, bs.v, &pdfPhi, &phi);
     *pdf = std::max( 0.0f , pdfPhi * pdfMu );
 
     auto sin2ThetaI = std::max( 0.0f , 1.0f - muI * muI );
@@ -163,8 +190,11 @@ Spectrum FourierBxdfData::sample_f( const Vector& wo , Vector& wi , const BsdfSa
     if( bsdfTable.nChannels == 1 )
         return scale * Y;
 
-    auto R = fourier( ak + 1 * bsdfTable.nMax , nMax , cosPhi );
-    auto B = fourier( ak + 2 * bsdfTable.nMax , nMax , cosPhi );
+    float rb[2];
+    FourierPacked( ak + bsdfTable.nMaxPadded , bsdfTable.nMaxPadded , nMax , cosPhi , 2 , rb );
+
+    auto R = rb[0];
+    auto B = rb[1];
     auto G = 1.39829f * Y - 0.100913f * B - 0.297375f * R;
     return Spectrum( R * scale , G * scale , B * scale ).Clamp( 0.0f , FLT_MAX );
 }
@@ -180,8 +210,8 @@ float FourierBxdfData::pdf( const Vector& wo , const Vector& wi, RenderContext&
         !getCatmullRomWeights( muO , offsetO , weightsO ) )
         return 0.0f;
 
-    auto ak = (float*)SORT_MALLOC_ARRAY(rc.m_memory_arena, float, bsdfTable.nMax );
-    memset( ak , 0 , sizeof( float ) * bsdfTable.nMax );
+    auto ak = (float*)SORT_MALLOC_ARRAY(rc.m_memory_arena, float, bsdfTable.nMaxPadded );
+    memset( ak , 0 , sizeof( float ) * bsdfTable.nMaxPadded );
     auto nMax = blendCoefficients( ak , 1 , offsetI, offsetO, weightsI, weightsO );
 
     auto rho = 0.0f;
@@ -190,7 +220,8 @@ float FourierBxdfData::pdf( const Vector& wo , const Vector& wi, RenderContext&
         rho += weightsO[o] * bsdfTable.cdf[ (offsetO + o) * bsdfTable.nMu + bsdfTable.nMu - 1 ] * TWO_PI;
     }
 
-    auto Y = fourier(ak, nMax, cosPhi);
+    float Y;
+    FourierPacked( ak , bsdfTable.nMaxPadded , nMax , cosPhi , 1 , &Y );
     return (rho > 0.0f && Y > 0.0f) ? (Y/rho) : 0.0f;
 }
 
@@ -317,7 +348,7 @@ float FourierBxdfData::sampleCatmullRom2D( int size1 , int size2 , const float*
 }
 
 // Fourier interpolation
-float FourierBxdfData::fourier( const float* ak , int m , double cosPhi ) const
+float FourierBxdfData::Fourier( const float* ak , int m , double cosPhi )
 {
     // cos( K * phi ) = 2.0 * cos( (K-1) * phi ) cos( phi ) - cos( (K-2) * Phi );
     double value = 0.0;
@@ -336,7 +367,7 @@ float FourierBxdfData::fourier( const float* ak , int m , double cosPhi ) const
 // Refer these two wiki pages for further detail:
 // Bisection method :   https://en.wikipedia.org/wiki/Bisection_method
 // Newton method :      https://en.wikipedia.org/wiki/Newton%27s_method
-float FourierBxdfData::sampleFourier( const float* ak , const float* recip , int m , float u , float* pdf , float* phiptr ) const
+float FourierBxdfData::SampleFourier( const float* ak , const float* recip , int m , float u , float* pdf , float* phiptr )
 {
     auto flip = u >= 0.5f;
     if( flip ) u = 2.0f * ( 1.0f - u );
@@ -386,6 +417,137 @@ float FourierBxdfData::sampleFourier( const float* ak , const float* recip , int
     return (float)f;
 }
 
+// Evaluate fourier series of multiple channels, four coefficients at a time
+// cos( ( K + 4 ) * phi ) = 2.0 * cos( 4 * phi ) * cos( K * phi ) - cos( ( K - 4 ) * Phi );
+void FourierBxdfData::FourierPacked( const float* ak , int stride , int m , float cosPhi , int channels , float* ret )
+{
+    const auto cos2Phi = 2.0f * cosPhi * cosPhi - 1.0f;
+    const auto cos3Phi = 2.0f * cosPhi * cos2Phi - cosPhi;
+    const auto cos4Phi = 2.0f * cosPhi * cos3Phi - cos2Phi;
+
+#ifdef SIMD_4WAY_ENABLED
+    const float cosKPhi[4] = { 1.0f , cosPhi , cos2Phi , cos3Phi };
+    const float cosKMinusFourPhi[4] = { cos4Phi , cos3Phi , cos2Phi , cosPhi };
+    const auto twoCos4Phi = simd_set_ps1( 2.0f * cos4Phi );
+
+    auto cosCur = simd_set_ps( cosKPhi );
+    auto cosPrev = simd_set_ps( cosKMinusFourPhi );
+    simd_data sum[3] = { simd_zeros , simd_zeros , simd_zeros };
+    for( auto k = 0 ; k < m ; k += 4 ){
+        for( auto c = 0 ; c < channels ; ++c )
+            sum[c] = simd_mad_ps( simd_set_ps( ak + c * stride + k ) , cosCur , sum[c] );
+
+        const auto cosNext = simd_sub_ps( simd_mul_ps( twoCos4Phi , cosCur ) , cosPrev );
+        cosPrev = cosCur;
+        cosCur = cosNext;
+    }
+
+    for( auto c = 0 ; c < channels ; ++c )
+        ret[c] = sum[c][0] + sum[c][1] + sum[c][2] + sum[c][3];
+#else
+    float cosCur[4] = { 1.0f , cosPhi , cos2Phi , cos3Phi };
+    float cosPrev[4] = { cos4Phi , cos3Phi , cos2Phi , cosPhi };
+    float sum[3][4] = {};
+    for( auto k = 0 ; k < m ; k += 4 ){
+        for( auto l = 0 ; l < 4 ; ++l ){
+            for( auto c = 0 ; c < channels ; ++c )
+                sum[c][l] += ak[c * stride + k + l] * cosCur[l];
+
+            const auto cosNext = 2.0f * cos4Phi * cosCur[l] - cosPrev[l];
+            cosPrev[l] = cosCur[l];
+            cosCur[l] = cosNext;
+        }
+    }
+
+    for( auto c = 0 ; c < channels ; ++c )
+        ret[c] = sum[c][0] + sum[c][1] + sum[c][2] + sum[c][3];
+#endif
+}
+
+// Importance sampling for fourier interpolation, four coefficients are evaluated at a time
+// sin( ( K + 4 ) * phi ) = 2.0 * cos( 4 * phi ) * sin( K * phi ) - sin( ( K - 4 ) * Phi );
+float FourierBxdfData::SampleFourierPacked( const float* ak , const float* recip , int m , float u , float* pdf , float* phiptr )
+{
+    auto flip = u >= 0.5f;
+    if( flip ) u = 2.0f * ( 1.0f - u );
+    else u *= 2.0f;
+
+    // Bisection method
+    double l = 0.0f , r = PI, phi = 0.5f * PI;
+    float F, f;
+    while( true ){
+        const auto cosPhi = (float)cos(phi);
+        const auto sinPhi = (float)sin(phi);
+        const auto cos2Phi = 2.0f * cosPhi * cosPhi - 1.0f , sin2Phi = 2.0f * sinPhi * cosPhi;
+        const auto cos3Phi = 2.0f * cosPhi * cos2Phi - cosPhi , sin3Phi = 2.0f * cosPhi * sin2Phi - sinPhi;
+        const auto cos4Phi = 2.0f * cosPhi * cos3Phi - cos2Phi , sin4Phi = 2.0f * cosPhi * sin3Phi - sin2Phi;
+
+#ifdef SIMD_4WAY_ENABLED
+        const float cosKPhi[4] = { 1.0f , cosPhi , cos2Phi , cos3Phi };
+        const float cosKMinusFourPhi[4] = { cos4Phi , cos3Phi , cos2Phi , cosPhi };
+        const float sinKPhi[4] = { 0.0f , sinPhi , sin2Phi , sin3Phi };
+        const float sinKMinusFourPhi[4] = { -sin4Phi , -sin3Phi , -sin2Phi , -sinPhi };
+        const auto twoCos4Phi = simd_set_ps1( 2.0f * cos4Phi );
+
+        auto cosCur = simd_set_ps( cosKPhi ) , cosPrev = simd_set_ps( cosKMinusFourPhi );
+        auto sinCur = simd_set_ps( sinKPhi ) , sinPrev = simd_set_ps( sinKMinusFourPhi );
+        auto sumF = simd_zeros , sumf = simd_zeros;
+        for( auto k = 0 ; k < m ; k += 4 ){
+            const auto a = simd_set_ps( ak + k );
+            sumF = simd_mad_ps( simd_mul_ps( a , simd_set_ps( recip + k ) ) , sinCur , sumF );
+            sumf = simd_mad_ps( a , cosCur , sumf );
+
+            const auto cosNext = simd_sub_ps( simd_mul_ps( twoCos4Phi , cosCur ) , cosPrev );
+            const auto sinNext = simd_sub_ps( simd_mul_ps( twoCos4Phi , sinCur ) , sinPrev );
+            cosPrev = cosCur;
+            cosCur = cosNext;
+            sinPrev = sinCur;
+            sinCur = sinNext;
+        }
+        F = sumF[0] + sumF[1] + sumF[2] + sumF[3];
+        f = sumf[0] + sumf[1] + sumf[2] + sumf[3];
+#else
+        float cosCur[4] = { 1.0f , cosPhi , cos2Phi , cos3Phi } , cosPrev[4] = { cos4Phi , cos3Phi , cos2Phi , cosPhi };
+        float sinCur[4] = { 0.0f , sinPhi , sin2Phi , sin3Phi } , sinPrev[4] = { -sin4Phi , -sin3Phi , -sin2Phi , -sinPhi };
+        F = f = 0.0f;
+        for( auto k = 0 ; k < m ; k += 4 ){
+            for( auto j = 0 ; j < 4 ; ++j ){
+                F += ak[k + j] * recip[k + j] * sinCur[j];
+                f += ak[k + j] * cosCur[j];
+
+                const auto cosNext = 2.0f * cos4Phi * cosCur[j] - cosPrev[j];
+                const auto sinNext = 2.0f * cos4Phi * sinCur[j] - sinPrev[j];
+                cosPrev[j] = cosCur[j];
+                cosCur[j] = cosNext;
+                sinPrev[j] = sinCur[j];
+                sinCur[j] = sinNext;
+            }
+        }
+#endif
+
+        // the constant term integrates to a linear function
+        F += (float)( ak[0] * ( phi - u * PI ) );
+
+        if( F > 0.0f ) r = phi;
+        else l = phi;
+
+        if( fabs(F) < 1e-6f || r - l < 1e-6f )
+            break;
+
+        // Newton method
+        phi -= F / f;
+
+        if( !(phi > l && phi < r ) )
+            phi = ( l + r ) * 0.5f;
+    }
+
+    if( flip ) phi = TWO_PI - phi;
+    if( pdf ) *pdf = INV_TWOPI * f / ak[0];
+    *phiptr = (float)phi;
+
+    return f;
+}
+
 // helper functio to blend coefficients for fourier
 int FourierBxdfData::blendCoefficients( float* ak , int channel , int offsetI , int offsetO , float* weightsI , float* weightsO ) const
 {
@@ -397,10 +559,24 @@ int FourierBxdfData::blendCoefficients( float* ak , int channel , int offsetI ,
                 int m;
                 float* a = bsdfTable.GetAk(offsetI + j , offsetO + i, &m );
                 nMax = std::max( nMax , m );
+
+                // the padding is zero, blending it in doesn't change anything
+                const auto mPadded = ( m + 3 ) & ~3;
+#ifdef SIMD_4WAY_ENABLED
+                const auto w_simd = simd_set_ps1( w );
+                for(auto c = 0 ; c < channel ; ++c ){
+                    auto* dst = ak + c * bsdfTable.nMaxPadded;
+                    const auto* src = a + c * mPadded;
+                    for(auto k = 0 ; k < mPadded ; k += 4 ){
+                        simd_store_ps( dst + k , simd_mad_ps( simd_set_ps( src + k ) , w_simd , simd_set_ps( dst + k ) ) );
+                    }
+                }
+#else
                 for(auto c = 0 ; c < channel ; ++c ){
-                    for(auto k = 0 ; k < m ; ++k )
-                        ak[ c * bsdfTable.nMax + k ] += w * a[ c * m + k ];
+                    for(auto k = 0 ; k < mPadded ; ++k )
+                        ak[ c * bsdfTable.nMaxPadded + k ] += w * a[ c * mPadded + k ];
                 }
+#endif
             }
         }
     }
@@ -70,11 +70,57 @@ public:
     //! @return             Whether the resource is loaded
     bool    LoadResource(const std::string filename) override;
 
+    //! @brief  Evaluate a Fourier series in cosine, this is the scalar reference implementation.
+    //!
+    //! @param ak       Coefficients of the series.
+    //! @param m        Number of coefficients.
+    //! @param cosPhi   Cosine of the azimuthal angle.
+    //! @return         Value of the series.
+    static float Fourier( const float* ak , int m , double cosPhi );
+
+    //! @brief  Evaluate Fourier series of multiple channels, four coefficients are evaluated at a time.
+    //!
+    //! @param ak       Coefficients of all channels, each channel is zero padded to a multiple of four coefficients.
+    //! @param stride   Distance between coefficients of two neighbouring channels.
+    //! @param m        Number of coefficients.
+    //! @param cosPhi   Cosine of the azimuthal angle.
+    //! @param channels Number of channels to evaluate.
+    //! @param ret      Value of the series of each channel.
+    static void  FourierPacked( const float* ak , int stride , int m , float cosPhi , int channels , float* ret );
+
+    //! @brief  Importance sample a Fourier series, this is the scalar reference implementation.
+    //!
+    //! Refer these two wiki pages for further detail:
+    //! Bisection method :   https://en.wikipedia.org/wiki/Bisection_method
+    //! Newton method :      https://en.wikipedia.org/wiki/Newton%27s_method
+    //!
+    //! @param ak       Coefficients of the series.
+    //! @param recip    Reciprocal of integers, it needs to have at least 'm' elements.
+    //! @param m        Number of coefficients.
+    //! @param u        A canonical random variable.
+    //! @param pdf      Pdf of the sampled azimuthal angle.
+    //! @param phiptr   The sampled azimuthal angle.
+    //! @return         Value of the series at the sampled angle.
+    static float SampleFourier( const float* ak , const float* recip , int m , float u , float* pdf , float* phiptr );
+
+    //! @brief  Importance sample a Fourier series, four coefficients are evaluated at a time.
+    //!
+    //! @param ak       Coefficients of the series, zero padded to a multiple of four coefficients.
+    //! @param recip    Reciprocal of integers, it needs to have at least 'm' elements rounded up to a multiple of four.
+    //! @param m        Number of coefficients.
+    //! @param u        A canonical random variable.
+    //! @param pdf      Pdf of the sampled azimuthal angle.
+    //! @param phiptr   The sampled azimuthal angle.
+    //! @return         Value of the series at the sampled angle.
+    static float SampleFourierPacked( const float* ak , const float* recip , int m , float u , float* pdf , float* phiptr );
+
 private:
     // Bxdf Table
+    // Coefficients of each channel are zero padded to a multiple of four so that they can be processed four at a time.
     struct FourierBxdfTable{
         float   eta = 1.0f;
         int     nMax = 0;
+        int     nMaxPadded = 0;
         int     nChannels = 1;
         int     nMu = 0;
         std::unique_ptr<float[]>   mu = nullptr;
@@ -94,14 +140,6 @@ private:
 
     FourierBxdfTable    bsdfTable;
 
-    // Fourier interpolation
-    float fourier( const float* ak , int m , double cosPhi ) const;
-    // Importance sampling for fourier interpolation
-    // Refer these two wiki pages for further detail:
-    // Bisection method :   https://en.wikipedia.org/wiki/Bisection_method
-    // Newton method :      https://en.wikipedia.org/wiki/Newton%27s_method
-    float sampleFourier( const float* ak , const float* recip , int m , float u , float* pdf , float* phiptr ) const;
-
     // Get CatmullRomWeights
     bool getCatmullRomWeights( float x , int& offset , float* weights ) const;
 
@@ -16,6 +16,13 @@
  */
 
 #include "hair.h"
+
+#if defined(ENABLE_HAIR_LUT) && defined(SIMD_4WAY_ENABLED)
+#define SIMD_4WAY_IMPLEMENTATION
+#include "simd/simd_wrapper.h"
+static_assert( PMAX + 1 == SIMD_CHANNEL , "All hair lobes are expected to fit in one SIMD vector." );
+#endif
+
 #include "sampler/sample.h"
 #include "core/samplemethod.h"
 #include "fresnel.h"
@@ -110,6 +117,67 @@ SORT_STATIC_FORCEINLINE void ComputeApPdf(const float cosThetaO , const float co
         pdf[i] = ap[i].GetIntensity() / sumY;
 }
 
+#ifdef ENABLE_HAIR_LUT
+//! @brief  Tables of the expensive terms in hair scattering.
+/**
+ * Both tables are independent of the hair parameters, longitudinal variance and azimuthal scale are folded in through
+ * per BSDF constants. This means they are built only once and shared by all hair strands in the scene.
+ */
+struct HairLut{
+    static constexpr int    BESSEL_RES = 2048;      /**< Resolution of the modified Bessel function table. */
+    static constexpr float  BESSEL_MAX = 64.0f;     /**< Largest argument in the modified Bessel function table. */
+    static constexpr int    LOGISTIC_RES = 1024;    /**< Resolution of the logistic distribution table. */
+    static constexpr float  LOGISTIC_MAX = 32.0f;   /**< Largest argument in the logistic distribution table. */
+
+    HairLut(){
+        for( auto i = 0 ; i <= BESSEL_RES ; ++i ){
+            const auto x = BESSEL_MAX * i / BESSEL_RES;
+            m_logI0[i] = LogI0( x ) - x;
+        }
+        for( auto i = 0 ; i <= LOGISTIC_RES ; ++i )
+            m_logistic[i] = Logistic( LOGISTIC_MAX * i / LOGISTIC_RES , 1.0f );
+    }
+
+    //! @brief  Get the two texels and interpolation factor of 'log(I0(x)) - x'.
+    //!
+    //! Unlike I0 itself, which grows exponentially, the residual is a slowly varying function that is friendly to linear
+    //! interpolation. Beyond the range of the table, the asymptotic expansion is used instead.
+    SORT_FORCEINLINE void LookupLogI0Residual( const float x , float& t0 , float& t1 , float& t ) const{
+        if( x >= BESSEL_MAX ){
+            t0 = t1 = 0.5f * ( -log( TWO_PI ) - log( x ) + 1.0f / ( 8.0f * x ) );
+            t = 0.0f;
+            return;
+        }
+        const auto fi = x * ( BESSEL_RES / BESSEL_MAX );
+        const auto i = (int)fi;
+        t0 = m_logI0[i];
+        t1 = m_logI0[i+1];
+        t = fi - i;
+    }
+
+    //! @brief  Get the two texels and interpolation factor of the logistic distribution with unit scale.
+    //!
+    //! The distribution is symmetric, the input is expected to be non-negative. It is practically zero beyond the range
+    //! of the table.
+    SORT_FORCEINLINE void LookupLogistic( const float x , float& t0 , float& t1 , float& t ) const{
+        if( x >= LOGISTIC_MAX ){
+            t0 = t1 = t = 0.0f;
+            return;
+        }
+        const auto fi = x * ( LOGISTIC_RES / LOGISTIC_MAX );
+        const auto i = (int)fi;
+        t0 = m_logistic[i];
+        t1 = m_logistic[i+1];
+        t = fi - i;
+    }
+
+    float   m_logI0[BESSEL_RES + 1];        /**< Table of 'log(I0(x)) - x'. */
+    float   m_logistic[LOGISTIC_RES + 1];   /**< Table of logistic distribution with unit scale. */
+};
+
+static const HairLut g_hairLut;
+#endif
+
 Hair::Hair(RenderContext& rc, const ClosureTypeHair& params, const Spectrum& weight): Hair(rc, params.sigma, params.longtitudinalRoughness, params.azimuthalRoughness, params.ior, weight, true ){}
 
 Hair::Hair(RenderContext& rc, const Spectrum& absorption, const float lRoughness, const float aRoughness, const float ior, const Spectrum& weight, bool doubleSided)
@@ -136,19 +204,110 @@ Hair::Hair(RenderContext& rc, const Spectrum& absorption, const float lRoughness
     m_scale = SqrtPiOver8 * (0.265f * m_aRoughness + 1.194f * SQR(m_aRoughness) + 5.372f * Pow<22>(m_aRoughness));
 
     m_etaSqr = SQR( m_eta );
+
+#ifdef ENABLE_HAIR_LUT
+    for( auto p = 0 ; p <= PMAX ; ++p ){
+        const auto v = m_v[p];
+        m_invV[p] = 1.0f / v;
+        // '-1/v' is not included, it is merged with the exponent in the evaluation to avoid catastrophic cancellation.
+        m_mpLogScale[p] = ( v <= .1f ) ? ( 0.6931f + log( 1.0f / ( 2.0f * v ) ) ) : ( 1.0f / v - log( sinh( 1.0f / v ) * 2.0f * v ) );
+    }
+    m_invScale = 1.0f / m_scale;
+    m_npScale = 1.0f / ( m_scale * ( LogisticCDF( PI , m_scale ) - LogisticCDF( -PI , m_scale ) ) );
+#endif
 }
 
+#ifdef ENABLE_HAIR_LUT
+void Hair::evaluateLobes( const float sinThetaI , const float cosThetaI , const float sinThetaO , const float cosThetaO ,
+                          const float phi , const float gammaO , const float gammaT , float mp[] , float np[] ) const{
+    float cosThetaOI[PMAX + 1] , sinThetaOI[PMAX + 1] , dphi[PMAX + 1];
+    for( auto p = 0 ; p <= PMAX ; ++p ){
+#ifndef DISABLE_ANGLE_TILT
+        float sinThetaIp , cosThetaIp;
+        if( p == 0 ){
+            sinThetaIp = sinThetaI * m_cos2kAlpha[1] + cosThetaI * m_sin2kAlpha[1];
+            cosThetaIp = cosThetaI * m_cos2kAlpha[1] - sinThetaI * m_sin2kAlpha[1];
+        }else if( p == 1 ){
+            sinThetaIp = sinThetaI * m_cos2kAlpha[0] - cosThetaI * m_sin2kAlpha[0];
+            cosThetaIp = cosThetaI * m_cos2kAlpha[0] + sinThetaI * m_sin2kAlpha[0];
+        }else if( p == 2 ){
+            sinThetaIp = sinThetaI * m_cos2kAlpha[2] - cosThetaI * m_sin2kAlpha[2];
+            cosThetaIp = cosThetaI * m_cos2kAlpha[2] + sinThetaI * m_sin2kAlpha[2];
+        }else{
+            sinThetaIp = sinThetaI;
+            cosThetaIp = cosThetaI;
+        }
+        if( p < PMAX )
+            cosThetaIp = abs( cosThetaIp );
+        cosThetaOI[p] = cosThetaIp * cosThetaO;
+        sinThetaOI[p] = sinThetaIp * sinThetaO;
+#else
+        cosThetaOI[p] = cosThetaI * cosThetaO;
+        sinThetaOI[p] = sinThetaI * sinThetaO;
+#endif
+
+        // the last lobe is uniform in azimuthal direction, its logistic term is not used at all.
+        auto d = 0.0f;
+        if( p < PMAX ){
+            d = phi - Phi( p , gammaO , gammaT );
+            while( d > PI ) d -= TWO_PI;
+            while( d < -PI ) d += TWO_PI;
+        }
+        dphi[p] = abs( d ) * m_invScale;
+    }
+
+    float mp0[PMAX + 1] , mp1[PMAX + 1] , mpt[PMAX + 1];
+    float np0[PMAX + 1] , np1[PMAX + 1] , npt[PMAX + 1];
+
+#ifdef SIMD_4WAY_ENABLED
+    // All lobes are evaluated at once, only fetching texels and exponential are done per lobe.
+    const auto inv_v = simd_set_ps( m_invV );
+    const auto a = simd_mul_ps( simd_set_ps( cosThetaOI ) , inv_v );
+    for( auto p = 0 ; p <= PMAX ; ++p ){
+        g_hairLut.LookupLogI0Residual( a[p] , mp0[p] , mp1[p] , mpt[p] );
+        g_hairLut.LookupLogistic( dphi[p] , np0[p] , np1[p] , npt[p] );
+    }
+
+    const auto t0 = simd_set_ps( mp0 );
+    const auto residual = simd_mad_ps( simd_sub_ps( simd_set_ps( mp1 ) , t0 ) , simd_set_ps( mpt ) , t0 );
+    const auto exponent = simd_mul_ps( simd_sub_ps( simd_sub_ps( simd_set_ps( cosThetaOI ) , simd_set_ps( sinThetaOI ) ) , simd_ones ) , inv_v );
+    const auto log_mp = simd_add_ps( simd_add_ps( residual , exponent ) , simd_set_ps( m_mpLogScale ) );
+
+    const auto l0 = simd_set_ps( np0 );
+    const auto logistic = simd_mad_ps( simd_sub_ps( simd_set_ps( np1 ) , l0 ) , simd_set_ps( npt ) , l0 );
+    const auto np_simd = simd_mul_ps( logistic , simd_set_ps1( m_npScale ) );
+
+    for( auto p = 0 ; p <= PMAX ; ++p ){
+        mp[p] = exp( log_mp[p] );
+        np[p] = np_simd[p];
+    }
+#else
+    for( auto p = 0 ; p <= PMAX ; ++p ){
+        const auto a = cosThetaOI[p] * m_invV[p];
+        g_hairLut.LookupLogI0Residual( a , mp0[p] , mp1[p] , mpt[p] );
+        g_hairLut.LookupLogistic( dphi[p] , np0[p] , np1[p] , npt[p] );
+
+        mp[p] = exp( slerp( mp0[p] , mp1[p] , mpt[p] ) + ( cosThetaOI[p] - sinThetaOI[p] - 1.0f ) * m_invV[p] + m_mpLogScale[p] );
+        np[p] = slerp( np0[p] , np1[p] , npt[p] ) * m_npScale;
+    }
+#endif
+
+    np[PMAX] = INV_TWOPI;
+}
+#endif
+
 Spectrum Hair::f( const Vector& wo , const Vector& wi ) const{
     if( wo.y <= 0.0f || wi.y == 0.0f )
         return 0.0f;
 
     const auto sinThetaO = wo.x;
     const auto cosThetaO = ssqrt( 1.0f - SQR(sinThetaO) );
-    const auto phiO = atan2(wo.y, wo.z);
 
     const auto sinThetaI = wi.x;
     const auto cosThetaI = ssqrt( 1.0f - SQR(sinThetaI) );
-    const auto phiI = atan2(wi.y, wi.z);
+
+    // Azimuthal difference between the two directions, no need to evaluate both azimuthal angles.
+    const auto phi = atan2( wo.z * wi.y - wo.y * wi.z , wo.z * wi.z + wo.y * wi.y );
 
     const auto sinThetaT = sinThetaO / m_eta;
     const auto cosThetaT = ssqrt( 1.0f - SQR(sinThetaT) );
@@ -168,12 +327,17 @@ Spectrum Hair::f( const Vector& wo , const Vector& wi ) const{
 
     const auto T = m_sigma * ( -2.0f * cosGammaT / cosThetaT );
     const auto expT = T.Exp();
-    const auto phi = phiI - phiO;
 
     Spectrum ap[PMAX + 1];
     Ap( cosThetaO , m_eta , cosGammaO , expT , ap );
 
     Spectrum fsum(0.0f);
+#ifdef ENABLE_HAIR_LUT
+    float mp[PMAX + 1] , np[PMAX + 1];
+    evaluateLobes( sinThetaI , cosThetaI , sinThetaO , cosThetaO , phi , gammaO , gammaT , mp , np );
+    for( auto p = 0 ; p <= PMAX ; ++p )
+        fsum += mp[p] * np[p] * ap[p];
+#else
     for( auto p = 0 ; p < PMAX ; ++p ){
 #ifndef DISABLE_ANGLE_TILT
         float sinThetaIp , cosThetaIp;
@@ -197,6 +361,7 @@ Spectrum Hair::f( const Vector& wo , const Vector& wi ) const{
 #endif
     }
     fsum += Mp( cosThetaI, cosThetaO, sinThetaI, sinThetaO, m_v[PMAX] ) * ap[PMAX] * INV_TWOPI;
+#endif
 
     return fsum;
 }
@@ -224,7 +389,19 @@ Spectrum Hair::sample_f(const Vector& wo, Vector& wi, const BsdfSample& bs, floa
     const auto cosGammaT = ssqrt( 1.0f - SQR(sinGammaT) );
 
     float apPdf[PMAX + 1] = {0.0f};
+#ifdef ENABLE_HAIR_LUT
+    // Attenuation is kept around so that the BSDF value can be evaluated along with the pdf without repeating anything.
+    Spectrum ap[PMAX + 1];
+    Ap( cosThetaO , m_eta , cosGammaO , ( m_sigma * ( -2.0f * cosGammaT / cosThetaT ) ).Exp() , ap );
+
+    auto sumY = 0.0f;
+    for( auto i = 0 ; i <= PMAX ; ++i )
+        sumY += ( apPdf[i] = ap[i].GetIntensity() );
+    for( auto i = 0 ; i <= PMAX ; ++i )
+        apPdf[i] /= sumY;
+#else
     ComputeApPdf( cosThetaO , cosThetaT , cosGammaO , cosGammaT , m_eta , m_sigma , apPdf );
+#endif
     auto r = sort_rand<float>(rc);
     auto p = 0;
     for( ; p < PMAX ; ++p ){
@@ -265,6 +442,25 @@ Spectrum Hair::sample_f(const Vector& wo, Vector& wi, const BsdfSample& bs, floa
     const auto phiI = phiO + dphi;
     wi = Vector3f( sinThetaI , cosThetaI * sin( phiI ) , cosThetaI * cos( phiI ) );
 
+#ifdef ENABLE_HAIR_LUT
+    float mp[PMAX + 1] , np[PMAX + 1];
+    evaluateLobes( sinThetaI , cosThetaI , sinThetaO , cosThetaO , dphi , gammaO , gammaT , mp , np );
+
+    if( pPdf ){
+        *pPdf = 0.0f;
+        for( auto p = 0 ; p <= PMAX ; ++p )
+            *pPdf += mp[p] * np[p] * apPdf[p];
+    }
+
+    // This matches the behavior of 'f', which treats directions perpendicular to the hair as invalid.
+    if( wi.y == 0.0f )
+        return 0.0f;
+
+    Spectrum fsum(0.0f);
+    for( auto p = 0 ; p <= PMAX ; ++p )
+        fsum += mp[p] * np[p] * ap[p];
+    return fsum;
+#else
     if( pPdf ){
         *pPdf = 0.0f;
         for( auto p = 0 ; p < PMAX ; ++p ){
@@ -292,6 +488,7 @@ Spectrum Hair::sample_f(const Vector& wo, Vector& wi, const BsdfSample& bs, floa
         *pPdf += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[PMAX] ) * apPdf[PMAX] * INV_TWOPI;
     }
     return f( wo , wi );
+#endif
 }
 
 float Hair::pdf( const Vector& wo , const Vector& wi ) const{
@@ -300,11 +497,12 @@ float Hair::pdf( const Vector& wo , const Vector& wi ) const{
 
     const auto sinThetaO = wo.x;
     const auto cosThetaO = ssqrt( 1.0f - SQR(sinThetaO) );
-    const auto phiO = atan2(wo.y, wo.z);
 
     const auto sinThetaI = wi.x;
     const auto cosThetaI = ssqrt( 1.0f - SQR(sinThetaI) );
-    const auto phiI = atan2(wi.y, wi.z);
+
+    // Azimuthal difference between the two directions, no need to evaluate both azimuthal angles.
+    const auto phi = atan2( wo.z * wi.y - wo.y * wi.z , wo.z * wi.z + wo.y * wi.y );
 
     const auto sinThetaT = sinThetaO / m_eta;
     const auto cosThetaT = ssqrt( 1.0f - SQR(sinThetaT) );
@@ -322,8 +520,13 @@ float Hair::pdf( const Vector& wo , const Vector& wi ) const{
     float apPdf[PMAX + 1] = {0.0f};
     ComputeApPdf( cosThetaO , cosThetaT , cosGammaO , cosGammaT , m_eta , m_sigma , apPdf );
 
-    auto phi = phiI - phiO;
     auto pdf = 0.0f;
+#ifdef ENABLE_HAIR_LUT
+    float mp[PMAX + 1] , np[PMAX + 1];
+    evaluateLobes( sinThetaI , cosThetaI , sinThetaO , cosThetaO , phi , gammaO , gammaT , mp , np );
+    for( auto p = 0 ; p <= PMAX ; ++p )
+        pdf += mp[p] * np[p] * apPdf[p];
+#else
     for( auto p = 0 ; p < PMAX ; ++p ){
 #ifndef DISABLE_ANGLE_TILT
         float sinThetaIp , cosThetaIp;
@@ -347,5 +550,6 @@ float Hair::pdf( const Vector& wo , const Vector& wi ) const{
 #endif
     }
     pdf += Mp( cosThetaI , cosThetaO , sinThetaI , sinThetaO , m_v[PMAX] ) * apPdf[PMAX] * INV_TWOPI;
+#endif
     return pdf;
 }
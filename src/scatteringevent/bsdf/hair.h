@@ -31,6 +31,12 @@ DECLARE_CLOSURE_TYPE_END(ClosureTypeHair)
 #define DISABLE_ANGLE_TILT
 #define PMAX                    3
 
+// Evaluate the longitudinal and azimuthal scattering functions through precomputed tables instead of evaluating the
+// modified Bessel function and logistic distribution per lobe. The tables are independent of hair parameters so that
+// they are built only once and shared by all hair strands, parameters are folded in per BSDF as a few constants.
+// The tables introduce a tiny bit of error, which is far below the noise level in practice.
+#define ENABLE_HAIR_LUT
+
 //! @brief Hair BRDF.
 /**
  * 'The Implementation of a Hair Scattering Model' by Matt Pharr.
@@ -74,6 +80,22 @@ public:
     float pdf( const Vector& wo , const Vector& wi ) const override;
 
 private:
+#ifdef ENABLE_HAIR_LUT
+    //! @brief  Evaluate the longitudinal and azimuthal scattering terms of all lobes through tables.
+    //!
+    //! @param sinThetaI    Sine of the incident longitudinal angle.
+    //! @param cosThetaI    Cosine of the incident longitudinal angle.
+    //! @param sinThetaO    Sine of the exitant longitudinal angle.
+    //! @param cosThetaO    Cosine of the exitant longitudinal angle.
+    //! @param phi          Azimuthal difference between incident and exitant direction.
+    //! @param gammaO       Exitant offset angle.
+    //! @param gammaT       Refracted offset angle.
+    //! @param mp           Longitudinal scattering term of each lobe.
+    //! @param np           Azimuthal scattering term of each lobe.
+    void evaluateLobes( const float sinThetaI , const float cosThetaI , const float sinThetaO , const float cosThetaO ,
+                        const float phi , const float gammaO , const float gammaT , float mp[] , float np[] ) const;
+#endif
+
     const Spectrum  m_sigma;            /**< Absorption coefficient. */
     const float     m_lRoughness;       /**< Longtitudinal roughness. */
     const float     m_aRoughness;       /**< Azimuthal roughness. */
@@ -82,6 +104,12 @@ private:
     float           m_v[PMAX+1];          /**< Some pre-calculated cached data. */
     float           m_scale;              /**< Azimuhthal logisitic scale factor. */
     float           m_etaSqr;             /**< Squared eta. */
+#ifdef ENABLE_HAIR_LUT
+    float           m_invV[PMAX+1];       /**< Reciprocal of longitudinal variance of each lobe. */
+    float           m_mpLogScale[PMAX+1]; /**< Logarithm of the normalization factor of longitudinal scattering, offset by 1/v. */
+    float           m_invScale;           /**< Reciprocal of azimuthal logistic scale factor. */
+    float           m_npScale;            /**< Normalization factor of the trimmed logistic distribution. */
+#endif
 #ifndef DISABLE_ANGLE_TILT
     float           m_cos2kAlpha[PMAX];   /**< Some pre-calculated cached data, cos( 2 ^ k ). */
     float           m_sin2kAlpha[PMAX];   /**< Some pre-calculated cached data, sin( 2 ^ k ). */
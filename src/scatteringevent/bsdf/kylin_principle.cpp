@@ -46,7 +46,7 @@ Spectrum KylinPrinciple::f( const Vector& wo , const Vector& wi ) const{
     if (!SameHemiSphere(wo, wi)) return 0.0f;
     if (!doubleSided && !PointingUp(wo)) return 0.0f;
 
-    auto ret = RGBSpectrum(0.0f);
+    auto ret = Spectrum(0.0f);
 
     const auto f0 = ComputeF0(specular, base_color, metallic);
     // There are clearly more accurate fresnel approximation in the world of offline rendering.
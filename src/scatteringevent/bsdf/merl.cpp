@@ -16,11 +16,18 @@
  */
 
 #include <string.h>
-#include <fstream>
 #include "merl.h"
+
+#ifdef SIMD_4WAY_ENABLED
+#define SIMD_4WAY_IMPLEMENTATION
+#include "simd/simd_wrapper.h"
+#endif
+
 #include "core/define.h"
 #include "core/memory.h"
 #include "core/path.h"
+#include "core/mapped_file.h"
+#include "sampler/sample.h"
 #include "math/vector3.h"
 #include "material/matmanager.h"
 
@@ -38,46 +45,153 @@ static const double MERL_RED_SCALE = 0.0006666666666667;
 static const double MERL_GREEN_SCALE = 0.000766666666666667;
 static const double MERL_BLUE_SCALE = 0.0011066666666666667;
 
+// Bins with no measured data at all still get a tiny bit of chance to be sampled, relative to the average bin.
+static const float MERL_THETA_H_PDF_FLOOR = 0.001f;
+
+#ifdef ENABLE_MERL_HALF_PRECISION
+#include "math/half.h"
+#else
+SORT_STATIC_FORCEINLINE float floatToHalf( const float f ){
+    return f;
+}
+
+SORT_STATIC_FORCEINLINE float halfToFloat( const float f ){
+    return f;
+}
+#endif
+
 // Load data from file
 bool MerlData::LoadResource( const std::string filename )
 {
-    // get full path
-    auto str = ( filename );
-
-    // try to open the file
-    std::ifstream file( str.c_str() , std::ios::binary );
-    if( false == file.is_open() )
+    // The file is mapped instead of read into a heap buffer since it is converted to the compact layout right away.
+    MappedFile file;
+    if( !file.Open( filename ) )
         return false;
+    return LoadData( file.GetData() , file.GetSize() );
+}
 
-    unsigned int dims[3];
-    file.read( (char*)dims , sizeof(unsigned int) * 3 );
-
+bool MerlData::LoadData( const unsigned char* data , const size_t size )
+{
     // check dimension
+    unsigned int dims[3];
+    if( size < sizeof( dims ) )
+        return false;
+    memcpy( dims , data , sizeof( dims ) );
     if( dims[0] != MERL_SAMPLING_RES_THETA_H ||
        dims[1] != MERL_SAMPLING_RES_THETA_D ||
-       dims[2] != MERL_SAMPLING_RES_PHI_D ){
-        file.close();
+       dims[2] != MERL_SAMPLING_RES_PHI_D )
+        return false;
+
+    // the file is made of three planes of doubles, one for each channel
+    const auto trunksize = dims[0] * dims[1] * dims[2];
+    if( size < sizeof( dims ) + sizeof( double ) * 3u * trunksize )
         return false;
+    const auto* src = data + sizeof( dims );
+
+    // Channels are interleaved so that all channels of a bin can be loaded at once.
+    m_data = std::make_unique<Texel[]>( 3u * trunksize + 1u );
+    const double scale[3] = { MERL_RED_SCALE , MERL_GREEN_SCALE , MERL_BLUE_SCALE };
+    for( auto c = 0u ; c < 3u ; ++c ){
+        for( auto i = 0u ; i < trunksize ; ++i ){
+            // the doubles are not necessarily aligned in the file
+            double value;
+            memcpy( &value , src + sizeof( double ) * ( (size_t)c * trunksize + i ) , sizeof( double ) );
+            m_data[ 3u * i + c ] = floatToHalf( (float)( value * scale[c] ) );
+        }
+    }
+    m_data[ 3u * trunksize ] = floatToHalf( 0.0f );
+
+    // The distribution of half angle theta is roughly the distribution of microfacet normals, which is estimated by
+    // averaging the BRDF over all difference angles, weighted by the projected solid angle of the bin of half angles.
+    float weights[MERL_SAMPLING_RES_THETA_H];
+    auto total = 0.0f;
+    for( auto i = 0u ; i < MERL_SAMPLING_RES_THETA_H ; ++i ){
+        auto sum = 0.0f;
+        for( auto j = 0u ; j < MERL_SAMPLING_RES_THETA_D * MERL_SAMPLING_RES_PHI_D ; ++j ){
+            const auto index = 3u * ( i * MERL_SAMPLING_RES_THETA_D * MERL_SAMPLING_RES_PHI_D + j );
+            const Spectrum value( halfToFloat( m_data[index] ) , halfToFloat( m_data[index + 1] ) , halfToFloat( m_data[index + 2] ) );
+            sum += std::max( 0.0f , value.GetIntensity() );
+        }
+
+        const auto theta0 = SQR( (float)i / MERL_SAMPLING_RES_THETA_H ) * HALF_PI;
+        const auto theta1 = SQR( (float)( i + 1 ) / MERL_SAMPLING_RES_THETA_H ) * HALF_PI;
+        const auto cos_theta = cos( 0.5f * ( theta0 + theta1 ) );
+        weights[i] = sum * cos_theta * ( cos( theta0 ) - cos( theta1 ) );
+        total += weights[i];
     }
+    const auto floor = total * MERL_THETA_H_PDF_FLOOR / MERL_SAMPLING_RES_THETA_H;
+    for( auto& weight : weights )
+        weight += floor;
+    m_thetaHDistribution = std::make_unique<Distribution1D>( weights , MERL_SAMPLING_RES_THETA_H );
 
-    // allocate data
-    auto trunksize = dims[0] * dims[1] * dims[2];
-    auto size = 3u * trunksize;
-    m_data = std::make_unique<double[]>(size);
-    file.read( (char*)m_data.get() , sizeof( double ) * size );
-
-    unsigned offset = 0;
-    for(auto i = 0u ; i < trunksize ; i++ )
-        m_data[offset++] *= MERL_RED_SCALE;
-    for(auto i = 0u ; i < trunksize ; i++ )
-        m_data[offset++] *= MERL_GREEN_SCALE;
-    for(auto i = 0u ; i < trunksize ; i++ )
-        m_data[offset++] *= MERL_BLUE_SCALE;
-
-    file.close();
     return true;
 }
 
+Spectrum MerlData::lookup( const float thetaH , const float thetaD , const float phiD ) const{
+    // Bins along theta are clamped at the boundary, phi wraps around since it is periodic with a period of PI.
+    const auto th = clamp( thetaH , 0.0f , (float)( MERL_SAMPLING_RES_THETA_H - 1 ) );
+    const auto td = clamp( thetaD , 0.0f , (float)( MERL_SAMPLING_RES_THETA_D - 1 ) );
+    const auto pd = phiD < 0.0f ? phiD + MERL_SAMPLING_RES_PHI_D : phiD;
+
+    const auto th0 = (unsigned)th , td0 = (unsigned)td;
+    const auto pd0 = std::min( (unsigned)pd , MERL_SAMPLING_RES_PHI_D - 1 );
+    const auto th1 = std::min( th0 + 1 , MERL_SAMPLING_RES_THETA_H - 1 );
+    const auto td1 = std::min( td0 + 1 , MERL_SAMPLING_RES_THETA_D - 1 );
+    const auto pd1 = ( pd0 + 1 ) % MERL_SAMPLING_RES_PHI_D;
+
+    const auto fh = th - th0 , fd = td - td0 , fp = pd - pd0;
+
+    const auto index = [&]( const unsigned h , const unsigned d , const unsigned p ){
+        return 3u * ( p + MERL_SAMPLING_RES_PHI_D * ( d + h * MERL_SAMPLING_RES_THETA_D ) );
+    };
+    const unsigned indices[8] = {
+        index( th0 , td0 , pd0 ) , index( th0 , td0 , pd1 ) , index( th0 , td1 , pd0 ) , index( th0 , td1 , pd1 ) ,
+        index( th1 , td0 , pd0 ) , index( th1 , td0 , pd1 ) , index( th1 , td1 , pd0 ) , index( th1 , td1 , pd1 ) ,
+    };
+
+#ifdef SIMD_4WAY_ENABLED
+    // Each texel is a vector of rgb channels, the last channel is not used.
+    simd_data texels[8];
+    for( auto i = 0 ; i < 8 ; ++i ){
+        const auto* texel = m_data.get() + indices[i];
+#ifdef ENABLE_MERL_HALF_PRECISION
+        const float rgb[4] = { halfToFloat( texel[0] ) , halfToFloat( texel[1] ) , halfToFloat( texel[2] ) , 0.0f };
+        texels[i] = simd_set_ps( rgb );
+#else
+        // the padding at the end of the table makes sure reading the fourth channel never goes out of bound
+        texels[i] = simd_set_ps( texel );
+#endif
+    }
+
+    const auto lerp = []( const simd_data& a , const simd_data& b , const simd_data& t ){
+        return simd_mad_ps( simd_sub_ps( b , a ) , t , a );
+    };
+    const auto tp = simd_set_ps1( fp ) , td_ = simd_set_ps1( fd ) , th_ = simd_set_ps1( fh );
+    const auto c00 = lerp( texels[0] , texels[1] , tp );
+    const auto c01 = lerp( texels[2] , texels[3] , tp );
+    const auto c10 = lerp( texels[4] , texels[5] , tp );
+    const auto c11 = lerp( texels[6] , texels[7] , tp );
+    const auto c0 = lerp( c00 , c01 , td_ );
+    const auto c1 = lerp( c10 , c11 , td_ );
+
+    // negative values indicate missing measurement
+    const auto c = simd_max_ps( lerp( c0 , c1 , th_ ) , simd_zeros );
+    return Spectrum( c[0] , c[1] , c[2] );
+#else
+    Spectrum texels[8];
+    for( auto i = 0 ; i < 8 ; ++i ){
+        const auto* texel = m_data.get() + indices[i];
+        texels[i] = Spectrum( halfToFloat( texel[0] ) , halfToFloat( texel[1] ) , halfToFloat( texel[2] ) );
+    }
+
+    const auto c0 = slerp( slerp( texels[0] , texels[1] , fp ) , slerp( texels[2] , texels[3] , fp ) , fd );
+    const auto c1 = slerp( slerp( texels[4] , texels[5] , fp ) , slerp( texels[6] , texels[7] , fp ) , fd );
+
+    // negative values indicate missing measurement
+    return slerp( c0 , c1 , fh ).Clamp( 0.0f , FLT_MAX );
+#endif
+}
+
 // evaluate bxdf
 Spectrum MerlData::f( const Vector& Wo , const Vector& Wi ) const
 {
@@ -112,24 +226,60 @@ Spectrum MerlData::f( const Vector& Wo , const Vector& Wi ) const
     if (wdPhi > PI)
         wdPhi -= PI;
 
-    // Compute indices _whThetaIndex_, _wdThetaIndex_, _wdPhiIndex_
-    auto whThetaIndex = (int)clamp(sqrtf(std::max(0.f, whTheta * 2.0f * INV_PI )) * MERL_SAMPLING_RES_THETA_H,  0.f, (float)(MERL_SAMPLING_RES_THETA_H-1));
-    auto wdThetaIndex = (int)clamp(wdTheta * INV_PI * 2.0f * MERL_SAMPLING_RES_THETA_D, 0.f , (float)(MERL_SAMPLING_RES_THETA_D-1));
-    auto wdPhiIndex = (int)clamp(wdPhi * INV_PI * MERL_SAMPLING_RES_PHI_D, 0.f , (float)(MERL_SAMPLING_RES_PHI_D - 1));
+    // Continuous coordinates in the table, bin centers are at half integer positions.
+    const auto thetaH = sqrtf(std::max(0.f, whTheta * 2.0f * INV_PI )) * MERL_SAMPLING_RES_THETA_H - 0.5f;
+    const auto thetaD = wdTheta * INV_PI * 2.0f * MERL_SAMPLING_RES_THETA_D - 0.5f;
+    const auto phiD = wdPhi * INV_PI * MERL_SAMPLING_RES_PHI_D - 0.5f;
+
+    return lookup( thetaH , thetaD , phiD );
+}
+
+Vector MerlData::SampleHalfVector( const float u , const float v ) const{
+    // Pick a bin of half angle theta first, the sample is then uniformly distributed in solid angle inside the bin.
+    const auto x = m_thetaHDistribution->SampleContinuous( u , nullptr ) * MERL_SAMPLING_RES_THETA_H;
+    const auto bin = std::min( (unsigned)x , MERL_SAMPLING_RES_THETA_H - 1 );
+    const auto t = x - bin;
 
-    // calculate the index
-    auto index = wdPhiIndex + MERL_SAMPLING_RES_PHI_D * (wdThetaIndex + whThetaIndex * MERL_SAMPLING_RES_THETA_D);
+    const auto cos_theta0 = cos( SQR( (float)bin / MERL_SAMPLING_RES_THETA_H ) * HALF_PI );
+    const auto cos_theta1 = cos( SQR( (float)( bin + 1 ) / MERL_SAMPLING_RES_THETA_H ) * HALF_PI );
+    const auto cos_theta = slerp( cos_theta0 , cos_theta1 , t );
+    const auto sin_theta = ssqrt( 1.0f - SQR( cos_theta ) );
+    return sphericalVec( sin_theta , cos_theta , TWO_PI * v );
+}
 
-    const auto r = (float)( m_data[ index ] );
-    index += MERL_SAMPLING_COUNT;
-    const auto g = (float)( m_data[ index ] );
-    index += MERL_SAMPLING_COUNT;
-    const auto b = (float)( m_data[ index ] );
+float MerlData::PdfHalfVector( const Vector& wh ) const{
+    const auto theta = sphericalTheta( wh );
+    const auto bin = std::min( (unsigned)( sqrtf( std::max( 0.f , theta * 2.0f * INV_PI ) ) * MERL_SAMPLING_RES_THETA_H ) , MERL_SAMPLING_RES_THETA_H - 1 );
 
-    return Spectrum( r , g , b );
+    const auto cos_theta0 = cos( SQR( (float)bin / MERL_SAMPLING_RES_THETA_H ) * HALF_PI );
+    const auto cos_theta1 = cos( SQR( (float)( bin + 1 ) / MERL_SAMPLING_RES_THETA_H ) * HALF_PI );
+    return m_thetaHDistribution->GetProperty( bin ) / ( TWO_PI * ( cos_theta0 - cos_theta1 ) );
 }
 
  Merl::Merl(RenderContext& rc, const ClosureTypeMERL& params, const Spectrum& weight, bool doubleSided)
      : Bxdf(rc, weight, BXDF_ALL, params.normal, doubleSided), m_data((MerlData*)params.merl_data)
  {
- }
\ No newline at end of file
+ }
+
+Spectrum Merl::sample_f( const Vector& wo , Vector& wi , const BsdfSample& bs , float* pPdf ) const{
+    // the half vector is sampled in the upper hemisphere, reflecting a back facing direction about it still works
+    const auto wh = m_data->SampleHalfVector( bs.u , bs.v );
+    wi = reflect( wo , wh );
+
+    if (pPdf) *pPdf = pdf(wo, wi);
+    return f( wo , wi );
+}
+
+float Merl::pdf( const Vector& wo , const Vector& wi ) const{
+    if (!SameHemiSphere(wo, wi)) return 0.0f;
+    if (!doubleSided && !PointingUp(wo)) return 0.0f;
+
+    auto wh = wo + wi;
+    if (wh.x == 0.f && wh.y == 0.f && wh.z == 0.f)
+        return 0.0f;
+    wh = normalize( wh );
+    if( wh.y < 0.0f )
+        wh = -wh;
+
+    return m_data->PdfHalfVector( wh ) / ( 4.0f * absDot( wo , wh ) );
+}
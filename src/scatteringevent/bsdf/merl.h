@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include "bxdf.h"
 #include "core/resource.h"
+#include "core/samplemethod.h"
 #include "scatteringevent/bsdf/bxdf_utils.h"
 
 DECLARE_CLOSURE_TYPE_BEGIN(ClosureTypeMERL, "merl")
@@ -26,6 +29,10 @@ DECLARE_CLOSURE_TYPE_VAR(ClosureTypeMERL, Tsl_resource, merl_data)
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeMERL, Tsl_float3, normal)
 DECLARE_CLOSURE_TYPE_END(ClosureTypeMERL)
 
+// Store measured BRDF in half precision instead of single precision. Measured data is noisy to begin with, the precision
+// loss is far below the measurement error, while it halves the memory footprint of each MERL material one more time.
+#define ENABLE_MERL_HALF_PRECISION
+
 //! @brief Phong BRDF.
 /**
  * MERL BRDF Database - Mitsubishi Electric Research Laboratories
@@ -45,16 +52,53 @@ public:
     //! @return     The Evaluated BRDF value.
     Spectrum f( const Vector& wo , const Vector& wi ) const;
 
+    //! @brief  Importance sample a half vector based on the tabulated distribution of half angles.
+    //!
+    //! @param u    A canonical random variable.
+    //! @param v    Another canonical random variable.
+    //! @return     The sampled half vector, it is always in the upper hemisphere.
+    Vector SampleHalfVector( const float u , const float v ) const;
+
+    //! @brief  Pdf of sampling a half vector w.r.t solid angle.
+    //!
+    //! @param wh   The half vector, it is expected to be in the upper hemisphere.
+    //! @return     The pdf of sampling the half vector.
+    float   PdfHalfVector( const Vector& wh ) const;
+
     //! Load brdf data from MERL file.
     //! @param filename Name of the MERL file.
     bool    LoadResource(const std::string filename) override;
 
+    //! @brief  Load brdf data from memory with exactly the same layout as a MERL file.
+    //!
+    //! @param data     Content of a MERL file.
+    //! @param size     Size of the data in bytes.
+    //! @return         Whether the data is valid.
+    bool    LoadData( const unsigned char* data , const size_t size );
+
     //! Whether there is valid data loaded.
     //! @return True if data is valid, otherwise it will return false.
     bool    IsValid() { return m_data != 0; }
 
 private:
-    std::unique_ptr<double[]>    m_data = nullptr;   /**< The actual data of MERL brdf. */
+#ifdef ENABLE_MERL_HALF_PRECISION
+    using Texel = uint16_t;
+#else
+    using Texel = float;
+#endif
+
+    //! @brief  Trilinearly interpolate the tabulated BRDF.
+    //!
+    //! @param thetaH   Continuous coordinate of half angle theta in the table.
+    //! @param thetaD   Continuous coordinate of difference angle theta in the table.
+    //! @param phiD     Continuous coordinate of difference angle phi in the table.
+    //! @return         The interpolated BRDF value.
+    Spectrum lookup( const float thetaH , const float thetaD , const float phiD ) const;
+
+    /**< Tabulated BRDF with interleaved rgb channels, there is one extra texel of padding at the end for 4-wide loads. */
+    std::unique_ptr<Texel[]>            m_data = nullptr;
+    /**< Distribution of half angle theta used for importance sampling. */
+    std::unique_ptr<Distribution1D>     m_thetaHDistribution = nullptr;
 };
 
 //! @brief  MERL brdf.
@@ -62,11 +106,10 @@ private:
  * MERL is short for Mitsubishi Electric Research Laboratories. They provide some measured
  * brdf on the website http://www.merl.com/brdf/. Merl class is responsible for loading
  * and displaying the brdf they provided in the renderer.\n
- * There is no importance sampling for this brdf. With the default sampling method, the
- * convergence rage is extremely low.
  * The paper <a href="http://csbio.unc.edu/mcmillan/pubs/sig03_matusik.pdf">
  * "A Data-Driven Reflectance Model"</a> didn't propose an importance sampling method
- * for it. Further research is needed before it can be practical to be used.
+ * for it. Half vectors are importance sampled based on the tabulated distribution of
+ * half angle theta, which captures the specular peak of most measured materials.
  */
 class Merl : public Bxdf
 {
@@ -87,6 +130,20 @@ public:
         return m_data->f(wo,wi) * absCosTheta(wi);
     }
 
+    //! @brief Importance sampling for the MERL BRDF.
+    //! @param wo   Exitant direction in shading coordinate.
+    //! @param wi   Incident direction in shading coordinate.
+    //! @param bs   Sample for bsdf that holds some random variables.
+    //! @param pdf  Probability density of the selected direction.
+    //! @return     The Evaluated BRDF value.
+    Spectrum sample_f( const Vector& wo , Vector& wi , const BsdfSample& bs , float* pdf ) const override;
+
+    //! @brief Evaluate the pdf of an exitant direction given the Incident direction.
+    //! @param wo   Exitant direction in shading coordinate.
+    //! @param wi   Incident direction in shading coordinate.
+    //! @return     The probability of choosing the out-going direction based on the Incident direction.
+    float pdf( const Vector& wo , const Vector& wi ) const override;
+
 private:
     const MerlData* m_data;   /**< The actual data of MERL brdf. */
 };
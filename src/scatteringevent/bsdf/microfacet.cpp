@@ -226,6 +226,13 @@ float Beckmann::G1( const Vector& v ) const {
     return ( 3.535f * a + 2.181f * a * a ) / ( 1.0f + 2.276f * a + 2.577f * a * a );
 }
 
+bool Beckmann::GetBatchParams( MicrofacetLobe& lobe ) const {
+    lobe.alphaU2 = alphaU2;
+    lobe.alphaV2 = alphaV2;
+    lobe.beckmann = true;
+    return true;
+}
+
 GGX::GGX( float roughnessU , float roughnessV ): MicroFacetDistribution(roughnessU) {
     // UE4 style way to convert roughness to alpha used here because it still keeps sharp reflection with low value of roughness
     // http://graphicrants.blogspot.com/2013/08/specular-brdf-reference.html
@@ -283,6 +290,13 @@ float GGX::G1( const Vector& v ) const {
     return 2.0f / ( 1.0f + sqrt( 1.0f + alpha2 * tan_theta_sq ) );
 }
 
+bool GGX::GetBatchParams( MicrofacetLobe& lobe ) const {
+    lobe.alphaU2 = alphaU2;
+    lobe.alphaV2 = alphaV2;
+    lobe.beckmann = false;
+    return true;
+}
+
 Microfacet::Microfacet(RenderContext& rc, const MF_Dist_Type distType, float ru , float rv , const Spectrum& w, const BXDF_TYPE t , const Vector& n , bool doubleSided ) :
     Bxdf(rc, w, t, n, doubleSided ) {
     if(distType == MF_DIST_GGX)
@@ -355,6 +369,16 @@ float MicroFacetReflection::pdf( const Vector& wo , const Vector& wi ) const {
     return distribution->Pdf(h) / (4.0f * EoH);
 }
 
+bool MicroFacetReflection::GetMicrofacetLobe( MicrofacetLobe& lobe ) const {
+    // lobes with normal map don't share the same shading frame with others
+    if( normal_map_applied || !distribution->GetBatchParams( lobe ) )
+        return false;
+    lobe.doubleSided = doubleSided;
+    lobe.R = R;
+    lobe.fresnel = fresnel;
+    return true;
+}
+
 Spectrum MicroFacetReflectionMS::f( const Vector& wo , const Vector& wi ) const {
     if (!SameHemiSphere(wo, wi)) return 0.0f;
     if (!doubleSided && !PointingUp(wo)) return 0.0f;
@@ -22,6 +22,7 @@
 #include "spectrum/spectrum.h"
 #include "scatteringevent/bsdf/bxdf_utils.h"
 #include "multi_scattering_lut.h"
+#include "microfacet_batch.h"
 
 DECLARE_CLOSURE_TYPE_BEGIN(ClosureTypeMirror, "mirror")
 DECLARE_CLOSURE_TYPE_VAR(ClosureTypeMirror, Tsl_float3, base_color)
@@ -142,6 +143,13 @@ public:
         return roughness;
     }
 
+    //! @brief Get the parameters of the distribution for evaluating it together with other lobes.
+    //! @param lobe     The lobe to be filled with the roughness and the type of the distribution.
+    //! @return         Whether the distribution could be evaluated in a batch.
+    virtual bool GetBatchParams( MicrofacetLobe& lobe ) const {
+        return false;
+    }
+
 protected:
     //! @brief  Roughness of the distribution, this is merely for multi-scattering brdf
     const float roughness;
@@ -203,6 +211,11 @@ public:
     //! @return     Sampled normal direction based on the NDF.
     Vector sample_f( const BsdfSample& bs ) const override;
 
+    //! @brief Get the parameters of the distribution for evaluating it together with other lobes.
+    //! @param lobe     The lobe to be filled with the roughness and the type of the distribution.
+    //! @return         Always true.
+    bool GetBatchParams( MicrofacetLobe& lobe ) const override;
+
 private:
     float alphaU , alphaV;        /**< Internal data used for NDF calculation. */
     float alphaU2 , alphaV2 , alphaUV, alpha;
@@ -232,6 +245,11 @@ public:
     //! @return     Sampled normal direction based on the NDF.
     Vector sample_f( const BsdfSample& bs ) const override;
 
+    //! @brief Get the parameters of the distribution for evaluating it together with other lobes.
+    //! @param lobe     The lobe to be filled with the roughness and the type of the distribution.
+    //! @return         Always true.
+    bool GetBatchParams( MicrofacetLobe& lobe ) const override;
+
 protected:
     float alphaU , alphaV;        /**< Internal data used for NDF calculation. */
     float alphaU2 , alphaV2 , alphaUV , alpha;
@@ -338,6 +356,11 @@ public:
     //! @return     The probability of choosing the out-going direction based on the Incident direction.
     float pdf( const Vector& wo , const Vector& wi ) const override;
 
+    //! @brief Get the parameters of the brdf as a microfacet reflection lobe.
+    //! @param lobe     Parameters of the lobe.
+    //! @return         Whether the brdf could be evaluated together with other microfacet reflection lobes.
+    bool GetMicrofacetLobe( MicrofacetLobe& lobe ) const override;
+
 protected:
     const Spectrum R;                   /**< Direction-hemisphere reflection. */
     const Fresnel* fresnel = nullptr;   /**< Fresnel term. */
@@ -368,6 +391,11 @@ public:
     //! @param wi   Incident direction in shading coordinate.
     //! @return     The Evaluated BRDF value.
     Spectrum f( const Vector& wo , const Vector& wi ) const override;
+
+    //! @brief Multi-scattering is not supported in batched evaluation, this brdf is always evaluated on its own.
+    bool GetMicrofacetLobe( MicrofacetLobe& lobe ) const override {
+        return false;
+    }
 };
 
 //! @brief Microfacet Refraction BTDF.
@@ -0,0 +1,174 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include "microfacet_batch.h"
+
+#ifdef SIMD_4WAY_ENABLED
+#define SIMD_4WAY_IMPLEMENTATION
+#include "simd/simd_wrapper.h"
+#endif
+
+#include "math/utils.h"
+#include "scatteringevent/bsdf/bxdf.h"
+#include "scatteringevent/bsdf/fresnel.h"
+
+#ifdef SIMD_4WAY_ENABLED
+static_assert( MF_BATCH_MAX_LOBE_CNT % SIMD_CHANNEL == 0 , "Lobe count in a batch needs to be multiple of SIMD channel count." );
+#endif
+
+// Beckmann shadowing-masking term, it is the same rational approximation used in Beckmann::G1.
+SORT_STATIC_FORCEINLINE float beckmannG1( const float a ){
+    if( a > 1.6f || IsInf( a ) ) return 1.0f;
+    return ( 3.535f * a + 2.181f * a * a ) / ( 1.0f + 2.276f * a + 2.577f * a * a );
+}
+
+bool MicrofacetBatch::Add( const Bxdf* bxdf ){
+    if( m_lobeCnt == MF_BATCH_MAX_LOBE_CNT )
+        return false;
+
+    MicrofacetLobe lobe;
+    if( !bxdf->GetMicrofacetLobe( lobe ) )
+        return false;
+
+    const auto i = m_lobeCnt++;
+
+#ifdef SIMD_4WAY_ENABLED
+    // Make sure the rest of the lanes in the same group hold valid parameters, they are evaluated, but never used.
+    if( i % SIMD_CHANNEL == 0 ){
+        std::fill( m_alphaU2 + i , m_alphaU2 + i + SIMD_CHANNEL , 1.0f );
+        std::fill( m_alphaV2 + i , m_alphaV2 + i + SIMD_CHANNEL , 1.0f );
+        std::fill( m_invAlphaU2 + i , m_invAlphaU2 + i + SIMD_CHANNEL , 1.0f );
+        std::fill( m_invAlphaV2 + i , m_invAlphaV2 + i + SIMD_CHANNEL , 1.0f );
+        std::fill( m_norm + i , m_norm + i + SIMD_CHANNEL , INV_PI );
+        std::fill( m_beckmann + i , m_beckmann + i + SIMD_CHANNEL , false );
+    }
+#endif
+
+    m_bxdfs[i] = bxdf;
+    m_R[i] = lobe.R * bxdf->GetEvalWeight();
+    m_fresnel[i] = lobe.fresnel;
+    m_sampleWeight[i] = bxdf->GetSampleWeight();
+    m_doubleSided[i] = lobe.doubleSided;
+    m_beckmann[i] = lobe.beckmann;
+    m_alphaU2[i] = lobe.alphaU2;
+    m_alphaV2[i] = lobe.alphaV2;
+    m_invAlphaU2[i] = 1.0f / lobe.alphaU2;
+    m_invAlphaV2[i] = 1.0f / lobe.alphaV2;
+    m_norm[i] = INV_PI / sqrt( lobe.alphaU2 * lobe.alphaV2 );
+    return true;
+}
+
+void MicrofacetBatch::Evaluate( const Vector& wo , const Vector& wi , Spectrum* f , float* pdf , const Bxdf* excluded ) const{
+    // None of the lobes has normal map, the geometry normal is simply the up axis in local coordinate.
+    const auto wo_up = wo.y > 0.0f;
+    if( wo_up != ( wi.y > 0.0f ) )
+        return;
+
+    // The half vector is shared by all lobes, so is everything depending only on it.
+    const auto wh = normalize( wo + wi );
+    const auto cos_h_sq = SQR( wh.y );
+    if( cos_h_sq <= 0.0f )
+        return;
+
+    const auto h_x_sq = SQR( wh.x ) , h_z_sq = SQR( wh.z );
+    const auto o_x_sq = SQR( wo.x ) , o_y_sq = SQR( wo.y ) , o_z_sq = SQR( wo.z );
+    const auto i_x_sq = SQR( wi.x ) , i_y_sq = SQR( wi.y ) , i_z_sq = SQR( wi.z );
+
+    // Normal distribution and the product of it and the shadowing-masking term of each lobe.
+    float d[MF_BATCH_MAX_LOBE_CNT] , dg[MF_BATCH_MAX_LOBE_CNT];
+
+#ifdef SIMD_4WAY_ENABLED
+    const auto cos_h_sq_simd = simd_set_ps1( cos_h_sq );
+    const auto h_x_sq_simd = simd_set_ps1( h_x_sq ) , h_z_sq_simd = simd_set_ps1( h_z_sq );
+    const auto o_x_sq_simd = simd_set_ps1( o_x_sq ) , o_y_sq_simd = simd_set_ps1( o_y_sq ) , o_z_sq_simd = simd_set_ps1( o_z_sq );
+    const auto i_x_sq_simd = simd_set_ps1( i_x_sq ) , i_y_sq_simd = simd_set_ps1( i_y_sq ) , i_z_sq_simd = simd_set_ps1( i_z_sq );
+    const auto two = simd_set_ps1( 2.0f );
+
+    // GGX:         D(h) = 1 / ( PI * alphaU * alphaV * ( cos^2 + x^2 / alphaU^2 + z^2 / alphaV^2 )^2 )
+    //              G1(v) = 2 / ( 1 + sqrt( 1 + ( alphaU^2 * x^2 + alphaV^2 * z^2 ) / y^2 ) )
+    // Beckmann:    D(h) = exp( -( x^2 / alphaU^2 + z^2 / alphaV^2 ) / cos^2 ) / ( PI * alphaU * alphaV * cos^4 )
+    //              G1(v) = rational approximation of a = y / sqrt( alphaU^2 * x^2 + alphaV^2 * z^2 )
+    const auto ggx_g1 = [&]( const simd_data& a2t ){
+        return simd_div_ps( two , simd_add_ps( simd_ones , simd_sqrt_ps( simd_add_ps( simd_ones , a2t ) ) ) );
+    };
+    const auto beckmann_g1 = [&]( const simd_data& a2t ){
+        const auto a = simd_sqrt_ps( simd_rcp_ps( a2t ) );
+        const auto a2 = simd_mul_ps( a , a );
+        const auto nom = simd_mad_ps( simd_set_ps1( 2.181f ) , a2 , simd_mul_ps( simd_set_ps1( 3.535f ) , a ) );
+        const auto denom = simd_mad_ps( simd_set_ps1( 2.577f ) , a2 , simd_mad_ps( simd_set_ps1( 2.276f ) , a , simd_ones ) );
+        return simd_pick_ps( simd_cmpgt_ps( a , simd_set_ps1( 1.6f ) ) , simd_ones , simd_div_ps( nom , denom ) );
+    };
+
+    for( auto g = 0u ; g < m_lobeCnt ; g += SIMD_CHANNEL ){
+        const auto alpha_u2 = simd_set_ps( m_alphaU2 + g ) , alpha_v2 = simd_set_ps( m_alphaV2 + g );
+        const auto norm = simd_set_ps( m_norm + g );
+        const auto beckmann = simd_set_mask( m_beckmann + g );
+
+        const auto q = simd_mad_ps( h_x_sq_simd , simd_set_ps( m_invAlphaU2 + g ) , simd_mul_ps( h_z_sq_simd , simd_set_ps( m_invAlphaV2 + g ) ) );
+        const auto a2t_o = simd_div_ps( simd_mad_ps( alpha_u2 , o_x_sq_simd , simd_mul_ps( alpha_v2 , o_z_sq_simd ) ) , o_y_sq_simd );
+        const auto a2t_i = simd_div_ps( simd_mad_ps( alpha_u2 , i_x_sq_simd , simd_mul_ps( alpha_v2 , i_z_sq_simd ) ) , i_y_sq_simd );
+
+        const auto beta = simd_add_ps( cos_h_sq_simd , q );
+        auto dist = simd_div_ps( norm , simd_mul_ps( beta , beta ) );
+        auto g1_o = ggx_g1( a2t_o ) , g1_i = ggx_g1( a2t_i );
+
+        if( simd_movemask_ps( beckmann ) ){
+            // there is no exponential in SIMD, it is only evaluated on Beckmann lanes.
+            float e[SIMD_CHANNEL];
+            simd_store_ps( e , simd_div_ps( q , cos_h_sq_simd ) );
+            for( auto k = 0u ; k < SIMD_CHANNEL ; ++k )
+                e[k] = m_beckmann[g + k] ? exp( -e[k] ) : 0.0f;
+            const auto beckmann_dist = simd_div_ps( simd_mul_ps( norm , simd_set_ps( e ) ) , simd_set_ps1( SQR( cos_h_sq ) ) );
+
+            dist = simd_pick_ps( beckmann , beckmann_dist , dist );
+            g1_o = simd_pick_ps( beckmann , beckmann_g1( a2t_o ) , g1_o );
+            g1_i = simd_pick_ps( beckmann , beckmann_g1( a2t_i ) , g1_i );
+        }
+
+        simd_store_ps( d + g , dist );
+        simd_store_ps( dg + g , simd_mul_ps( dist , simd_mul_ps( g1_o , g1_i ) ) );
+    }
+#else
+    for( auto i = 0u ; i < m_lobeCnt ; ++i ){
+        const auto q = h_x_sq * m_invAlphaU2[i] + h_z_sq * m_invAlphaV2[i];
+        const auto a2t_o = ( m_alphaU2[i] * o_x_sq + m_alphaV2[i] * o_z_sq ) / o_y_sq;
+        const auto a2t_i = ( m_alphaU2[i] * i_x_sq + m_alphaV2[i] * i_z_sq ) / i_y_sq;
+        if( m_beckmann[i] ){
+            d[i] = m_norm[i] * exp( -q / cos_h_sq ) / SQR( cos_h_sq );
+            dg[i] = d[i] * beckmannG1( 1.0f / sqrt( a2t_o ) ) * beckmannG1( 1.0f / sqrt( a2t_i ) );
+        }else{
+            d[i] = m_norm[i] / SQR( cos_h_sq + q );
+            dg[i] = d[i] * 2.0f / ( 1.0f + sqrt( 1.0f + a2t_o ) ) * 2.0f / ( 1.0f + sqrt( 1.0f + a2t_i ) );
+        }
+    }
+#endif
+
+    const auto VoH = dot( wo , wh );
+    const auto NoV = fabs( wo.y );
+    const auto f_scale = NoV == 0.0f ? 0.0f : 1.0f / ( 4.0f * NoV );
+    const auto pdf_scale = fabs( wh.y ) / ( 4.0f * fabs( VoH ) );
+
+    for( auto i = 0u ; i < m_lobeCnt ; ++i ){
+        if( m_bxdfs[i] == excluded || ( !m_doubleSided[i] && !wo_up ) )
+            continue;
+        if( f && f_scale > 0.0f )
+            *f += m_R[i] * m_fresnel[i]->Evaluate( VoH ) * ( dg[i] * f_scale );
+        if( pdf )
+            *pdf += d[i] * pdf_scale * m_sampleWeight[i];
+    }
+}
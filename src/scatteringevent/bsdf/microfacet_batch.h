@@ -0,0 +1,109 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "core/define.h"
+#include "spectrum/spectrum.h"
+#include "math/vector3.h"
+
+// Evaluate GGX/Beckmann microfacet reflection lobes in a scattering event together instead of one virtual call per lobe.
+// Lobes without normal map share the exact same local frame, which means the half vector, the fresnel cosine and most of
+// the geometry term inputs are shared among them, only the roughness and the reflectance differ. With this enabled, such
+// lobes are gathered when added to the scattering event and their distribution and shadowing terms are evaluated with SIMD
+// across lobes.
+#define ENABLE_BXDF_BATCH
+
+// Batching only pays off when there are at least this many lobes to evaluate together.
+#define MF_BATCH_MIN_LOBE_CNT       2
+
+// Maximum number of lobes in a batch, it matches the maximum number of bxdfs in a scattering event.
+#define MF_BATCH_MAX_LOBE_CNT       16
+
+class Bxdf;
+class Fresnel;
+
+//! @brief  Parameters of a microfacet reflection lobe that could be evaluated together with other lobes.
+struct MicrofacetLobe{
+    float           alphaU2 = 1.0f;         /**< Squared alpha along the tangent direction. */
+    float           alphaV2 = 1.0f;         /**< Squared alpha along the bi-tangent direction. */
+    bool            beckmann = false;       /**< Beckmann distribution if true, GGX otherwise. */
+    bool            doubleSided = false;    /**< Whether the lobe is double sided. */
+    Spectrum        R;                      /**< Reflectance of the lobe. */
+    const Fresnel*  fresnel = nullptr;      /**< Fresnel term of the lobe. */
+};
+
+//! @brief  A batch of microfacet reflection lobes sharing the same local frame.
+/**
+ * The batch keeps the parameters of the lobes in structure of arrays layout so that the normal distribution and the
+ * shadowing-masking terms of SIMD_CHANNEL lobes are evaluated at once. Fresnel terms stay per lobe since they could be
+ * of any type, though they only take one shared cosine value.
+ * The result is exactly what MicroFacetReflection::f and MicroFacetReflection::pdf return, summed over the lobes with
+ * their evaluation and sampling weights.
+ */
+class MicrofacetBatch{
+public:
+    //! @brief  Try to add a bxdf in the batch.
+    //!
+    //! @param  bxdf        The bxdf to be added.
+    //! @return             Whether the bxdf is added, only microfacet reflection lobes without normal map are accepted.
+    bool        Add( const Bxdf* bxdf );
+
+    //! @brief  Get the number of lobes in the batch.
+    //!
+    //! @return             Number of lobes in the batch.
+    SORT_FORCEINLINE unsigned GetLobeCnt() const {
+        return m_lobeCnt;
+    }
+
+    //! @brief  Evaluate the weighted sum of all lobes in the batch.
+    //!
+    //! Results are accumulated on top of what is passed in so that the rest of the bxdfs can be added the same way.
+    //!
+    //! @param  wo          Exitant direction in local coordinate.
+    //! @param  wi          Incident direction in local coordinate.
+    //! @param  f           BRDF values multiplied by evaluation weights are added to it, it could be 'nullptr'.
+    //! @param  pdf         PDFs multiplied by sampling weights are added to it, it could be 'nullptr'.
+    //! @param  excluded    A lobe to be skipped during evaluation, it could be 'nullptr'.
+    void        Evaluate( const Vector& wo , const Vector& wi , Spectrum* f , float* pdf , const Bxdf* excluded = nullptr ) const;
+
+private:
+    /**< Bxdfs in the batch. */
+    const Bxdf*     m_bxdfs[MF_BATCH_MAX_LOBE_CNT] = { nullptr };
+    /**< Reflectance multiplied by evaluation weight of each lobe. */
+    Spectrum        m_R[MF_BATCH_MAX_LOBE_CNT];
+    /**< Fresnel term of each lobe. */
+    const Fresnel*  m_fresnel[MF_BATCH_MAX_LOBE_CNT] = { nullptr };
+    /**< Sampling weight of each lobe. */
+    float           m_sampleWeight[MF_BATCH_MAX_LOBE_CNT] = { 0.0f };
+    /**< Whether each lobe is double sided. */
+    bool            m_doubleSided[MF_BATCH_MAX_LOBE_CNT] = { false };
+    /**< Whether each lobe uses Beckmann distribution instead of GGX. */
+    bool            m_beckmann[MF_BATCH_MAX_LOBE_CNT] = { false };
+    /**< Squared alpha along the tangent direction. */
+    float           m_alphaU2[MF_BATCH_MAX_LOBE_CNT];
+    /**< Squared alpha along the bi-tangent direction. */
+    float           m_alphaV2[MF_BATCH_MAX_LOBE_CNT];
+    /**< Reciprocal of the squared alpha along the tangent direction. */
+    float           m_invAlphaU2[MF_BATCH_MAX_LOBE_CNT];
+    /**< Reciprocal of the squared alpha along the bi-tangent direction. */
+    float           m_invAlphaV2[MF_BATCH_MAX_LOBE_CNT];
+    /**< Normalization factor of the distribution, 1 / ( PI * alphaU * alphaV ). */
+    float           m_norm[MF_BATCH_MAX_LOBE_CNT];
+    /**< Number of lobes in the batch. */
+    unsigned        m_lobeCnt = 0;
+};
@@ -56,9 +56,7 @@ public:
         : Bxdf(rc, weight, (BXDF_TYPE)(BXDF_DIFFUSE | BXDF_REFLECTION), params.normal, doubleSided) , D(params.diffuse), S(params.specular), power(params.specular_power),
           diffRatio(intensity_tsl_float3(params.diffuse)/(intensity_tsl_float3(params.diffuse)+ intensity_tsl_float3(params.specular))) {
         const auto combined = D + S;
-        sAssert(combined.r <= 1.0f, MATERIAL);
-        sAssert(combined.g <= 1.0f, MATERIAL);
-        sAssert(combined.b <= 1.0f, MATERIAL);
+        sAssert(combined.GetMaxComponent() <= 1.0f, MATERIAL);
     }
 
     //! Constructor
@@ -71,9 +69,7 @@ public:
         : Bxdf(rc, weight, (BXDF_TYPE)(BXDF_DIFFUSE | BXDF_REFLECTION), n, doubleSided) , D(diffuse), S(specular), power(specularPower),
           diffRatio(diffuse.GetIntensity()/(diffuse.GetIntensity()+specular.GetIntensity())) {
         const auto combined = D + S;
-        sAssert(combined.r <= 1.0f, MATERIAL);
-        sAssert(combined.g <= 1.0f, MATERIAL);
-        sAssert(combined.b <= 1.0f, MATERIAL);
+        sAssert(combined.GetMaxComponent() <= 1.0f, MATERIAL);
     }
 
     //! Evaluate the BRDF
@@ -31,23 +31,6 @@ SeparableBssrdf::SeparableBssrdf( const Spectrum& R , const SurfaceInteraction*
 }
 
 void SeparableBssrdf::Sample_S( const Scene& scene , const Vector& wo , const Point& po , BSSRDFIntersections& inter, RenderContext& rc ) const {
-    Vector vx , vy , vz;
-    const auto r0 = sort_rand<float>(rc);
-
-    if( r0 <= 0.5f ){
-        vx = btn;
-        vy = nn;
-        vz = tn;
-    }else if( r0 < 0.75f ){
-        vx = tn;
-        vy = btn;
-        vz = nn;
-    }else{
-        vx = nn;
-        vy = tn;
-        vz = btn;
-    }
-
     const auto ch = Sample_Ch(rc);
     const auto tmp = sort_rand<float>(rc);
     const auto r = Sample_Sr(ch, tmp);
@@ -61,19 +44,50 @@ void SeparableBssrdf::Sample_S( const Scene& scene , const Vector& wo , const Po
     const auto l = 2.0f * sqrt( SQR(rMax) - SQR(r) );
 
     const auto phi = TWO_PI * sort_rand<float>(rc);
-    const auto source = po + r * ( vx * cos(phi) + vz * sin(phi) ) + l * vy * 0.5f;
-    
-    const Ray ray( source , -vy , 0 , 0.0001f , l );
-    scene.GetIntersect( ray , inter , rc, intersection->primitive->GetMaterial()->GetUniqueID() );
+    const auto cos_phi = cos(phi);
+    const auto sin_phi = sin(phi);
+
+    // The sampled point on the disk is projected along all three axes, instead of a randomly picked one. The three probe rays
+    // are traced as one packet so that they share the cost of traversal.
+    const Vector frames[SSS_PROBE_CNT][3] = { { btn , nn , tn } , { tn , btn , nn } , { nn , tn , btn } };
+    Ray rays[SSS_PROBE_CNT];
+    for( auto i = 0u ; i < SSS_PROBE_CNT ; ++i ){
+        const auto& vx = frames[i][0];
+        const auto& vy = frames[i][1];
+        const auto& vz = frames[i][2];
+        const auto source = po + r * ( vx * cos_phi + vz * sin_phi ) + l * vy * 0.5f;
+        rays[i] = Ray( source , -vy , 0 , 0.0001f , l );
+    }
+
+    BSSRDFIntersections probes[SSS_PROBE_CNT];
+    scene.GetIntersectPacket( rays , probes , SSS_PROBE_CNT , rc, intersection->primitive->GetMaterial()->GetUniqueID() );
+
+    BSSRDFIntersection* hits[SSS_PROBE_CNT * TOTAL_SSS_INTERSECTION_CNT];
+    auto hit_cnt = 0u;
+    for( const auto& probe : probes ){
+        for( auto i = 0u ; i < probe.cnt ; ++i )
+            hits[hit_cnt++] = probe.intersections[i];
+    }
+
+    // There are more hits than what could be returned, a random subset is kept with their weights scaled up to compensate the rest.
+    const auto kept_cnt = std::min( hit_cnt , (unsigned)TOTAL_SSS_INTERSECTION_CNT );
+    for( auto i = 0u ; i < kept_cnt ; ++i ){
+        const auto j = i + std::min( (unsigned)( sort_rand<float>(rc) * ( hit_cnt - i ) ) , hit_cnt - i - 1 );
+        std::swap( hits[i] , hits[j] );
+    }
+    const auto compensation = kept_cnt > 0 ? (float)hit_cnt / (float)kept_cnt : 0.0f;
+
+    inter.cnt = kept_cnt;
+    for( auto i = 0u ; i < kept_cnt ; ++i ){
+        sAssert(IS_PTR_VALID(hits[i]), MATERIAL );
 
-    for( auto i = 0u ; i < inter.cnt ; ++i ){
-        sAssert(IS_PTR_VALID(inter.intersections[i]), MATERIAL );
+        auto pIntersection = hits[i];
+        inter.intersections[i] = pIntersection;
 
-        auto pIntersection = inter.intersections[i];
         const auto bssrdf = Sr( distance( po , pIntersection->intersection.intersect ) );
         const auto pdf = Pdf_Sp( po , pIntersection->intersection.intersect , pIntersection->intersection.gnormal );
         if( pdf > 0.0f && !bssrdf.IsBlack() )
-            pIntersection->weight = bssrdf / pdf * GetEvalWeight();
+            pIntersection->weight = bssrdf / pdf * GetEvalWeight() * compensation;
     }
 }
 
@@ -86,7 +100,8 @@ float SeparableBssrdf::Pdf_Sp( const Point& po , const Point& pi , const Vector&
                        sqrt( SQR( dLocal.x ) + SQR( dLocal.z ) ) ,
                        sqrt( SQR( dLocal.x ) + SQR( dLocal.y ) ) };
 
-    constexpr float axisProb[3] = { 0.25f , 0.5f , 0.25f };
+    // Every hit could be found by any of the three probe rays, the pdf of all of them are summed up, which is the
+    // balance heuristic of multi-sample MIS.
     auto pdf = 0.0f ;
     for( auto axis = 0 ; axis < 3 ; ++axis ){
         for( auto ch = 0 ; ch < SPECTRUM_SAMPLE ; ++ch ){
@@ -94,7 +109,7 @@ float SeparableBssrdf::Pdf_Sp( const Point& po , const Point& pi , const Vector&
             if( R[ch] == 0.0f )
                 continue;
             #endif
-            pdf += Pdf_Sr( ch , rProj[axis] ) * std::abs( nLocal[axis] ) * axisProb[axis];
+            pdf += Pdf_Sr( ch , rProj[axis] ) * std::abs( nLocal[axis] );
         }
     }
     pdf /= channels;
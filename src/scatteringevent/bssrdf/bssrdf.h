@@ -30,6 +30,10 @@ class Scene;
 
 // Up to 4 intersection supported.
 #define     TOTAL_SSS_INTERSECTION_CNT      4
+// Up to 4 probe rays could be traced in a packet.
+#define     SSS_PACKET_MAX_CNT              4
+// Number of probe rays, one along each axis of the local coordinate.
+#define     SSS_PROBE_CNT                   3
 
 struct BSSRDFIntersection{
     SurfaceInteraction  intersection;
@@ -126,6 +130,8 @@ public:
 
     //! @brief  PDF of sampling the reflectance profile.
     //!
+    //! This is the sum of the pdf of all probe rays, each of which projects the disk along an axis of the local coordinate.
+    //!
     //! @param  po      Extant position in world coordinate.
     //! @param  pi      Incident position in world coordinate.
     //! @param  n       Normal in world coordinate at incident position.
@@ -21,6 +21,10 @@
 #include "sampler/sample.h"
 #include "scatteringevent/bsdf/bxdf_utils.h"
 
+#ifdef ENABLE_BXDF_BATCH
+static_assert( MF_BATCH_MAX_LOBE_CNT >= SE_MAX_BXDF_COUNT , "Microfacet batch needs to be able to hold all bxdfs in a scattering event." );
+#endif
+
 template< class T  >
 SORT_STATIC_FORCEINLINE const T* pickScattering( RenderContext& rc, const T* const scattering[] , unsigned int cnt , float totalWeight , float& pdf ){
     sAssert( totalWeight > 0.0f , MATERIAL );
@@ -83,8 +87,14 @@ Spectrum ScatteringEvent::Evaluate_BSDF( const Vector& wo , const Vector& wi ) c
     const auto swo = worldToLocal( wo );
     const auto swi = worldToLocal( wi );
     Spectrum r;
-    for( auto i = 0u ; i < m_bxdfCnt ; ++i )
-        r += m_bxdfs[i]->F( swo , swi ) * m_bxdfs[i]->GetEvalWeight();
+#ifdef ENABLE_BXDF_BATCH
+    if( useBatch() )
+        m_mfBatch.Evaluate( swo , swi , &r , nullptr );
+#endif
+    for( auto i = 0u ; i < m_bxdfCnt ; ++i ){
+        if( !isBatched( i ) )
+            r += m_bxdfs[i]->F( swo , swi ) * m_bxdfs[i]->GetEvalWeight();
+    }
 
     return r;
 }
@@ -115,10 +125,14 @@ Spectrum ScatteringEvent::Sample_BSDF( const Vector& wo , Vector& wi , const cla
     pdf *= bxdf_pdf;
 
     // setup pdf
+#ifdef ENABLE_BXDF_BATCH
+    if( useBatch() )
+        m_mfBatch.Evaluate( swo , wi , &ret , &pdf , bxdf );
+#endif
     for( auto i = 0u; i < m_bxdfCnt ; ++i ){
-        if( m_bxdfs[i] != bxdf ){
-            ret += m_bxdfs[i]->F(wo,wi) * m_bxdfs[i]->GetEvalWeight();
-            pdf += m_bxdfs[i]->Pdf(wo,wi) * m_bxdfs[i]->GetSampleWeight();
+        if( m_bxdfs[i] != bxdf && !isBatched( i ) ){
+            ret += m_bxdfs[i]->F(swo,wi) * m_bxdfs[i]->GetEvalWeight();
+            pdf += m_bxdfs[i]->Pdf(swo,wi) * m_bxdfs[i]->GetSampleWeight();
         }
     }
 
@@ -133,8 +147,14 @@ float ScatteringEvent::Pdf_BSDF( const Vector& wo , const Vector& wi ) const{
     const auto lwi = worldToLocal( wi );
 
     auto pdf = 0.0f;
-    for( auto i = 0u ; i < m_bxdfCnt ; ++i )
-        pdf += m_bxdfs[i]->Pdf( lwo , lwi ) * m_bxdfs[i]->GetSampleWeight();
+#ifdef ENABLE_BXDF_BATCH
+    if( useBatch() )
+        m_mfBatch.Evaluate( lwo , lwi , nullptr , &pdf );
+#endif
+    for( auto i = 0u ; i < m_bxdfCnt ; ++i ){
+        if( !isBatched( i ) )
+            pdf += m_bxdfs[i]->Pdf( lwo , lwi ) * m_bxdfs[i]->GetSampleWeight();
+    }
     return pdf;
 }
 
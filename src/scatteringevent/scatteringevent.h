@@ -20,6 +20,7 @@
 #include "core/define.h"
 #include "math/interaction.h"
 #include "bssrdf/bssrdf.h"
+#include "bsdf/microfacet_batch.h"
 
 enum SE_Flag : unsigned int{
     SE_NONE             = 0x00,
@@ -69,6 +70,10 @@ public:
     SORT_FORCEINLINE  void    AddBxdf( const Bxdf* bxdf ){
         if( m_bxdfCnt == SE_MAX_BXDF_COUNT || IS_PTR_INVALID(bxdf) || bxdf->GetEvalWeight().IsBlack() )
             return;
+#ifdef ENABLE_BXDF_BATCH
+        if( m_mfBatch.Add( bxdf ) )
+            m_bxdfBatchedMask |= 1u << m_bxdfCnt;
+#endif
         m_bxdfs[m_bxdfCnt++] = bxdf;
         m_bxdfTotalSampleWeight += bxdf->GetSampleWeight();
     }
@@ -147,6 +152,10 @@ private:
     const Bxdf*         m_bxdfs[SE_MAX_BXDF_COUNT]      = { nullptr };     /**< All bsdfs in the scattering event. */
     unsigned            m_bxdfCnt                       = 0;               /**< Number of bxdfs in the scattering event. */
     float               m_bxdfTotalSampleWeight         = 0.0f;            /**< Total weight of BXDF. */
+#ifdef ENABLE_BXDF_BATCH
+    MicrofacetBatch     m_mfBatch;                                         /**< Microfacet reflection lobes evaluated together. */
+    unsigned            m_bxdfBatchedMask               = 0;               /**< One bit per bxdf indicating whether it is in the batch. */
+#endif
     const Bssrdf*       m_bssrdfs[SE_MAX_BSSRDF_COUNT]  = { nullptr };     /**< All bssrdfs in the scattering event. */
     unsigned            m_bssrdfCnt                     = 0;               /**< Number of bssrdfs in the scattering event. */
     float               m_bssrdfTotalSampleWeight       = 0.0f;            /**< Total weight of BSSRDF. */
@@ -169,4 +178,27 @@ private:
     //! @param v        A vector in shading coordinate.
     //! @return         The corresponding vector in world coordinate.
     SORT_FORCEINLINE Vector localToWorld( const Vector& v ) const;
+
+    //! @brief  Whether a bxdf is evaluated in the microfacet batch instead of on its own.
+    //!
+    //! @param i        Index of the bxdf.
+    //! @return         Whether the bxdf is evaluated in the batch.
+    SORT_FORCEINLINE bool isBatched( unsigned i ) const {
+#ifdef ENABLE_BXDF_BATCH
+        return useBatch() && ( ( m_bxdfBatchedMask >> i ) & 1u );
+#else
+        return false;
+#endif
+    }
+
+    //! @brief  Whether the microfacet batch is used in evaluation.
+    //!
+    //! @return         Whether the microfacet batch is used.
+    SORT_FORCEINLINE bool useBatch() const {
+#ifdef ENABLE_BXDF_BATCH
+        return m_mfBatch.GetLobeCnt() >= MF_BATCH_MIN_LOBE_CNT;
+#else
+        return false;
+#endif
+    }
 };
\ No newline at end of file
@@ -29,6 +29,11 @@ struct Line8;
 struct Ray8_Data;
 #endif
 
+#ifdef SIMD_16WAY_ENABLED
+struct Line16;
+struct Ray16_Data;
+#endif
+
 //! @brief  Line is a common type for hair or fur rendering.
 /**
  * Although being called line, this shape is essentially open cylinder. Other choose is to represent line
@@ -179,6 +184,11 @@ private:
     friend SORT_FORCEINLINE bool intersectLine_SIMD( const Ray& ray , const Ray8_Data& ray_simd , const Line8& line_simd , SurfaceInteraction* ret );
 #endif
 
+#ifdef SIMD_16WAY_ENABLED
+    friend struct Line16;
+    friend SORT_FORCEINLINE bool intersectLine_SIMD( const Ray& ray , const Ray16_Data& ray_simd , const Line16& line_simd , SurfaceInteraction* ret );
+#endif
+
 #if INTEL_EMBREE_ENABLED
 public:
     //! @brief      Construct instersection data from Embree intersection.
@@ -17,6 +17,8 @@
 
 #include "triangle.h"
 #include "entity/visual.h"
+#include "sampler/sample.h"
+#include "core/samplemethod.h"
 
 SORT_STATIC_FORCEINLINE Vector3f Permute( const Vector3f& v , int ax , int ay , int az ){
     return Vector3f( v[ax] , v[ay] , v[az] );
@@ -266,4 +268,61 @@ EmbreeGeometry* Triangle::BuildEmbreeGeometry(RTCDevice device, Embree& ebmree)
     return nullptr;
 }
 
-#endif
\ No newline at end of file
+#endif
+
+Vector Triangle::FaceNormal() const{
+    const auto& mem = m_meshVisual->m_memory;
+    const auto& mv0 = mem->m_vertices[m_index.m_id[0]];
+    const auto& mv1 = mem->m_vertices[m_index.m_id[1]];
+    const auto& mv2 = mem->m_vertices[m_index.m_id[2]];
+
+    const auto n = normalize( cross( mv2.m_position - mv0.m_position , mv1.m_position - mv0.m_position ) );
+    return dot( n , mv0.m_normal + mv1.m_normal + mv2.m_normal ) < 0.0f ? -n : n;
+}
+
+Point Triangle::Sample_l( const LightSample& ls , const Point& p , Vector& wi , Vector& n , float* pdf ) const{
+    const auto& mem = m_meshVisual->m_memory;
+    const auto& p0 = mem->m_vertices[m_index.m_id[0]].m_position;
+    const auto& p1 = mem->m_vertices[m_index.m_id[1]].m_position;
+    const auto& p2 = mem->m_vertices[m_index.m_id[2]].m_position;
+
+    // uniformly sample a point on the triangle
+    const auto su = sqrt( ls.u );
+    const auto b0 = 1.0f - su;
+    const auto b1 = ls.v * su;
+    const auto lp = b0 * p0 + b1 * p1 + ( 1.0f - b0 - b1 ) * p2;
+
+    n = FaceNormal();
+    const auto delta = lp - p;
+    wi = normalize( delta );
+
+    const auto d = dot( -wi , n );
+    if( pdf )
+        *pdf = d <= 0.0f ? 0.0f : delta.SquaredLength() / ( SurfaceArea() * d );
+
+    return lp;
+}
+
+void Triangle::Sample_l( RenderContext& rc, const LightSample& ls , Ray& r , Vector& n , float* pdf ) const{
+    const auto& mem = m_meshVisual->m_memory;
+    const auto& p0 = mem->m_vertices[m_index.m_id[0]].m_position;
+    const auto& p1 = mem->m_vertices[m_index.m_id[1]].m_position;
+    const auto& p2 = mem->m_vertices[m_index.m_id[2]].m_position;
+
+    const auto su = sqrt( ls.u );
+    const auto b0 = 1.0f - su;
+    const auto b1 = ls.v * su;
+
+    n = FaceNormal();
+    Vector t , b;
+    coordinateSystem( n , t , b );
+    const auto local_dir = UniformSampleHemisphere( sort_rand<float>(rc) , sort_rand<float>(rc) );
+
+    r.m_fMin = 0.0f;
+    r.m_fMax = FLT_MAX;
+    r.m_Ori = b0 * p0 + b1 * p1 + ( 1.0f - b0 - b1 ) * p2;
+    r.m_Dir = t * local_dir.x + n * local_dir.y + b * local_dir.z;
+
+    if( pdf )
+        *pdf = UniformHemispherePdf() / SurfaceArea();
+}
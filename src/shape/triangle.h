@@ -47,10 +47,7 @@ public:
     //! @param wi       The vector from shading point to sampled point, it is normalized.
     //! @param pdf      The pdf w.r.t solid angle ( not surface area ) of picking the sampled point.
     //! @return         The sampled point on the surface of the shape.
-    Point           Sample_l( const LightSample& ls , const Point& p , Vector& wi , Vector& n, float* pdf ) const override{
-        // to be implemented
-        return Point();
-    }
+    Point           Sample_l( const LightSample& ls , const Point& p , Vector& wi , Vector& n, float* pdf ) const override;
 
     //! @brief Sample a ray from the light source without a given shading point.
     //!
@@ -61,9 +58,7 @@ public:
     //!                 the direction of the ray will point outward depending on the normal.
     //! @param n        The normal at the surface where the ray shoots from.
     //! @param pdf      The pdf w.r.t solid angle of picking the ray.
-    void            Sample_l( RenderContext& rc, const LightSample& ls , Ray& r , Vector& n , float* pdf ) const override{
-        // to be implemented.
-    }
+    void            Sample_l( RenderContext& rc, const LightSample& ls , Ray& r , Vector& n , float* pdf ) const override;
 
     //! @brief      Get intersected point between the ray and the shape.
     //!
@@ -101,6 +96,14 @@ public:
     //! @return     Surface area of the shape.
     float           SurfaceArea() const override;
 
+    //! @brief      Get the normal of the triangle plane.
+    //!
+    //! The normal is oriented to agree with the vertex normals so that it faces the same side as the
+    //! shading normals.
+    //!
+    //! @return     The normalized face normal of the triangle.
+    Vector          FaceNormal() const;
+
     //! @brief      Get the type of the shape
     //!
     //! @return     The type of the shape.
@@ -137,4 +140,9 @@ public:
     struct Triangle8;
     friend SORT_FORCEINLINE void setupIntersection(const Triangle8& tri4, const Ray& ray, const simd_data_avx& t8, const simd_data_avx& u8, const simd_data_avx& v8, const int id, SurfaceInteraction* intersection);
 #endif
+
+#ifdef SIMD_16WAY_ENABLED
+    struct Triangle16;
+    friend SORT_FORCEINLINE void setupIntersection(const Triangle16& tri16, const Ray& ray, const simd_data_avx512& t16, const simd_data_avx512& u16, const simd_data_avx512& v16, const int id, SurfaceInteraction* intersection);
+#endif
 };
\ No newline at end of file
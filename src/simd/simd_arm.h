@@ -24,6 +24,10 @@
     static_assert( false , "No 8 lane width simd available on Arm." );
 #endif
 
+#if defined(SIMD_16WAY_IMPLEMENTATION)
+    static_assert( false , "No 16 lane width simd available on Arm." );
+#endif
+
 const static unsigned mask_true_i = 0xffffffff;
 const static float mask_true = *((float*)&( mask_true_i ));
 
@@ -95,6 +99,9 @@ SORT_STATIC_FORCEINLINE simd_data   simd_set_ps1( const float d ){
 SORT_STATIC_FORCEINLINE simd_data   simd_set_ps( const float d[] ){
     return vld1q_f32( d );
 }
+SORT_STATIC_FORCEINLINE void        simd_store_ps( float d[] , const simd_data& s ){
+    vst1q_f32( d , get_neon_data(s) );
+}
 SORT_STATIC_FORCEINLINE simd_data   simd_set_mask(const bool mask[]) {
 #define MASK_TO_INT(m)  (m?mask_true:0)
     return (float32x4_t){MASK_TO_INT(mask[0]), MASK_TO_INT(mask[1]), MASK_TO_INT(mask[2]), MASK_TO_INT(mask[3])};
@@ -23,7 +23,7 @@
 // Reference implementation is disabled by default, it is only for debugging purposes.
 // #define SIMD_BBOX_REFERENCE_IMPLEMENTATION
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
     static_assert( false , "More than one SIMD version is defined before including simd_bbox." );
 #endif
 
@@ -37,9 +37,15 @@
     #define Simd_BBox   BBox4
 #endif
 
+#if defined(SIMD_16WAY_IMPLEMENTATION)
+    #define Simd_BBox   BBox16
+#endif
+
+#include "simd_target_begin.h"
+
 //! @brief  SIMD version bounding box.
 /**
- * This is basically 4/8 bounding box in a single data structure. For best performance, they are saved in
+ * This is basically 4/8/16 bounding box in a single data structure. For best performance, they are saved in
  * structure of arrays.
  * Since this data structure is only used in limited places, only very few interfaces are implemented for
  * simplicity.
@@ -107,4 +113,7 @@ SORT_FORCEINLINE int IntersectBBox_SIMD(const Ray& ray, const Simd_Ray_Data& sim
     return ret;
 #endif
 }
+
+#include "simd_target_end.h"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "simd_dispatch.h"
+
+#if defined(SORT_X64_TARGET) && defined(SORT_IN_WINDOWS)
+#include <intrin.h>
+#endif
+
+//! @brief  CPU features relevant to the SIMD kernels in SORT.
+struct CpuFeatures {
+    bool    sse41 = false;      /**< SSE4.1, which is what the 4 lane version needs on x64. */
+    bool    avx = false;        /**< AVX, including the OS support of saving YMM registers. */
+    bool    avx512f = false;    /**< AVX512F, including the OS support of saving ZMM registers. */
+};
+
+static CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if defined(SORT_X64_TARGET)
+    #if defined(SORT_IN_WINDOWS)
+        int info[4];
+        __cpuid(info, 0);
+        const auto max_leaf = info[0];
+
+        __cpuid(info, 1);
+        features.sse41 = (info[2] >> 19) & 1;
+        const auto osxsave = (info[2] >> 27) & 1;
+
+        // the OS needs to save the extended registers during context switch, otherwise the instructions can't be used.
+        const auto xcr0 = osxsave ? _xgetbv(0) : 0ull;
+        features.avx = ((info[2] >> 28) & 1) && (xcr0 & 0x06) == 0x06;
+
+        if (max_leaf >= 7) {
+            __cpuidex(info, 7, 0);
+            features.avx512f = features.avx && ((info[1] >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+        }
+    #else
+        // the builtins check the OS support of extended registers as well
+        __builtin_cpu_init();
+        features.sse41 = __builtin_cpu_supports("sse4.1");
+        features.avx = __builtin_cpu_supports("avx");
+        features.avx512f = __builtin_cpu_supports("avx512f");
+    #endif
+#endif
+    return features;
+}
+
+bool IsSimdWidthSupported( unsigned width ){
+    static const CpuFeatures features = detectCpuFeatures();
+
+    switch (width) {
+    case 1:
+        return true;
+#if defined(SIMD_4WAY_ENABLED)
+    case 4:
+    #if defined(SORT_X64_TARGET)
+        return features.sse41;
+    #else
+        // Neon is always available on arm64
+        return true;
+    #endif
+#endif
+#if defined(SIMD_8WAY_ENABLED)
+    case 8:
+        return features.avx;
+#endif
+#if defined(SIMD_16WAY_ENABLED)
+    case 16:
+        return features.avx512f;
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+unsigned GetSimdWidth(){
+    static const unsigned width = IsSimdWidthSupported(16) ? 16 : IsSimdWidthSupported(8) ? 8 : IsSimdWidthSupported(4) ? 4 : 1;
+    return width;
+}
@@ -0,0 +1,36 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "core/define.h"
+
+//! @brief  Whether the binary has SIMD code of a specific width and the current CPU is able to run it.
+//!
+//! With runtime dispatch, SSE, AVX and AVX512 versions of the SIMD kernels are all compiled in the same binary,
+//! it is up to the caller to make sure only the supported ones are used.
+//!
+//! @param  width   Number of lanes, 1 means no SIMD at all, which is always supported.
+//! @return         Whether it is safe to use SIMD code of this width.
+bool        IsSimdWidthSupported( unsigned width );
+
+//! @brief  Get the widest SIMD width that is both compiled in the binary and supported by the current CPU.
+//!
+//! CPU features are only detected once, the result is cached afterwards.
+//!
+//! @return         16, 8, 4 or 1 if there is no SIMD support at all.
+unsigned    GetSimdWidth();
@@ -24,7 +24,7 @@
 #include <float.h>
 #include "core/define.h"
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
     static_assert( false , "More than one SIMD version is defined before including the wrapper." );
 #endif
 
@@ -99,6 +99,9 @@ SORT_STATIC_FORCEINLINE simd_data   simd_set_ps1( const float d ){
 SORT_STATIC_FORCEINLINE simd_data   simd_set_ps( const float d[] ){
     return _mm_set_ps( d[3] , d[2] , d[1] , d[0] );
 }
+SORT_STATIC_FORCEINLINE void        simd_store_ps( float d[] , const simd_data& s ){
+    _mm_storeu_ps( d , get_sse_data(s) );
+}
 SORT_STATIC_FORCEINLINE simd_data   simd_set_mask(const bool mask[]) {
 #define MASK_TO_INT(m)  (m?mask_true:0)
     return _mm_set_ps(MASK_TO_INT(mask[3]), MASK_TO_INT(mask[2]), MASK_TO_INT(mask[1]), MASK_TO_INT(mask[0]));
@@ -197,6 +200,14 @@ struct simd_data_avx {
 };
 #endif
 
+// zero tolerance in any extra size in this structure.
+static_assert(sizeof(simd_data_avx) == sizeof(__m256), "Incorrect AVX data size.");
+
+#ifdef SIMD_8WAY_IMPLEMENTATION
+
+#include "simd_target_begin.h"
+
+// The helper is only available where the instructions are enabled, other translation units may still see the data type.
 SORT_STATIC_FORCEINLINE __m256 get_avx_data( const simd_data_avx& d ){
 #ifdef SORT_IN_WINDOWS
     return d.avx_data;
@@ -205,15 +216,12 @@ SORT_STATIC_FORCEINLINE __m256 get_avx_data( const simd_data_avx& d ){
 #endif
 }
 
-// zero tolerance in any extra size in this structure.
-static_assert(sizeof(simd_data_avx) == sizeof(__m256), "Incorrect AVX data size.");
-
-#ifdef SIMD_8WAY_IMPLEMENTATION
-
-static const __m256 avx_zeros       = _mm256_set_ps(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-static const __m256 avx_infinites   = _mm256_set_ps(FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX );
-static const __m256 avx_neg_ones    = _mm256_set_ps(-1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f);
-static const __m256 avx_ones        = _mm256_set_ps(1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+// Constants are initialized statically instead of through intrinsics. Dynamic initialization happens at startup, which
+// would execute AVX instructions no matter what the CPU supports in case of runtime dispatch.
+static const __m256 avx_zeros       = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+static const __m256 avx_infinites   = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+static const __m256 avx_neg_ones    = { -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+static const __m256 avx_ones        = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 
 #define simd_data       simd_data_avx
 #define simd_ones       avx_ones
@@ -233,6 +241,9 @@ SORT_STATIC_FORCEINLINE simd_data   simd_set_ps1( const float f ){
 SORT_STATIC_FORCEINLINE simd_data   simd_set_ps( const float d[] ){
     return _mm256_set_ps( d[7] , d[6] , d[5] , d[4] , d[3] , d[2] , d[1] , d[0] );
 }
+SORT_STATIC_FORCEINLINE void        simd_store_ps( float d[] , const simd_data& s ){
+    _mm256_storeu_ps( d , get_avx_data(s) );
+}
 SORT_STATIC_FORCEINLINE simd_data   simd_set_mask(const bool mask[]) {
 #define MASK_TO_INT(m)  (m?mask_true:0.0f)
     return _mm256_set_ps( MASK_TO_INT( mask[7] ) , MASK_TO_INT( mask[6] ) , MASK_TO_INT( mask[5] ) , MASK_TO_INT( mask[4] ) , MASK_TO_INT( mask[3] ) , MASK_TO_INT( mask[2] ) , MASK_TO_INT( mask[1] ) , MASK_TO_INT( mask[0] ) );
@@ -311,6 +322,163 @@ SORT_STATIC_FORCEINLINE simd_data   simd_minreduction_ps( const simd_data& s ){
     return simd_set_ps1( reduced_data[0] < reduced_data[4] ? reduced_data[0] : reduced_data[4] );
 }
 
+#include "simd_target_end.h"
+
+#endif
+
+#endif
+
+#ifdef  SIMD_16WAY_ENABLED
+
+#include <immintrin.h>
+
+#ifndef SORT_IN_WINDOWS
+#define simd_data_avx512    __m512
+#else
+struct simd_data_avx512 {
+    union {
+        __m512  avx512_data;
+        float   float_data[16];
+    };
+
+    SORT_FORCEINLINE simd_data_avx512() {}
+    SORT_FORCEINLINE simd_data_avx512(const __m512& data) :avx512_data(data) {}
+
+    SORT_FORCEINLINE float  operator [](const int i) const {
+        return float_data[i];
+    }
+    SORT_FORCEINLINE float& operator [](const int i) {
+        return float_data[i];
+    }
+};
+#endif
+
+// zero tolerance in any extra size in this structure.
+static_assert(sizeof(simd_data_avx512) == sizeof(__m512), "Incorrect AVX512 data size.");
+
+#ifdef SIMD_16WAY_IMPLEMENTATION
+
+#include "simd_target_begin.h"
+
+SORT_STATIC_FORCEINLINE __m512 get_avx512_data( const simd_data_avx512& d ){
+#ifdef SORT_IN_WINDOWS
+    return d.avx512_data;
+#else
+    return d;
+#endif
+}
+
+// Like the AVX constants, they are initialized statically so that nothing runs at startup.
+#define AVX512_CONSTANT(x)  { x, x, x, x, x, x, x, x, x, x, x, x, x, x, x, x }
+static const __m512 avx512_zeros     = AVX512_CONSTANT(0.0f);
+static const __m512 avx512_infinites = AVX512_CONSTANT(FLT_MAX);
+static const __m512 avx512_neg_ones  = AVX512_CONSTANT(-1.0f);
+static const __m512 avx512_ones      = AVX512_CONSTANT(1.0f);
+#undef AVX512_CONSTANT
+
+#define simd_data       simd_data_avx512
+#define simd_ones       avx512_ones
+#define simd_zeros      avx512_zeros
+#define simd_neg_ones   avx512_neg_ones
+#define simd_infinites  avx512_infinites
+
+#define SIMD_CHANNEL    16
+#define SIMD_ALIGNMENT  64
+
+// AVX512F comparisons produce bit masks instead of vector masks. To keep the same interface as the SSE/AVX version,
+// where masks are full vectors that can be combined with bitwise operations, bit masks are expanded to vectors here.
+// Only AVX512F instructions are used so that it works on every CPU supporting AVX512.
+SORT_STATIC_FORCEINLINE simd_data   avx512_expand_mask( const __mmask16 m ){
+    return _mm512_castsi512_ps( _mm512_maskz_set1_epi32( m , -1 ) );
+}
+SORT_STATIC_FORCEINLINE __mmask16   avx512_compress_mask( const simd_data& mask ){
+    return _mm512_cmplt_epi32_mask( _mm512_castps_si512( get_avx512_data(mask) ) , _mm512_setzero_si512() );
+}
+
+SORT_STATIC_FORCEINLINE simd_data   simd_zero(){
+    return _mm512_setzero_ps();
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_set_ps1( const float f ){
+    return _mm512_set1_ps( f );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_set_ps( const float d[] ){
+    return _mm512_loadu_ps( d );
+}
+SORT_STATIC_FORCEINLINE void        simd_store_ps( float d[] , const simd_data& s ){
+    _mm512_storeu_ps( d , get_avx512_data(s) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_set_mask(const bool mask[]) {
+    unsigned m = 0;
+    for( auto i = 0 ; i < SIMD_CHANNEL ; ++i )
+        m |= mask[i] ? ( 1u << i ) : 0u;
+    return avx512_expand_mask( (__mmask16)m );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_add_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_add_ps( get_avx512_data(s0) , get_avx512_data(s1) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_sub_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_sub_ps( get_avx512_data(s0) , get_avx512_data(s1) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_mul_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_mul_ps( get_avx512_data(s0) , get_avx512_data(s1) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_div_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_div_ps( get_avx512_data(s0) , get_avx512_data(s1) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_sqr_ps( const simd_data& m ){
+    return _mm512_mul_ps( get_avx512_data(m) , get_avx512_data(m) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_sqrt_ps( const simd_data& m ){
+    return _mm512_sqrt_ps( get_avx512_data(m) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_rcp_ps( const simd_data& m ){
+    return _mm512_div_ps( avx512_ones , get_avx512_data(m) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_mad_ps( const simd_data& a , const simd_data& b , const simd_data& c ){
+    return _mm512_add_ps( _mm512_mul_ps( get_avx512_data(a) , get_avx512_data(b) ) , get_avx512_data(c) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_pick_ps( const simd_data& mask , const simd_data& a , const simd_data& b ){
+    return _mm512_mask_blend_ps( avx512_compress_mask(mask) , get_avx512_data(b) , get_avx512_data(a) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_cmpeq_ps( const simd_data& s0 , const simd_data& s1 ){
+    return avx512_expand_mask( _mm512_cmp_ps_mask( get_avx512_data(s0) , get_avx512_data(s1) , _CMP_EQ_OQ ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_cmpneq_ps( const simd_data& s0 , const simd_data& s1 ){
+    return avx512_expand_mask( _mm512_cmp_ps_mask( get_avx512_data(s0) , get_avx512_data(s1) , _CMP_NEQ_OQ ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_cmple_ps( const simd_data& s0 , const simd_data& s1 ){
+    return avx512_expand_mask( _mm512_cmp_ps_mask( get_avx512_data(s0) , get_avx512_data(s1) , _CMP_LE_OQ ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_cmplt_ps( const simd_data& s0 , const simd_data& s1 ){
+    return avx512_expand_mask( _mm512_cmp_ps_mask( get_avx512_data(s0) , get_avx512_data(s1) , _CMP_LT_OQ ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_cmpge_ps( const simd_data& s0 , const simd_data& s1 ){
+    return avx512_expand_mask( _mm512_cmp_ps_mask( get_avx512_data(s0) , get_avx512_data(s1) , _CMP_GE_OQ ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_cmpgt_ps( const simd_data& s0 , const simd_data& s1 ){
+    return avx512_expand_mask( _mm512_cmp_ps_mask( get_avx512_data(s0) , get_avx512_data(s1) , _CMP_GT_OQ ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_and_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_castsi512_ps( _mm512_and_si512( _mm512_castps_si512( get_avx512_data(s0) ) , _mm512_castps_si512( get_avx512_data(s1) ) ) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_or_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_castsi512_ps( _mm512_or_si512( _mm512_castps_si512( get_avx512_data(s0) ) , _mm512_castps_si512( get_avx512_data(s1) ) ) );
+}
+SORT_STATIC_FORCEINLINE int         simd_movemask_ps( const simd_data& mask ){
+    return (int)avx512_compress_mask( mask );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_min_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_min_ps( get_avx512_data(s0) , get_avx512_data(s1) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_max_ps( const simd_data& s0 , const simd_data& s1 ){
+    return _mm512_max_ps( get_avx512_data(s0) , get_avx512_data(s1) );
+}
+SORT_STATIC_FORCEINLINE simd_data   simd_minreduction_ps( const simd_data& s ){
+    return _mm512_set1_ps( _mm512_reduce_min_ps( get_avx512_data(s) ) );
+}
+
+#include "simd_target_end.h"
+
 #endif
 
 #endif
@@ -25,7 +25,7 @@
 // Reference implementation is disabled by default, it is only for debugging purposes.
 // #define SIMD_LINE_REFERENCE_IMPLEMENTATION
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
     static_assert( false , "More than one SIMD version is defined before including simd_line.h." );
 #endif
 
@@ -39,6 +39,12 @@
     #define Simd_Line   Line8
 #endif
 
+#ifdef SIMD_16WAY_IMPLEMENTATION
+    #define Simd_Line   Line16
+#endif
+
+#include "simd_target_begin.h"
+
 //! @brief  Like Triangle8, Line8 is the corresponding version for line shape.
 struct alignas(SIMD_ALIGNMENT) Simd_Line{
     simd_data  m_p0_x , m_p0_y , m_p0_z;   /**< Point at the end of the line. */
@@ -122,6 +128,20 @@ struct alignas(SIMD_ALIGNMENT) Simd_Line{
         m_ori_line[7] = line;
         return true;
 #endif
+
+#ifdef SIMD_16WAY_IMPLEMENTATION
+        const Line* line = dynamic_cast<const Line*>(primitive->GetShape());
+        for( auto i = 0 ; i < SIMD_CHANNEL - 1 ; ++i ){
+            if(IS_PTR_INVALID(m_ori_pri[i])){
+                m_ori_pri[i] = primitive;
+                m_ori_line[i] = line;
+                return false;
+            }
+        }
+        m_ori_pri[SIMD_CHANNEL - 1] = primitive;
+        m_ori_line[SIMD_CHANNEL - 1] = line;
+        return true;
+#endif
     }
 
     //! @brief  Pack line information into SIMD compatible data.
@@ -213,6 +233,13 @@ struct alignas(SIMD_ALIGNMENT) Simd_Line{
         m_ori_pri[0] = m_ori_pri[1] = m_ori_pri[2] = m_ori_pri[3] = m_ori_pri[4] = m_ori_pri[5] = m_ori_pri[6] = m_ori_pri[7] = nullptr;
         m_ori_line[0] = m_ori_line[1] = m_ori_line[2] = m_ori_line[3] = m_ori_line[4] = m_ori_line[5] = m_ori_line[6] = m_ori_line[7] = nullptr;
 #endif
+
+#ifdef SIMD_16WAY_IMPLEMENTATION
+        for( auto i = 0 ; i < SIMD_CHANNEL ; ++i ){
+            m_ori_pri[i] = nullptr;
+            m_ori_line[i] = nullptr;
+        }
+#endif
     }
 };
 
@@ -364,4 +391,6 @@ SORT_FORCEINLINE bool intersectLineFast_SIMD( const Ray& ray , const Simd_Ray_Da
 #endif
 }
 
-#endif // SIMD_4WAY_IMPLEMENTATION || SIMD_8WAY_IMPLEMENTATION
+#include "simd_target_end.h"
+
+#endif // SIMD_4WAY_IMPLEMENTATION || SIMD_8WAY_IMPLEMENTATION || SIMD_16WAY_IMPLEMENTATION
@@ -21,11 +21,11 @@
 #include "simd_wrapper.h"
 #include "math/ray.h"
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
     static_assert( false , "More than one SIMD version is defined before including simd_bbox." );
 #endif
 
-#if defined(SIMD_4WAY_ENABLED) || defined(SIMD_8WAY_ENABLED)
+#if defined(SIMD_4WAY_ENABLED) || defined(SIMD_8WAY_ENABLED) || defined(SIMD_16WAY_ENABLED)
 #ifdef SIMD_BVH_IMPLEMENTATION
 
 #ifdef SIMD_4WAY_IMPLEMENTATION
@@ -34,6 +34,11 @@
 #ifdef SIMD_8WAY_IMPLEMENTATION
     #define Simd_Ray_Data   Ray8_Data
 #endif
+#ifdef SIMD_16WAY_IMPLEMENTATION
+    #define Simd_Ray_Data   Ray16_Data
+#endif
+
+#include "simd_target_begin.h"
 
 SORT_STATIC_FORCEINLINE float sign( const float x ){
     return x < 0.0f ? -1.0f : 1.0f;
@@ -57,7 +62,7 @@ struct alignas(SIMD_ALIGNMENT) Simd_Ray_Data{
     simd_data  scale_z;      /**< Scaling along each axis in local coordinate. */
 };
 
-void resolveRayData( const Ray& ray , Simd_Ray_Data& simd_ray_data ){
+SORT_STATIC_FORCEINLINE void resolveRayData( const Ray& ray , Simd_Ray_Data& simd_ray_data ){
     constexpr float delta = 0.00001f;
     const auto dir_x = fabs(ray.m_Dir[0]) < delta ? sign(ray.m_Dir[0]) * delta : ray.m_Dir[0];
     const auto dir_y = fabs(ray.m_Dir[1]) < delta ? sign(ray.m_Dir[1]) * delta : ray.m_Dir[1];
@@ -127,6 +132,9 @@ SORT_STATIC_FORCEINLINE simd_data   ray_scale_y( const Simd_Ray_Data& ray ){
 SORT_STATIC_FORCEINLINE simd_data   ray_scale_z( const Simd_Ray_Data& ray ){
     return ray.scale_z;
 }
+
+#include "simd_target_end.h"
+
 #endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+// There is no include guard on purpose, this is included right before code with SIMD instructions wider than the
+// baseline, and 'simd_target_end.h' has to be included after it.
+//
+// With runtime dispatch, the baseline of the whole binary stays at SSE, only functions defined between the two are
+// allowed to use AVX or AVX512 instructions. This is done through target attributes instead of compiling whole
+// translation units with extra flags, otherwise inline functions shared with other translation units, which the
+// linker only keeps one copy of, could be compiled with instructions the CPU doesn't support. Headers with such
+// shared functions must not be included in between.
+//
+// MSVC allows any intrinsic without extra flags and it doesn't generate wider instructions by itself, nothing needs
+// to be done there.
+
+#if defined(SORT_SIMD_RUNTIME_DISPATCH) && !defined(SORT_IN_WINDOWS)
+    #if defined(SIMD_16WAY_IMPLEMENTATION)
+        #if defined(__clang__)
+            #pragma clang attribute push(__attribute__((target("avx,avx512f"))), apply_to = function)
+        #else
+            #pragma GCC push_options
+            #pragma GCC target("avx,avx512f")
+        #endif
+    #elif defined(SIMD_8WAY_IMPLEMENTATION)
+        #if defined(__clang__)
+            #pragma clang attribute push(__attribute__((target("avx"))), apply_to = function)
+        #else
+            #pragma GCC push_options
+            #pragma GCC target("avx")
+        #endif
+    #endif
+#endif
@@ -31,7 +31,7 @@
 // Reference implementation is disabled by default, it is only for debugging purposes.
 // #define SIMD_TRI_REFERENCE_IMPLEMENTATION
 
-#if defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION)
+#if ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_8WAY_IMPLEMENTATION) ) || ( defined(SIMD_4WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) ) || ( defined(SIMD_8WAY_IMPLEMENTATION) && defined(SIMD_16WAY_IMPLEMENTATION) )
     static_assert( false , "More than one SIMD version is defined before including simd_triangle.h." );
 #endif
 
@@ -45,6 +45,12 @@
     #define Simd_Triangle       Triangle8
 #endif
 
+#ifdef SIMD_16WAY_IMPLEMENTATION
+    #define Simd_Triangle       Triangle16
+#endif
+
+#include "simd_target_begin.h"
+
 //! @brief  Simd_Triangle is more of a simplified resolved data structure holds only bare bone information of triangle.
 /**
  * Simd_Triangle is used in OBVH/QBVH to accelerate ray triangle intersection using AVX/SSE. Its sole purpose is to accelerate 
@@ -127,6 +133,20 @@ struct alignas(SIMD_ALIGNMENT) Simd_Triangle{
         m_ori_tri[7] = triangle;
         return true;
 #endif
+
+#ifdef SIMD_16WAY_IMPLEMENTATION
+        const Triangle* triangle = dynamic_cast<const Triangle*>(primitive->GetShape());
+        for( auto i = 0 ; i < SIMD_CHANNEL - 1 ; ++i ){
+            if(IS_PTR_INVALID(m_ori_pri[i])){
+                m_ori_pri[i] = primitive;
+                m_ori_tri[i] = triangle;
+                return false;
+            }
+        }
+        m_ori_pri[SIMD_CHANNEL - 1] = primitive;
+        m_ori_tri[SIMD_CHANNEL - 1] = triangle;
+        return true;
+#endif
     }
 
     //! @brief  Pack triangle information into SSE/AVX compatible data.
@@ -195,10 +215,17 @@ struct alignas(SIMD_ALIGNMENT) Simd_Triangle{
         m_ori_pri[0] = m_ori_pri[1] = m_ori_pri[2] = m_ori_pri[3] = m_ori_pri[4] = m_ori_pri[5] = m_ori_pri[6] = m_ori_pri[7] = nullptr;
         m_ori_tri[0] = m_ori_tri[1] = m_ori_tri[2] = m_ori_tri[3] = m_ori_tri[4] = m_ori_tri[5] = m_ori_tri[6] = m_ori_tri[7] = nullptr;
 #endif
+
+#ifdef SIMD_16WAY_IMPLEMENTATION
+        for( auto i = 0 ; i < SIMD_CHANNEL ; ++i ){
+            m_ori_pri[i] = nullptr;
+            m_ori_tri[i] = nullptr;
+        }
+#endif
     }
 };
 
-static_assert( sizeof( Simd_Triangle ) % SIMD_ALIGNMENT == 0 , "Incorrect size of Triangle8." );
+static_assert( sizeof( Simd_Triangle ) % SIMD_ALIGNMENT == 0 , "Incorrect size of Simd_Triangle." );
 
 //! @brief  Core algorithm of ray triangle intersection.
 //!
@@ -303,16 +330,14 @@ SORT_FORCEINLINE bool intersectTriangleInner_SIMD(const Ray& ray, const Simd_Ray
 //!
 //! @param  tri_simd      The triangle data structure that has 4/8 triangles.
 //! @param  ray           Ray that we used to tested.
-//! @param  t_simd        Output, the distances from ray origin to triangles. It will be FLT_MAX if there is no intersection.
-//! @param  u_simd        Blending factor.
-//! @param  v_simd        Blending factor.
+//! @param  res_t         The distance from ray origin to the triangle of interest.
+//! @param  u             Blending factor.
+//! @param  v             Blending factor.
 //! @param  id            Index of the intersection of our interest.
 //! @param  intersection  The pointer to the result to be filled. It can't be nullptr.
-SORT_FORCEINLINE void setupIntersection(const Simd_Triangle& tri_simd, const Ray& ray, const simd_data& t_simd, const simd_data& u_simd, const simd_data& v_simd, const int id, SurfaceInteraction* intersection) {
+SORT_FORCEINLINE void setupIntersection(const Simd_Triangle& tri_simd, const Ray& ray, const float res_t, const float u, const float v, const int id, SurfaceInteraction* intersection) {
     const auto* triangle = tri_simd.m_ori_tri[id];
 
-    const auto u = u_simd[id];
-    const auto v = v_simd[id];
     const auto w = 1 - u - v;
 
     const auto& mem = triangle->m_meshVisual->m_memory;
@@ -324,7 +349,6 @@ SORT_FORCEINLINE void setupIntersection(const Simd_Triangle& tri_simd, const Ray
     const auto& mv1 = mem->m_vertices[id1];
     const auto& mv2 = mem->m_vertices[id2];
 
-    const auto res_t = t_simd[id];
     intersection->intersect = ray(res_t);
     intersection->t = res_t;
 
@@ -340,6 +364,19 @@ SORT_FORCEINLINE void setupIntersection(const Simd_Triangle& tri_simd, const Ray
     intersection->primitive = tri_simd.m_ori_pri[id];
 }
 
+//! @brief  A helper function setup the result of intersection.
+//!
+//! @param  tri_simd      The triangle data structure that has 4/8 triangles.
+//! @param  ray           Ray that we used to tested.
+//! @param  t_simd        Output, the distances from ray origin to triangles. It will be FLT_MAX if there is no intersection.
+//! @param  u_simd        Blending factor.
+//! @param  v_simd        Blending factor.
+//! @param  id            Index of the intersection of our interest.
+//! @param  intersection  The pointer to the result to be filled. It can't be nullptr.
+SORT_FORCEINLINE void setupIntersection(const Simd_Triangle& tri_simd, const Ray& ray, const simd_data& t_simd, const simd_data& u_simd, const simd_data& v_simd, const int id, SurfaceInteraction* intersection) {
+    setupIntersection(tri_simd, ray, t_simd[id], u_simd[id], v_simd[id], id, intersection);
+}
+
 //! @brief  With the power of SSE/AVX, this utility function helps intersect a ray with four/eight triangles at the cost of one.
 //!
 //! @param  ray         Ray to be tested against.
@@ -403,28 +440,81 @@ SORT_FORCEINLINE bool intersectTriangleFast_SIMD(const Ray& ray, const Simd_Ray_
 #endif
 }
 
-//! @brief  Unlike the above function, this helper function will populate all results in the BSSRDFIntersection data structure.
-//!         It is for BSSRDF intersection tests.
+//! @brief  A light weight record of a BSSRDF hit candidate.
+//!
+//! Only the final hits need a fully setup intersection, candidates replaced by closer hits during traversal never do.
+struct Simd_Sss_Hit {
+    float                   t = FLT_MAX;            /**< Distance from the ray origin to the hit. */
+    float                   u = 0.0f;               /**< Barycentric coordinate of the hit. */
+    float                   v = 0.0f;               /**< Barycentric coordinate of the hit. */
+    const Simd_Triangle*    tri = nullptr;          /**< The triangle group that is hit. */
+    int                     lane = 0;               /**< Index of the triangle in the group. */
+#ifdef SIMD_TRI_REFERENCE_IMPLEMENTATION
+    SurfaceInteraction      intersection;           /**< The reference implementation has no barycentric coordinate exposed. */
+#endif
+};
+
+//! @brief  The nearest BSSRDF hits of a ray, sorted by distance.
+struct Simd_Sss_Hits {
+    Simd_Sss_Hit    hits[TOTAL_SSS_INTERSECTION_CNT];   /**< Hits sorted from the nearest to the farthest. */
+    unsigned        cnt = 0;                            /**< Number of hits. */
+    float           maxt = FLT_MAX;                     /**< Anything further than this won't make it into the buffer. */
+
+    //! @brief  Insert a hit into the buffer, the farthest one is dropped if the buffer is full.
+    //!
+    //! @param  hit     The hit to be inserted.
+    SORT_FORCEINLINE void Insert(const Simd_Sss_Hit& hit) {
+        if (hit.t >= maxt)
+            return;
+
+        auto i = cnt < TOTAL_SSS_INTERSECTION_CNT ? cnt++ : TOTAL_SSS_INTERSECTION_CNT - 1;
+        for (; i > 0 && hits[i - 1].t > hit.t; --i)
+            hits[i] = hits[i - 1];
+        hits[i] = hit;
+
+        if (cnt == TOTAL_SSS_INTERSECTION_CNT)
+            maxt = hits[TOTAL_SSS_INTERSECTION_CNT - 1].t;
+    }
+
+    //! @brief  Populate the hits into BSSRDFIntersections, this is when the intersections are actually setup.
+    //!
+    //! @param  ray             The ray that hits the triangles.
+    //! @param  intersections   The intersections to be populated.
+    SORT_FORCEINLINE void Resolve(const Ray& ray, BSSRDFIntersections& intersections, RenderContext& rc) const {
+        intersections.cnt = cnt;
+        for (auto i = 0u; i < cnt; ++i) {
+            intersections.intersections[i] = SORT_MALLOC(rc.m_memory_arena, BSSRDFIntersection)();
+#ifndef SIMD_TRI_REFERENCE_IMPLEMENTATION
+            setupIntersection(*hits[i].tri, ray, hits[i].t, hits[i].u, hits[i].v, hits[i].lane, &intersections.intersections[i]->intersection);
+#else
+            intersections.intersections[i]->intersection = hits[i].intersection;
+#endif
+        }
+        intersections.maxt = maxt;
+    }
+};
+
+//! @brief  Unlike the above function, this helper function collects all hits with the same material for BSSRDF intersection tests.
 //!
 //! @param  ray         Ray to be tested against.
+//! @param  ray_simd    Resolved simd ray data.
 //! @param  tri_simd    Data structure holds four/eight triangles.
-//! @param  ret         The result of intersection.
-SORT_FORCEINLINE void intersectTriangleMulti_SIMD(const Ray& ray, const Simd_Ray_Data& ray_simd, const Simd_Triangle& tri_simd, const StringID matID , RenderContext& rc, BSSRDFIntersections& intersections) {
+//! @param  matID       Only triangles with this material are of interest.
+//! @param  hits        The nearest hits found so far.
+SORT_FORCEINLINE void intersectTriangleMulti_SIMD(const Ray& ray, const Simd_Ray_Data& ray_simd, const Simd_Triangle& tri_simd, const StringID matID, Simd_Sss_Hits& hits) {
 #ifndef SIMD_TRI_REFERENCE_IMPLEMENTATION
     simd_data   u_simd, v_simd, t_simd, mask;
     const auto intersected = intersectTriangleInner_SIMD<false>(ray, ray_simd, tri_simd, t_simd, u_simd, v_simd, mask);
     if (!intersected)
         return;
 
-    mask = simd_and_ps(mask, simd_cmplt_ps(t_simd, simd_set_ps1(intersections.maxt)));
+    mask = simd_and_ps(mask, simd_cmplt_ps(t_simd, simd_set_ps1(hits.maxt)));
     auto resolved_mask = simd_movemask_ps(mask);
     if (0 == resolved_mask)
         return;
 
     sAssert(resolved_mask > 0 && resolved_mask < pow(2,SIMD_CHANNEL), SPATIAL_ACCELERATOR);
 
-    // A better approach would be to sort the intersection before populating it into the results to avoid some unnecessary setup.
-    // However, the overhead to sort the result may out-weight the gain we expect.
     while (resolved_mask) {
         const auto res_i = __bsf(resolved_mask);
         resolved_mask = resolved_mask & (resolved_mask - 1);
@@ -433,55 +523,31 @@ SORT_FORCEINLINE void intersectTriangleMulti_SIMD(const Ray& ray, const Simd_Ray
         if (matID != primitive->GetMaterial()->GetUniqueID())
             continue;
 
-        if (intersections.cnt < TOTAL_SSS_INTERSECTION_CNT) {
-            intersections.intersections[intersections.cnt] = SORT_MALLOC(rc.m_memory_arena, BSSRDFIntersection)();
-            setupIntersection(tri_simd, ray, t_simd, u_simd, v_simd, res_i, &intersections.intersections[intersections.cnt++]->intersection);
-        } else {
-            auto picked_i = -1;
-            auto t = 0.0f;
-            for (auto i = 0; i < TOTAL_SSS_INTERSECTION_CNT; ++i) {
-                if (t < intersections.intersections[i]->intersection.t) {
-                    t = intersections.intersections[i]->intersection.t;
-                    picked_i = i;
-                }
-            }
-            if( picked_i >= 0 )
-                setupIntersection(tri_simd, ray, t_simd, u_simd, v_simd, res_i, &intersections.intersections[picked_i]->intersection);
-
-            intersections.ResolveMaxDepth();
-        }
+        Simd_Sss_Hit hit;
+        hit.t = t_simd[res_i];
+        hit.u = u_simd[res_i];
+        hit.v = v_simd[res_i];
+        hit.tri = &tri_simd;
+        hit.lane = res_i;
+        hits.Insert(hit);
     }
 #else
-    SurfaceInteraction intersection;
     for( auto i = 0u ; i < SIMD_CHANNEL && IS_PTR_VALID(tri_simd.m_ori_pri[i]) ; ++i ){
         const auto* primitive = tri_simd.m_ori_pri[i];
         if (matID != primitive->GetMaterial()->GetUniqueID())
             continue;
 
-        intersection.Reset();
-        const auto intersected = primitive->GetIntersect(ray, &intersection);
-        if (intersected) {
-            if (intersections.cnt < TOTAL_SSS_INTERSECTION_CNT) {
-                intersections.intersections[intersections.cnt] = SORT_MALLOC(rc.m_memory_arena, BSSRDFIntersection)();
-                intersections.intersections[intersections.cnt++]->intersection = intersection;
-            }
-            else {
-                auto picked_i = -1;
-                auto t = 0.0f;
-                for (auto i = 0; i < TOTAL_SSS_INTERSECTION_CNT; ++i) {
-                    if (t < intersections.intersections[i]->intersection.t) {
-                        t = intersections.intersections[i]->intersection.t;
-                        picked_i = i;
-                    }
-                }
-                if (picked_i >= 0)
-                    intersections.intersections[picked_i]->intersection = intersection;
-
-                intersections.ResolveMaxDepth();
-            }
+        Simd_Sss_Hit hit;
+        if (primitive->GetIntersect(ray, &hit.intersection) && hit.intersection.t < hits.maxt) {
+            hit.t = hit.intersection.t;
+            hit.tri = &tri_simd;
+            hit.lane = i;
+            hits.Insert(hit);
         }
     }
 #endif
 }
 
-#endif // SIMD_4WAY_IMPLEMENTATION || SIMD_8WAY_IMPLEMENTATION
\ No newline at end of file
+#include "simd_target_end.h"
+
+#endif // SIMD_4WAY_IMPLEMENTATION || SIMD_8WAY_IMPLEMENTATION || SIMD_16WAY_IMPLEMENTATION
\ No newline at end of file
@@ -25,6 +25,9 @@
     #ifdef SIMD_8WAY_IMPLEMENTATION
         #undef SIMD_8WAY_IMPLEMENTATION
     #endif
+    #ifdef SIMD_16WAY_IMPLEMENTATION
+        #undef SIMD_16WAY_IMPLEMENTATION
+    #endif
 
     #include "simd_arm.h"
 #endif
\ No newline at end of file
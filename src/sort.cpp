@@ -19,7 +19,10 @@
 #include "sort.h"
 #include "work/image_evaluation/image_evaluation.h"
 #include "work/unit_tests/unit_tests.h"
+#include "work/benchmark/benchmark.h"
+#include "work/benchmark/render_benchmark.h"
 #include "core/parse_args.h"
+#include "core/live_stats.h"
 
 int RunSORT(int argc, char** argv) {
     // Parse command line arguments.
@@ -27,7 +30,11 @@ int RunSORT(int argc, char** argv) {
 
     bool profiling_enabled = false;
     bool unit_test_mode = false;
+    bool benchmark_mode = false;
+    bool render_benchmark_mode = false;
     bool valid_args = false;
+    unsigned live_stats_interval = 0;
+    std::string live_stats_file = "sort_live_stats.jsonl";
 
     for (auto& arg : args) {
         const auto& key_str = arg.first;
@@ -40,9 +47,24 @@ int RunSORT(int argc, char** argv) {
             unit_test_mode = true;
             valid_args = true;
         }
+        else if (key_str == "benchmark") {
+            benchmark_mode = true;
+            valid_args = true;
+        }
+        else if (key_str == "renderbenchmark") {
+            render_benchmark_mode = true;
+            valid_args = true;
+        }
         else if (key_str == "profiling") {
             profiling_enabled = value_str == "on";
         }
+        else if (key_str == "livestats") {
+            const auto interval = atoi(value_str.c_str());
+            live_stats_interval = interval > 0 ? (unsigned)interval : 1000;
+        }
+        else if (key_str == "livestatsfile") {
+            live_stats_file = value_str;
+        }
     }
 
     // Disable profiling if necessary
@@ -54,7 +76,24 @@ int RunSORT(int argc, char** argv) {
         slog(INFO, GENERAL, "  --input:<filename>   Specify the sort input file.");
         slog(INFO, GENERAL, "  --blendermode        SORT is triggered from Blender.");
         slog(INFO, GENERAL, "  --unittest           Run unit tests.");
+        slog(INFO, GENERAL, "  --benchmark[:<name>] Run benchmarks, only the ones with <name> in their names if specified.");
+        slog(INFO, GENERAL, "  --benchmarkrep:<n>   Number of repetitions of each benchmark, 7 by default.");
+        slog(INFO, GENERAL, "  --benchmarktime:<ms> Minimum time of each repetition, 50 ms by default.");
+        slog(INFO, GENERAL, "  --benchmarkdetail:<f> Complexity of the procedural scenes to benchmark, 1.0 by default.");
+        slog(INFO, GENERAL, "  --benchmarkfile:<f>  Save benchmark results to a file as JSON lines.");
+        slog(INFO, GENERAL, "  --renderbenchmark[:<name>] Render procedural scenes with all integrators and spatial structures.");
+        slog(INFO, GENERAL, "  --benchmarkref:<dir> Folder of reference images of render benchmarks, benchmark_ref by default.");
+        slog(INFO, GENERAL, "  --benchmarkupdateref Overwrite reference images of render benchmarks.");
+        slog(INFO, GENERAL, "  --benchmarkspp:<n>   Sample per pixel of render benchmarks, 4 by default.");
+        slog(INFO, GENERAL, "  --benchmarksize:<n>  Image size of render benchmarks, 128 by default.");
+        slog(INFO, GENERAL, "  --benchmarkthreads:<n> Number of threads of render benchmarks, all cores by default.");
         slog(INFO, GENERAL, "  --nomaterial         Disable materials in SORT.");
+        slog(INFO, GENERAL, "  --numa               Pin threads to NUMA nodes and keep memory close to them.");
+        slog(INFO, GENERAL, "  --tileheatmap        Save the rendering cost of each tile as an extra image.");
+        slog(INFO, GENERAL, "  --adaptivetiles      Split expensive tiles on the fly to cut the tail of rendering.");
+        slog(INFO, GENERAL, "  --keepaccelerator    Keep the BVH width of the scene instead of upgrading to the widest the CPU supports.");
+        slog(INFO, GENERAL, "  --livestats:<ms>     Publish throughput of rendering periodically, every second by default.");
+        slog(INFO, GENERAL, "  --livestatsfile:<f>  File to publish live stats to, sort_live_stats.jsonl by default.");
         slog(INFO, GENERAL, "  --profiling:<on|off> Toggling profiling option, false by default.");
         return -1;
     }
@@ -68,19 +107,30 @@ int RunSORT(int argc, char** argv) {
         slog(INFO, GENERAL, "Profiling system is %s.", SORT_PROFILE_ISENABLED ? "enabled" : "disabled");
     }
 
-    // Run in unit test mode if required.
+    // Run in unit test or benchmark mode if required.
     std::unique_ptr<Work> work;
     if (unit_test_mode)
         work = std::make_unique<UnitTests>();
+    else if (benchmark_mode)
+        work = std::make_unique<Benchmark>();
+    else if (render_benchmark_mode)
+        work = std::make_unique<RenderBenchmark>();
     else
         work = std::make_unique<ImageEvaluation>();
+
+    const auto render_mode = !unit_test_mode && !benchmark_mode && !render_benchmark_mode;
+    if (live_stats_interval > 0 && render_mode)
+        StartLiveStatsSampler(live_stats_interval, live_stats_file);
+
     work->StartRunning(argc, argv);
     auto ret = work->WaitForWorkToBeDone();
 
+    StopLiveStatsSampler();
+
     // Flush main thread data
     SortStatsFlushData(true);
     // Output stats data
-    if (ret == 0 && !unit_test_mode)
+    if (ret == 0 && render_mode)
         SortStatsPrintData();
     
     return ret;
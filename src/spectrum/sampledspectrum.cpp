@@ -0,0 +1,140 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include "sampledspectrum.h"
+
+const SampledSpectrum SampledSpectrum::m_White(1.0f);
+
+// Number of entries in the RGB upsampling basis, one every 10 nanometers from SPECTRUM_LAMBDA_MIN to SPECTRUM_LAMBDA_MAX.
+static constexpr int    BASIS_CNT = 48;
+static constexpr float  BASIS_STEP = ( SPECTRUM_LAMBDA_MAX - SPECTRUM_LAMBDA_MIN ) / ( BASIS_CNT - 1 );
+
+// RGB upsampling basis spectra, a spectrum is upsampled as r * red + g * green + b * blue.
+// Similar with 'Spectral Primary Decomposition for Rendering with sRGB Reflectance', Mallett and Yuksel 2019, the basis
+// spectra are the smoothest ones that
+//  - are never negative and sum up to one at each wavelength, upsampled colors inside [0, 1] are always valid reflectance
+//    and white is upsampled to a constant spectrum.
+//  - are converted back to the exact sRGB primaries, with linear interpolation and the color matching functions below,
+//    under equal energy illuminant. The round trip error of the table is below 1e-5.
+static const float g_basis[3][BASIS_CNT] = {
+    {
+    0.06682f, 0.08612f, 0.10520f, 0.12284f, 0.13509f, 0.13329f, 0.10816f, 0.06633f,
+    0.02395f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,
+        0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f, 0.16693f, 0.56821f,
+    0.90967f, 1.00000f, 1.00000f, 1.00000f, 1.00000f, 1.00000f, 1.00000f, 1.00000f,
+    1.00000f, 0.99929f, 0.99222f, 0.98027f, 0.96579f, 0.95029f, 0.93450f, 0.91873f,
+    0.90305f, 0.88749f, 0.87203f, 0.85663f, 0.84129f, 0.82598f, 0.81069f, 0.79540f
+    },
+    {
+    0.07728f, 0.05913f, 0.04109f, 0.02371f, 0.00878f,     0.0f,     0.0f,     0.0f,
+        0.0f,     0.0f, 0.03168f, 0.13307f, 0.29874f, 0.50097f, 0.70208f, 0.86544f,
+    0.96568f, 1.00000f, 1.00000f, 1.00000f, 1.00000f, 0.96409f, 0.77490f, 0.41425f,
+    0.09033f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,
+        0.0f, 0.00071f, 0.00523f, 0.01241f, 0.02093f, 0.02995f, 0.03908f, 0.04819f,
+    0.05722f, 0.06617f, 0.07506f, 0.08390f, 0.09271f, 0.10149f, 0.11027f, 0.11904f
+    },
+    {
+    0.85590f, 0.85475f, 0.85371f, 0.85345f, 0.85613f, 0.86671f, 0.89184f, 0.93367f,
+    0.97605f, 1.00000f, 0.96832f, 0.86693f, 0.70126f, 0.49903f, 0.29792f, 0.13456f,
+    0.03432f,     0.0f,     0.0f,     0.0f,     0.0f, 0.03591f, 0.05817f, 0.01754f,
+        0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,     0.0f,
+        0.0f,     0.0f, 0.00255f, 0.00732f, 0.01328f, 0.01976f, 0.02642f, 0.03308f,
+    0.03973f, 0.04634f, 0.05291f, 0.05947f, 0.06600f, 0.07253f, 0.07904f, 0.08556f
+    },
+};
+
+// Multi-lobe fit of CIE 1931 color matching functions, Wyman et al. 2013
+// http://jcgt.org/published/0002/02/01/
+SORT_STATIC_FORCEINLINE float piecewiseGaussian( float lambda , float mu , float sigma0 , float sigma1 ){
+    const auto t = ( lambda - mu ) / ( lambda < mu ? sigma0 : sigma1 );
+    return exp( -0.5f * t * t );
+}
+
+SORT_STATIC_FORCEINLINE void colorMatching( float lambda , float xyz[3] ){
+    xyz[0] = 1.056f * piecewiseGaussian( lambda , 599.8f , 37.9f , 31.0f ) + 0.362f * piecewiseGaussian( lambda , 442.0f , 16.0f , 26.7f )
+           - 0.065f * piecewiseGaussian( lambda , 501.1f , 20.4f , 26.2f );
+    xyz[1] = 0.821f * piecewiseGaussian( lambda , 568.8f , 46.9f , 40.5f ) + 0.286f * piecewiseGaussian( lambda , 530.9f , 16.3f , 31.1f );
+    xyz[2] = 1.217f * piecewiseGaussian( lambda , 437.0f , 11.8f , 36.0f ) + 0.681f * piecewiseGaussian( lambda , 459.0f , 26.0f , 13.8f );
+}
+
+// Linear sRGB, with the color matching functions above converted from XYZ to it.
+SORT_STATIC_FORCEINLINE void colorMatchingRGB( float lambda , float rgb[3] ){
+    float xyz[3];
+    colorMatching( lambda , xyz );
+    rgb[0] =  3.2404542f * xyz[0] - 1.5371385f * xyz[1] - 0.4985314f * xyz[2];
+    rgb[1] = -0.9692660f * xyz[0] + 1.8760108f * xyz[1] + 0.0415560f * xyz[2];
+    rgb[2] =  0.0556434f * xyz[0] - 0.2040259f * xyz[1] + 1.0572252f * xyz[2];
+}
+
+// Wavelengths are importance sampled based on a fit of the sensitivity of human eyes, this is the same fit used in pbrt-v4.
+SORT_STATIC_FORCEINLINE float sampleVisibleWavelength( float u ){
+    return 538.0f - 138.888889f * std::atanh( 0.85691062f - 1.82750197f * u );
+}
+
+SORT_STATIC_FORCEINLINE float visibleWavelengthPdf( float lambda ){
+    return 0.0039398042f / SQR( std::cosh( 0.0072f * ( lambda - 538.0f ) ) );
+}
+
+// Normalization of the color matching functions so that a constant spectrum of one is converted to white.
+struct ColorMatchingNorm{
+    float   invIntegral[3];     /**< Reciprocal of the integral of the color matching function of each channel. */
+
+    ColorMatchingNorm(){
+        constexpr auto step_cnt = 4700;
+        constexpr auto step = ( SPECTRUM_LAMBDA_MAX - SPECTRUM_LAMBDA_MIN ) / step_cnt;
+
+        double integral[3] = { 0.0 , 0.0 , 0.0 };
+        for( auto i = 0 ; i < step_cnt ; ++i ){
+            float rgb[3];
+            colorMatchingRGB( SPECTRUM_LAMBDA_MIN + ( i + 0.5f ) * step , rgb );
+            for( auto c = 0 ; c < 3 ; ++c )
+                integral[c] += rgb[c] * step;
+        }
+        for( auto c = 0 ; c < 3 ; ++c )
+            invIntegral[c] = (float)( 1.0 / integral[c] );
+    }
+};
+static const ColorMatchingNorm g_colorMatchingNorm;
+
+SampledWavelengths SampledWavelengths::Sample( float u ){
+    SampledWavelengths ret;
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ){
+        // rotate the hero wavelength in primary sample space
+        auto ui = u + (float)i / SAMPLED_SPECTRUM_SAMPLE;
+        if( ui >= 1.0f )
+            ui -= 1.0f;
+
+        const auto lambda = clamp( sampleVisibleWavelength( ui ) , SPECTRUM_LAMBDA_MIN , SPECTRUM_LAMBDA_MAX );
+        const auto pdf = visibleWavelengthPdf( lambda );
+        ret.m_lambda[i] = lambda;
+        ret.m_pdf[i] = pdf;
+
+        const auto t = ( lambda - SPECTRUM_LAMBDA_MIN ) / BASIS_STEP;
+        const auto k = std::min( (int)t , BASIS_CNT - 2 );
+        const auto d = t - k;
+        for( auto c = 0 ; c < 3 ; ++c )
+            ret.m_basis[c][i] = slerp( g_basis[c][k] , g_basis[c][k + 1] , d );
+
+        // each wavelength is an estimation of the color on its own, the result is the average of them
+        float rgb[3];
+        colorMatchingRGB( lambda , rgb );
+        for( auto c = 0 ; c < 3 ; ++c )
+            ret.m_toRGB[c][i] = rgb[c] * g_colorMatchingNorm.invIntegral[c] / ( pdf * SAMPLED_SPECTRUM_SAMPLE );
+    }
+    return ret;
+}
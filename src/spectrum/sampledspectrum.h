@@ -0,0 +1,309 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <tsl_args.h>
+#include "core/define.h"
+#include "math/utils.h"
+#include "rgbspectrum.h"
+
+// Number of wavelengths carried by a path in spectral mode, it matches the width of a 4-way SIMD register.
+#define SAMPLED_SPECTRUM_SAMPLE     4
+
+// Range of wavelengths, in nanometers, considered in spectral mode.
+#define SPECTRUM_LAMBDA_MIN         360.0f
+#define SPECTRUM_LAMBDA_MAX         830.0f
+
+//! @brief  A packet of wavelengths carried by a path in spectral mode.
+/**
+ * Hero wavelength sampling, Wilkie et al. 2014
+ * https://cgg.mff.cuni.cz/~wilkie/Website/EGSR_14_files/WNDWH14HWSS.pdf
+ * Only the first (hero) wavelength is randomly picked, the rest are rotated versions of it in the primary sample space so
+ * that the whole visible range is covered by every single path. Each wavelength is marginally distributed the same way,
+ * which is importance sampled based on the sensitivity of human eyes.
+ *
+ * Everything that depends on the wavelengths only, the upsampling basis of RGB values and the weights to convert the
+ * sampled values back to RGB, is evaluated once when the wavelengths are sampled so that converting between RGB and
+ * sampled spectrum is nothing but a few multiply-adds per lane.
+ */
+class SampledWavelengths{
+public:
+    //! @brief  Sample a packet of wavelengths.
+    //!
+    //! @param  u       A canonical random number for the hero wavelength.
+    //! @return         The sampled wavelengths.
+    static SampledWavelengths Sample( float u );
+
+    //! @brief  Set the wavelengths carried by paths traced in the current thread.
+    //!
+    //! Spectrum values constructed from RGB values are upsampled based on these wavelengths, it needs to be updated for
+    //! each camera sample before tracing paths.
+    //!
+    //! @param  wavelengths     The wavelengths of the paths to be traced.
+    static void SetCurrent( const SampledWavelengths& wavelengths );
+
+    //! @brief  Get the wavelengths carried by paths traced in the current thread.
+    //!
+    //! @return         The wavelengths of the paths being traced.
+    static const SampledWavelengths& GetCurrent();
+
+    //! @brief  Get a wavelength in the packet.
+    //!
+    //! @param  i       Index of the wavelength.
+    //! @return         The wavelength in nanometers.
+    SORT_FORCEINLINE float Lambda( int i ) const {
+        return m_lambda[i];
+    }
+
+    //! @brief  Get the pdf of a wavelength in the packet.
+    //!
+    //! @param  i       Index of the wavelength.
+    //! @return         The pdf of sampling the wavelength w.r.t nanometers.
+    SORT_FORCEINLINE float Pdf( int i ) const {
+        return m_pdf[i];
+    }
+
+    alignas(16) float   m_lambda[SAMPLED_SPECTRUM_SAMPLE] = { 0.0f };      /**< Wavelengths in nanometers. */
+    alignas(16) float   m_pdf[SAMPLED_SPECTRUM_SAMPLE] = { 0.0f };         /**< Pdf of each wavelength. */
+    alignas(16) float   m_basis[3][SAMPLED_SPECTRUM_SAMPLE] = { { 0.0f } }; /**< RGB upsampling basis evaluated at the wavelengths. */
+    alignas(16) float   m_toRGB[3][SAMPLED_SPECTRUM_SAMPLE] = { { 0.0f } }; /**< Weights converting the sampled values to linear sRGB. */
+};
+
+//! @brief  Spectrum sampled at the wavelengths carried by the current path.
+/**
+ * This is the spectrum representation in spectral mode, it has the exact same interface with RGBSpectrum so that the
+ * rest of the renderer is agnostic of the mode. RGB values, coming from textures, shader parameters or lights, are
+ * upsampled to spectra at the wavelengths of the current thread the moment they are converted to a spectrum, products
+ * of them along a path happen per wavelength, which is where spectral rendering differs from RGB rendering.
+ *
+ * Values of all wavelengths are laid out in one 16 bytes aligned array so that the compiler keeps the whole spectrum in
+ * one SSE/Neon register. The intrinsics wrapper is not used on purpose since this header is included by every single
+ * source file, including the ones with 8-way SIMD implementation.
+ */
+class SampledSpectrum{
+public:
+    //! @brief  Default constructor.
+    SORT_FORCEINLINE SampledSpectrum() : SampledSpectrum( 0.0f ) {}
+
+    //! @brief  Constructor from a single value that is the same for all wavelengths.
+    //!
+    //! @param  v       Value of all wavelengths.
+    SORT_FORCEINLINE SampledSpectrum( float v ){
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            data[i] = v;
+    }
+
+    //! @brief  Upsample an RGB color at the wavelengths of the current thread.
+    //!
+    //! @param  r       Value in red channel.
+    //! @param  g       Value in green channel.
+    //! @param  b       Value in blue channel.
+    SORT_FORCEINLINE SampledSpectrum( float r , float g , float b ){
+        const auto& wavelengths = SampledWavelengths::GetCurrent();
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            data[i] = r * wavelengths.m_basis[0][i] + g * wavelengths.m_basis[1][i] + b * wavelengths.m_basis[2][i];
+    }
+
+    //! @brief  Upsample an RGB color at the wavelengths of the current thread.
+    SORT_FORCEINLINE SampledSpectrum( const RGBSpectrum& rgb ) : SampledSpectrum( rgb.r , rgb.g , rgb.b ) {}
+
+    //! @brief  Upsample a tsl float3 at the wavelengths of the current thread.
+    SORT_FORCEINLINE SampledSpectrum( const Tsl_Namespace::float3& f3 ) : SampledSpectrum( f3.x , f3.y , f3.z ) {}
+
+    //! @brief  Convert the spectrum to linear sRGB based on the wavelengths of the current thread.
+    //!
+    //! This is an unbiased estimation of the color, averaging it across samples gives the color of the spectrum.
+    //!
+    //! @return         The estimated color of the spectrum.
+    SORT_FORCEINLINE RGBSpectrum ToRGB() const {
+        const auto& wavelengths = SampledWavelengths::GetCurrent();
+        RGBSpectrum ret;
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ){
+            ret.r += data[i] * wavelengths.m_toRGB[0][i];
+            ret.g += data[i] * wavelengths.m_toRGB[1][i];
+            ret.b += data[i] * wavelengths.m_toRGB[2][i];
+        }
+        return ret;
+    }
+
+    //! @brief  Get the value of the maximum wavelength.
+    //!
+    //! @return     The value of the maximum wavelength.
+    SORT_FORCEINLINE float GetMaxComponent() const {
+        auto ret = data[0];
+        for( auto i = 1 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            ret = std::max( ret , data[i] );
+        return ret;
+    }
+
+    //! @brief  Clamping the spectrum.
+    //!
+    //! @param  low     Minimum value of the range of clamping.
+    //! @param  high    Maximum value of the range of clamping.
+    //! @return         The clamped spectrum.
+    SORT_FORCEINLINE SampledSpectrum Clamp( float low , float high ) const {
+        SampledSpectrum ret;
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            ret.data[i] = clamp( data[i] , low , high );
+        return ret;
+    }
+
+    //! @brief  Return value of a specific wavelength.
+    //!
+    //! @param  i       Index of the wavelength.
+    //! @return         Copy of the value of interest.
+    SORT_FORCEINLINE float operator []( int i ) const {
+        sAssert( i >= 0 && i < SAMPLED_SPECTRUM_SAMPLE , GENERAL );
+        return data[i];
+    }
+
+    //! @brief  Return value of a specific wavelength.
+    //!
+    //! @param  i       Index of the wavelength.
+    //! @return         Reference of the value of interest.
+    SORT_FORCEINLINE float& operator []( int i ) {
+        return data[i];
+    }
+
+    //! @brief  Whether the spectrum is totally black.
+    //!
+    //! @return     Whether the spectrum is black.
+    SORT_FORCEINLINE bool IsBlack() const {
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            if( data[i] != 0.0f )
+                return false;
+        return true;
+    }
+
+    //! @brief  Get the intensity of the spectrum.
+    //!
+    //! Unlike RGB, this is the average of all wavelengths instead of luminance. Luminance of a single path is a noisy
+    //! estimation that could even be negative, while the average is never negative for valid spectra and it is exactly
+    //! the value of gray colors, which is what this is mostly used for, like picking lobes and russian roulette.
+    //!
+    //! @return     Intensity of the spectrum.
+    SORT_FORCEINLINE float GetIntensity() const {
+        auto ret = 0.0f;
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            ret += data[i];
+        return ret / SAMPLED_SPECTRUM_SAMPLE;
+    }
+
+    //! @brief  Return the x^e of each wavelength.
+    //!
+    //! @return     A spectrum with each wavelength as exp of the original spectrum.
+    SORT_FORCEINLINE SampledSpectrum Exp() const {
+        SampledSpectrum ret;
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            ret.data[i] = exp( data[i] );
+        return ret;
+    }
+
+    //! @brief  Return the squared root of each wavelength.
+    //!
+    //! @return     A spectrum with each wavelength as squared root of the original spectrum.
+    SORT_FORCEINLINE SampledSpectrum Sqrt() const {
+        SampledSpectrum ret;
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            ret.data[i] = sqrt( data[i] );
+        return ret;
+    }
+
+    //! @brief  Whether the spectrum is valid.
+    //!
+    //! @return     Whether the spectrum contains Nan or Inf
+    SORT_FORCEINLINE bool IsValid() const {
+        for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+            if( isnan( data[i] ) || isinf( data[i] ) )
+                return false;
+        return true;
+    }
+
+    alignas(16) float data[SAMPLED_SPECTRUM_SAMPLE];
+
+    static const SampledSpectrum    m_White;
+};
+
+static_assert(sizeof(SampledSpectrum) == sizeof(float) * SAMPLED_SPECTRUM_SAMPLE);
+
+//! @brief  The thread local wavelengths, it should be accessed through SampledWavelengths::GetCurrent.
+//!
+//! Threads that never trace paths, like the ones building lights or folding shaders at load time, still convert RGB
+//! values to spectra, they start with a fixed valid packet instead of a zero basis that turns every color to black.
+inline thread_local SampledWavelengths g_current_wavelengths = SampledWavelengths::Sample( 0.5f );
+
+SORT_FORCEINLINE const SampledWavelengths& SampledWavelengths::GetCurrent(){
+    return g_current_wavelengths;
+}
+
+SORT_FORCEINLINE void SampledWavelengths::SetCurrent( const SampledWavelengths& wavelengths ){
+    g_current_wavelengths = wavelengths;
+}
+
+//! @brief  Convert a spectrum to linear sRGB, based on the wavelengths of the current thread.
+SORT_STATIC_FORCEINLINE RGBSpectrum ToRGBSpectrum( const SampledSpectrum& s ){
+    return s.ToRGB();
+}
+
+#define SAMPLED_SPECTRUM_BINARY_OP( OP ) \
+SORT_STATIC_FORCEINLINE SampledSpectrum operator OP ( const SampledSpectrum& s0 , const SampledSpectrum& s1 ){ \
+    SampledSpectrum ret; \
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ) \
+        ret.data[i] = s0.data[i] OP s1.data[i]; \
+    return ret; \
+} \
+SORT_STATIC_FORCEINLINE SampledSpectrum operator OP ( const SampledSpectrum& s0 , const float f ){ \
+    SampledSpectrum ret; \
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ) \
+        ret.data[i] = s0.data[i] OP f; \
+    return ret; \
+} \
+SORT_STATIC_FORCEINLINE SampledSpectrum operator OP ( const float f , const SampledSpectrum& s0 ){ \
+    SampledSpectrum ret; \
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ) \
+        ret.data[i] = f OP s0.data[i]; \
+    return ret; \
+} \
+SORT_STATIC_FORCEINLINE SampledSpectrum operator OP##= ( SampledSpectrum& s0 , const SampledSpectrum& s1 ){ \
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ) \
+        s0.data[i] OP##= s1.data[i]; \
+    return s0; \
+} \
+SORT_STATIC_FORCEINLINE SampledSpectrum operator OP##= ( SampledSpectrum& s0 , const float f ){ \
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i ) \
+        s0.data[i] OP##= f; \
+    return s0; \
+}
+
+SAMPLED_SPECTRUM_BINARY_OP( + )
+SAMPLED_SPECTRUM_BINARY_OP( - )
+SAMPLED_SPECTRUM_BINARY_OP( * )
+SAMPLED_SPECTRUM_BINARY_OP( / )
+
+#undef SAMPLED_SPECTRUM_BINARY_OP
+
+SORT_STATIC_FORCEINLINE bool operator == ( const SampledSpectrum& s0 , const SampledSpectrum& s1 ){
+    for( auto i = 0 ; i < SAMPLED_SPECTRUM_SAMPLE ; ++i )
+        if( s0.data[i] != s1.data[i] )
+            return false;
+    return true;
+}
+
+SORT_STATIC_FORCEINLINE bool operator != ( const SampledSpectrum& s0 , const SampledSpectrum& s1 ){
+    return !( s0 == s1 );
+}
@@ -19,5 +19,24 @@
 
 #include "rgbspectrum.h"
 
+// Spectral rendering traces a packet of wavelengths with each path instead of RGB colors. Color inputs are upsampled
+// to spectra on the fly and radiance is converted back to RGB before it is accumulated in the film. It is mainly for
+// cross validation of the RGB renderer since none of the closures is wavelength dependent yet.
+#ifdef SORT_SPECTRAL_RENDERING
+
+#include "sampledspectrum.h"
+
+#define Spectrum            SampledSpectrum
+#define SPECTRUM_SAMPLE     SAMPLED_SPECTRUM_SAMPLE
+
+#else
+
 #define Spectrum            RGBSpectrum
-#define SPECTRUM_SAMPLE     RGBSPECTRUM_SAMPLE
\ No newline at end of file
+#define SPECTRUM_SAMPLE     RGBSPECTRUM_SAMPLE
+
+//! @brief  Convert a spectrum to RGB color, which is nothing but the spectrum itself in RGB mode.
+SORT_STATIC_FORCEINLINE const RGBSpectrum& ToRGBSpectrum( const RGBSpectrum& s ){
+    return s;
+}
+
+#endif
\ No newline at end of file
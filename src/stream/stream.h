@@ -207,7 +207,7 @@ public:
     //!
     //! @param v    Value to be saved.
     //! @return     Reference of the stream itself.
-    SORT_FORCEINLINE StreamBase&  operator << (const Spectrum& v) {
+    SORT_FORCEINLINE StreamBase&  operator << (const RGBSpectrum& v) {
         *this << v.r << v.g << v.b;
         return *this;
     }
@@ -216,10 +216,10 @@ public:
     //!
     //! @param v    Value to be loaded.
     //! @return     Reference of the stream itself.
-    SORT_FORCEINLINE StreamBase&  operator >> (Spectrum& v) {
+    SORT_FORCEINLINE StreamBase&  operator >> (RGBSpectrum& v) {
         float r , g , b;
         *this >> r >> g >> b;
-        v = Spectrum ( r , g , b );
+        v = RGBSpectrum ( r , g , b );
         return *this;
     }
 
@@ -30,7 +30,7 @@ BEGIN_EXTERNAL_INCLUDES
 
 END_EXTERNAL_INCLUDES
 
-Spectrum ImageTexture2D::GetColor( int x , int y ) const{
+RGBSpectrum ImageTexture2D::GetColor( int x , int y ) const{
     // if there is no image, just crash
     sAssertMsg(IS_PTR_VALID(m_memory) && IS_PTR_VALID(m_memory->m_rgb) , IMAGE , "Texture %s not loaded!" , m_name.c_str() );
 
@@ -76,9 +76,9 @@ bool ImageTexture2D::LoadResource( const std::string str ){
 
         if (ret >= 0) {
             const auto total = m_iTexWidth * m_iTexHeight;
-            m_memory->m_rgb = std::make_unique<Spectrum[]>(total);
+            m_memory->m_rgb = std::make_unique<RGBSpectrum[]>(total);
             for (auto i = 0; i < total; i++)
-                m_memory->m_rgb[i] = Spectrum(out[4 * i], out[4 * i + 1], out[4 * i + 2]);
+                m_memory->m_rgb[i] = RGBSpectrum(out[4 * i], out[4 * i + 1], out[4 * i + 2]);
 
             free(out);
 
@@ -97,7 +97,7 @@ bool ImageTexture2D::LoadResource( const std::string str ){
 
     if (data) {
         if( m_iTexWidth > 0 && m_iTexHeight > 0 ){
-            m_memory->m_rgb = std::make_unique<Spectrum[]>(m_iTexWidth*m_iTexHeight);
+            m_memory->m_rgb = std::make_unique<RGBSpectrum[]>(m_iTexWidth*m_iTexHeight);
             for (auto i = 0; i < m_iTexHeight; ++i) {
                 for (auto j = 0; j < m_iTexWidth; ++j) {
                     const auto k = i * m_iTexWidth + j;
@@ -133,7 +133,7 @@ bool ImageTexture2D::LoadResource( const std::string str ){
     return false;
 }
 
-Spectrum ImageTexture2D::GetAverage() const{
+RGBSpectrum ImageTexture2D::GetAverage() const{
     return m_average;
 }
 
@@ -142,7 +142,7 @@ void ImageTexture2D::average(){
     if(IS_PTR_INVALID(m_memory) || IS_PTR_INVALID(m_memory->m_rgb))
         return;
 
-    Spectrum average;
+    RGBSpectrum average;
     for (auto i = 0; i < m_iTexHeight; ++i) {
         for (auto j = 0; j < m_iTexWidth; ++j) {
             // get the offset
@@ -39,7 +39,7 @@ public:
     //! @param  x           X coordinate. If out of range, it will be filtered.
     //! @param  y           Y coordinate. If out of range, it will be filtered.
     //! @return             The color at the specific position.
-    Spectrum GetColor( int x , int y ) const override;
+    RGBSpectrum GetColor( int x , int y ) const override;
 
     //! @brief  Get the alpha at a specific position.
     //!
@@ -58,12 +58,12 @@ public:
     //! @brief  Get the average color of the texture.
     //!
     //! @return             The average color of the texture.
-    Spectrum GetAverage() const;
+    RGBSpectrum GetAverage() const;
 
 private:
     class ImgMemory{
     public:
-        std::unique_ptr<Spectrum[]>     m_rgb = nullptr;   /**< RGB Channels. */
+        std::unique_ptr<RGBSpectrum[]>     m_rgb = nullptr;   /**< RGB Channels. */
         std::unique_ptr<float[]>        m_a  = nullptr;   /**< Alpha Channel. */
     };
 
@@ -71,7 +71,7 @@ private:
     std::unique_ptr<ImgMemory>  m_memory = nullptr;
 
     // the average radiance of the texture
-    Spectrum    m_average;
+    RGBSpectrum    m_average;
 
     // texture name
     std::string m_name;
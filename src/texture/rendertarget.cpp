@@ -19,7 +19,7 @@
 #include "core/sassert.h"
 
 // set the color
-void RenderTarget::SetColor( int x , int y , const Spectrum& color ){
+void RenderTarget::SetColor( int x , int y , const RGBSpectrum& color ){
     // check if there is memory
     sAssertMsg(IS_PTR_VALID(m_pData), IMAGE , "There is no data in render target , can't set color" );
 
@@ -33,7 +33,7 @@ void RenderTarget::SetColor( int x , int y , const Spectrum& color ){
     m_pData[offset] = color;
 }
 
-Spectrum RenderTarget::GetColor( int x , int y ) const{
+RGBSpectrum RenderTarget::GetColor( int x , int y ) const{
     sAssertMsg(IS_PTR_VALID(m_pData) , IMAGE , "No memory in the render target, can't get color." );
 
     // filter the x y coordinate
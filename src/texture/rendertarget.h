@@ -23,18 +23,18 @@
 class   RenderTarget : public Texture2DBase{
 public:
     RenderTarget( int w , int h ) : Texture2DBase( w , h ){
-        m_pData = std::make_unique<Spectrum[]>( w * h );
+        m_pData = std::make_unique<RGBSpectrum[]>( w * h );
     }
 
-    void SetColor( int x , int y , const Spectrum& c );
-    Spectrum GetColor( int x , int y ) const;
+    void SetColor( int x , int y , const RGBSpectrum& c );
+    RGBSpectrum GetColor( int x , int y ) const;
 
-    const Spectrum* GetData() const {
+    const RGBSpectrum* GetData() const {
         return m_pData.get();
     }
 
 private:
-    std::unique_ptr<Spectrum[]> m_pData;
+    std::unique_ptr<RGBSpectrum[]> m_pData;
 
     friend struct FullTargetUpdate;
 };
@@ -0,0 +1,131 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include "sparsetexture3d.h"
+
+template class SparseTexture3D<float>;
+template class SparseTexture3D<Spectrum>;
+
+SORT_STATIC_FORCEINLINE bool isZero(const float v) {
+    return v == 0.0f;
+}
+
+SORT_STATIC_FORCEINLINE bool isZero(const Spectrum& v) {
+    return v.IsBlack();
+}
+
+template<class T>
+T SparseTexture3D<T>::Sample(int x, int y, int z) const {
+    if (x < 0 || x >= (int)Texture3DBase<T>::m_width || y < 0 || y >= (int)Texture3DBase<T>::m_height || z < 0 || z >= (int)Texture3DBase<T>::m_depth)
+        return 0.0f;
+
+    const auto index = m_brickIndex[brickOffset(x / BRICK_SIZE, y / BRICK_SIZE, z / BRICK_SIZE)];
+    if (index < 0)
+        return 0.0f;
+
+    const auto lx = x % BRICK_SIZE, ly = y % BRICK_SIZE, lz = z % BRICK_SIZE;
+    return m_voxels[(size_t)index * BRICK_VOXEL_CNT + (lz * BRICK_SIZE + ly) * BRICK_SIZE + lx];
+}
+
+template<class T>
+T SparseTexture3D<T>::Sample(float u, float v, float w) const {
+    if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f || w < 0.0f || w >= 1.0f)
+        return 0.0f;
+
+    const auto width  = Texture3DBase<T>::m_width;
+    const auto height = Texture3DBase<T>::m_height;
+    const auto depth  = Texture3DBase<T>::m_depth;
+
+    // voxel centers are at half integer positions, lookups right at the boundary are clamped to the outermost voxels
+    const auto fx = std::max(u * width - 0.5f, 0.0f);
+    const auto fy = std::max(v * height - 0.5f, 0.0f);
+    const auto fz = std::max(w * depth - 0.5f, 0.0f);
+
+    const auto x0 = (int)fx, y0 = (int)fy, z0 = (int)fz;
+    const auto x1 = std::min(x0 + 1, (int)width - 1);
+    const auto y1 = std::min(y0 + 1, (int)height - 1);
+    const auto z1 = std::min(z0 + 1, (int)depth - 1);
+
+    const auto dx = fx - x0;
+    const auto dy = fy - y0;
+    const auto dz = fz - z0;
+
+    const auto t00 = slerp(Sample(x0, y0, z0), Sample(x1, y0, z0), dx);
+    const auto t10 = slerp(Sample(x0, y1, z0), Sample(x1, y1, z0), dx);
+    const auto t01 = slerp(Sample(x0, y0, z1), Sample(x1, y0, z1), dx);
+    const auto t11 = slerp(Sample(x0, y1, z1), Sample(x1, y1, z1), dx);
+
+    return slerp(slerp(t00, t10, dy), slerp(t01, t11, dy), dz);
+}
+
+template<class T>
+void SparseTexture3D<T>::Reset(unsigned int w, unsigned int h, unsigned int d) {
+    Texture3DBase<T>::m_width = w;
+    Texture3DBase<T>::m_height = h;
+    Texture3DBase<T>::m_depth = d;
+
+    m_brickRes[0] = (w + BRICK_SIZE - 1) / BRICK_SIZE;
+    m_brickRes[1] = (h + BRICK_SIZE - 1) / BRICK_SIZE;
+    m_brickRes[2] = (d + BRICK_SIZE - 1) / BRICK_SIZE;
+
+    const auto brick_cnt = m_brickRes[0] * m_brickRes[1] * m_brickRes[2];
+    m_brickIndex.assign(brick_cnt, -1);
+    m_voxels.clear();
+    m_brickMax.assign(brick_cnt, 0.0f);
+    m_occupancy.assign((brick_cnt + 63) / 64, 0);
+}
+
+template<class T>
+T* SparseTexture3D<T>::AllocateBrick(unsigned int bx, unsigned int by, unsigned int bz) {
+    auto& index = m_brickIndex[brickOffset(bx, by, bz)];
+    if (index < 0) {
+        index = (int)GetAllocatedBrickCnt();
+        m_voxels.resize(m_voxels.size() + BRICK_VOXEL_CNT, T(0.0f));
+    }
+    return m_voxels.data() + (size_t)index * BRICK_VOXEL_CNT;
+}
+
+template<class T>
+void SparseTexture3D<T>::BuildFromDense(unsigned int w, unsigned int h, unsigned int d, const T* texels) {
+    Reset(w, h, d);
+
+    for (auto bz = 0u; bz < m_brickRes[2]; ++bz) {
+        for (auto by = 0u; by < m_brickRes[1]; ++by) {
+            for (auto bx = 0u; bx < m_brickRes[0]; ++bx) {
+                const auto x_end = std::min((bx + 1) * BRICK_SIZE, w);
+                const auto y_end = std::min((by + 1) * BRICK_SIZE, h);
+                const auto z_end = std::min((bz + 1) * BRICK_SIZE, d);
+
+                // skip the brick if all of its voxels are zero
+                auto empty = true;
+                for (auto z = bz * BRICK_SIZE; z < z_end && empty; ++z)
+                    for (auto y = by * BRICK_SIZE; y < y_end && empty; ++y)
+                        for (auto x = bx * BRICK_SIZE; x < x_end && empty; ++x)
+                            empty = isZero(texels[((size_t)z * h + y) * w + x]);
+                if (empty)
+                    continue;
+
+                auto* voxels = AllocateBrick(bx, by, bz);
+                for (auto z = bz * BRICK_SIZE; z < z_end; ++z)
+                    for (auto y = by * BRICK_SIZE; y < y_end; ++y)
+                        for (auto x = bx * BRICK_SIZE; x < x_end; ++x)
+                            voxels[((z % BRICK_SIZE) * BRICK_SIZE + (y % BRICK_SIZE)) * BRICK_SIZE + (x % BRICK_SIZE)] = texels[((size_t)z * h + y) * w + x];
+            }
+        }
+    }
+}
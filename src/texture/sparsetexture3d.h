@@ -0,0 +1,196 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "texturebase.h"
+
+//! @brief  Sparse 3D texture.
+/**
+ * Voxels are grouped in bricks of BRICK_SIZE^3 voxels and only bricks with non-zero voxels are allocated, everything
+ * else is implicitly zero. A dense top level grid maps brick coordinates to allocated bricks, which makes it a two-level
+ * tree similar to the leaf and internal nodes of VDB. Volumes like clouds or explosions are mostly empty, which is where
+ * most of the memory is saved compared with dense storage.
+ *
+ * Besides the voxels, each brick keeps the maximum voxel value in its filtering footprint and an occupancy bit, both of
+ * which are for skipping empty space during volume rendering.
+ */
+template<class T>
+class SparseTexture3D : public Texture3DBase<T> {
+public:
+    /**< Number of voxels along each axis in a brick. */
+    static constexpr unsigned int BRICK_SIZE = 8;
+    /**< Number of voxels in a brick. */
+    static constexpr unsigned int BRICK_VOXEL_CNT = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+    //! @brief  Default constructor.
+    SparseTexture3D() : Texture3DBase<T>(0u, 0u, 0u) {}
+
+    //! @brief  Take a sample in 3D texture given a position of texel.
+    //!
+    //! @param  x       X coordinate position.
+    //! @param  y       Y coordinate position.
+    //! @param  z       Z coordinate position.
+    //! @return         The voxel value, zero if it is out of range or in an empty brick.
+    T Sample(int x, int y, int z) const override;
+
+    //! @brief  Take a trilinear filtered sample in 3D texture.
+    //!
+    //! @param u        U coordinate.
+    //! @param v        V coordinate.
+    //! @param w        W coordinate.
+    //! @return         The filtered value, zero if the coordinate is out of range.
+    T Sample(float u, float v, float w) const override;
+
+    //! @brief  Reset the texture to an empty one with the given size.
+    //!
+    //! @param  w       Width of the texture.
+    //! @param  h       Height of the texture.
+    //! @param  d       Depth of the texture.
+    void Reset(unsigned int w, unsigned int h, unsigned int d);
+
+    //! @brief  Allocate a brick, all of its voxels are zero after allocation.
+    //!
+    //! Allocating a brick that is already allocated simply returns the existing one.
+    //!
+    //! @param  bx      X coordinate of the brick.
+    //! @param  by      Y coordinate of the brick.
+    //! @param  bz      Z coordinate of the brick.
+    //! @return         Voxels of the brick, x is the fastest changing axis.
+    T*   AllocateBrick(unsigned int bx, unsigned int by, unsigned int bz);
+
+    //! @brief  Build the texture from dense voxels, bricks with all voxels being zero are not allocated.
+    //!
+    //! @param  w       Width of the texture.
+    //! @param  h       Height of the texture.
+    //! @param  d       Depth of the texture.
+    //! @param  texels  Dense voxels, x is the fastest changing axis and z is the slowest one.
+    void BuildFromDense(unsigned int w, unsigned int h, unsigned int d, const T* texels);
+
+    //! @brief  Update the per brick maximum values and occupancy bits.
+    //!
+    //! This needs to be called once all voxels are filled.
+    //!
+    //! @param  max_value   A function returning a scalar value of a voxel to take the maximum of.
+    template<class F>
+    void UpdateBrickMaximum(F&& max_value);
+
+    //! @brief  Get the number of bricks along an axis.
+    //!
+    //! @param  axis    The axis of interest, 0 for x, 1 for y and 2 for z.
+    //! @return         Number of bricks along the axis.
+    unsigned int GetBrickRes(int axis) const {
+        return m_brickRes[axis];
+    }
+
+    //! @brief  Get the number of allocated bricks.
+    //!
+    //! @return         Number of allocated bricks.
+    unsigned int GetAllocatedBrickCnt() const {
+        return (unsigned int)(m_voxels.size() / BRICK_VOXEL_CNT);
+    }
+
+    //! @brief  Get the maximum value of the voxels affecting filtered lookups inside a brick.
+    //!
+    //! @param  bx      X coordinate of the brick.
+    //! @param  by      Y coordinate of the brick.
+    //! @param  bz      Z coordinate of the brick.
+    //! @return         The maximum value, it is valid only after UpdateBrickMaximum is called.
+    float GetBrickMaximum(unsigned int bx, unsigned int by, unsigned int bz) const {
+        return m_brickMax[brickOffset(bx, by, bz)];
+    }
+
+    //! @brief  Whether filtered lookups inside a brick could be non-zero.
+    //!
+    //! @param  bx      X coordinate of the brick.
+    //! @param  by      Y coordinate of the brick.
+    //! @param  bz      Z coordinate of the brick.
+    //! @return         False if all filtered lookups inside the brick are zero.
+    bool IsBrickOccupied(unsigned int bx, unsigned int by, unsigned int bz) const {
+        const auto offset = brickOffset(bx, by, bz);
+        return (m_occupancy[offset >> 6] >> (offset & 63)) & 1;
+    }
+
+protected:
+    //! @brief  Get the index of a brick in the top level grid.
+    unsigned int brickOffset(unsigned int bx, unsigned int by, unsigned int bz) const {
+        return (bz * m_brickRes[1] + by) * m_brickRes[0] + bx;
+    }
+
+    /**< Number of bricks along each axis. */
+    unsigned int            m_brickRes[3] = { 0, 0, 0 };
+    /**< Index of the allocated brick for each brick coordinate, -1 for empty bricks. */
+    std::vector<int>        m_brickIndex;
+    /**< Voxels of all allocated bricks, one brick after another. */
+    std::vector<T>          m_voxels;
+    /**< Maximum value affecting filtered lookups inside each brick. */
+    std::vector<float>      m_brickMax;
+    /**< One bit per brick indicating whether it could have non-zero filtered lookups. */
+    std::vector<uint64_t>   m_occupancy;
+};
+
+template<class T>
+template<class F>
+void SparseTexture3D<T>::UpdateBrickMaximum(F&& max_value) {
+    const auto brick_cnt = m_brickRes[0] * m_brickRes[1] * m_brickRes[2];
+    m_brickMax.assign(brick_cnt, 0.0f);
+    m_occupancy.assign((brick_cnt + 63) / 64, 0);
+
+    // A voxel affects trilinear lookups up to one voxel away from it, which could be inside a neighboring brick.
+    const auto brick_range = [&](unsigned int v, int axis, unsigned int& lo, unsigned int& hi) {
+        lo = (v > 0 ? v - 1 : 0) / BRICK_SIZE;
+        hi = std::min((v + 1) / BRICK_SIZE, m_brickRes[axis] - 1);
+    };
+
+    for (auto bz = 0u; bz < m_brickRes[2]; ++bz) {
+        for (auto by = 0u; by < m_brickRes[1]; ++by) {
+            for (auto bx = 0u; bx < m_brickRes[0]; ++bx) {
+                const auto index = m_brickIndex[brickOffset(bx, by, bz)];
+                if (index < 0)
+                    continue;
+
+                const auto* voxels = m_voxels.data() + (size_t)index * BRICK_VOXEL_CNT;
+                for (auto lz = 0u; lz < BRICK_SIZE; ++lz) {
+                    unsigned int z0, z1;
+                    brick_range(bz * BRICK_SIZE + lz, 2, z0, z1);
+                    for (auto ly = 0u; ly < BRICK_SIZE; ++ly) {
+                        unsigned int y0, y1;
+                        brick_range(by * BRICK_SIZE + ly, 1, y0, y1);
+                        for (auto lx = 0u; lx < BRICK_SIZE; ++lx) {
+                            const auto value = max_value(voxels[(lz * BRICK_SIZE + ly) * BRICK_SIZE + lx]);
+                            if (value <= 0.0f)
+                                continue;
+
+                            unsigned int x0, x1;
+                            brick_range(bx * BRICK_SIZE + lx, 0, x0, x1);
+                            for (auto cz = z0; cz <= z1; ++cz)
+                                for (auto cy = y0; cy <= y1; ++cy)
+                                    for (auto cx = x0; cx <= x1; ++cx) {
+                                        const auto offset = brickOffset(cx, cy, cz);
+                                        m_brickMax[offset] = std::max(m_brickMax[offset], value);
+                                        m_occupancy[offset >> 6] |= (uint64_t)1 << (offset & 63);
+                                    }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
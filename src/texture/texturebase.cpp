@@ -35,7 +35,7 @@ bool Texture2DBase::Output( const std::string& name ){
         {
             auto x = i % totalXRes;
             auto y = i / totalXRes;
-            Spectrum c = GetColor(x, y);
+            RGBSpectrum c = GetColor(x, y);
 
             data[3 * i] = c.r;
             data[3 * i + 1] = c.g;
@@ -87,7 +87,7 @@ void Texture2DBase::texCoordFilter( int& x , int& y ) const{
     }
 }
 
-Spectrum Texture2DBase::GetColorFromUV( float u , float v ) const{
+RGBSpectrum Texture2DBase::GetColorFromUV( float u , float v ) const{
     // Before I have time to work on texturing system, using linear sampling by default.
     // This is by no means the most efficient way to implement bilinear sampling, but it works for now.
 
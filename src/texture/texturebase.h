@@ -63,7 +63,7 @@ public:
     //! @param  x           X coordinate. If out of range, it will be filtered.
     //! @param  y           Y coordinate. If out of range, it will be filtered.
     //! @return             The color at the specific position.
-    virtual Spectrum GetColor( int x , int y ) const = 0;
+    virtual RGBSpectrum GetColor( int x , int y ) const = 0;
 
     //! @brief  Get the alpha at a specific position.
     //!
@@ -79,7 +79,7 @@ public:
     //! @param  u           U coordinate. If out of range, it will be filtered.
     //! @param  v           V coordinate. If out of range, it will be filtered.
     //! @return             The color at the specific texture coordinate.
-    virtual Spectrum GetColorFromUV( float u , float v ) const;
+    virtual RGBSpectrum GetColorFromUV( float u , float v ) const;
 
     //! @brief  Get the alpha given a texture coordinate.
     //!
@@ -21,11 +21,13 @@
 
 #ifdef SIMD_8WAY_ENABLED
 #define SIMD_8WAY_IMPLEMENTATION
+#define SIMD_BVH_IMPLEMENTATION
 #endif
 
 #include "simd.hpp"
 
 #ifdef SIMD_8WAY_ENABLED
+#undef SIMD_BVH_IMPLEMENTATION
 #undef SIMD_8WAY_IMPLEMENTATION
 #endif
 
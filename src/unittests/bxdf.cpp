@@ -18,6 +18,9 @@
 #include <thread>
 #include <mutex>
 #include <memory>
+#include <cstring>
+#include <limits>
+#include <vector>
 #include "unittest_common.h"
 #include "thirdparty/gtest/gtest.h"
 #include "sampler/sample.h"
@@ -34,6 +37,9 @@
 #include "scatteringevent/bsdf/hair.h"
 #include "scatteringevent/bsdf/fabric.h"
 #include "scatteringevent/bsdf/kylin_principle.h"
+#include "scatteringevent/bsdf/fourierbxdf.h"
+#include "scatteringevent/bsdf/merl.h"
+#include "math/half.h"
 #include "core/render_context.h"
 
 using namespace unittest;
@@ -49,9 +55,9 @@ void checkReciprocity(const Bxdf* bxdf) {
         const auto f1 = bxdf->F(wi, wo) * absCosTheta(wi);
 
         std::lock_guard<spinlock_mutex> lock(mutex);
-        ASSERT_NEAR(f0.r, f1.r, 0.001f);
-        ASSERT_NEAR(f0.g, f1.g, 0.001f);
-        ASSERT_NEAR(f0.b, f1.b, 0.001f);
+        ASSERT_NEAR(f0[0], f1[0], 0.001f);
+        ASSERT_NEAR(f0[1], f1[1], 0.001f);
+        ASSERT_NEAR(f0[2], f1[2], 0.001f);
     });
 }
 
@@ -63,9 +69,9 @@ void checkEnergyConservation(const Bxdf* bxdf) {
         Spectrum r = bxdf->Sample_F(DIR_UP, wi, BsdfSample(GetRenderContext()), &pdf);
         return pdf > 0.0f ? r / pdf : 0.0f;
     } );
-    EXPECT_LE(total.r, 1.03f);
-    EXPECT_LE(total.g, 1.03f);
-    EXPECT_LE(total.b, 1.03f);
+    EXPECT_LE(total[0], 1.03f);
+    EXPECT_LE(total[1], 1.03f);
+    EXPECT_LE(total[2], 1.03f);
 }
 
 // Check whether the pdf evaluated from sample_f matches the one from Pdf
@@ -90,9 +96,9 @@ void checkPdf( const Bxdf* bxdf ){
         EXPECT_LE( fabs( pdf / calculated_pdf - 1.0f ) , 0.01f );
         EXPECT_TRUE( !IsNan(pdf) );
         EXPECT_GE( pdf , 0.0f );
-        EXPECT_NEAR(f0.r, f1.r, 0.001f);
-        EXPECT_NEAR(f0.g, f1.g, 0.001f);
-        EXPECT_NEAR(f0.b, f1.b, 0.001f);
+        EXPECT_NEAR(f0[0], f1[0], 0.001f);
+        EXPECT_NEAR(f0[1], f1[1], 0.001f);
+        EXPECT_NEAR(f0[2], f1[2], 0.001f);
     });
 
     // Check whether pdf adds together is less to 1.0
@@ -296,8 +302,8 @@ TEST(BXDF, DISABLED_HairSamplingConsistance) {
         } );
         const auto ratio = uni.GetIntensity() / imp.GetIntensity();
         if( fabs( ratio - 1.0f ) > 0.05f ){
-            std::cout<<uni.r << "\t"<<uni.g << "\t"<< uni.b<<std::endl;
-            std::cout<<imp.r << "\t"<<imp.g << "\t"<< imp.b<<std::endl;
+            std::cout<<uni[0] << "\t"<<uni[1] << "\t"<< uni[2]<<std::endl;
+            std::cout<<imp[0] << "\t"<<imp[1] << "\t"<< imp[2]<<std::endl;
         }
         EXPECT_LE( fabs( ratio - 1.0f ) , 0.05f );
     };
@@ -321,4 +327,197 @@ TEST(BXDF, KylinPrinciple) {
     params.specular = 1.0f;
     KylinPrinciple principle(rc, params);
     checkAll(&principle);
-}
\ No newline at end of file
+}
+
+// The vectorized Fourier series evaluation should match the scalar reference implementation.
+TEST(BXDF, FourierSeriesPacked) {
+    for( const auto m : { 1 , 3 , 4 , 7 , 16 , 61 } ){
+        const auto stride = ( m + 3 ) & ~3;
+        std::vector<float> ak( stride * 3 , 0.0f );
+        auto sum = 0.0f;
+        for( auto c = 0 ; c < 3 ; ++c ){
+            for( auto k = 0 ; k < m ; ++k ){
+                ak[c * stride + k] = ( sort_rand_float() * 2.0f - 1.0f ) / ( 1.0f + k );
+                sum += fabs( ak[c * stride + k] );
+            }
+        }
+
+        for( auto i = 0 ; i < 1024 ; ++i ){
+            const auto cosPhi = sort_rand_float() * 2.0f - 1.0f;
+
+            float packed[3];
+            FourierBxdfData::FourierPacked( ak.data() , stride , m , cosPhi , 3 , packed );
+            for( auto c = 0 ; c < 3 ; ++c )
+                EXPECT_NEAR( packed[c] , FourierBxdfData::Fourier( ak.data() + c * stride , m , cosPhi ) , 1e-5f * sum );
+        }
+    }
+}
+
+// Importance sampling a Fourier series with the vectorized kernel should match the scalar reference implementation.
+TEST(BXDF, FourierSamplingPacked) {
+    for( const auto m : { 1 , 5 , 8 , 33 } ){
+        const auto stride = ( m + 3 ) & ~3;
+        std::vector<float> ak( stride , 0.0f ) , recip( stride , 0.0f );
+        for( auto k = 1 ; k < stride ; ++k )
+            recip[k] = 1.0f / k;
+
+        // keep the series positive so that it is a valid distribution
+        ak[0] = 1.0f;
+        for( auto k = 1 ; k < m ; ++k )
+            ak[k] = ( sort_rand_float() * 2.0f - 1.0f ) * 0.9f / m;
+
+        for( auto i = 0 ; i < 256 ; ++i ){
+            const auto u = sort_rand_float();
+
+            float phi0 , pdf0 , phi1 , pdf1;
+            const auto f0 = FourierBxdfData::SampleFourier( ak.data() , recip.data() , m , u , &pdf0 , &phi0 );
+            const auto f1 = FourierBxdfData::SampleFourierPacked( ak.data() , recip.data() , m , u , &pdf1 , &phi1 );
+            EXPECT_NEAR( phi0 , phi1 , 1e-4f );
+            EXPECT_NEAR( pdf0 , pdf1 , 1e-4f );
+            EXPECT_NEAR( f0 , f1 , 1e-4f );
+        }
+    }
+}
+
+// Evaluating microfacet reflection lobes in a batch should match evaluating them one by one.
+TEST(BXDF, MicrofacetBatch) {
+    auto& rc = GetRenderContext();
+
+    const GGX ggx_iso( 0.3f , 0.3f ) , ggx_aniso( 0.2f , 0.7f );
+    const Beckmann beckmann_iso( 0.5f , 0.5f ) , beckmann_aniso( 0.6f , 0.25f );
+    const Blinn blinn( 0.4f , 0.4f );
+    const FresnelConductor conductor( Spectrum( 0.2f , 0.9f , 1.1f ) , Spectrum( 3.9f , 2.4f , 2.1f ) );
+    const FresnelDielectric dielectric( 1.0f , 1.5f );
+    const FresnelNo no_fresnel;
+
+    const MicroFacetReflection lobes[] = {
+        MicroFacetReflection( rc , Spectrum( 0.9f , 0.6f , 0.3f ) , &conductor , &ggx_iso , Spectrum( 0.5f ) , DIR_UP ),
+        MicroFacetReflection( rc , Spectrum( 0.4f , 0.8f , 0.7f ) , &dielectric , &beckmann_aniso , Spectrum( 0.3f , 0.2f , 0.1f ) , DIR_UP , true ),
+        MicroFacetReflection( rc , Spectrum( 1.0f ) , &no_fresnel , &ggx_aniso , Spectrum( 0.7f ) , DIR_UP ),
+        MicroFacetReflection( rc , Spectrum( 0.2f , 0.3f , 0.9f ) , &conductor , &beckmann_iso , Spectrum( 0.4f ) , DIR_UP , true ),
+        MicroFacetReflection( rc , Spectrum( 0.6f ) , &dielectric , &ggx_aniso , Spectrum( 0.2f ) , DIR_UP ),
+        // neither of the two below could be batched
+        MicroFacetReflection( rc , Spectrum( 0.5f ) , &conductor , &blinn , Spectrum( 0.5f ) , DIR_UP ),
+        MicroFacetReflection( rc , Spectrum( 0.5f ) , &conductor , &ggx_iso , Spectrum( 0.5f ) , normalize( Vector( 0.2f , 1.0f , 0.1f ) ) ),
+    };
+    constexpr auto batched_cnt = 5u;
+
+    MicrofacetBatch batch;
+    for( auto i = 0u ; i < sizeof( lobes ) / sizeof( lobes[0] ) ; ++i )
+        EXPECT_EQ( batch.Add( &lobes[i] ) , i < batched_cnt );
+    EXPECT_EQ( batch.GetLobeCnt() , batched_cnt );
+
+    for( auto i = 0 ; i < 4096 ; ++i ){
+        const auto wo = UniformSampleSphere( sort_rand_float() , sort_rand_float() );
+        const auto wi = UniformSampleSphere( sort_rand_float() , sort_rand_float() );
+
+        for( auto excluded = 0u ; excluded <= batched_cnt ; ++excluded ){
+            Spectrum expected_f;
+            auto expected_pdf = 0.0f;
+            for( auto k = 0u ; k < batched_cnt ; ++k ){
+                if( k == excluded )
+                    continue;
+                expected_f += lobes[k].F( wo , wi ) * lobes[k].GetEvalWeight();
+                expected_pdf += lobes[k].Pdf( wo , wi ) * lobes[k].GetSampleWeight();
+            }
+
+            Spectrum f;
+            auto pdf = 0.0f;
+            batch.Evaluate( wo , wi , &f , &pdf , excluded < batched_cnt ? &lobes[excluded] : nullptr );
+
+            EXPECT_NEAR( f[0] , expected_f[0] , 1e-3f * std::max( 1.0f , expected_f[0] ) );
+            EXPECT_NEAR( f[1] , expected_f[1] , 1e-3f * std::max( 1.0f , expected_f[1] ) );
+            EXPECT_NEAR( f[2] , expected_f[2] , 1e-3f * std::max( 1.0f , expected_f[2] ) );
+            EXPECT_NEAR( pdf , expected_pdf , 1e-3f * std::max( 1.0f , expected_pdf ) );
+        }
+    }
+}
+
+// Every finite half should survive a round trip through single precision, including denormalized ones.
+TEST(BXDF, HalfRoundTrip) {
+    for( auto h = 0u ; h < 0x10000 ; ++h ){
+        if( ( h & 0x7c00 ) == 0x7c00 )
+            continue;
+        const auto f = halfToFloat( (uint16_t)h );
+        EXPECT_EQ( floatToHalf( f ) , h );
+    }
+
+    // converting a float to half should pick the nearest half
+    for( auto i = 0 ; i < 65536 ; ++i ){
+        const auto f = ( sort_rand_float() * 2.0f - 1.0f ) * 65504.0f;
+        EXPECT_NEAR( halfToFloat( floatToHalf( f ) ) , f , std::max( fabs( f ) / 2048.0f , 1.0f / ( 1 << 25 ) ) );
+    }
+}
+
+// Denormalized halfs are multiples of 2^-24, anything smaller than half of it becomes zero.
+TEST(BXDF, HalfDenormal) {
+    const auto smallest = 1.0f / ( 1 << 24 );
+    EXPECT_EQ( halfToFloat( 0x0001 ) , smallest );
+    EXPECT_EQ( halfToFloat( 0x03ff ) , smallest * 1023.0f );
+    EXPECT_EQ( halfToFloat( 0x8001 ) , -smallest );
+    EXPECT_EQ( floatToHalf( smallest ) , 0x0001 );
+    EXPECT_EQ( floatToHalf( smallest * 1023.0f ) , 0x03ff );
+    EXPECT_EQ( floatToHalf( smallest * 0.25f ) , 0x0000 );
+    EXPECT_EQ( floatToHalf( -smallest * 0.25f ) , 0x8000 );
+
+    // the largest denormalized half rounds up to the smallest normalized half
+    EXPECT_EQ( floatToHalf( smallest * 1023.75f ) , 0x0400 );
+    EXPECT_EQ( halfToFloat( 0x0400 ) , smallest * 1024.0f );
+}
+
+// Infinity and NaN are preserved, finite values out of range are clamped to the largest finite half.
+TEST(BXDF, HalfInfNan) {
+    const auto inf = std::numeric_limits<float>::infinity();
+    EXPECT_EQ( floatToHalf( inf ) , 0x7c00 );
+    EXPECT_EQ( floatToHalf( -inf ) , 0xfc00 );
+    EXPECT_EQ( halfToFloat( 0x7c00 ) , inf );
+    EXPECT_EQ( halfToFloat( 0xfc00 ) , -inf );
+
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+    EXPECT_EQ( floatToHalf( nan ) & 0x7c00 , 0x7c00 );
+    EXPECT_NE( floatToHalf( nan ) & 0x03ff , 0 );
+    EXPECT_TRUE( IsNan( halfToFloat( floatToHalf( nan ) ) ) );
+    EXPECT_TRUE( IsNan( halfToFloat( 0x7e00 ) ) );
+
+    EXPECT_EQ( floatToHalf( 65504.0f ) , 0x7bff );
+    EXPECT_EQ( floatToHalf( 1e10f ) , 0x7bff );
+    EXPECT_EQ( floatToHalf( -1e10f ) , 0xfbff );
+    EXPECT_EQ( halfToFloat( 0x7bff ) , 65504.0f );
+}
+
+// A synthetic MERL table with a glossy lobe, it only depends on the half angle, which makes it exactly reciprocal.
+static std::vector<unsigned char> createMerlData(){
+    const unsigned int dims[3] = { 90 , 90 , 180 };
+    const auto trunksize = dims[0] * dims[1] * dims[2];
+    const double scale[3] = { 0.0006666666666667 , 0.000766666666666667 , 0.0011066666666666667 };
+    const double albedo[3] = { 1.0 , 0.8 , 0.6 };
+
+    std::vector<unsigned char> data( sizeof( dims ) + sizeof( double ) * 3u * trunksize );
+    memcpy( data.data() , dims , sizeof( dims ) );
+    for( auto c = 0u ; c < 3u ; ++c ){
+        for( auto i = 0u ; i < trunksize ; ++i ){
+            // bins of half angle theta are distributed quadratically
+            const auto h = i / ( dims[1] * dims[2] );
+            const auto theta_h = SQR( ( h + 0.5f ) / dims[0] ) * HALF_PI;
+            const auto brdf = albedo[c] * ( 0.05 + 0.2 * exp( -SQR( theta_h ) / 0.2 ) );
+
+            const auto value = brdf / scale[c];
+            memcpy( data.data() + sizeof( dims ) + sizeof( double ) * ( (size_t)c * trunksize + i ) , &value , sizeof( double ) );
+        }
+    }
+    return data;
+}
+
+TEST(BXDF, Merl) {
+    const auto raw = createMerlData();
+    MerlData data;
+    ASSERT_TRUE( data.LoadData( raw.data() , raw.size() ) );
+    EXPECT_FALSE( MerlData().LoadData( raw.data() , raw.size() - 1 ) );
+
+    auto& rc = GetRenderContext();
+    ClosureTypeMERL params;
+    params.merl_data = &data;
+    params.normal = { 0.0f , 1.0f , 0.0f };
+    Merl merl( rc , params , FULL_WEIGHT );
+    checkAll( &merl );
+}
@@ -78,3 +78,81 @@ TEST(DISTRIBUTION, ClearcoatGGX) {
     checkAll(&cggx);
 }
 #endif
+
+// Alias table should pick each bucket with its normalized probability
+TEST(DISTRIBUTION, AliasTable) {
+    const float weights[] = { 1.0f , 0.0f , 3.0f , 0.5f , 2.5f , 0.0f , 4.0f , 1.0f };
+    const auto n = (unsigned)( sizeof( weights ) / sizeof( weights[0] ) );
+    const AliasTable table( weights , n );
+
+    EXPECT_NEAR( table.GetSum() , 12.0f , 0.0001f );
+
+    constexpr unsigned TOTAL = 1 << 20;
+    unsigned counts[n] = { 0 };
+    for( unsigned i = 0 ; i < TOTAL ; ++i ){
+        float pdf = 0.0f , remapped = 0.0f;
+        const auto id = table.SampleDiscrete( ( i + 0.5f ) / TOTAL , &pdf , &remapped );
+        ASSERT_TRUE( id >= 0 && id < (int)n );
+        EXPECT_GT( pdf , 0.0f );
+        EXPECT_FLOAT_EQ( pdf , table.GetProperty( id ) );
+        EXPECT_TRUE( remapped >= 0.0f && remapped < 1.0f );
+        ++counts[id];
+    }
+
+    for( unsigned i = 0 ; i < n ; ++i ){
+        EXPECT_NEAR( table.GetProperty( i ) , weights[i] / 12.0f , 0.0001f );
+        EXPECT_NEAR( (float)counts[i] / TOTAL , weights[i] / 12.0f , 0.001f );
+    }
+}
+
+// The pdf of the 2D alias distribution should integrate to one and match the sampled pdf
+TEST(DISTRIBUTION, AliasDistribution2D) {
+    constexpr unsigned NU = 16 , NV = 8;
+    float data[NU * NV];
+    for( unsigned i = 0 ; i < NU * NV ; ++i )
+        data[i] = (float)( ( i * 7 ) % 5 );
+    const AliasDistribution2D dist( data , NU , NV );
+
+    double total = 0.0;
+    for( unsigned i = 0 ; i < NV ; ++i )
+        for( unsigned j = 0 ; j < NU ; ++j )
+            total += dist.Pdf( ( j + 0.5f ) / NU , ( i + 0.5f ) / NV ) / ( NU * NV );
+    EXPECT_NEAR( total , 1.0 , 0.0001 );
+
+    auto& rc = GetRenderContext();
+    for( unsigned i = 0 ; i < 1024 ; ++i ){
+        float uv[2] , pdf = 0.0f;
+        dist.SampleContinuous( sort_rand<float>(rc) , sort_rand<float>(rc) , uv , &pdf );
+        EXPECT_GT( pdf , 0.0f );
+        EXPECT_NEAR( pdf , dist.Pdf( uv[0] , uv[1] ) , 0.0001f );
+    }
+}
+
+// Samples should be uniformly distributed within their cells even for a sky sized map
+TEST(DISTRIBUTION, AliasDistribution2DLarge) {
+    constexpr unsigned NU = 2048 , NV = 1024 , SUB = 64;
+    std::vector<float> data( NU * NV );
+    for( unsigned i = 0 ; i < NU * NV ; ++i )
+        data[i] = 1.0f + (float)( ( i * 2654435761u ) % 97 );
+    const AliasDistribution2D dist( data.data() , NU , NV );
+
+    // histogram of the sample positions within their cells along both axes
+    constexpr unsigned TOTAL = 1 << 20;
+    std::vector<unsigned> sub_u( SUB , 0 ) , sub_v( SUB , 0 );
+    auto& rc = GetRenderContext();
+    for( unsigned i = 0 ; i < TOTAL ; ++i ){
+        float uv[2] , pdf = 0.0f;
+        dist.SampleContinuous( sort_rand<float>(rc) , sort_rand<float>(rc) , uv , &pdf );
+        ASSERT_GT( pdf , 0.0f );
+        EXPECT_NEAR( pdf , dist.Pdf( uv[0] , uv[1] ) , pdf * 0.0001f );
+
+        const auto fu = (double)uv[0] * NU , fv = (double)uv[1] * NV;
+        ++sub_u[ std::min( (unsigned)( ( fu - floor( fu ) ) * SUB ) , SUB - 1 ) ];
+        ++sub_v[ std::min( (unsigned)( ( fv - floor( fv ) ) * SUB ) , SUB - 1 ) ];
+    }
+
+    for( unsigned i = 0 ; i < SUB ; ++i ){
+        EXPECT_NEAR( (double)sub_u[i] * SUB / TOTAL , 1.0 , 0.05 );
+        EXPECT_NEAR( (double)sub_v[i] * SUB / TOTAL , 1.0 , 0.05 );
+    }
+}
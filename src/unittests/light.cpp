@@ -0,0 +1,135 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "thirdparty/gtest/gtest.h"
+#include "unittest_common.h"
+#include "core/scene.h"
+#include "core/samplemethod.h"
+#include "entity/visual.h"
+#include "light/meshlight.h"
+#include "sampler/sample.h"
+
+using namespace unittest;
+
+// A single triangle facing down to the origin, the triangle is in the plane y = 1.
+static std::unique_ptr<MeshVisual> createTriangleVisual(){
+    auto mesh = std::make_unique<Mesh>();
+    const Point positions[] = { Point( 0.0f , 1.0f , 0.0f ) , Point( 1.0f , 1.0f , 0.0f ) , Point( 0.0f , 1.0f , 1.0f ) };
+    for( const auto& position : positions ){
+        MeshVertex vertex;
+        vertex.m_position = position;
+        vertex.m_normal = Vector( 0.0f , -1.0f , 0.0f );
+        mesh->m_vertices.push_back( vertex );
+    }
+
+    MeshFaceIndex index;
+    index.m_id[0] = 0;
+    index.m_id[1] = 1;
+    index.m_id[2] = 2;
+    mesh->m_indices.push_back( index );
+
+    auto visual = std::make_unique<MeshVisual>();
+    visual->SetMesh( std::move(mesh) );
+    visual->ApplyTransform( Transform() );
+    return visual;
+}
+
+// Solid angle subtended by a triangle viewed from a point, by Van Oosterom and Strackee.
+static double triangleSolidAngle( const Point& p , const Point& p0 , const Point& p1 , const Point& p2 ){
+    const auto a = p0 - p , b = p1 - p , c = p2 - p;
+    const auto la = a.Length() , lb = b.Length() , lc = c.Length();
+    const auto numerator = fabs( dot( a , cross( b , c ) ) );
+    const auto denominator = la * lb * lc + dot( a , b ) * lc + dot( a , c ) * lb + dot( b , c ) * la;
+    return 2.0 * atan2( numerator , denominator );
+}
+
+// Sampling a point on the triangle from a shading point should cover exactly the solid angle of the triangle.
+TEST(LIGHT, TriangleSamplePdf) {
+    const auto visual = createTriangleVisual();
+    const auto triangle = visual->m_triangles[0].get();
+
+    const Point p( 0.2f , 0.0f , 0.3f );
+    const auto solid_angle = triangleSolidAngle( p , Point( 0.0f , 1.0f , 0.0f ) , Point( 1.0f , 1.0f , 0.0f ) , Point( 0.0f , 1.0f , 1.0f ) );
+
+    const auto total = ParrallReduction<double, 8, 1024 * 128>( [&](){
+        auto& rc = GetRenderContext();
+        const LightSample ls(rc);
+
+        Vector wi , n;
+        float pdf = 0.0f;
+        triangle->Sample_l( ls , p , wi , n , &pdf );
+        return pdf > 0.0f ? 1.0 / pdf : 0.0;
+    } );
+    EXPECT_NEAR( total , solid_angle , solid_angle * 0.01 );
+}
+
+// The pdf of a sampled direction has to match what the light reports for the same direction for MIS to work.
+TEST(LIGHT, TriangleLightPdfConsistency) {
+    const auto visual = createTriangleVisual();
+    const RGBSpectrum radiance( 2.0f , 3.0f , 4.0f );
+    TriangleLight light( visual->m_triangles[0].get() , radiance );
+    light.Setup();
+
+    Scene scene;
+    auto& rc = GetRenderContext();
+    const Point p( 0.2f , 0.0f , 0.3f );
+    for( auto i = 0 ; i < 1024 ; ++i ){
+        const LightSample ls(rc);
+
+        Vector wi;
+        float distance = 0.0f , pdf = 0.0f;
+        Visibility visibility(scene);
+        const auto le = light.sample_l( p , &ls , wi , &distance , &pdf , nullptr , nullptr , visibility );
+        ASSERT_GT( pdf , 0.0f );
+        EXPECT_EQ( le.GetIntensity() , radiance.GetIntensity() );
+        EXPECT_NEAR( light.Pdf( p , wi ) , pdf , pdf * 0.001f );
+
+        // the ray towards the sampled point hits the triangle with the same radiance
+        Spectrum hit_radiance;
+        SurfaceInteraction intersect;
+        EXPECT_TRUE( light.Le( Ray( p , wi ) , &intersect , hit_radiance ) );
+        EXPECT_EQ( hit_radiance.GetIntensity() , radiance.GetIntensity() );
+    }
+
+    // the back side doesn't emit anything
+    EXPECT_EQ( light.Pdf( Point( 0.2f , 2.0f , 0.3f ) , Vector( 0.0f , -1.0f , 0.0f ) ) , 0.0f );
+}
+
+// Integrating the radiance of emitted rays over their pdf should give the flux of a lambertian emitter.
+TEST(LIGHT, TriangleLightEmittedPower) {
+    const auto visual = createTriangleVisual();
+    const RGBSpectrum radiance( 2.0f , 3.0f , 4.0f );
+    TriangleLight light( visual->m_triangles[0].get() , radiance );
+    light.Setup();
+
+    const auto total = ParrallReduction<double, 8, 1024 * 128>( [&](){
+        auto& rc = GetRenderContext();
+        const LightSample ls(rc);
+
+        Ray r;
+        float pdf_w = 0.0f , cos_at_light = 0.0f;
+        const auto le = light.sample_l( rc , ls , r , &pdf_w , nullptr , &cos_at_light );
+        return pdf_w > 0.0f ? le.GetIntensity() * cos_at_light / pdf_w : 0.0;
+    } );
+
+    // the area of the triangle is 0.5
+    const auto expected = PI * 0.5 * radiance.GetIntensity();
+    EXPECT_NEAR( total , expected , expected * 0.01 );
+
+    // Power is only used to pick lights relative to each other, it follows the same convention as area lights.
+    EXPECT_NEAR( light.Power().GetIntensity() , TWO_PI * 0.5f * radiance.GetIntensity() , 0.001f );
+}
@@ -0,0 +1,115 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include "thirdparty/gtest/gtest.h"
+#include "material/volume_table.h"
+
+// A smooth volume shader peaking at a few places, it stands in for an actual shader so that no shader compiler is needed.
+static void evaluateVolume( const float density , MediumSample& ms ){
+    ms.basecolor = RGBSpectrum( 1.0f , 0.5f , 0.25f );
+    ms.absorption = 0.5f * density;
+    ms.scattering = 1.0f + density + std::sin( 3.0f * density );
+    ms.extinction = ms.absorption + ms.scattering;
+    ms.emission = 0.1f * density;
+    ms.anisotropy = 0.3f;
+}
+
+// Looking up the table should match evaluating the shader, densities beyond the table are evaluated by the shader.
+TEST(MEDIUM, VolumeShaderTableLookup) {
+    VolumeShaderTable table;
+    EXPECT_FALSE( table.IsValid() );
+    table.Build( evaluateVolume );
+    EXPECT_TRUE( table.IsValid() );
+
+    for( auto i = 0u ; i <= 4096 ; ++i ){
+        const auto density = 6.0f * i / 4096;
+
+        MediumSample expected , actual;
+        evaluateVolume( density , expected );
+        table.Evaluate( density , actual );
+
+        const auto tolerance = density < VolumeShaderTable::MAX_DENSITY ? 1e-4f : 0.0f;
+        EXPECT_NEAR( actual.extinction , expected.extinction , tolerance );
+        EXPECT_NEAR( actual.scattering , expected.scattering , tolerance );
+        EXPECT_NEAR( actual.absorption , expected.absorption , tolerance );
+        EXPECT_NEAR( actual.emission , expected.emission , tolerance );
+        EXPECT_NEAR( actual.anisotropy , expected.anisotropy , tolerance );
+        EXPECT_NEAR( actual.basecolor.GetMaxComponent() , expected.basecolor.GetMaxComponent() , tolerance );
+    }
+}
+
+// Base color and extinction changing in opposite directions between entries, their interpolated product peaks
+// between entries instead of at them.
+static void evaluateVolumeOpposite( const float density , MediumSample& ms ){
+    const auto phase = density * ( VolumeShaderTable::SIZE - 1 ) / VolumeShaderTable::MAX_DENSITY * 2.5f;
+    ms.basecolor = RGBSpectrum( 0.5f + 0.5f * std::cos( phase ) , 0.25f , 0.25f );
+    ms.absorption = 0.0f;
+    ms.scattering = 1.0f - std::cos( phase );
+    ms.extinction = ms.absorption + ms.scattering;
+}
+
+// The majorant of a region has to bound the extinction of every density inside it. Interpolated lookups are strictly
+// bounded, shaders peaking between two entries could exceed the bound slightly without the lookup table.
+TEST(MEDIUM, VolumeShaderTableMajorant) {
+    VolumeShaderTable table;
+    table.Build( evaluateVolume );
+
+#ifdef SORT_ENABLE_VOLUME_SHADER_LUT
+    constexpr auto tolerance = 0.0f;
+#else
+    constexpr auto tolerance = 1e-4f;
+#endif
+
+    for( auto i = 0u ; i <= 256 ; ++i ){
+        const auto max_density = VolumeShaderTable::MAX_DENSITY * i / 256;
+        const auto majorant = table.GetMajorant( max_density );
+        for( auto j = 0u ; j <= 256 ; ++j ){
+            MediumSample ms;
+            table.Evaluate( max_density * j / 256 , ms );
+            EXPECT_GE( majorant * ( 1.0f + tolerance ) , ( ms.basecolor * ms.extinction ).GetMaxComponent() );
+        }
+    }
+
+    // The bound beyond the table is extrapolated, it is not exact and tracking handles what exceeds it. It still
+    // never shrinks with higher densities.
+    auto majorant = table.GetMajorant( VolumeShaderTable::MAX_DENSITY );
+    for( auto i = 1u ; i <= 256 ; ++i ){
+        const auto next = table.GetMajorant( VolumeShaderTable::MAX_DENSITY * ( 1.0f + 0.25f * i ) );
+        EXPECT_GE( next , majorant );
+        majorant = next;
+    }
+}
+
+#ifdef SORT_ENABLE_VOLUME_SHADER_LUT
+// The majorant has to bound what lookups return between entries, not only the entries themselves.
+TEST(MEDIUM, VolumeShaderTableInterpolatedMajorant) {
+    VolumeShaderTable table;
+    table.Build( evaluateVolumeOpposite );
+
+    constexpr auto SUB = 64u;
+    for( auto i = 0u ; i < 64u ; ++i ){
+        const auto max_density = VolumeShaderTable::MAX_DENSITY * ( i + 1 ) / ( VolumeShaderTable::SIZE - 1 );
+        const auto majorant = table.GetMajorant( max_density );
+        for( auto j = 0u ; j <= SUB ; ++j ){
+            MediumSample ms;
+            table.Evaluate( max_density * ( i * SUB + j ) / ( ( i + 1 ) * SUB ) , ms );
+            EXPECT_GE( majorant * ( 1.0f + 1e-5f ) , ( ms.basecolor * ms.extinction ).GetMaxComponent() );
+        }
+    }
+}
+#endif
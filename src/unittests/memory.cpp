@@ -50,4 +50,23 @@ TEST(Memory, AlignedAllocation_ZeroInput) {
 
     // this line should do nothing.
     free_aligned( ret );
-}
\ No newline at end of file
+}
+// Memory from the memory allocator should be aligned to what the type requires.
+TEST(Memory, AllocatorAlignment) {
+    struct alignas(16) Aligned16 {
+        float   data[4];
+    };
+
+    MemoryAllocator allocator;
+    for( auto i = 0 ; i < 4096 ; ++i ){
+        // odd sized allocations in between shift the position of the next one
+        allocator.Allocate<char>( 1 + i % 7 );
+
+        const auto ret = allocator.Allocate<Aligned16>( 1 + i % 3 );
+        EXPECT_EQ( ((uintptr_t)ret) % alignof(Aligned16) , (uintptr_t)0 );
+    }
+
+    allocator.Reset();
+    allocator.Allocate<char>( 3 );
+    EXPECT_EQ( ((uintptr_t)allocator.Allocate<Aligned16>()) % alignof(Aligned16) , (uintptr_t)0 );
+}
@@ -0,0 +1,175 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "thirdparty/gtest/gtest.h"
+#include "core/trace_profiler.h"
+
+// Count the occurrences of a string in a file.
+static unsigned countInFile(const char* filename, const std::string& str) {
+    std::ifstream file(filename);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    const auto content = ss.str();
+
+    auto cnt = 0u;
+    for (auto pos = content.find(str); pos != std::string::npos; pos = content.find(str, pos + str.size()))
+        ++cnt;
+    return cnt;
+}
+
+// Begin and end time of all events with a name in a dumped trace, each event is on its own line.
+static std::vector<std::pair<double, double>> eventTimes(const char* filename, const std::string& name) {
+    std::vector<std::pair<double, double>> times;
+    std::ifstream file(filename);
+    const auto key = "{\"name\":\"" + name + "\",";
+    for (std::string line; std::getline(file, line);) {
+        const auto pos = line.find("\"ts\":");
+        if (line.compare(0, key.size(), key) != 0 || pos == std::string::npos)
+            continue;
+
+        double ts = 0.0, dur = 0.0;
+        if (sscanf(line.c_str() + pos, "\"ts\":%lf,\"dur\":%lf", &ts, &dur) == 2)
+            times.emplace_back(ts, ts + dur);
+    }
+    return times;
+}
+
+// Scopes should only be recorded when the profiler is enabled and end up in the trace of the right thread.
+TEST(PROFILER, TraceScope) {
+    const auto was_enabled = TraceProfilerIsEnabled();
+    const auto filename = "sort_unittest_trace.json";
+
+    // naming a thread or starting a scope with the profiler disabled doesn't allocate anything
+    TraceProfilerEnable(false);
+    const auto buffer_cnt = TraceProfilerBufferCount();
+    std::thread([]() {
+        TraceProfilerSetThreadName("Disabled Thread");
+        TraceScope scope("Disabled Scope");
+    }).join();
+    EXPECT_EQ(TraceProfilerBufferCount(), buffer_cnt);
+
+    TraceProfilerEnable(true);
+    std::thread([]() {
+        TraceProfilerSetThreadName("Enabled Thread");
+        TraceProfilerSetTask(7);
+        for (auto i = 0; i < 3; ++i) {
+            TraceScope scope(std::string("Enabled \"Scope\""));
+            TraceScope inner("Inner Scope");
+        }
+    }).join();
+    TraceProfilerEnable(was_enabled);
+
+    EXPECT_GT(TraceProfilerDump(filename), 0u);
+    EXPECT_EQ(countInFile(filename, "\"Disabled Scope\""), 0u);
+    EXPECT_EQ(countInFile(filename, "\"Disabled Thread\""), 0u);
+    EXPECT_EQ(countInFile(filename, "\"Enabled \\\"Scope\\\"\""), 3u);
+    EXPECT_EQ(countInFile(filename, "\"Inner Scope\""), 3u);
+    EXPECT_EQ(countInFile(filename, "\"Enabled Thread\""), 1u);
+    EXPECT_EQ(countInFile(filename, "\"task\":7"), 6u);
+    remove(filename);
+}
+
+// Only the latest events are kept once the ring buffer is full.
+TEST(PROFILER, RingBuffer) {
+    const auto was_enabled = TraceProfilerIsEnabled();
+    const auto filename = "sort_unittest_trace.json";
+
+    TraceProfilerEnable(true);
+    std::thread([]() {
+        for (auto i = 0u; i < TRACE_EVENT_BUFFER_SIZE + 10; ++i)
+            TraceScope scope(i < 10 ? "Old Scope" : "New Scope");
+    }).join();
+    TraceProfilerEnable(was_enabled);
+
+    TraceProfilerDump(filename);
+    EXPECT_EQ(countInFile(filename, "\"Old Scope\""), 0u);
+    EXPECT_EQ(countInFile(filename, "\"New Scope\""), TRACE_EVENT_BUFFER_SIZE);
+    remove(filename);
+}
+
+// Buffers of threads that are gone are reused, events recorded before are still dumped with the right thread.
+TEST(PROFILER, BufferReuse) {
+    const auto was_enabled = TraceProfilerIsEnabled();
+    const auto filename = "sort_unittest_trace.json";
+
+    TraceProfilerEnable(true);
+    std::thread([]() {
+        TraceProfilerSetThreadName("First Thread");
+        TraceScope scope("First Scope");
+    }).join();
+
+    const auto buffer_cnt = TraceProfilerBufferCount();
+    for (auto i = 0; i < 4; ++i) {
+        std::thread([]() {
+            TraceProfilerSetThreadName("Next Thread");
+            TraceScope scope("Next Scope");
+        }).join();
+    }
+    TraceProfilerEnable(was_enabled);
+    EXPECT_EQ(TraceProfilerBufferCount(), buffer_cnt);
+
+    TraceProfilerDump(filename);
+    EXPECT_EQ(countInFile(filename, "\"First Scope\""), 1u);
+    EXPECT_EQ(countInFile(filename, "\"First Thread\""), 1u);
+    EXPECT_EQ(countInFile(filename, "\"Next Scope\""), 4u);
+    EXPECT_EQ(countInFile(filename, "\"Next Thread\""), 4u);
+    remove(filename);
+}
+
+// Scopes of a suspended task are closed, whatever the thread executes in the meantime never overlaps with them.
+TEST(PROFILER, SuspendTask) {
+    const auto was_enabled = TraceProfilerIsEnabled();
+    const auto filename = "sort_unittest_trace.json";
+
+    TraceProfilerEnable(true);
+    std::thread([]() {
+        TraceScope thread_scope("Thread Scope");
+
+        TraceProfilerResumeTask(3, nullptr);
+        {
+            TraceScope scope("Suspended Scope");
+            auto scopes = TraceProfilerSuspendTask();
+            EXPECT_NE(scopes, nullptr);
+
+            // the thread executes something else while the task is suspended
+            TraceProfilerResumeTask(4, nullptr);
+            { TraceScope other("Other Scope"); }
+            EXPECT_EQ(TraceProfilerSuspendTask(), nullptr);
+
+            TraceProfilerResumeTask(3, scopes);
+        }
+        EXPECT_EQ(TraceProfilerSuspendTask(), nullptr);
+    }).join();
+    TraceProfilerEnable(was_enabled);
+
+    TraceProfilerDump(filename);
+    const auto suspended = eventTimes(filename, "Suspended Scope");
+    const auto other = eventTimes(filename, "Other Scope");
+    ASSERT_EQ(suspended.size(), 2u);
+    ASSERT_EQ(other.size(), 1u);
+    for (const auto& event : suspended)
+        EXPECT_TRUE(event.second <= other[0].first || event.first >= other[0].second);
+    EXPECT_EQ(countInFile(filename, "\"task\":3"), 2u);
+    EXPECT_EQ(countInFile(filename, "\"Thread Scope\""), 1u);
+    remove(filename);
+}
@@ -15,8 +15,15 @@
     this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
 #include "thirdparty/gtest/gtest.h"
 #include "job/scheduler.h"
+#include "job/task_graph.h"
 
 //! @brief  Helper class that setup the bind and unbind for the class
 struct SchedulerWrapper {
@@ -81,4 +88,248 @@ TEST(SchedulerTest, RecursiveSchedule) {
     sw.scheduler.Stop();
 
     EXPECT_EQ(k, 7);
-}
\ No newline at end of file
+}
+
+// Owner pops in LIFO order while thieves steal in FIFO order, the buffer should grow without losing anything.
+TEST(SchedulerTest, WorkStealingDeque) {
+    constexpr auto N = 100;
+    int data[N];
+
+    WorkStealingDeque<int> deque(4);
+    EXPECT_EQ(deque.Pop(), nullptr);
+    EXPECT_EQ(deque.Steal(), nullptr);
+
+    for (auto i = 0; i < N; ++i)
+        deque.Push(data + i);
+    EXPECT_EQ(deque.Steal(), data);
+    EXPECT_EQ(deque.Steal(), data + 1);
+    for (auto i = N - 1; i >= 2; --i)
+        EXPECT_EQ(deque.Pop(), data + i);
+
+    EXPECT_EQ(deque.Pop(), nullptr);
+    EXPECT_TRUE(deque.IsEmpty());
+}
+
+// Every element should be taken exactly once, no matter whether it is popped by the owner or stolen by others.
+TEST(SchedulerTest, WorkStealingDequeConcurrent) {
+    constexpr auto N = 100000;
+    constexpr auto THIEF_CNT = 4;
+    std::vector<int> data(N, 0);
+    std::vector<std::atomic<int>> taken(N);
+
+    WorkStealingDeque<int> deque(16);
+    std::atomic<bool> done = false;
+    std::vector<std::thread> thieves;
+    for (auto i = 0; i < THIEF_CNT; ++i) {
+        thieves.emplace_back([&]() {
+            while (!done || !deque.IsEmpty()) {
+                if (auto p = deque.Steal())
+                    ++taken[p - data.data()];
+            }
+        });
+    }
+
+    for (auto i = 0; i < N; ++i) {
+        deque.Push(data.data() + i);
+        if (i % 3 == 0) {
+            if (auto p = deque.Pop())
+                ++taken[p - data.data()];
+        }
+    }
+    while (auto p = deque.Pop())
+        ++taken[p - data.data()];
+
+    done = true;
+    for (auto& thief : thieves)
+        thief.join();
+
+    for (auto i = 0; i < N; ++i)
+        EXPECT_EQ(taken[i], 1);
+}
+
+// A lot of tasks spawning more tasks, all of them should be executed exactly once.
+TEST(SchedulerTest, ManyTasks) {
+    SchedulerWrapper sw;
+
+    constexpr auto N = 64;
+    std::atomic<int> k = 0;
+    for (auto i = 0; i < N; ++i) {
+        schedule_parallel([&k](int cnt) {
+            for (auto j = 0; j < cnt; ++j)
+                schedule_parallel([&k]() { ++k; });
+            ++k;
+        }, N);
+    }
+
+    sw.scheduler.Begin();
+    sw.scheduler.Stop();
+
+    EXPECT_EQ(k, N * N + N);
+}
+
+// Tasks enqueued in a task go to the deque of the slave worker, which runs the most recent one first. Tasks enqueued
+// by other threads go to the external queue, which runs them in order. With a single slave worker, nothing is
+// stolen and the order tells which queue tasks go to.
+TEST(SchedulerTest, TasksInTaskGoToWorkerDeque) {
+    SchedulerConfig cfg;
+    cfg.slave_thread_cnt = 1;
+
+    SchedulerWrapper sw;
+    sw.scheduler.SetupConfig(cfg);
+
+    constexpr auto N = 16;
+    std::vector<int> external_order, worker_order;
+    for (auto i = 0; i < N; ++i)
+        schedule_parallel([&external_order, i]() { external_order.push_back(i); });
+
+    schedule_parallel([&]() {
+        for (auto i = 0; i < N; ++i)
+            schedule_parallel([&worker_order, i]() { worker_order.push_back(i); });
+    });
+
+    sw.scheduler.Begin();
+    sw.scheduler.Stop();
+
+    ASSERT_EQ(external_order.size(), (size_t)N);
+    ASSERT_EQ(worker_order.size(), (size_t)N);
+    for (auto i = 0; i < N; ++i) {
+        EXPECT_EQ(external_order[i], i);
+        EXPECT_EQ(worker_order[i], N - 1 - i);
+    }
+}
+
+// Tasks spawned on one slave worker and finished on others go back to the pool they come from, a pool keeps
+// reusing its tasks instead of growing.
+TEST(SchedulerTest, TaskPoolRecycling) {
+    TaskPool pool;
+    std::vector<Task*> tasks;
+    for (auto i = 0; i < 512; ++i)
+        tasks.push_back(pool.Allocate());
+
+    // all tasks are freed on another thread
+    std::thread([&]() {
+        for (auto task : tasks)
+            TaskPool::Free(task, false);
+    }).join();
+
+    std::vector<Task*> reused;
+    for (auto i = 0; i < 512; ++i)
+        reused.push_back(pool.Allocate());
+
+    std::sort(tasks.begin(), tasks.end());
+    std::sort(reused.begin(), reused.end());
+    EXPECT_EQ(tasks, reused);
+}
+
+// Slave workers without anything to do shouldn't keep burning the CPU while a long task is running.
+TEST(SchedulerTest, IdleWorkersSleep) {
+    SchedulerConfig cfg;
+    cfg.slave_thread_cnt = 4;
+
+    SchedulerWrapper sw;
+    sw.scheduler.SetupConfig(cfg);
+
+    constexpr auto duration = std::chrono::milliseconds(200);
+    schedule_parallel([&]() {
+        std::this_thread::sleep_for(duration);
+    });
+
+    const auto cpu_start = std::clock();
+    sw.scheduler.Begin();
+    sw.scheduler.Stop();
+    const auto cpu_time = (double)(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    // spinning slave workers would take three times the duration of the task in total
+    EXPECT_LT(cpu_time, 0.1);
+}
+
+// Waiting in a task should pause it until all tasks it spawns are done.
+TEST(SchedulerTest, WaitGroupInTask) {
+    SchedulerWrapper sw;
+
+    constexpr auto N = 32;
+    std::atomic<int> k = 0;
+    int result = 0;
+    schedule_parallel([&]() {
+        WaitGroup wg(N);
+        for (auto i = 0; i < N; ++i) {
+            schedule_parallel([&]() {
+                // yielding in the middle should not stop the task from finishing
+                ++k;
+                Scheduler::Yield();
+                ++k;
+                wg.Done();
+            });
+        }
+        wg.Wait();
+        result = k;
+    });
+
+    sw.scheduler.Begin();
+    sw.scheduler.Stop();
+
+    EXPECT_EQ(result, 2 * N);
+}
+
+// Tasks in the graph should never start before their dependencies are done.
+TEST(SchedulerTest, TaskGraph) {
+    SchedulerWrapper sw;
+
+    std::atomic<int> order = 0;
+    int a = -1, b = -1, c = -1, d = -1;
+    std::atomic<int> spawned = 0;
+
+    TaskGraph graph;
+    const auto na = graph.AddTask([&]() { a = order++; }, "a");
+    const auto nb = graph.AddTask([&]() {
+        // tasks in the graph can spawn and wait for more tasks
+        WaitGroup wg(8);
+        for (auto i = 0; i < 8; ++i)
+            schedule_parallel([&]() { ++spawned; wg.Done(); });
+        wg.Wait();
+        b = order++;
+    }, "b");
+    const auto nc = graph.AddTask([&]() { c = order++; }, "c");
+    const auto nd = graph.AddTask([&]() { d = order++; }, "d");
+    graph.Precede(na, nb);
+    graph.Precede(na, nc);
+    graph.Precede(nb, nd);
+    graph.Precede(nc, nd);
+    graph.Run();
+
+    sw.scheduler.Begin();
+    sw.scheduler.Stop();
+
+    EXPECT_TRUE(graph.IsDone());
+    EXPECT_EQ(a, 0);
+    EXPECT_LT(a, b);
+    EXPECT_LT(a, c);
+    EXPECT_EQ(d, 3);
+    EXPECT_EQ(spawned, 8);
+}
+
+// Tasks scheduled on any NUMA node should be executed, no matter how many nodes there are.
+TEST(SchedulerTest, NumaScheduling) {
+    ASSERT_GE(GetNumaNodeCount(), 1u);
+    for (auto node = 0u; node < GetNumaNodeCount(); ++node)
+        EXPECT_FALSE(GetNumaNodeProcessors(node).empty());
+
+    SchedulerConfig cfg;
+    cfg.numa_aware = true;
+
+    SchedulerWrapper sw;
+    sw.scheduler.SetupConfig(cfg);
+
+    constexpr auto N = 256;
+    std::atomic<int> k = 0;
+    schedule_parallel([&]() {
+        for (auto i = 0u; i < N; ++i)
+            schedule_on_node(i % 4, [&]() { ++k; });
+    });
+
+    sw.scheduler.Begin();
+    sw.scheduler.Stop();
+
+    EXPECT_EQ(k, N);
+    EXPECT_LE(sw.scheduler.GetActiveNumaNodeCount(), GetNumaNodeCount());
+}
@@ -21,6 +21,19 @@
 #include "simd/simd_wrapper.h"
 #include "unittest_common.h"
 #include "job/fiber.h"
+#include "simd/simd_dispatch.h"
+
+#ifdef SIMD_BVH_IMPLEMENTATION
+#include <bitset>
+#include <random>
+#include "simd/simd_ray_utils.h"
+#include "simd/simd_bbox.h"
+#include "simd/simd_triangle.h"
+#include "entity/visual.h"
+#include "accel/accelerator.h"
+#include "core/samplemethod.h"
+#include "work/benchmark/procedural_scene.h"
+#endif
 
 using namespace unittest;
 
@@ -32,6 +45,14 @@ using namespace unittest;
     #endif
 #endif
 
+#ifdef SIMD_16WAY_IMPLEMENTATION
+    #ifdef SORT_X64_TARGET
+        #define SIMD_TEST       SIMD_AVX512
+    #else
+        #error "Undefined SIMD"
+    #endif
+#endif
+
 #ifdef SIMD_4WAY_IMPLEMENTATION
     #ifdef SORT_X64_TARGET
         #define SIMD_TEST       SIMD_SSE
@@ -42,11 +63,19 @@ using namespace unittest;
     #endif
 #endif
 
-#if defined( SIMD_4WAY_IMPLEMENTATION ) || defined( SIMD_8WAY_IMPLEMENTATION )
+#if defined( SIMD_4WAY_IMPLEMENTATION ) || defined( SIMD_8WAY_IMPLEMENTATION ) || defined( SIMD_16WAY_IMPLEMENTATION )
+
+#include "simd/simd_target_begin.h"
 
 static constexpr float nan_unsigned = 0xffc00000;
 static constexpr float nan_float = *((float*)(&nan_unsigned));
 
+// The tests are only supposed to run on CPUs supporting the SIMD width.
+TEST(SIMD_TEST, cpu_support) {
+    EXPECT_TRUE( IsSimdWidthSupported( SIMD_CHANNEL ) );
+    EXPECT_GE( GetSimdWidth() , (unsigned)SIMD_CHANNEL );
+}
+
 TEST(SIMD_TEST, simd_set_ps1) {
     constexpr float c_data = 2.0f;
     const auto simd_data = simd_set_ps1( c_data );
@@ -543,4 +572,190 @@ TEST(SIMD_TEST, fiber_split) {
     switchFiber(thread_fiber.get(), fiber.get());
 }
 
+#ifdef SIMD_BVH_IMPLEMENTATION
+
+// Rays start outside of the unit cube and point to a random position inside it.
+// Copying a ray doesn't keep its prepared data, the returned ray needs to be prepared before intersection tests.
+static Ray randomRay( std::mt19937& gen ){
+    std::uniform_real_distribution<float> dist( -1.0f , 1.0f );
+    const auto ori = Point( dist(gen) , dist(gen) , dist(gen) ) * 4.0f;
+    const auto target = Point( dist(gen) , dist(gen) , dist(gen) );
+    return Ray( ori , normalize( target - ori ) );
+}
+
+static Simd_BBox randomBBoxes( std::mt19937& gen , BBox bboxes[] , bool valid[] ){
+    std::uniform_real_distribution<float> dist( -1.0f , 1.0f );
+    float   min_x[SIMD_CHANNEL] , min_y[SIMD_CHANNEL] , min_z[SIMD_CHANNEL];
+    float   max_x[SIMD_CHANNEL] , max_y[SIMD_CHANNEL] , max_z[SIMD_CHANNEL];
+    for( auto i = 0 ; i < SIMD_CHANNEL ; ++i ){
+        const auto center = Point( dist(gen) , dist(gen) , dist(gen) );
+        const auto extent = Vector( dist(gen) + 1.0f , dist(gen) + 1.0f , dist(gen) + 1.0f ) * 0.25f;
+        bboxes[i] = BBox( center - extent , center + extent );
+        valid[i] = dist(gen) > -0.8f;
+
+        min_x[i] = bboxes[i].m_Min.x;
+        min_y[i] = bboxes[i].m_Min.y;
+        min_z[i] = bboxes[i].m_Min.z;
+        max_x[i] = bboxes[i].m_Max.x;
+        max_y[i] = bboxes[i].m_Max.y;
+        max_z[i] = bboxes[i].m_Max.z;
+    }
+
+    Simd_BBox simd_bbox;
+    simd_bbox.m_min_x = simd_set_ps( min_x );
+    simd_bbox.m_min_y = simd_set_ps( min_y );
+    simd_bbox.m_min_z = simd_set_ps( min_z );
+    simd_bbox.m_max_x = simd_set_ps( max_x );
+    simd_bbox.m_max_y = simd_set_ps( max_y );
+    simd_bbox.m_max_z = simd_set_ps( max_z );
+    simd_bbox.m_mask = simd_set_mask( valid );
+    return simd_bbox;
+}
+
+// A mesh with random triangles inside the unit cube.
+static std::unique_ptr<MeshVisual> randomMesh( std::mt19937& gen , unsigned int tri_cnt , std::vector<std::unique_ptr<Primitive>>& primitives ){
+    std::uniform_real_distribution<float> dist( -1.0f , 1.0f );
+    auto visual = std::make_unique<MeshVisual>();
+    visual->m_memory = std::make_unique<Mesh>();
+
+    auto& mesh = *visual->m_memory;
+    mesh.m_indices.resize( tri_cnt );
+    for( auto i = 0u ; i < tri_cnt ; ++i ){
+        const auto center = Point( dist(gen) , dist(gen) , dist(gen) );
+        for( auto j = 0 ; j < 3 ; ++j ){
+            MeshVertex vertex;
+            vertex.m_position = center + Vector( dist(gen) , dist(gen) , dist(gen) ) * 0.3f;
+            vertex.m_normal = Vector( 0.0f , 1.0f , 0.0f );
+            vertex.m_tangent = Vector( 1.0f , 0.0f , 0.0f );
+            mesh.m_indices[i].m_id[j] = (int)mesh.m_vertices.size();
+            mesh.m_vertices.push_back( vertex );
+        }
+    }
+
+    for( auto i = 0u ; i < tri_cnt ; ++i ){
+        visual->m_triangles.push_back( std::make_unique<Triangle>( visual.get() , mesh.m_indices[i] ) );
+        primitives.push_back( std::make_unique<Primitive>( &mesh , nullptr , visual->m_triangles.back().get() ) );
+    }
+    return visual;
+}
+
+// Ray bounding box intersection of all channels should match the scalar version.
+TEST(SIMD_TEST, bbox_intersection) {
+    std::mt19937 gen(0);
+    for( auto i = 0 ; i < 4096 ; ++i ){
+        BBox    bboxes[SIMD_CHANNEL];
+        bool    valid[SIMD_CHANNEL];
+        const auto simd_bbox = randomBBoxes( gen , bboxes , valid );
+
+        const auto ray = randomRay( gen );
+        ray.Prepare();
+        Simd_Ray_Data simd_ray;
+        resolveRayData( ray , simd_ray );
+
+        simd_data f_min;
+        const auto m = IntersectBBox_SIMD( ray , simd_ray , simd_bbox , f_min );
+        for( auto j = 0 ; j < SIMD_CHANNEL ; ++j ){
+            const auto t = Intersect( ray , bboxes[j] );
+            const auto hit = valid[j] && t >= 0.0f;
+            EXPECT_EQ( ( ( m >> j ) & 0x01 ) != 0 , hit );
+            if( hit )
+                EXPECT_NEAR( f_min[j] , t , 1e-4f );
+        }
+    }
+}
+
+// Ray triangle intersection of all channels should find the same nearest triangle as the scalar version.
+TEST(SIMD_TEST, triangle_intersection) {
+    std::mt19937 gen(0);
+    std::vector<std::unique_ptr<Primitive>> primitives;
+    const auto visual = randomMesh( gen , SIMD_CHANNEL * 16 , primitives );
+
+    std::vector<Simd_Triangle> tri_list;
+    Simd_Triangle simd_tri;
+    for( const auto& primitive : primitives ){
+        if( simd_tri.PushTriangle( primitive.get() ) && simd_tri.PackData() ){
+            tri_list.push_back( simd_tri );
+            simd_tri.Reset();
+        }
+    }
+    EXPECT_EQ( tri_list.size() , 16u );
+
+    for( auto i = 0 ; i < 4096 ; ++i ){
+        const auto ray = randomRay( gen );
+        ray.Prepare();
+        Simd_Ray_Data simd_ray;
+        resolveRayData( ray , simd_ray );
+
+        for( const auto& tri : tri_list ){
+            SurfaceInteraction simd_ret , scalar_ret;
+            const auto simd_hit = intersectTriangle_SIMD( ray , simd_ray , tri , &simd_ret );
+            const auto fast_hit = intersectTriangleFast_SIMD( ray , simd_ray , tri );
+
+            auto scalar_hit = false;
+            for( auto j = 0 ; j < SIMD_CHANNEL ; ++j )
+                scalar_hit |= tri.m_ori_pri[j]->GetIntersect( ray , &scalar_ret );
+
+            EXPECT_EQ( simd_hit , scalar_hit );
+            EXPECT_EQ( fast_hit , scalar_hit );
+            if( simd_hit && scalar_hit ){
+                EXPECT_EQ( simd_ret.primitive , scalar_ret.primitive );
+                EXPECT_NEAR( simd_ret.t , scalar_ret.t , 1e-4f );
+            }
+        }
+    }
+}
+
+// Name of the fast BVH with the current SIMD width.
+#if defined(SIMD_16WAY_IMPLEMENTATION)
+    #define SIMD_FAST_BVH   "Hbvh"
+#elif defined(SIMD_8WAY_IMPLEMENTATION)
+    #define SIMD_FAST_BVH   "Obvh"
+#else
+    #define SIMD_FAST_BVH   "Qbvh"
+#endif
+
+// Traversing the fast BVH of the current SIMD width should find the same intersections as the plain BVH.
+TEST(SIMD_TEST, fast_bvh_intersection) {
+    auto& rc = GetRenderContext();
+    for( auto type = 0u ; type < (unsigned)ProceduralSceneType::Count ; ++type ){
+        Scene scene;
+        GenerateProceduralScene( scene , (ProceduralSceneType)type , 0 , 0.05f );
+        scene.SetupScene( SID("Bvh") );
+
+        auto bvh = MakeUniqueInstance<Accelerator>( SID("Bvh") );
+        auto fast_bvh = MakeUniqueInstance<Accelerator>( StringID(SIMD_FAST_BVH) );
+        ASSERT_TRUE( bvh && fast_bvh );
+        bvh->Build( scene );
+        fast_bvh->Build( scene );
+        ASSERT_TRUE( bvh->GetIsValid() && fast_bvh->GetIsValid() );
+
+        // rays start inside the scene and point to all directions
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<float> dist( 0.0f , 1.0f );
+        const auto& bbox = scene.GetBBox();
+        for( auto i = 0 ; i < 4096 ; ++i ){
+            const auto ori = bbox.m_Min + ( bbox.m_Max - bbox.m_Min ) * Vector( dist(gen) , dist(gen) , dist(gen) );
+            const Ray ray( ori , UniformSampleSphere( dist(gen) , dist(gen) ) );
+
+            SurfaceInteraction bvh_ret , fast_ret;
+            const auto bvh_hit = bvh->GetIntersect( rc , ray , bvh_ret );
+            const auto fast_hit = fast_bvh->GetIntersect( rc , ray , fast_ret );
+            EXPECT_EQ( fast_hit , bvh_hit );
+#ifndef ENABLE_TRANSPARENT_SHADOW
+            EXPECT_EQ( fast_bvh->IsOccluded( ray ) , bvh_hit );
+#endif
+            if( bvh_hit && fast_hit ){
+                EXPECT_EQ( fast_ret.primitive , bvh_ret.primitive );
+                EXPECT_NEAR( fast_ret.t , bvh_ret.t , 1e-4f * std::max( 1.0f , bvh_ret.t ) );
+            }
+        }
+    }
+}
+
+#undef SIMD_FAST_BVH
+
+#endif
+
+#include "simd/simd_target_end.h"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <random>
+#include <thread>
+#include "thirdparty/gtest/gtest.h"
+#include "spectrum/sampledspectrum.h"
+
+// Average the color of a spectrum across stratified wavelength samples, which converges to the color of the spectrum.
+static RGBSpectrum averageColor(const RGBSpectrum& color) {
+    constexpr auto N = 4096;
+
+    RGBSpectrum total;
+    for (auto i = 0; i < N; ++i) {
+        SampledWavelengths::SetCurrent(SampledWavelengths::Sample((i + 0.5f) / N));
+        total += SampledSpectrum(color).ToRGB();
+    }
+    return total / (float)N;
+}
+
+// Wavelengths should be in the visible range and rotated versions of the hero wavelength.
+TEST(SPECTRUM, SampledWavelengths) {
+    for (auto i = 0; i < 1024; ++i) {
+        const auto wavelengths = SampledWavelengths::Sample((i + 0.5f) / 1024);
+        for (auto j = 0; j < SAMPLED_SPECTRUM_SAMPLE; ++j) {
+            EXPECT_GE(wavelengths.Lambda(j), SPECTRUM_LAMBDA_MIN);
+            EXPECT_LE(wavelengths.Lambda(j), SPECTRUM_LAMBDA_MAX);
+            EXPECT_GT(wavelengths.Pdf(j), 0.0f);
+        }
+    }
+}
+
+// Upsampled reflectance should never go beyond the range of the RGB color and white should be a constant spectrum.
+TEST(SPECTRUM, Upsampling) {
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    for (auto i = 0; i < 1024; ++i) {
+        SampledWavelengths::SetCurrent(SampledWavelengths::Sample(dist(gen)));
+
+        const auto white = SampledSpectrum(1.0f, 1.0f, 1.0f);
+        const auto color = RGBSpectrum(dist(gen), dist(gen), dist(gen));
+        const auto spectrum = SampledSpectrum(color);
+        for (auto j = 0; j < SAMPLED_SPECTRUM_SAMPLE; ++j) {
+            EXPECT_NEAR(white[j], 1.0f, 1e-4f);
+            EXPECT_GE(spectrum[j], 0.0f);
+            EXPECT_LE(spectrum[j], color.GetMaxComponent() + 1e-4f);
+        }
+    }
+}
+
+// Threads that never set their wavelengths should still upsample colors to valid spectra.
+TEST(SPECTRUM, DefaultWavelengths) {
+    std::thread([]() {
+        const auto white = SampledSpectrum(1.0f, 1.0f, 1.0f);
+        const auto red = SampledSpectrum(1.0f, 0.0f, 0.0f);
+        for (auto j = 0; j < SAMPLED_SPECTRUM_SAMPLE; ++j)
+            EXPECT_NEAR(white[j], 1.0f, 1e-4f);
+        EXPECT_GT(red.GetIntensity(), 0.0f);
+        EXPECT_GT(white.ToRGB().GetIntensity(), 0.0f);
+    }).join();
+}
+
+// Upsampling an RGB color and converting it back should give the same color.
+TEST(SPECTRUM, RoundTrip) {
+    const RGBSpectrum colors[] = {
+        RGBSpectrum(1.0f, 1.0f, 1.0f),
+        RGBSpectrum(1.0f, 0.0f, 0.0f),
+        RGBSpectrum(0.0f, 1.0f, 0.0f),
+        RGBSpectrum(0.0f, 0.0f, 1.0f),
+        RGBSpectrum(0.8f, 0.5f, 0.2f),
+        RGBSpectrum(0.1f, 0.3f, 0.6f),
+    };
+    for (const auto& color : colors) {
+        const auto rgb = averageColor(color);
+        EXPECT_NEAR(rgb.r, color.r, 0.01f);
+        EXPECT_NEAR(rgb.g, color.g, 0.01f);
+        EXPECT_NEAR(rgb.b, color.b, 0.01f);
+    }
+}
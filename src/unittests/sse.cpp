@@ -21,11 +21,13 @@
 
 #ifdef SIMD_4WAY_ENABLED
 #define SIMD_4WAY_IMPLEMENTATION
+#define SIMD_BVH_IMPLEMENTATION
 #endif
 
 #include "simd.hpp"
 
 #ifdef SIMD_4WAY_ENABLED
+#undef SIMD_BVH_IMPLEMENTATION
 #undef SIMD_4WAY_IMPLEMENTATION
 #endif
 
@@ -0,0 +1,90 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "thirdparty/gtest/gtest.h"
+#include "core/live_stats.h"
+
+// Each thread should get its own slot, which is padded to a cache line.
+TEST(LiveStats, Slot) {
+    EXPECT_EQ(sizeof(LiveStatsSlot) % 64, 0u);
+
+    // both threads stay alive until both have their slots, otherwise the slot of the first one may be reused
+    LiveStatsSlot* slots[2] = { nullptr, nullptr };
+    std::atomic<unsigned> acquired{0};
+    const auto acquire = [&](const unsigned i) {
+        slots[i] = &GetLiveStatsSlot();
+        ++acquired;
+        while (acquired < 2)
+            std::this_thread::yield();
+    };
+    std::thread t0(acquire, 0);
+    std::thread t1(acquire, 1);
+    t0.join();
+    t1.join();
+
+    EXPECT_NE(slots[0], slots[1]);
+    EXPECT_EQ(&GetLiveStatsSlot(), &GetLiveStatsSlot());
+}
+
+// Slots of threads that are gone should be reused without losing their counters.
+TEST(LiveStats, SlotRecycling) {
+    LiveStatsSlot* slots[2] = { nullptr, nullptr };
+    std::thread([&]() {
+        slots[0] = &GetLiveStatsSlot();
+        AddLiveStats(LiveStatsCounter::Path, 3);
+    }).join();
+
+    const auto before = TakeLiveStatsSnapshot();
+    std::thread([&]() {
+        slots[1] = &GetLiveStatsSlot();
+        AddLiveStats(LiveStatsCounter::Path, 5);
+    }).join();
+    const auto after = TakeLiveStatsSnapshot();
+
+    EXPECT_EQ(slots[0], slots[1]);
+    EXPECT_EQ(after[LiveStatsCounter::Path] - before[LiveStatsCounter::Path], 5u);
+}
+
+// Snapshots should have counters of all threads, including the ones that are already gone.
+TEST(LiveStats, Snapshot) {
+    constexpr unsigned THREAD_CNT = 8;
+    constexpr unsigned RAY_CNT = 100000;
+
+    const auto before = TakeLiveStatsSnapshot();
+
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i < THREAD_CNT; ++i) {
+        threads.emplace_back([]() {
+            for (auto k = 0u; k < RAY_CNT; ++k) {
+                AddLiveStats(LiveStatsCounter::Ray);
+                if (k % 4 == 0)
+                    AddLiveStats(LiveStatsCounter::ShadowRay);
+            }
+            AddLiveStats(LiveStatsCounter::Path, 10);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    const auto after = TakeLiveStatsSnapshot();
+    EXPECT_EQ(after[LiveStatsCounter::Ray] - before[LiveStatsCounter::Ray], (unsigned long long)THREAD_CNT * RAY_CNT);
+    EXPECT_EQ(after[LiveStatsCounter::ShadowRay] - before[LiveStatsCounter::ShadowRay], (unsigned long long)THREAD_CNT * RAY_CNT / 4);
+    EXPECT_EQ(after[LiveStatsCounter::Path] - before[LiveStatsCounter::Path], (unsigned long long)THREAD_CNT * 10);
+}
@@ -0,0 +1,96 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <random>
+#include <vector>
+#include "thirdparty/gtest/gtest.h"
+#include "texture/sparsetexture3d.h"
+
+// A mostly empty volume with a few blobs in it, dimensions are deliberately not multiple of brick size.
+static constexpr unsigned int W = 37, H = 21, D = 18;
+static std::vector<float> buildDenseVolume() {
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<float> texels(W * H * D, 0.0f);
+    for (auto z = 0u; z < D; ++z)
+        for (auto y = 0u; y < H; ++y)
+            for (auto x = 0u; x < W; ++x)
+                if ((x > 3 && x < 9 && y < 6) || (x > 30 && z > 12))
+                    texels[(z * H + y) * W + x] = dist(gen);
+    return texels;
+}
+
+// Sparse storage should have the exact same voxels as the dense one and only allocate non-empty bricks.
+TEST(TEXTURE, SparseTexture3DVoxel) {
+    const auto texels = buildDenseVolume();
+
+    SparseTexture3D<float> tex;
+    tex.BuildFromDense(W, H, D, texels.data());
+
+    EXPECT_EQ(tex.GetBrickRes(0), 5u);
+    EXPECT_EQ(tex.GetBrickRes(1), 3u);
+    EXPECT_EQ(tex.GetBrickRes(2), 3u);
+    // 6 bricks for the first blob and 12 bricks for the second one, out of 45 bricks in total
+    EXPECT_EQ(tex.GetAllocatedBrickCnt(), 18u);
+
+    for (auto z = 0u; z < D; ++z)
+        for (auto y = 0u; y < H; ++y)
+            for (auto x = 0u; x < W; ++x)
+                EXPECT_EQ(tex.Sample((int)x, (int)y, (int)z), texels[(z * H + y) * W + x]);
+
+    EXPECT_EQ(tex.Sample(-1, 0, 0), 0.0f);
+    EXPECT_EQ(tex.Sample((int)W, 0, 0), 0.0f);
+}
+
+// Filtered lookups should never exceed the maximum value of the brick they fall in and should be zero in empty bricks.
+TEST(TEXTURE, SparseTexture3DBrickMaximum) {
+    const auto texels = buildDenseVolume();
+
+    SparseTexture3D<float> tex;
+    tex.BuildFromDense(W, H, D, texels.data());
+    tex.UpdateBrickMaximum([](const float v) { return v; });
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    for (auto i = 0; i < 100000; ++i) {
+        const auto u = dist(gen), v = dist(gen), w = dist(gen);
+        const auto value = tex.Sample(u, v, w);
+
+        const auto bx = (unsigned int)(u * W) / SparseTexture3D<float>::BRICK_SIZE;
+        const auto by = (unsigned int)(v * H) / SparseTexture3D<float>::BRICK_SIZE;
+        const auto bz = (unsigned int)(w * D) / SparseTexture3D<float>::BRICK_SIZE;
+        EXPECT_LE(value, tex.GetBrickMaximum(bx, by, bz));
+        if (!tex.IsBrickOccupied(bx, by, bz))
+            EXPECT_EQ(value, 0.0f);
+    }
+}
+
+// Filtered lookup right at voxel centers should return the voxel value itself.
+TEST(TEXTURE, SparseTexture3DFilter) {
+    const auto texels = buildDenseVolume();
+
+    SparseTexture3D<float> tex;
+    tex.BuildFromDense(W, H, D, texels.data());
+
+    for (auto z = 0u; z < D; ++z)
+        for (auto y = 0u; y < H; ++y)
+            for (auto x = 0u; x < W; ++x) {
+                const auto value = tex.Sample((x + 0.5f) / W, (y + 0.5f) / H, (z + 0.5f) / D);
+                EXPECT_NEAR(value, texels[(z * H + y) * W + x], 1e-5f);
+            }
+}
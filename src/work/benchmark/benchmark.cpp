@@ -0,0 +1,355 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "benchmark.h"
+#include "procedural_scene.h"
+#include "core/parse_args.h"
+#include "core/samplemethod.h"
+#include "core/memory.h"
+#include "core/stats.h"
+#include "sampler/sample.h"
+#include "simd/simd_dispatch.h"
+#include "scatteringevent/bsdf/lambert.h"
+#include "scatteringevent/bsdf/orennayar.h"
+#include "scatteringevent/bsdf/microfacet.h"
+#include "scatteringevent/bsdf/disney.h"
+
+// Seed of everything random in the benchmarks, the exact same work is measured every time.
+static constexpr unsigned BENCHMARK_SEED = 0;
+// Number of rays traced in each call of the traversal kernels.
+static constexpr unsigned BENCHMARK_RAY_CNT = 1 << 14;
+// Number of samples taken in each call of the BXDF and distribution kernels.
+static constexpr unsigned BENCHMARK_SAMPLE_CNT = 4096;
+
+// Spatial structures to measure, the ones not compiled in the binary or not supported by the CPU are skipped.
+static const char* BENCHMARK_ACCELERATORS[] = { "Bvh" , "KDTree" , "OcTree" , "UniGrid" , "Qbvh" , "Obvh" , "Hbvh" , "Embree" };
+
+// Wider BVHs can only be used if the CPU is able to run the SIMD code behind them.
+static bool isAcceleratorSupported( const std::string& name ){
+    if( name == "Qbvh" )
+        return IsSimdWidthSupported(4);
+    if( name == "Obvh" )
+        return IsSimdWidthSupported(8);
+    if( name == "Hbvh" )
+        return IsSimdWidthSupported(16);
+    return true;
+}
+
+std::vector<std::string> GetBenchmarkAccelerators() {
+    std::vector<std::string> ret;
+    for (const auto accel_name : BENCHMARK_ACCELERATORS) {
+        if (isAcceleratorSupported(accel_name) && MakeUniqueInstance<Accelerator>(StringID(accel_name)))
+            ret.push_back(accel_name);
+    }
+    return ret;
+}
+
+void Benchmark::StartRunning(int argc, char** argv) {
+    const auto& args = parse_args(argc, argv, true);
+    for (const auto& arg : args) {
+        const auto& key_str = arg.first;
+        const auto& value_str = arg.second;
+
+        if (key_str == "benchmark") {
+            m_filter = value_str;
+        } else if (key_str == "benchmarkrep") {
+            m_repetition = std::max(1, atoi(value_str.c_str()));
+        } else if (key_str == "benchmarktime") {
+            m_min_time_ms = std::max(1, atoi(value_str.c_str()));
+        } else if (key_str == "benchmarkdetail") {
+            const auto detail = (float)atof(value_str.c_str());
+            m_detail = detail > 0.0f ? detail : 1.0f;
+        } else if (key_str == "benchmarkfile") {
+            m_output_file = value_str;
+        }
+    }
+
+    slog(INFO, PERFORMANCE, "Running benchmarks%s%s, %d repetitions of at least %d (ms) each.", m_filter.empty() ? "" : " matching ",
+         m_filter.c_str(), m_repetition, m_min_time_ms);
+
+    // All kernels are measured on a single thread, an extra slave worker would only disturb the measurement.
+    // Scene setup still needs the scheduler though.
+    SchedulerConfig cfg;
+    cfg.slave_thread_cnt = 1;
+    cfg.slave_fiber_stack_size = 1024 * 1024;
+
+    m_scheduler = std::make_unique<Scheduler>();
+    m_scheduler->SetupConfig(cfg);
+    m_scheduler->Bind();
+
+    schedule_parallel([this]() { run(); });
+}
+
+int Benchmark::WaitForWorkToBeDone() {
+    m_scheduler->Begin();
+    m_scheduler->Stop();
+
+    m_scheduler->Unbind();
+    m_scheduler = nullptr;
+
+    if (m_results.empty()) {
+        slog(WARNING, PERFORMANCE, "No benchmark matches '%s'.", m_filter.c_str());
+        return -1;
+    }
+
+    saveResults();
+    return 0;
+}
+
+bool Benchmark::IsSelected(const std::string& name) const {
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void Benchmark::Measure(const std::string& name, const char* unit, const unsigned long long op_cnt, const std::function<unsigned long long()>& kernel) {
+    if (!IsSelected(name))
+        return;
+
+    using clock = std::chrono::steady_clock;
+    const auto elapsed_ns = [](const clock::time_point& start) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+    };
+
+    // the warm-up call fills the caches and decides how many calls each repetition needs
+    auto start = clock::now();
+    const auto checksum = kernel();
+    const auto warmup_ns = std::max(elapsed_ns(start), 1.0);
+    const auto call_cnt = (unsigned long long)std::max(1.0, std::ceil(m_min_time_ms * 1e6 / warmup_ns));
+
+    std::vector<double> samples(m_repetition);
+    for (auto& sample : samples) {
+        start = clock::now();
+        for (auto i = 0ull; i < call_cnt; ++i)
+            kernel();
+        sample = elapsed_ns(start) / (double)(call_cnt * op_cnt);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    const auto cnt = samples.size();
+    const auto median = cnt % 2 ? samples[cnt / 2] : 0.5 * (samples[cnt / 2 - 1] + samples[cnt / 2]);
+    auto mean = 0.0, variance = 0.0;
+    for (const auto sample : samples)
+        mean += sample / cnt;
+    for (const auto sample : samples)
+        variance += (sample - mean) * (sample - mean) / cnt;
+
+    Result result;
+    result.name = name;
+    result.unit = unit;
+    result.median_ns = median;
+    result.min_ns = samples.front();
+    result.rsd = mean > 0.0 ? std::sqrt(variance) / mean : 0.0;
+    result.checksum = checksum;
+    m_results.push_back(result);
+
+    slog(INFO, PERFORMANCE, "%-32s %10.2f ns/%s (min %.2f, +-%.1f%%) %10.3f M%s/s", name.c_str(), median, unit, result.min_ns,
+         result.rsd * 100.0, median > 0.0 ? 1e3 / median : 0.0, unit);
+}
+
+void Benchmark::run() {
+    benchmarkAccelerators();
+    if (IsSimdWidthSupported(4))
+        BenchmarkSimd4Kernels(*this);
+    if (IsSimdWidthSupported(8))
+        BenchmarkSimd8Kernels(*this);
+    if (IsSimdWidthSupported(16))
+        BenchmarkSimd16Kernels(*this);
+    benchmarkBxdfs();
+    benchmarkUtilities();
+}
+
+void Benchmark::benchmarkAccelerators() {
+    auto rc = pullContext(m_rc_holder);
+
+    for (auto type = 0u; type < (unsigned)ProceduralSceneType::Count; ++type) {
+        const auto scene_type = (ProceduralSceneType)type;
+        const auto prefix = std::string("accel/") + GetProceduralSceneName(scene_type) + "/";
+
+        const auto accel_names = GetBenchmarkAccelerators();
+
+        auto selected = false;
+        for (const auto& accel_name : accel_names)
+            selected |= IsSelected(prefix + accel_name + "/build") || IsSelected(prefix + accel_name + "/intersect");
+        if (!selected)
+            continue;
+
+        Scene scene;
+        GenerateProceduralScene(scene, scene_type, BENCHMARK_SEED, m_detail);
+        scene.SetupScene(SID("Bvh"));
+
+        const auto primitive_cnt = scene.GetPrimitiveCount();
+        slog(INFO, PERFORMANCE, "Procedural scene '%s' has %d primitives.", GetProceduralSceneName(scene_type), primitive_cnt);
+
+        // Incoherent rays starting inside the scene, which is more or less what secondary rays look like.
+        std::mt19937 gen(BENCHMARK_SEED);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        const auto& bbox = scene.GetBBox();
+        std::vector<Ray> rays;
+        rays.reserve(BENCHMARK_RAY_CNT);
+        for (auto i = 0u; i < BENCHMARK_RAY_CNT; ++i) {
+            const auto ori = bbox.m_Min + (bbox.m_Max - bbox.m_Min) * Vector(dist(gen), dist(gen), dist(gen));
+            rays.push_back(Ray(ori, UniformSampleSphere(dist(gen), dist(gen))));
+        }
+
+        for (const auto& accel_name : accel_names) {
+            std::unique_ptr<Accelerator> accel = MakeUniqueInstance<Accelerator>(StringID(accel_name));
+
+            // a new instance is needed for every build, its destruction is measured too
+            Measure(prefix + accel_name + "/build", "primitive", primitive_cnt, [&]() {
+                auto fresh = MakeUniqueInstance<Accelerator>(StringID(accel_name));
+                fresh->Build(scene);
+                accel.swap(fresh);
+                return (unsigned long long)accel->GetIsValid();
+            });
+            if (!accel->GetIsValid())
+                accel->Build(scene);
+
+            Measure(prefix + accel_name + "/intersect", "ray", rays.size(), [&]() {
+                auto hit_cnt = 0ull;
+                SurfaceInteraction intersect;
+                for (const auto& ray : rays) {
+                    intersect.t = FLT_MAX;
+                    hit_cnt += accel->GetIntersect(*rc, ray, intersect) ? 1 : 0;
+                }
+                return hit_cnt;
+            });
+        }
+    }
+
+    recycleContext(m_rc_holder, rc);
+}
+
+void Benchmark::benchmarkBxdfs() {
+    auto rc = pullContext(m_rc_holder);
+
+    std::vector<BsdfSample> bsdf_samples;
+    std::vector<Vector> directions;
+    for (auto i = 0u; i < BENCHMARK_SAMPLE_CNT; ++i) {
+        bsdf_samples.push_back(BsdfSample(*rc));
+        directions.push_back(UniformSampleSphere(sort_rand<float>(*rc), sort_rand<float>(*rc)));
+    }
+    const auto wo = normalize(Vector(0.3f, 1.0f, 0.2f));
+
+    const GGX ggx(0.3f, 0.3f);
+    const FresnelConductor conductor(Spectrum(0.2f, 0.9f, 1.1f), Spectrum(3.9f, 2.4f, 2.1f));
+
+    const Lambert lambert(*rc, WHITE_SPECTRUM, FULL_WEIGHT, DIR_UP);
+    const OrenNayar oren_nayar(*rc, WHITE_SPECTRUM, 0.5f, FULL_WEIGHT, DIR_UP);
+    const MicroFacetReflection microfacet(*rc, WHITE_SPECTRUM, &conductor, &ggx, FULL_WEIGHT, DIR_UP);
+    const DisneyBRDF disney(*rc, WHITE_SPECTRUM, 0.3f, 0.5f, 0.0f, 0.4f, 0.0f, 0.2f, 0.5f, 0.3f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 0, FULL_WEIGHT, DIR_UP);
+
+    const std::pair<const char*, const Bxdf*> bxdfs[] = {
+        { "lambert" , &lambert } , { "orennayar" , &oren_nayar } , { "microfacet_ggx" , &microfacet } , { "disney" , &disney }
+    };
+    for (const auto& bxdf : bxdfs) {
+        const auto prefix = std::string("bxdf/") + bxdf.first;
+
+        Measure(prefix + "/f", "eval", directions.size(), [&]() {
+            auto non_black = 0ull;
+            for (const auto& wi : directions)
+                non_black += bxdf.second->F(wo, wi).IsBlack() ? 0 : 1;
+            return non_black;
+        });
+
+        Measure(prefix + "/sample_f", "sample", bsdf_samples.size(), [&]() {
+            auto valid = 0ull;
+            for (const auto& bs : bsdf_samples) {
+                Vector wi;
+                float pdf = 0.0f;
+                valid += bxdf.second->Sample_F(wo, wi, bs, &pdf).IsBlack() || pdf <= 0.0f ? 0 : 1;
+            }
+            return valid;
+        });
+    }
+
+    recycleContext(m_rc_holder, rc);
+}
+
+void Benchmark::benchmarkUtilities() {
+    std::mt19937 gen(BENCHMARK_SEED);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<float> us(BENCHMARK_SAMPLE_CNT);
+    for (auto& u : us)
+        u = dist(gen);
+
+    // Small distributions fit in L1 cache, the largest one is about the size of an environment map.
+    for (const auto cnt : { 16u , 1024u , 1024u * 1024u }) {
+        const auto suffix = "/" + std::to_string(cnt);
+        if (!IsSelected("distribution1d" + suffix) && !IsSelected("aliastable" + suffix))
+            continue;
+
+        std::vector<float> weights(cnt);
+        for (auto& weight : weights)
+            weight = dist(gen);
+
+        const Distribution1D distribution(weights.data(), cnt);
+        Measure("distribution1d" + suffix, "sample", us.size(), [&]() {
+            auto sum = 0ull;
+            float pdf;
+            for (const auto u : us)
+                sum += distribution.SampleDiscrete(u, &pdf);
+            return sum;
+        });
+
+        const AliasTable alias_table(weights.data(), cnt);
+        Measure("aliastable" + suffix, "sample", us.size(), [&]() {
+            auto sum = 0ull;
+            float pdf;
+            for (const auto u : us)
+                sum += alias_table.SampleDiscrete(u, &pdf);
+            return sum;
+        });
+    }
+
+    // Allocations of the size of a typical BXDF, the arena is reset once it is full just like what happens after a sample.
+    MemoryAllocator allocator;
+    for (const auto size : { 16u , 256u }) {
+        Measure("memory/allocate/" + std::to_string(size), "alloc", BENCHMARK_SAMPLE_CNT, [&]() {
+            allocator.Reset();
+
+            auto sum = 0ull;
+            for (auto i = 0u; i < BENCHMARK_SAMPLE_CNT; ++i)
+                sum += (unsigned long long)allocator.Allocate<char>(size) & 0xff;
+            return sum;
+        });
+    }
+}
+
+void Benchmark::saveResults() const {
+    if (m_output_file.empty())
+        return;
+
+    auto file = fopen(m_output_file.c_str(), "w");
+    if (!file) {
+        slog(WARNING, PERFORMANCE, "Failed to open %s for benchmark results.", m_output_file.c_str());
+        return;
+    }
+
+    for (const auto& result : m_results) {
+        fprintf(file, "{\"name\":\"%s\",\"unit\":\"%s\",\"median_ns\":%.4f,\"min_ns\":%.4f,\"rsd\":%.4f,\"mops\":%.4f,\"checksum\":%llu}\n",
+                result.name.c_str(), result.unit.c_str(), result.median_ns, result.min_ns, result.rsd,
+                result.median_ns > 0.0 ? 1e3 / result.median_ns : 0.0, result.checksum);
+    }
+    fclose(file);
+
+    slog(INFO, PERFORMANCE, "Benchmark results are saved to %s.", m_output_file.c_str());
+}
@@ -0,0 +1,105 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "../work.h"
+#include "job/scheduler.h"
+
+//! @brief  Micro benchmarks of the performance critical kernels.
+/**
+ * Unlike unit tests, which only care about correctness, this work measures the throughput of kernels like
+ * spatial structure traversal, SIMD intersection tests, BXDF evaluation and sampling. Each kernel is measured
+ * on a single thread a few times so that the spread of the measurement is known, a regression is only real
+ * if it is way larger than the spread.
+ */
+class Benchmark : public Work {
+public:
+    DEFINE_RTTI(Benchmark, Work);
+
+    //! @brief  Start work evaluation.
+    //!
+    //! @param  argc        Number of command line arguments.
+    //! @param  argv        Command line arguments.
+    void    StartRunning(int argc, char** argv) override;
+
+    //! @brief  Run all benchmarks.
+    int     WaitForWorkToBeDone() override;
+
+    //! @brief  Measure the throughput of a kernel, it is skipped if it doesn't match the filter.
+    //!
+    //! The kernel is called repeatedly until a repetition takes long enough, the number of calls is decided by a
+    //! warm-up call.
+    //!
+    //! @param  name        Name of the benchmark.
+    //! @param  unit        What an operation is, like 'ray'.
+    //! @param  op_cnt      Number of operations performed in each call of the kernel.
+    //! @param  kernel      The kernel to measure, it returns a checksum like the number of hits. The checksum of the warm-up
+    //!                     call is reported so that it is easy to tell whether the same work is measured across runs.
+    void    Measure(const std::string& name, const char* unit, const unsigned long long op_cnt, const std::function<unsigned long long()>& kernel);
+
+    //! @brief  Whether a benchmark is selected by the filter, this is for skipping expensive setup.
+    bool    IsSelected(const std::string& name) const;
+
+private:
+    //! @brief  Result of a benchmark.
+    struct Result {
+        std::string     name;               /**< Name of the benchmark. */
+        std::string     unit;               /**< What an operation is. */
+        double          median_ns;          /**< Median of the time of an operation among all repetitions, in nano second. */
+        double          min_ns;             /**< Minimum of the time of an operation among all repetitions, in nano second. */
+        double          rsd;                /**< Relative standard deviation of the time among all repetitions. */
+        unsigned long long  checksum;       /**< Sum of what the kernel returns in the warm-up call. */
+    };
+
+    std::unique_ptr<Scheduler>  m_scheduler;            /**< Scheduler running the benchmarks, scene setup needs it. */
+    std::string         m_filter;                       /**< Only benchmarks with this in their names are measured. */
+    std::string         m_output_file;                  /**< File to save results to, results are only logged if it is empty. */
+    unsigned            m_repetition = 7;               /**< Number of repetitions of each benchmark. */
+    unsigned            m_min_time_ms = 50;             /**< Minimum time of each repetition, in milli-second. */
+    float               m_detail = 1.0f;                /**< Complexity of procedural scenes. */
+    std::vector<Result> m_results;                      /**< Results of all measured benchmarks. */
+
+    //! @brief  Run all the benchmarks, it is executed in a task.
+    void    run();
+
+    //! @brief  Spatial structure construction and traversal on procedural scenes.
+    void    benchmarkAccelerators();
+
+    //! @brief  Evaluation and importance sampling of BXDFs.
+    void    benchmarkBxdfs();
+
+    //! @brief  Sampling discrete distributions and allocating memory from the arena.
+    void    benchmarkUtilities();
+
+    //! @brief  Save results to the output file as JSON lines.
+    void    saveResults() const;
+};
+
+//! @brief  Ray bounding box and ray triangle tests of each SIMD width.
+//!
+//! They are implemented in separate files so that SIMD width is only decided there, a width is only measured
+//! if the CPU supports it.
+void    BenchmarkSimd4Kernels(Benchmark& benchmark);
+void    BenchmarkSimd8Kernels(Benchmark& benchmark);
+void    BenchmarkSimd16Kernels(Benchmark& benchmark);
+
+//! @brief  Spatial structures to be benchmarked, the ones not compiled in the binary or not supported by the CPU are excluded.
+std::vector<std::string>    GetBenchmarkAccelerators();
@@ -0,0 +1,37 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include "core/define.h"
+
+#if defined(SORT_X64_TARGET) && defined(SIMD_16WAY_ENABLED)
+#define SIMD_16WAY_IMPLEMENTATION
+#define SIMD_BVH_IMPLEMENTATION
+
+#include "benchmark_simd.hpp"
+
+#undef SIMD_BVH_IMPLEMENTATION
+#undef SIMD_16WAY_IMPLEMENTATION
+
+#else
+
+#include "benchmark.h"
+
+void BenchmarkSimd16Kernels(Benchmark& benchmark) {
+    // there is no 16-wide SIMD kernel to measure without AVX512 support.
+}
+
+#endif
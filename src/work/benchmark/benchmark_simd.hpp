@@ -0,0 +1,170 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+// There is no include guard on purpose, this is included once for each SIMD width with one of SIMD_4WAY_IMPLEMENTATION,
+// SIMD_8WAY_IMPLEMENTATION and SIMD_16WAY_IMPLEMENTATION defined, the same way unit tests of SIMD are compiled.
+
+#include <bitset>
+#include <random>
+#include "simd/simd_ray_utils.h"
+#include "simd/simd_bbox.h"
+#include "simd/simd_triangle.h"
+#include "entity/visual.h"
+#include "benchmark.h"
+
+#if defined(SIMD_16WAY_IMPLEMENTATION)
+    #define SIMD_BENCHMARK_KERNELS  BenchmarkSimd16Kernels
+    #define SIMD_BENCHMARK_PREFIX   "simd16/"
+#elif defined(SIMD_8WAY_IMPLEMENTATION)
+    #define SIMD_BENCHMARK_KERNELS  BenchmarkSimd8Kernels
+    #define SIMD_BENCHMARK_PREFIX   "simd8/"
+#elif defined(SIMD_4WAY_IMPLEMENTATION)
+    #define SIMD_BENCHMARK_KERNELS  BenchmarkSimd4Kernels
+    #define SIMD_BENCHMARK_PREFIX   "simd4/"
+#else
+    #error "Undefined SIMD"
+#endif
+
+#include "simd/simd_target_begin.h"
+
+// Number of rays tested against all packs in each call of the kernels.
+static constexpr unsigned SIMD_BENCHMARK_RAY_CNT = 1024;
+// Number of bounding box packs and triangle packs, they are small enough to stay in L1 cache.
+static constexpr unsigned SIMD_BENCHMARK_PACK_CNT = 64;
+
+// Names of all kernels measured.
+static const char* const g_simd_kernel_names[] = { SIMD_BENCHMARK_PREFIX "bbox", SIMD_BENCHMARK_PREFIX "triangle_inner",
+                                                   SIMD_BENCHMARK_PREFIX "triangle", SIMD_BENCHMARK_PREFIX "triangle_fast" };
+
+void SIMD_BENCHMARK_KERNELS(Benchmark& benchmark) {
+    // skip preparing the data if none of the kernels is selected
+    auto selected = false;
+    for (const auto name : g_simd_kernel_names)
+        selected |= benchmark.IsSelected(name);
+    if (!selected)
+        return;
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    // rays start outside the unit cube and point to a random position inside it
+    std::vector<Ray> rays;
+    std::vector<Simd_Ray_Data> simd_rays(SIMD_BENCHMARK_RAY_CNT);
+    for (auto i = 0u; i < SIMD_BENCHMARK_RAY_CNT; ++i) {
+        const auto ori = Point(dist(gen), dist(gen), dist(gen)) * 4.0f;
+        const auto target = Point(dist(gen), dist(gen), dist(gen));
+        rays.push_back(Ray(ori, normalize(target - ori)));
+        rays.back().Prepare();
+        resolveRayData(rays.back(), simd_rays[i]);
+    }
+
+    std::vector<Simd_BBox> bbox_list(SIMD_BENCHMARK_PACK_CNT);
+    for (auto& bbox : bbox_list) {
+        float min_x[SIMD_CHANNEL], min_y[SIMD_CHANNEL], min_z[SIMD_CHANNEL];
+        float max_x[SIMD_CHANNEL], max_y[SIMD_CHANNEL], max_z[SIMD_CHANNEL];
+        bool  valid[SIMD_CHANNEL];
+        for (auto i = 0; i < SIMD_CHANNEL; ++i) {
+            const auto center = Point(dist(gen), dist(gen), dist(gen));
+            const auto extent = Vector(dist(gen) + 1.0f, dist(gen) + 1.0f, dist(gen) + 1.0f) * 0.25f;
+            min_x[i] = center.x - extent.x;
+            min_y[i] = center.y - extent.y;
+            min_z[i] = center.z - extent.z;
+            max_x[i] = center.x + extent.x;
+            max_y[i] = center.y + extent.y;
+            max_z[i] = center.z + extent.z;
+            valid[i] = true;
+        }
+        bbox.m_min_x = simd_set_ps(min_x);
+        bbox.m_min_y = simd_set_ps(min_y);
+        bbox.m_min_z = simd_set_ps(min_z);
+        bbox.m_max_x = simd_set_ps(max_x);
+        bbox.m_max_y = simd_set_ps(max_y);
+        bbox.m_max_z = simd_set_ps(max_z);
+        bbox.m_mask = simd_set_mask(valid);
+    }
+
+    // random triangles inside the unit cube
+    auto mesh = std::make_unique<Mesh>();
+    mesh->m_indices.resize(SIMD_BENCHMARK_PACK_CNT * SIMD_CHANNEL);
+    for (auto& index : mesh->m_indices) {
+        const auto center = Point(dist(gen), dist(gen), dist(gen));
+        for (auto j = 0; j < 3; ++j) {
+            MeshVertex vertex;
+            vertex.m_position = center + Vector(dist(gen), dist(gen), dist(gen)) * 0.3f;
+            vertex.m_normal = Vector(0.0f, 1.0f, 0.0f);
+            index.m_id[j] = (int)mesh->m_vertices.size();
+            mesh->m_vertices.push_back(vertex);
+        }
+    }
+    MeshVisual visual;
+    visual.SetMesh(std::move(mesh));
+
+    std::vector<Simd_Triangle> tri_list;
+    Simd_Triangle simd_tri;
+    for (auto i = 0u; i < visual.GetPrimitiveCount(); ++i) {
+        if (simd_tri.PushTriangle(visual.GetPrimitive(i)) && simd_tri.PackData()) {
+            tri_list.push_back(simd_tri);
+            simd_tri.Reset();
+        }
+    }
+
+    const auto test_cnt = (unsigned long long)SIMD_BENCHMARK_RAY_CNT * SIMD_BENCHMARK_PACK_CNT;
+
+    benchmark.Measure(SIMD_BENCHMARK_PREFIX "bbox", "test", test_cnt, [&]() {
+        auto hit_cnt = 0ull;
+        simd_data f_min;
+        for (auto i = 0u; i < SIMD_BENCHMARK_RAY_CNT; ++i) {
+            for (const auto& bbox : bbox_list)
+                hit_cnt += std::bitset<SIMD_CHANNEL>(IntersectBBox_SIMD(rays[i], simd_rays[i], bbox, f_min)).count();
+        }
+        return hit_cnt;
+    });
+
+    benchmark.Measure(SIMD_BENCHMARK_PREFIX "triangle_inner", "test", test_cnt, [&]() {
+        auto hit_cnt = 0ull;
+        simd_data t, u, v, mask;
+        for (auto i = 0u; i < SIMD_BENCHMARK_RAY_CNT; ++i) {
+            for (const auto& tri : tri_list)
+                hit_cnt += intersectTriangleInner_SIMD<false>(rays[i], simd_rays[i], tri, t, u, v, mask) ? 1 : 0;
+        }
+        return hit_cnt;
+    });
+
+    benchmark.Measure(SIMD_BENCHMARK_PREFIX "triangle", "test", test_cnt, [&]() {
+        auto hit_cnt = 0ull;
+        for (auto i = 0u; i < SIMD_BENCHMARK_RAY_CNT; ++i) {
+            SurfaceInteraction intersect;
+            for (const auto& tri : tri_list)
+                hit_cnt += intersectTriangle_SIMD(rays[i], simd_rays[i], tri, &intersect) ? 1 : 0;
+        }
+        return hit_cnt;
+    });
+
+    benchmark.Measure(SIMD_BENCHMARK_PREFIX "triangle_fast", "test", test_cnt, [&]() {
+        auto hit_cnt = 0ull;
+        for (auto i = 0u; i < SIMD_BENCHMARK_RAY_CNT; ++i) {
+            for (const auto& tri : tri_list)
+                hit_cnt += intersectTriangleFast_SIMD(rays[i], simd_rays[i], tri) ? 1 : 0;
+        }
+        return hit_cnt;
+    });
+}
+
+#include "simd/simd_target_end.h"
+
+#undef SIMD_BENCHMARK_PREFIX
+#undef SIMD_BENCHMARK_KERNELS
@@ -0,0 +1,242 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include <random>
+#include "procedural_scene.h"
+#include "entity/visual_entity.h"
+#include "material/matmanager.h"
+#include "math/utils.h"
+
+// Append a triangle with its face normal, vertices are not shared with other triangles.
+static void addTriangle( Mesh& mesh , const Point& p0 , const Point& p1 , const Point& p2 , const MaterialBase* mat ){
+    const auto n = cross( p1 - p0 , p2 - p0 );
+    if( n.SquaredLength() == 0.0f )
+        return;
+
+    MeshFaceIndex index;
+    index.m_mat = mat;
+    auto i = 0;
+    for( const auto& p : { p0 , p1 , p2 } ){
+        MeshVertex vertex;
+        vertex.m_position = p;
+        vertex.m_normal = normalize( n );
+        index.m_id[i++] = (int)mesh.m_vertices.size();
+        mesh.m_vertices.push_back( vertex );
+    }
+    mesh.m_indices.push_back( index );
+}
+
+// Append a parametric patch tessellated into nu x nv quads, 'surface' maps the unit square to the surface.
+// Normals follow the winding of the triangles, which is cross( dp/du , dp/dv ).
+template<class Surface>
+static void addPatch( Mesh& mesh , const unsigned nu , const unsigned nv , const Surface& surface , const MaterialBase* mat ){
+    static constexpr float delta = 1e-3f;
+
+    const auto base = (int)mesh.m_vertices.size();
+    for( auto j = 0u ; j <= nv ; ++j ){
+        for( auto i = 0u ; i <= nu ; ++i ){
+            const auto u = (float)i / nu , v = (float)j / nv;
+            const auto dpdu = surface( u + delta , v ) - surface( u - delta , v );
+            const auto dpdv = surface( u , v + delta ) - surface( u , v - delta );
+
+            MeshVertex vertex;
+            vertex.m_position = surface( u , v );
+            vertex.m_normal = normalize( cross( dpdu , dpdv ) );
+            mesh.m_vertices.push_back( vertex );
+        }
+    }
+
+    const auto vertex_id = [&]( const unsigned i , const unsigned j ){
+        return base + (int)( j * ( nu + 1 ) + i );
+    };
+    for( auto j = 0u ; j < nv ; ++j ){
+        for( auto i = 0u ; i < nu ; ++i ){
+            MeshFaceIndex index;
+            index.m_mat = mat;
+            index.m_id[0] = vertex_id( i , j );
+            index.m_id[1] = vertex_id( i + 1 , j );
+            index.m_id[2] = vertex_id( i + 1 , j + 1 );
+            mesh.m_indices.push_back( index );
+
+            index.m_id[1] = vertex_id( i + 1 , j + 1 );
+            index.m_id[2] = vertex_id( i , j + 1 );
+            mesh.m_indices.push_back( index );
+        }
+    }
+}
+
+// Append a flat quad spanned by two edges, it faces cross( edge_u , edge_v ).
+static void addQuad( Mesh& mesh , const Point& corner , const Vector& edge_u , const Vector& edge_v , const unsigned nu , const unsigned nv , const MaterialBase* mat ){
+    addPatch( mesh , nu , nv , [&]( const float u , const float v ){ return corner + edge_u * u + edge_v * v; } , mat );
+}
+
+// Append an axis aligned box facing outside.
+static void addBox( Mesh& mesh , const Point& pmin , const Point& pmax , const MaterialBase* mat ){
+    const auto dx = Vector( pmax.x - pmin.x , 0.0f , 0.0f );
+    const auto dy = Vector( 0.0f , pmax.y - pmin.y , 0.0f );
+    const auto dz = Vector( 0.0f , 0.0f , pmax.z - pmin.z );
+
+    addQuad( mesh , pmin , dx , dz , 1 , 1 , mat );             // bottom
+    addQuad( mesh , pmin + dy , dz , dx , 1 , 1 , mat );        // top
+    addQuad( mesh , pmin , dz , dy , 1 , 1 , mat );             // left
+    addQuad( mesh , pmin + dx , dy , dz , 1 , 1 , mat );        // right
+    addQuad( mesh , pmin , dy , dx , 1 , 1 , mat );             // back
+    addQuad( mesh , pmin + dz , dx , dy , 1 , 1 , mat );        // front
+}
+
+// Append the side of a vertical cylinder facing outside.
+static void addCylinder( Mesh& mesh , const Point& bottom , const float radius , const float height , const unsigned segments , const unsigned rings , const MaterialBase* mat ){
+    addPatch( mesh , segments , rings , [&]( const float u , const float v ){
+        const auto theta = -TWO_PI * u;
+        return bottom + Vector( radius * cos( theta ) , height * v , radius * sin( theta ) );
+    } , mat );
+}
+
+// Tessellation along one dimension of a patch, it grows with the square root of the detail so that the triangle count grows linearly.
+static unsigned tessellation( const unsigned n , const float detail ){
+    return std::max( 1u , (unsigned)std::ceil( n * std::sqrt( detail ) ) );
+}
+
+// Small random triangles overlapping each other.
+static void generateTriangleSoup( Mesh& mesh , std::mt19937& gen , const float detail , const MaterialBase* mat ){
+    std::uniform_real_distribution<float> dist( -1.0f , 1.0f );
+
+    const auto tri_cnt = std::max( 1u , (unsigned)( 65536 * detail ) );
+    for( auto i = 0u ; i < tri_cnt ; ++i ){
+        const auto center = Point( dist(gen) , dist(gen) , dist(gen) );
+        const auto p0 = center + Vector( dist(gen) , dist(gen) , dist(gen) ) * 0.08f;
+        const auto p1 = center + Vector( dist(gen) , dist(gen) , dist(gen) ) * 0.08f;
+        const auto p2 = center + Vector( dist(gen) , dist(gen) , dist(gen) ) * 0.08f;
+        addTriangle( mesh , p0 , p1 , p2 , mat );
+    }
+}
+
+// An atrium with two floors of columns, the roof is open so that the sky lights it up, just like Sponza.
+static void generatePillarGrid( Mesh& mesh , std::mt19937& gen , const float detail , const MaterialBase* mat ){
+    std::uniform_real_distribution<float> dist( 0.0f , 1.0f );
+
+    constexpr auto half_length = 15.0f;
+    constexpr auto half_width = 7.5f;
+    constexpr auto height = 10.0f;
+    constexpr auto column_cnt = 10;
+    constexpr auto column_z = 4.0f;
+    constexpr auto gallery_y = 4.5f;
+
+    // floor and walls
+    addQuad( mesh , Point( -half_length , 0.0f , -half_width ) , Vector( 0.0f , 0.0f , 2.0f * half_width ) , Vector( 2.0f * half_length , 0.0f , 0.0f ) , tessellation( 24 , detail ) , tessellation( 60 , detail ) , mat );
+    addBox( mesh , Point( -half_length - 0.5f , 0.0f , -half_width - 0.5f ) , Point( half_length + 0.5f , height , -half_width ) , mat );
+    addBox( mesh , Point( -half_length - 0.5f , 0.0f , half_width ) , Point( half_length + 0.5f , height , half_width + 0.5f ) , mat );
+    addBox( mesh , Point( -half_length - 0.5f , 0.0f , -half_width ) , Point( -half_length , height , half_width ) , mat );
+    addBox( mesh , Point( half_length , 0.0f , -half_width ) , Point( half_length + 0.5f , height , half_width ) , mat );
+
+    const auto segments = tessellation( 32 , detail );
+    const auto rings = tessellation( 16 , detail );
+    for( const auto side : { -1.0f , 1.0f } ){
+        const auto z = side * column_z;
+
+        // galleries on both sides with beams on top of them
+        addBox( mesh , Point( -half_length , gallery_y , std::min( z , side * half_width ) ) , Point( half_length , gallery_y + 0.5f , std::max( z , side * half_width ) ) , mat );
+        addBox( mesh , Point( -half_length , height - 1.0f , z - 0.3f ) , Point( half_length , height - 0.5f , z + 0.3f ) , mat );
+
+        for( auto i = 0 ; i < column_cnt ; ++i ){
+            const auto x = -half_length + ( i + 0.5f ) * ( 2.0f * half_length / column_cnt );
+
+            // columns on the ground floor with a plinth and a capital, smaller ones on the gallery
+            addBox( mesh , Point( x - 0.6f , 0.0f , z - 0.6f ) , Point( x + 0.6f , 0.4f , z + 0.6f ) , mat );
+            addCylinder( mesh , Point( x , 0.4f , z ) , 0.4f , gallery_y - 0.8f , segments , rings , mat );
+            addBox( mesh , Point( x - 0.6f , gallery_y - 0.4f , z - 0.6f ) , Point( x + 0.6f , gallery_y , z + 0.6f ) , mat );
+            addCylinder( mesh , Point( x , gallery_y + 0.5f , z ) , 0.3f , height - gallery_y - 1.5f , segments , rings , mat );
+
+            // drapes hanging from the gallery between every other pair of columns
+            if( i % 2 == 0 && i + 1 < column_cnt ){
+                const auto x0 = x + 0.5f;
+                const auto x1 = x + 2.0f * half_length / column_cnt - 0.5f;
+                const auto phase = dist(gen) * TWO_PI;
+                addPatch( mesh , tessellation( 16 , detail ) , tessellation( 16 , detail ) , [&]( const float u , const float v ){
+                    const auto wave = 0.15f * sin( u * 3.0f * TWO_PI + phase ) * ( 1.0f - 0.5f * v );
+                    return Point( x0 + ( x1 - x0 ) * u , gallery_y - 3.0f * v , z - side * 0.6f + wave );
+                } , mat );
+            }
+        }
+    }
+}
+
+// Curly hair strands growing out of a unit sphere.
+static void generateHairBall( HairVisual& hair , std::mt19937& gen , const float detail , const int mat_id ){
+    std::uniform_real_distribution<float> dist( -1.0f , 1.0f );
+    const auto random_direction = [&](){
+        while( true ){
+            const auto d = Vector( dist(gen) , dist(gen) , dist(gen) );
+            const auto len = d.SquaredLength();
+            if( len > 1e-4f && len <= 1.0f )
+                return normalize( d );
+        }
+    };
+
+    constexpr auto segment_cnt = 16u;
+    constexpr auto segment_length = 0.06f;
+
+    const auto strand_cnt = std::max( 1u , (unsigned)( 8192 * detail ) );
+    std::vector<Point> points( segment_cnt + 1 );
+    for( auto i = 0u ; i < strand_cnt ; ++i ){
+        const auto root = random_direction();
+        auto dir = root;
+        points[0] = Point( root.x , root.y , root.z );
+        for( auto j = 1u ; j <= segment_cnt ; ++j ){
+            dir = normalize( dir * 0.8f + random_direction() * 0.5f + root * 0.2f );
+            points[j] = points[j - 1] + dir * segment_length;
+        }
+        hair.AddHair( points , 0.01f , 0.002f , mat_id );
+    }
+}
+
+const char* GetProceduralSceneName( const ProceduralSceneType type ){
+    switch( type ){
+    case ProceduralSceneType::TriangleSoup:
+        return "soup";
+    case ProceduralSceneType::PillarGrid:
+        return "grid";
+    case ProceduralSceneType::HairBall:
+        return "hairball";
+    default:
+        return "unknown";
+    }
+}
+
+void GenerateProceduralScene( Scene& scene , const ProceduralSceneType type , const unsigned seed , const float detail , const int mat_id ){
+    std::mt19937 gen( seed );
+    const auto mat = MatManager::GetSingleton().GetMaterial( mat_id );
+
+    auto entity = std::make_unique<VisualEntity>();
+    if( type == ProceduralSceneType::HairBall ){
+        auto hair = std::make_unique<HairVisual>();
+        generateHairBall( *hair , gen , detail , mat_id );
+        entity->AddVisual( std::move(hair) );
+    }else{
+        auto mesh = std::make_unique<Mesh>();
+        if( type == ProceduralSceneType::TriangleSoup )
+            generateTriangleSoup( *mesh , gen , detail , mat );
+        else
+            generatePillarGrid( *mesh , gen , detail , mat );
+
+        auto visual = std::make_unique<MeshVisual>();
+        visual->SetMesh( std::move(mesh) );
+        entity->AddVisual( std::move(visual) );
+    }
+    scene.AddEntity( std::move(entity) );
+}
@@ -0,0 +1,46 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include "core/scene.h"
+
+//! @brief  Procedural scenes used for benchmarking.
+/**
+ * The scenes are generated in code with a fixed seed so that the exact same geometry is used every time,
+ * no exported scene is needed to measure performance.
+ */
+enum class ProceduralSceneType {
+    TriangleSoup,       /**< Small random triangles overlapping each other in a cube, the worst case for any BVH. */
+    PillarGrid,         /**< An atrium with columns, galleries and drapes, a Sponza-like architectural scene. */
+    HairBall,           /**< Curly hair strands growing out of a sphere, lots of thin and long primitives. */
+    Count
+};
+
+//! @brief  Name of a procedural scene.
+const char* GetProceduralSceneName( const ProceduralSceneType type );
+
+//! @brief  Fill a scene with procedurally generated primitives.
+//!
+//! Only geometry is generated, Scene::SetupScene still needs to be called afterwards.
+//!
+//! @param  scene       The scene to be filled.
+//! @param  type        Type of the procedural scene.
+//! @param  seed        Seed of the random number generator.
+//! @param  detail      Multiplier of the number of primitives, 1.0 means the default complexity.
+//! @param  mat_id      Id of the material of all primitives, the default material is used if it is not valid.
+void        GenerateProceduralScene( Scene& scene , const ProceduralSceneType type , const unsigned seed , const float detail = 1.0f , const int mat_id = -1 );
@@ -0,0 +1,324 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include "render_benchmark.h"
+#include "benchmark.h"
+#include "core/define.h"
+#include "core/parse_args.h"
+#include "core/path.h"
+#include "stream/mstream.h"
+#include "work/image_evaluation/image_evaluation.h"
+
+#if defined(SORT_IN_LINUX)
+#include <fstream>
+#elif defined(SORT_IN_MAC)
+#include <sys/resource.h>
+#endif
+
+BEGIN_EXTERNAL_INCLUDES
+#include "thirdparty/tiny_exr/tinyexr.h"
+END_EXTERNAL_INCLUDES
+
+// Seed of everything random in the benchmark, the exact same images are rendered every time.
+static constexpr unsigned RENDER_BENCHMARK_SEED = 0;
+
+// Integrators to measure, each of them is configured the same way as what the exporter does by default.
+static const char* RENDER_BENCHMARK_INTEGRATORS[] = { "PathTracing" , "BidirPathTracing" , "LightTracing" , "DirectLight" , "WhittedRT" , "AmbientOcclusion" , "InstantRadiosity" };
+
+// Configure a serializable object by feeding it the same data an exporter would stream.
+template<class T>
+static void serialize( T& target , const std::function<void(StreamBase&)>& write ){
+    OMemoryStream ostream;
+    write(ostream);
+
+    IMemoryStream istream(ostream.GetData(), ostream.GetDataSize());
+    target.Serialize(istream);
+}
+
+// Create an integrator configured the same way as what the exporter does by default.
+static std::unique_ptr<Integrator> createIntegrator( const std::string& name ){
+    auto integrator = MakeUniqueInstance<Integrator>(StringID(name));
+    if( !integrator )
+        return nullptr;
+
+    serialize( *integrator , [&]( StreamBase& stream ){
+        stream << 6;                                // max recursive depth
+        if( name == "PathTracing" )
+            stream << 4;                            // max bounces in BSSRDF path
+        else if( name == "BidirPathTracing" )
+            stream << true;                         // multiple importance sampling
+        else if( name == "AmbientOcclusion" )
+            stream << 3.0f;                         // max distance
+        else if( name == "InstantRadiosity" )
+            stream << 1 << 64 << 1.0f;              // light path set, light paths, min distance
+    });
+    return integrator;
+}
+
+// Add a camera, a sky light and a sun to a procedural scene, the camera is placed so that the whole scene is visible.
+static void addCameraAndLights( Scene& scene , const ProceduralSceneType type , const unsigned image_size ){
+    auto eye = Point( 3.0f , 2.0f , 3.5f );
+    auto target = Point( 0.0f , 0.0f , 0.0f );
+    auto fov = 0.8f;
+    switch( type ){
+    case ProceduralSceneType::PillarGrid:
+        // looking down the nave of the atrium
+        eye = Point( -13.5f , 2.5f , 0.0f );
+        target = Point( 10.0f , 5.0f , 0.0f );
+        fov = 1.2f;
+        break;
+    case ProceduralSceneType::HairBall:
+        eye = Point( 0.0f , 1.5f , 5.5f );
+        break;
+    default:
+        break;
+    }
+
+    auto camera = MakeUniqueInstance<Entity>(SID("PerspectiveCameraEntity"));
+    serialize( *camera , [&]( StreamBase& stream ){
+        stream << eye << Vector( 0.0f , 1.0f , 0.0f ) << target;
+        stream << image_size << image_size;
+        stream << 0.0f;                             // lens radius
+        stream << 0.0f << 0.0f << 0;                // sensor size and aspect fit
+        stream << 1.0f << 1.0f;                     // aspect ratio
+        stream << fov;
+    });
+    scene.AddEntity(std::move(camera));
+
+    auto sky = MakeUniqueInstance<Entity>(SID("SkyLightEntity"));
+    serialize( *sky , [&]( StreamBase& stream ){
+        stream << Transform() << 0.5f << RGBSpectrum( 0.6f , 0.7f , 0.9f ) << std::string();
+    });
+    scene.AddEntity(std::move(sky));
+
+    // the y axis of the transform is the direction of the light
+    auto sun = MakeUniqueInstance<Entity>(SID("DirLightEntity"));
+    serialize( *sun , [&]( StreamBase& stream ){
+        stream << RotateY( 0.6f ) * RotateX( 0.8f * PI ) << 3.0f << RGBSpectrum( 1.0f , 0.95f , 0.85f );
+    });
+    scene.AddEntity(std::move(sun));
+}
+
+// Peak resident memory of the process in mega-byte since the last reset, zero if it is not available.
+static double peakMemoryMB(){
+#if defined(SORT_IN_LINUX)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while( std::getline( status , line ) ){
+        if( line.compare( 0 , 6 , "VmHWM:" ) == 0 )
+            return atof( line.c_str() + 6 ) / 1024.0;
+    }
+    return 0.0;
+#elif defined(SORT_IN_MAC)
+    // there is no way to reset it on Mac, it is the peak of the whole process
+    struct rusage usage;
+    getrusage( RUSAGE_SELF , &usage );
+    return usage.ru_maxrss / ( 1024.0 * 1024.0 );
+#else
+    return 0.0;
+#endif
+}
+
+// Reset the peak resident memory to the current resident memory so that each combination has its own peak.
+static void resetPeakMemory(){
+#if defined(SORT_IN_LINUX)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+
+void RenderBenchmark::StartRunning(int argc, char** argv) {
+    const auto& args = parse_args(argc, argv, true);
+    for (const auto& arg : args) {
+        const auto& key_str = arg.first;
+        const auto& value_str = arg.second;
+
+        if (key_str == "renderbenchmark") {
+            m_filter = value_str;
+        } else if (key_str == "benchmarkref") {
+            if (!value_str.empty())
+                m_reference_dir = value_str;
+        } else if (key_str == "benchmarkupdateref") {
+            m_update_reference = true;
+        } else if (key_str == "benchmarkspp") {
+            m_sample_per_pixel = std::max(1, atoi(value_str.c_str()));
+        } else if (key_str == "benchmarksize") {
+            m_image_size = std::max(16, atoi(value_str.c_str()));
+        } else if (key_str == "benchmarkthreads") {
+            m_thread_cnt = std::max(0, atoi(value_str.c_str()));
+        } else if (key_str == "benchmarkdetail") {
+            const auto detail = (float)atof(value_str.c_str());
+            m_detail = detail > 0.0f ? detail : 1.0f;
+        } else if (key_str == "benchmarkfile") {
+            m_output_file = value_str;
+        }
+    }
+
+    slog(INFO, PERFORMANCE, "Running render benchmarks%s%s, %dx%d pixels with %d samples per pixel.", m_filter.empty() ? "" : " matching ",
+         m_filter.c_str(), m_image_size, m_image_size, m_sample_per_pixel);
+}
+
+int RenderBenchmark::WaitForWorkToBeDone() {
+    std::error_code err;
+    std::filesystem::create_directories(GetFilePathInExeFolder(m_reference_dir), err);
+
+    const auto accel_names = GetBenchmarkAccelerators();
+    for (auto i = 0; i < (int)ProceduralSceneType::Count; ++i) {
+        const auto scene_type = (ProceduralSceneType)i;
+        const auto scene_name = std::string(GetProceduralSceneName(scene_type));
+
+        for (const auto integrator_name : RENDER_BENCHMARK_INTEGRATORS) {
+            const auto prefix = scene_name + "/" + integrator_name + "/";
+
+            auto selected = false;
+            for (const auto& accel_name : accel_names)
+                selected |= m_filter.empty() || (prefix + accel_name).find(m_filter) != std::string::npos;
+            if (!selected)
+                continue;
+
+            // All spatial structures should generate the same image, they share the same reference.
+            auto reference = m_update_reference ? Reference() : loadReference(m_reference_dir + "/" + scene_name + "_" + integrator_name + ".exr");
+            for (const auto& accel_name : accel_names) {
+                if (m_filter.empty() || (prefix + accel_name).find(m_filter) != std::string::npos)
+                    render(scene_type, integrator_name, accel_name, reference);
+            }
+        }
+    }
+
+    if (m_results.empty()) {
+        slog(WARNING, PERFORMANCE, "No render benchmark matches '%s'.", m_filter.c_str());
+        return -1;
+    }
+
+    saveResults();
+    return 0;
+}
+
+void RenderBenchmark::render(const ProceduralSceneType scene_type, const std::string& integrator, const std::string& accelerator, Reference& reference) {
+    const auto scene_name = std::string(GetProceduralSceneName(scene_type));
+
+    Result result;
+    result.name = scene_name + "/" + integrator + "/" + accelerator;
+    result.new_reference = reference.pixels.empty();
+
+    ImageEvaluationSetup setup;
+    setup.thread_cnt = m_thread_cnt;
+    setup.sample_per_pixel = m_sample_per_pixel;
+    setup.image_width = m_image_size;
+    setup.image_height = m_image_size;
+    setup.seed = RENDER_BENCHMARK_SEED;
+    setup.integrator = createIntegrator(integrator);
+    setup.accelerator = StringID(accelerator);
+    setup.fill_scene = [this, scene_type](Scene& scene) {
+        GenerateProceduralScene(scene, scene_type, RENDER_BENCHMARK_SEED, m_detail);
+        addCameraAndLights(scene, scene_type, m_image_size);
+    };
+    if (result.new_reference)
+        setup.image_file = m_reference_dir + "/" + scene_name + "_" + integrator + ".exr";
+
+    if (!setup.integrator) {
+        slog(WARNING, PERFORMANCE, "Integrator %s is not supported.", integrator.c_str());
+        return;
+    }
+
+    resetPeakMemory();
+
+    auto evaluation = std::make_unique<ImageEvaluation>();
+    evaluation->StartRunning(std::move(setup));
+    evaluation->WaitForWorkToBeDone();
+
+    result.accel_time = evaluation->GetAccelerationStructureTime();
+    result.render_time = evaluation->GetRenderingTime();
+    result.ray_cnt = evaluation->GetRayCount();
+    result.peak_memory_mb = peakMemoryMB();
+
+    const auto image = evaluation->GetRenderTarget();
+    if (result.new_reference) {
+        reference.width = image->GetWidth();
+        reference.height = image->GetHeight();
+        reference.pixels.assign(image->GetData(), image->GetData() + reference.width * reference.height);
+    }
+
+    if (reference.width == image->GetWidth() && reference.height == image->GetHeight()) {
+        auto error = 0.0;
+        for (auto y = 0; y < reference.height; ++y) {
+            for (auto x = 0; x < reference.width; ++x) {
+                const auto diff = image->GetColor(x, y) - reference.pixels[y * reference.width + x];
+                error += diff.r * diff.r + diff.g * diff.g + diff.b * diff.b;
+            }
+        }
+        result.rmse = sqrt(error / (3.0 * reference.width * reference.height));
+    } else {
+        slog(WARNING, PERFORMANCE, "Reference image of %s has a different size, use --benchmarkupdateref to update it.", result.name.c_str());
+        result.rmse = -1.0;
+    }
+
+    slog(INFO, PERFORMANCE, "%-45s %8d ms (build %6d ms) %8.3f MRays/s %8.1f MB  rmse %.5f%s", result.name.c_str(), result.render_time, result.accel_time,
+         result.render_time ? result.ray_cnt / (result.render_time * 1000.0) : 0.0, result.peak_memory_mb, result.rmse,
+         result.new_reference ? " (new reference)" : "");
+
+    m_results.push_back(result);
+}
+
+RenderBenchmark::Reference RenderBenchmark::loadReference(const std::string& file) const {
+    Reference reference;
+
+    float* out = nullptr;
+    const char* err = nullptr;
+    const auto full_file_path = GetFilePathInExeFolder(file);
+    if (LoadEXR(&out, &reference.width, &reference.height, full_file_path.c_str(), &err) < 0) {
+        if (err)
+            FreeEXRErrorMessage(err);
+        slog(INFO, PERFORMANCE, "There is no reference image %s, it will be created.", full_file_path.c_str());
+        return Reference();
+    }
+
+    const auto total = reference.width * reference.height;
+    reference.pixels.resize(total);
+    for (auto i = 0; i < total; ++i)
+        reference.pixels[i] = RGBSpectrum(out[4 * i], out[4 * i + 1], out[4 * i + 2]);
+    free(out);
+
+    return reference;
+}
+
+void RenderBenchmark::saveResults() const {
+    if (m_output_file.empty())
+        return;
+
+    auto file = fopen(m_output_file.c_str(), "w");
+    if (!file) {
+        slog(WARNING, PERFORMANCE, "Failed to open %s for benchmark results.", m_output_file.c_str());
+        return;
+    }
+
+    for (const auto& result : m_results) {
+        fprintf(file, "{\"name\":\"%s\",\"spp\":%d,\"width\":%d,\"height\":%d,\"build_ms\":%d,\"render_ms\":%d,\"rays\":%lld,\"mrays_per_s\":%.4f,"
+                      "\"peak_memory_mb\":%.2f,\"rmse\":%.6f,\"new_reference\":%s}\n",
+                result.name.c_str(), m_sample_per_pixel, m_image_size, m_image_size, result.accel_time, result.render_time, result.ray_cnt,
+                result.render_time ? result.ray_cnt / (result.render_time * 1000.0) : 0.0, result.peak_memory_mb, result.rmse,
+                result.new_reference ? "true" : "false");
+    }
+    fclose(file);
+
+    slog(INFO, PERFORMANCE, "Benchmark results are saved to %s.", m_output_file.c_str());
+}
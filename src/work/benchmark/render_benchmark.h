@@ -0,0 +1,91 @@
+/*
+    This file is a part of SORT(Simple Open Ray Tracing), an open-source cross
+    platform physically based renderer.
+
+    Copyright (c) 2011-2023 by Jiayin Cao - All rights reserved.
+
+    SORT is a free software written for educational purpose. Anyone can distribute
+    or modify it under the the terms of the GNU General Public License Version 3 as
+    published by the Free Software Foundation. However, there is NO warranty that
+    all components are functional in a perfect manner. Without even the implied
+    warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with
+    this program. If not, see <http://www.gnu.org/licenses/gpl-3.0.html>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../work.h"
+#include "procedural_scene.h"
+#include "core/stats.h"
+#include "spectrum/rgbspectrum.h"
+
+//! @brief  End to end rendering benchmark on procedural scenes.
+/**
+ * Micro benchmarks can't tell how the kernels interact with each other, this work renders each procedural
+ * scene with every integrator and every spatial structure supported, so that regressions in the whole pipeline
+ * are caught. The same seed and sample count are used every time, the image of each combination is compared
+ * with a stored reference image so that a speed up that breaks the image is caught too.
+ */
+class RenderBenchmark : public Work {
+public:
+    DEFINE_RTTI(RenderBenchmark, Work);
+
+    //! @brief  Start work evaluation.
+    //!
+    //! @param  argc        Number of command line arguments.
+    //! @param  argv        Command line arguments.
+    void    StartRunning(int argc, char** argv) override;
+
+    //! @brief  Render all combinations one by one.
+    //!
+    //! Each combination has its own job system, which takes over the main thread until it is done.
+    int     WaitForWorkToBeDone() override;
+
+private:
+    //! @brief  Result of rendering a combination.
+    struct Result {
+        std::string     name;                   /**< Name of the combination, scene/integrator/accelerator. */
+        unsigned        accel_time = 0;         /**< Time spent on constructing the spatial structure, in milli-second. */
+        unsigned        render_time = 0;        /**< Time spent on rendering tiles, in milli-second. */
+        StatsInt        ray_cnt = 0;            /**< Number of rays traced, it is only available with stats collection. */
+        double          peak_memory_mb = 0.0;   /**< Peak resident memory of the process, in mega-byte. */
+        double          rmse = 0.0;             /**< Root mean square error against the reference image. */
+        bool            new_reference = false;  /**< Whether the reference image is created by this run. */
+    };
+
+    //! @brief  Reference image of a scene rendered by an integrator.
+    struct Reference {
+        int                         width = 0;  /**< Width of the reference image. */
+        int                         height = 0; /**< Height of the reference image. */
+        std::vector<RGBSpectrum>    pixels;     /**< Pixels of the reference image, row by row. */
+    };
+
+    std::string         m_filter;                       /**< Only combinations with this in their names are rendered. */
+    std::string         m_reference_dir = "benchmark_ref";  /**< Folder of reference images, relative to the working folder. */
+    std::string         m_output_file;                  /**< File to save results to, results are only logged if it is empty. */
+    bool                m_update_reference = false;     /**< Overwrite existing reference images instead of comparing with them. */
+    unsigned            m_thread_cnt = 0;               /**< Number of threads rendering, all hardware threads are used if it is zero. */
+    unsigned            m_sample_per_pixel = 4;         /**< Sample per pixel of all combinations. */
+    unsigned            m_image_size = 128;             /**< Width and height of all images. */
+    float               m_detail = 1.0f;                /**< Complexity of procedural scenes. */
+    std::vector<Result> m_results;                      /**< Results of all rendered combinations. */
+
+    //! @brief  Render a procedural scene with an integrator and a spatial structure.
+    //!
+    //! @param  scene_type  Type of the procedural scene.
+    //! @param  integrator  Name of the integrator.
+    //! @param  accelerator Name of the spatial structure.
+    //! @param  reference   Reference image, it is filled with the result if it is empty.
+    void    render(const ProceduralSceneType scene_type, const std::string& integrator, const std::string& accelerator, Reference& reference);
+
+    //! @brief  Load the reference image of a scene rendered by an integrator, it is left empty if there is none.
+    Reference   loadReference(const std::string& file) const;
+
+    //! @brief  Save results to the output file as JSON lines.
+    void    saveResults() const;
+};
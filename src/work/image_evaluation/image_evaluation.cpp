@@ -16,9 +16,7 @@
  */
 
 #include <regex>
-#include <marl/defer.h>
-#include <marl/event.h>
-#include <marl/waitgroup.h>
+#include <thread>
 #include "image_evaluation.h"
 #include "core/display_mgr.h"
 #include "stream/fstream.h"
@@ -28,6 +26,8 @@
 #include "sampler/random.h"
 #include "core/parse_args.h"
 #include "core/log.h"
+#include "core/live_stats.h"
+#include "core/profile.h"
 
 SORT_STATS_DEFINE_COUNTER(sPreprocessingTimeMS)
 SORT_STATS_DEFINE_COUNTER(sRenderingTimeMS)
@@ -42,9 +42,18 @@ SORT_STATS_COUNTER("Performance", "Worker thread number", sThreadCnt);
 
 static constexpr unsigned int GLOBAL_CONFIGURATION_VERSION = 0;
 static constexpr unsigned int IMAGE_TILE_SIZE = 64;
-
-void thread_shut_down(int id) {
-    SortStatsFlushData();
+// The rest of a tile is only split if it has at least this number of rows for each half.
+static constexpr int TILE_SPLIT_MIN_ROWS = 4;
+// The rest of a tile is only split if it is estimated to take longer than this, in micro second.
+static constexpr unsigned long long TILE_SPLIT_MIN_TIME = 20000;
+
+// Number of rays traced so far by the current thread, rays are only counted with stats collection.
+SORT_STATIC_FORCEINLINE StatsInt currentRayCount() {
+#ifdef SORT_ENABLE_STATS_COLLECTION
+    return sRayCount;
+#else
+    return 0;
+#endif
 }
 
 void ImageEvaluation::StartRunning(int argc, char** argv) {
@@ -59,229 +68,221 @@ void ImageEvaluation::StartRunning(int argc, char** argv) {
     // create tsl thread context
     CreateTSLThreadContexts();
     
-    // load the file
-    std::unique_ptr<IStreamBase> stream_ptr = std::make_unique<IFileStream>( m_input_file );
-    auto& stream = *stream_ptr;
+    // load the file, it is read by tasks in the pipeline later
+    m_stream = std::make_unique<IFileStream>( m_input_file );
     
     // load configuration
-    loadConfig(stream);
+    loadConfig(*m_stream);
 
-    // setup job system
-    marl::Scheduler::Config cfg;
-    cfg.setWorkerThreadCount(m_thread_cnt);
-    cfg.setWorkerThreadShutdown(thread_shut_down);
+    setupPipeline();
+}
 
-    m_scheduler = std::make_unique<marl::Scheduler>(cfg);
-    m_scheduler->bind();
+void ImageEvaluation::StartRunning(ImageEvaluationSetup&& setup) {
+    m_procedural_scene = true;
+    m_thread_cnt = setup.thread_cnt ? setup.thread_cnt : std::thread::hardware_concurrency();
+    m_sample_per_pixel = setup.sample_per_pixel;
+    m_image_width = setup.image_width;
+    m_image_height = setup.image_height;
+    m_seed = setup.seed;
+    m_accelerator = setup.accelerator;
+    m_fill_scene = std::move(setup.fill_scene);
+    m_output_file = std::move(setup.image_file);
+
+    m_integrator = std::move(setup.integrator);
+    m_integrator->SetImageEvaluation(this);
+
+    setupPipeline();
+}
 
-    if (m_has_display_server) {
-        // build acceleration structure
-        marl::schedule([&]() {
-            // Try connecting the display server
-            DisplayManager::GetSingleton().SetupDisplayServer(m_display_server_ip, m_display_server_port);
-        });
-    }
+void ImageEvaluation::setupPipeline() {
+    // setup job system, the main thread will join the slave workers once the pipeline is ready
+    SchedulerConfig cfg;
+    cfg.slave_thread_cnt = m_thread_cnt;
+    // tasks like shader compilation need way more stack memory than what the scheduler offers by default
+    cfg.slave_fiber_stack_size = 1024 * 1024;
+    cfg.slave_thread_shutdown = []() { SortStatsFlushData(); };
+    cfg.numa_aware = m_numa_mode;
+
+    m_scheduler = std::make_unique<Scheduler>();
+    m_scheduler->SetupConfig(cfg);
+    m_scheduler->Bind();
 
     m_need_render_target = !m_blender_mode || m_integrator->NeedFinalUpdate();
-    if (m_need_render_target)
+    if (m_need_render_target) {
+        // tiles are spread across all NUMA nodes, so is the render target
+        NumaInterleaveScope interleave(m_numa_mode);
         m_render_target = std::make_unique<RenderTarget>(m_image_width, m_image_height);
-
-    // Load materials from stream
-    auto sc = pullContext(m_sc_holder);
-    auto& mat_pool = MatManager::GetSingleton().ParseMatFile(stream, m_no_material_mode, sc->context.get());
-    recycleContext(m_sc_holder, sc);
-
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-    marl::WaitGroup build_mat_wait_group((unsigned)mat_pool.size());
-    for (auto& mat : mat_pool) {
-        marl::schedule([&](MaterialBase* mat) {
-            defer(build_mat_wait_group.done());
-
-            auto sc = pullContext(m_sc_holder);
-            mat->BuildMaterial(sc->context.get());
-            recycleContext(m_sc_holder, sc);
-        }, mat.get());
     }
-#endif
 
-    // Serialize the scene entities
-    m_scene.LoadScene(stream);
-
-    // display the image first
-    if (m_has_display_server) {
-        std::shared_ptr<DisplayImageInfo> image_info = std::make_shared<DisplayImageInfo>(m_image_title, m_image_width, m_image_height, m_blender_mode);
-        DisplayManager::GetSingleton().QueueDisplayItem(image_info);
-    }
+    if (m_tile_heatmap)
+        m_tile_cost_target = std::make_unique<RenderTarget>(m_image_width, m_image_height);
 
     SORT_STATS(sSamplePerPixel = m_sample_per_pixel);
     SORT_STATS(sThreadCnt = m_thread_cnt);
 
-    // Create a WaitGroup with an initial count of numTasks.
-    marl::WaitGroup accel_structure_done(1);
-    marl::WaitGroup pre_processing_done(1);
+    // get the number of total task
+    const auto tilesize = IMAGE_TILE_SIZE;
+    const auto tile_num = Vector2i((int)ceil(m_image_width / (float)tilesize), (int)ceil(m_image_height / (float)tilesize));
+    m_tiles_done.Add(tile_num.x * tile_num.y);
+    m_tiles_pending = tile_num.x * tile_num.y;
+
+    // The whole process of generating the image is expressed as a graph of tasks. Steps that don't depend on each
+    // other, like shader compilation and acceleration structure construction, overlap automatically.
+    const auto load_scene = m_pipeline.AddTask([this]() {
+        // The memory policy belongs to the thread, it is only changed around steps that never yield. Populating the
+        // scene waits for tasks building lights, other tasks picked up by this thread meanwhile would be affected.
+        if (m_procedural_scene) {
+            {
+                // meshes are read by threads on all NUMA nodes during rendering
+                NumaInterleaveScope interleave(m_numa_mode);
+                m_fill_scene(m_scene);
+            }
+
+            const auto valid_accel = m_scene.SetupScene(m_accelerator);
+            sAssertMsg(valid_accel, SPATIAL_ACCELERATOR, "Acceleration structure is not supported.");
+            return;
+        }
 
-    // build acceleration structure
-    marl::schedule([&]() {
-        // Decrement the WaitGroup counter when the task has finished.
-        defer(accel_structure_done.done());
+        // Serialize the scene entities
+        m_scene.LoadScene(*m_stream, !m_keep_accelerator, m_numa_mode);
 
+        // nothing else is read from the stream
+        m_stream = nullptr;
+    }, "Load Scene");
+
+    const auto build_accel = m_pipeline.AddTask([this]() {
         // update preprocessing time
         SORT_STATS(TIMING_EVENT_STAT("", sPreprocessingTimeMS));
 
+        // Instead of replicating the acceleration structure on each NUMA node, its memory is interleaved across nodes.
+        // Building it never yields, so the memory policy doesn't leak to other tasks.
+        NumaInterleaveScope interleave(m_numa_mode);
+
         // Build acceleration structures, commonly QBVH
+        Timer timer;
         m_scene.BuildAccelerationStructure();
-    });
+        m_accel_time = timer.GetElapsedTime();
+    }, "Build Acceleration Structure");
 
     // pre-processing for integrators, like instant radiosity
-    marl::schedule([&]() {
-        // Decrement the WaitGroup counter when the task has finished.
-        defer(pre_processing_done.done());
-
-        // this has to be after the two acceleration structures construction to be done.
-        accel_structure_done.wait();
-
+    const auto pre_process = m_pipeline.AddTask([this]() {
         // get a render context
         auto pRc = pullContext(m_rc_holder);
+        if (m_procedural_scene)
+            pRc->m_random_num_generator->Seed(m_seed);
 
         // preprocessing for integrators
         m_integrator->PreProcess(m_scene, *pRc);
 
         // recycle the render context
         recycleContext(m_rc_holder, pRc);
-    });
+    }, "Pre-Processing");
 
-    // get the number of total task
-    const auto tilesize = IMAGE_TILE_SIZE;
-    Vector2i tile_num = Vector2i((int)ceil(m_image_width / (float)tilesize), (int)ceil(m_image_height / (float)tilesize));
+    const auto render = m_pipeline.AddTask([this, tile_num]() {
+        // display the image first
+        if (m_has_display_server) {
+            std::shared_ptr<DisplayImageInfo> image_info = std::make_shared<DisplayImageInfo>(m_image_title, m_image_width, m_image_height, m_blender_mode);
+            DisplayManager::GetSingleton().QueueDisplayItem(image_info);
+        }
 
-    // start tile from center instead of top-left corner
-    Vector2i cur_pos(tile_num / 2);
-    int cur_dir = 0;
-    int cur_len = 0;
-    int cur_dir_len = 1;
-    const Vector2i dir[4] = { Vector2i(0 , -1) , Vector2i(-1 , 0) , Vector2i(0 , 1) , Vector2i(1 , 0) };
+        m_timer.Reset();
 
-    // make sure preprocessing is done
-    pre_processing_done.wait();
+        // Neighbouring tiles share a lot of data, like geometry and textures. In NUMA mode, the image is split into
+        // horizontal bands, each of which is rendered by slave workers on one node.
+        const auto node_cnt = m_scheduler->GetActiveNumaNodeCount();
 
-#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
-    // make sure all materials are built already
-    build_mat_wait_group.wait();
-#endif
+        // start tile from center instead of top-left corner
+        Vector2i cur_pos(tile_num / 2);
+        int cur_dir = 0;
+        int cur_len = 0;
+        int cur_dir_len = 1;
+        const Vector2i dir[4] = { Vector2i(0 , -1) , Vector2i(-1 , 0) , Vector2i(0 , 1) , Vector2i(1 , 0) };
 
-    m_timer.Reset();
-
-    // at this point, we are starting to render stuff
-    while (true) {
-        // only process node inside the image region
-        if (cur_pos.x >= 0 && cur_pos.x < tile_num.x && cur_pos.y >= 0 && cur_pos.y < tile_num.y) {
-            Vector2i tl(cur_pos.x * tilesize, cur_pos.y * tilesize);
-            Vector2i size((tilesize < (m_image_width - tl.x)) ? tilesize : (m_image_width - tl.x),
-                (tilesize < (m_image_height - tl.y)) ? tilesize : (m_image_height - tl.y));
-
-            // pre-processing for integrators, like instant radiosity
-            ++m_tile_cnt;
-            marl::schedule([this](const Vector2i& ori, const Vector2i& size) {
-                // get a render context
-                auto pRc = pullContext(m_rc_holder);
-                auto& rc = *pRc;
-
-                // get camera
-                auto camera = m_scene.GetCamera();
-
-                auto sampler = std::make_unique<RandomSampler>();
-                auto pixelSamples = std::make_unique<PixelSample[]>(m_sample_per_pixel);
-
-                // request samples
-                m_integrator->RequestSample(sampler.get(), pixelSamples.get(), m_sample_per_pixel);
-
-                const bool need_refresh_tile = m_integrator->NeedRefreshTile();
-                const auto total_pixel = size.x * size.y;
-                std::shared_ptr<DisplayTile> display_tile;
-                if (m_has_display_server && need_refresh_tile) {
-                    // indicate that we are rendering this tile
-                    std::shared_ptr<IndicationTile> indicate_tile = std::make_shared<IndicationTile>(m_image_title, ori.x, ori.y, size.x, size.y, m_blender_mode);
-                    DisplayManager::GetSingleton().QueueDisplayItem(indicate_tile);
-
-                    display_tile = std::make_shared<DisplayTile>(m_image_title, ori.x, ori.y, size.x, size.y, m_blender_mode);
-                }
+        // at this point, we are starting to render stuff
+        while (true) {
+            // only process node inside the image region
+            if (cur_pos.x >= 0 && cur_pos.x < tile_num.x && cur_pos.y >= 0 && cur_pos.y < tile_num.y) {
+                Vector2i tl(cur_pos.x * IMAGE_TILE_SIZE, cur_pos.y * IMAGE_TILE_SIZE);
+                Vector2i size((IMAGE_TILE_SIZE < (m_image_width - tl.x)) ? IMAGE_TILE_SIZE : (m_image_width - tl.x),
+                    (IMAGE_TILE_SIZE < (m_image_height - tl.y)) ? IMAGE_TILE_SIZE : (m_image_height - tl.y));
 
-                Vector2i rb = ori + size;
-                for (int i = ori.y; i < rb.y; i++) {
-                    for (int j = ori.x; j < rb.x; j++) {
-                        // reset the memory allocator so that the last sample could reuse memory
-                        // otherwise, memory usage is linear to spp.
-                        rc.Reset();
-
-                        // generate samples to be used later
-                        m_integrator->GenerateSample(sampler.get(), pixelSamples.get(), m_sample_per_pixel, m_scene, rc);
-
-                        // the radiance
-                        Spectrum radiance;
-
-                        auto valid_pixel_cnt = m_sample_per_pixel;
-                        for (unsigned k = 0; k < m_sample_per_pixel; ++k) {
-
-                            // generate rays
-                            auto r = camera->GenerateRay((float)j, (float)i, pixelSamples[k]);
-                            // accumulate the radiance
-                            auto li = m_integrator->Li(r, pixelSamples[k], m_scene, rc);
-                            if (m_clampping > 0.0f)
-                                li = li.Clamp(0.0f, m_clampping);
-
-                            sAssert(li.IsValid(), GENERAL);
-
-                            if (li.IsValid())
-                                radiance += li;
-                            else
-                                --valid_pixel_cnt;
-                        }
-
-                        if (valid_pixel_cnt > 0)
-                            radiance /= (float)valid_pixel_cnt;
-
-                        if (m_need_render_target)
-                            UpdateImage(Vector2i(j,i), radiance);
-
-                        // update the value if display server is connected
-                        if (m_has_display_server && need_refresh_tile) {
-                            auto local_i = i - ori.y;
-                            auto local_j = j - ori.x;
-                            display_tile->UpdatePixel(local_j, local_i, radiance);
-                        }
-                    }
-                }
+                const auto node = (unsigned)cur_pos.y * node_cnt / (unsigned)tile_num.y;
+                schedule_on_node(node, [this](const Vector2i& ori, const Vector2i& size) {
+                    --m_tiles_pending;
 
-                // update display server if needed
-                if (m_has_display_server && need_refresh_tile)
-                    DisplayManager::GetSingleton().QueueDisplayItem(display_tile);
+                    renderTile(ori, size);
 
-                // we are done with this tile
-                --m_tile_cnt;
+                    // we are done with this tile
+                    m_tiles_done.Done();
+                }, tl, size);
+            }
 
-                // we are done with the render context, recycle it
-                recycleContext(m_rc_holder, pRc);
-            }, tl, size);
-        }
+            // turn to the next direction
+            if (cur_len >= cur_dir_len) {
+                cur_dir = (cur_dir + 1) % 4;
+                cur_len = 0;
+                cur_dir_len += 1 - cur_dir % 2;
+            }
 
-        // turn to the next direction
-        if (cur_len >= cur_dir_len) {
-            cur_dir = (cur_dir + 1) % 4;
-            cur_len = 0;
-            cur_dir_len += 1 - cur_dir % 2;
+            cur_pos += dir[cur_dir];
+            ++cur_len;
+
+            if ((cur_pos.x < 0 || cur_pos.x >= tile_num.x) && (cur_pos.y < 0 || cur_pos.y >= tile_num.y))
+                break;
         }
+    }, "Render Tiles");
+
+    m_pipeline.Precede(load_scene, build_accel);
+    m_pipeline.Precede(build_accel, pre_process);
+    m_pipeline.Precede(pre_process, render);
+
+    // procedural scenes only use the default material
+    if (!m_procedural_scene) {
+        const auto load_materials = m_pipeline.AddTask([this]() {
+            // Load materials from stream
+            auto sc = pullContext(m_sc_holder);
+            m_materials = &MatManager::GetSingleton().ParseMatFile(*m_stream, m_no_material_mode, sc->context.get());
+            recycleContext(m_sc_holder, sc);
+        }, "Load Materials");
+
+        m_pipeline.Precede(load_materials, load_scene);
+
+#ifdef ENABLE_MULTI_THREAD_SHADER_COMPILATION
+        const auto build_materials = m_pipeline.AddTask([this]() {
+            WaitGroup build_mat_done((unsigned)m_materials->size());
+            for (auto& mat : *m_materials) {
+                schedule_parallel([&](MaterialBase* mat) {
+                    auto sc = pullContext(m_sc_holder);
+                    mat->BuildMaterial(sc->context.get());
+                    recycleContext(m_sc_holder, sc);
+
+                    build_mat_done.Done();
+                }, mat.get());
+            }
+            build_mat_done.Wait();
+        }, "Build Materials");
+
+        // integrators may evaluate materials during pre-processing already
+        m_pipeline.Precede(load_materials, build_materials);
+        m_pipeline.Precede(build_materials, pre_process);
+#endif
+    }
 
-        cur_pos += dir[cur_dir];
-        ++cur_len;
+    if (m_has_display_server) {
+        const auto connect_display = m_pipeline.AddTask([this]() {
+            // Try connecting the display server
+            DisplayManager::GetSingleton().SetupDisplayServer(m_display_server_ip, m_display_server_port);
+        }, "Connect Display Server");
 
-        if ((cur_pos.x < 0 || cur_pos.x >= tile_num.x) && (cur_pos.y < 0 || cur_pos.y >= tile_num.y))
-            break;
+        m_pipeline.Precede(connect_display, render);
     }
+
+    m_pipeline.Run();
 }
 
-int ImageEvaluation::WaitForWorkToBeDone() {
+void ImageEvaluation::refreshDisplay() {
     Timer timer;
-    while (m_tile_cnt > 0) {
+    while (!m_tiles_done.IsDone()) {
         if (DisplayManager::GetSingleton().IsDisplayServerConnected()) {
             if (UNLIKELY(m_integrator->NeedFullTargetRealtimeUpdate())) {
                 if (timer.GetElapsedTime() > 1000) {
@@ -295,24 +296,224 @@ int ImageEvaluation::WaitForWorkToBeDone() {
         }
         std::this_thread::yield();
     }
+}
+
+void ImageEvaluation::renderTile(const Vector2i& ori, const Vector2i& size) {
+    SORT_PROFILE("Render Tile");
+
+    // rendering a tile never yields, all rays of the tile are traced on this thread
+    Timer tile_timer;
+    const auto ray_cnt = currentRayCount();
+
+    // get a render context
+    auto pRc = pullContext(m_rc_holder);
+    auto& rc = *pRc;
+
+    // The random numbers of a tile only depend on the seed and where the tile is, which thread renders it doesn't matter.
+    if (m_procedural_scene)
+        rc.m_random_num_generator->Seed(m_seed ^ ((unsigned)ori.x * 73856093u) ^ ((unsigned)ori.y * 19349663u));
+
+    // get camera
+    auto camera = m_scene.GetCamera();
+
+    auto sampler = std::make_unique<RandomSampler>();
+    auto pixelSamples = std::make_unique<PixelSample[]>(m_sample_per_pixel);
+
+    // request samples
+    m_integrator->RequestSample(sampler.get(), pixelSamples.get(), m_sample_per_pixel);
+
+    const bool need_refresh_tile = m_has_display_server && m_integrator->NeedRefreshTile();
+
+    // The size of the tile may shrink during rendering, the display tile is only created once the tile is done.
+    std::unique_ptr<RGBSpectrum[]> tile_radiance;
+    if (need_refresh_tile) {
+        // indicate that we are rendering this tile
+        std::shared_ptr<IndicationTile> indicate_tile = std::make_shared<IndicationTile>(m_image_title, ori.x, ori.y, size.x, size.y, m_blender_mode);
+        DisplayManager::GetSingleton().QueueDisplayItem(indicate_tile);
+
+        tile_radiance = std::make_unique<RGBSpectrum[]>(size.x * size.y);
+    }
+
+    Vector2i rb = ori + size;
+    for (int i = ori.y; i < rb.y; i++) {
+        // Once all tiles are picked up, some workers will run out of work soon while others are still busy with
+        // expensive tiles. To cut the tail, the rest of an expensive tile is split in half and the lower half is
+        // pushed to the queue of this worker so that idle workers can steal it. The remaining rows may be split
+        // again later if they are still expensive.
+        if (m_adaptive_tiles && i > ori.y && m_tiles_pending.load(std::memory_order_relaxed) == 0) {
+            const auto rows_left = rb.y - i;
+            const auto time_left = tile_timer.GetElapsedTimeInMicroSecond() * rows_left / (i - ori.y);
+            if (rows_left >= 2 * TILE_SPLIT_MIN_ROWS && time_left > TILE_SPLIT_MIN_TIME) {
+                const auto split = i + rows_left / 2;
+
+                // the sub-tile needs to be accounted before it is scheduled
+                m_tiles_done.Add(1);
+                ++m_tiles_split;
+
+                schedule_parallel([this](const Vector2i& sub_ori, const Vector2i& sub_size) {
+                    renderTile(sub_ori, sub_size);
+                    m_tiles_done.Done();
+                }, Vector2i(ori.x, split), Vector2i(size.x, rb.y - split));
+
+                rb.y = split;
+            }
+        }
+
+        for (int j = ori.x; j < rb.x; j++) {
+            // reset the memory allocator so that the last sample could reuse memory
+            // otherwise, memory usage is linear to spp.
+            rc.Reset();
+
+            // generate samples to be used later
+            m_integrator->GenerateSample(sampler.get(), pixelSamples.get(), m_sample_per_pixel, m_scene, rc);
+
+            // the radiance, it is always accumulated in RGB even if paths carry wavelengths
+            RGBSpectrum radiance;
+
+            auto valid_pixel_cnt = m_sample_per_pixel;
+            for (unsigned k = 0; k < m_sample_per_pixel; ++k) {
+                SORT_LIVE_STATS(Path, 1);
+
+#ifdef SORT_SPECTRAL_RENDERING
+                // each camera sample carries its own wavelengths, all spectra upsampled from RGB values
+                // along the path are based on them
+                SampledWavelengths::SetCurrent(SampledWavelengths::Sample(sort_rand<float>(rc)));
+#endif
+
+                // generate rays
+                auto r = camera->GenerateRay((float)j, (float)i, pixelSamples[k]);
+                // accumulate the radiance
+                auto li = m_integrator->Li(r, pixelSamples[k], m_scene, rc);
+                if (m_clampping > 0.0f)
+                    li = li.Clamp(0.0f, m_clampping);
+
+                sAssert(li.IsValid(), GENERAL);
+
+                if (li.IsValid())
+                    radiance += ToRGBSpectrum(li);
+                else
+                    --valid_pixel_cnt;
+            }
+
+            if (valid_pixel_cnt > 0)
+                radiance /= (float)valid_pixel_cnt;
+
+            if (m_need_render_target)
+                UpdateImage(Vector2i(j,i), radiance);
+
+            // update the value if display server is connected
+            if (need_refresh_tile)
+                tile_radiance[(i - ori.y) * size.x + j - ori.x] = radiance;
+        }
+    }
+
+    const auto rendered_size = rb - ori;
+
+    // update display server if needed
+    if (need_refresh_tile) {
+        std::shared_ptr<DisplayTile> display_tile = std::make_shared<DisplayTile>(m_image_title, ori.x, ori.y, rendered_size.x, rendered_size.y, m_blender_mode);
+        for (int i = 0; i < rendered_size.y; ++i)
+            for (int j = 0; j < rendered_size.x; ++j)
+                display_tile->UpdatePixel(j, i, tile_radiance[i * size.x + j]);
+        DisplayManager::GetSingleton().QueueDisplayItem(display_tile);
+    }
+
+    // we are done with the render context, recycle it
+    recycleContext(m_rc_holder, pRc);
+
+    TileCost cost;
+    cost.ori = ori;
+    cost.size = rendered_size;
+    cost.time = tile_timer.GetElapsedTimeInMicroSecond();
+    cost.ray_cnt = currentRayCount() - ray_cnt;
+    recordTileCost(cost);
+}
+
+void ImageEvaluation::recordTileCost(const TileCost& cost) {
+    // Each pixel in the heatmap has the time spent on it in micro second in red channel and the number of rays
+    // traced for it in green channel, both are averaged across the tile.
+    if (m_tile_cost_target) {
+        const auto pixel_cnt = (float)(cost.size.x * cost.size.y);
+        const auto value = RGBSpectrum(cost.time / pixel_cnt, cost.ray_cnt / pixel_cnt, 0.0f);
+        for (int i = cost.ori.y; i < cost.ori.y + cost.size.y; ++i)
+            for (int j = cost.ori.x; j < cost.ori.x + cost.size.x; ++j)
+                m_tile_cost_target->SetColor(j, i, value);
+    }
+
+    std::lock_guard<std::mutex> guard(m_tile_cost_lock);
+    m_tile_costs.push_back(cost);
+}
+
+void ImageEvaluation::reportTileCosts(const std::string& image_name) {
+    if (m_tile_costs.empty())
+        return;
+
+    unsigned long long total_time = 0;
+    StatsInt total_ray_cnt = 0;
+    const TileCost* most_expensive = &m_tile_costs[0];
+    for (const auto& cost : m_tile_costs) {
+        total_time += cost.time;
+        total_ray_cnt += cost.ray_cnt;
+        if (cost.time > most_expensive->time)
+            most_expensive = &cost;
+    }
+
+    const auto tile_cnt = (unsigned)m_tile_costs.size();
+    slog(INFO, GENERAL, "%d tiles are rendered, %d of them are split from expensive tiles.", tile_cnt, m_tiles_split.load());
+    slog(INFO, GENERAL, "Average cost of tiles is %.2f (ms), %lld rays per tile.", total_time / 1000.0f / tile_cnt, total_ray_cnt / tile_cnt);
+    slog(INFO, GENERAL, "The most expensive tile at (%d, %d) costs %.2f (ms) with %lld rays.", most_expensive->ori.x, most_expensive->ori.y,
+         most_expensive->time / 1000.0f, most_expensive->ray_cnt);
+
+    if (m_tile_cost_target) {
+        m_tile_cost_target->Output(image_name);
+        slog(INFO, GENERAL, "Tile cost heatmap is saved in %s.", image_name.c_str());
+    }
+}
+
+int ImageEvaluation::WaitForWorkToBeDone() {
+    // The display is refreshed on a dedicated thread, which is not a slave worker so that it never picks up tiles
+    // and the display keeps being refreshed while tiles are being rendered.
+    std::thread refresh_display;
+    if (m_has_display_server)
+        refresh_display = std::thread([this]() { refreshDisplay(); });
+
+    // the main thread becomes one of the slave workers, it only returns after all tasks in the pipeline are done
+    m_scheduler->Begin();
+    m_scheduler->Stop();
+
+    if (refresh_display.joinable())
+        refresh_display.join();
+
+    m_rendering_time = m_timer.GetElapsedTime();
 
     if (m_has_display_server && UNLIKELY(m_integrator->NeedFinalUpdate())) {
         std::shared_ptr<FullTargetUpdate> di = std::make_shared<FullTargetUpdate>(m_image_title, m_render_target.get(), m_blender_mode);
         DisplayManager::GetSingleton().QueueDisplayItem(di);
     }
 
-    if (!m_blender_mode)
-        m_render_target->Output("sort_" + logTimeStringStripped() + ".exr");
+    const auto image_name = "sort_" + logTimeStringStripped();
+    if (m_procedural_scene) {
+        if (!m_output_file.empty())
+            m_render_target->Output(m_output_file);
+    } else if (!m_blender_mode) {
+        m_render_target->Output(image_name + ".exr");
+    }
+
+    reportTileCosts(image_name + "_tilecost.exr");
 
     // make sure flush all display items before quiting
     DisplayManager::GetSingleton().ProcessDisplayQueue(-1);
 
     DestroyTSLThreadContexts();
 
-    m_scheduler->unbind();
+    m_scheduler->Unbind();
     m_scheduler = nullptr;
 
-    SORT_STATS(sRenderingTimeMS = m_timer.GetElapsedTime());
+    SORT_STATS(sRenderingTimeMS = m_rendering_time);
+
+    // there is neither display server nor socket system for procedural scenes
+    if (m_procedural_scene)
+        return 0;
 
     // Close the display server to make sure TEV/Blender receives all data
     DisplayManager::GetSingleton().DisconnectDisplayServer();
@@ -323,6 +524,13 @@ int ImageEvaluation::WaitForWorkToBeDone() {
     return 0;
 }
 
+StatsInt ImageEvaluation::GetRayCount() const {
+    StatsInt ray_cnt = 0;
+    for (const auto& cost : m_tile_costs)
+        ray_cnt += cost.ray_cnt;
+    return ray_cnt;
+}
+
 void ImageEvaluation::parseCommandArgs(int argc, char** argv){
     // Parse command line arguments.
     const auto& args = parse_args(argc, argv, true);
@@ -337,6 +545,14 @@ void ImageEvaluation::parseCommandArgs(int argc, char** argv){
             m_blender_mode = true;
         }else if (key_str == "profiling"){
             m_enable_profiling = value_str == "on";
+        }else if (key_str == "numa"){
+            m_numa_mode = true;
+        }else if (key_str == "tileheatmap"){
+            m_tile_heatmap = true;
+        }else if (key_str == "adaptivetiles"){
+            m_adaptive_tiles = true;
+        }else if (key_str == "keepaccelerator"){
+            m_keep_accelerator = true;
         }else if (key_str == "nomaterial" ){
             m_no_material_mode = true;
         }else if (key_str == "displayserver") {
@@ -375,9 +591,11 @@ void ImageEvaluation::loadConfig(IStreamBase& stream) {
     }
 
     slog(INFO, GENERAL, "There will be %d threads rendering at the same time.", m_thread_cnt);
+    if (m_numa_mode)
+        slog(INFO, GENERAL, "NUMA mode is enabled, there are %d NUMA nodes.", GetNumaNodeCount());
 }
 
-void ImageEvaluation::UpdateImage(const Vector2i& coord, const Spectrum& value) {
+void ImageEvaluation::UpdateImage(const Vector2i& coord, const RGBSpectrum& value) {
     if (m_integrator->NeedImageLock()) {
         std::lock_guard<std::mutex> guard(m_image_lock);
         const auto total = value + m_render_target->GetColor(coord.x, coord.y);
@@ -18,12 +18,27 @@
 #pragma once
 
 #include <atomic>
-#include <marl/scheduler.h>
+#include <functional>
 #include "work/work.h"
+#include "job/scheduler.h"
+#include "job/task_graph.h"
 #include "core/timer.h"
 #include "integrator/integrator.h"
 #include "texture/rendertarget.h"
 
+//! @brief  Setup of rendering a scene generated in code instead of loading it from a stream.
+struct ImageEvaluationSetup {
+    unsigned                        thread_cnt = 0;         /**< Number of threads rendering, all hardware threads are used if it is zero. */
+    unsigned                        sample_per_pixel = 16;  /**< Sample per pixel to be evaluated. */
+    unsigned                        image_width = 0;        /**< Width of the image, it needs to match the camera. */
+    unsigned                        image_height = 0;       /**< Height of the image, it needs to match the camera. */
+    unsigned                        seed = 0;               /**< Seed of random numbers, the image is reproducible with the same seed. */
+    std::unique_ptr<Integrator>     integrator;             /**< The algorithm used for ray tracing. */
+    StringID                        accelerator;            /**< Type of the spatial acceleration structure. */
+    std::function<void(Scene&)>     fill_scene;             /**< Adding entities to the scene, it is executed in a task. */
+    std::string                     image_file;             /**< File to save the image to, the image is not saved if it is empty. */
+};
+
 //! @brief  Generating an image using ray tracing algorithms.
 /**
  * This class has all the image generation specific logic inside, including parsing streamed input,
@@ -39,12 +54,19 @@ public:
     //! @param stream       The stream as input.
     void    StartRunning(int argc, char** argv) override;
 
+    //! @brief  Start rendering a scene generated in code.
+    //!
+    //! Unlike rendering a scene from a stream, there is no material, display server or command line argument
+    //! involved. Each tile has its random numbers seeded by its position so that the image only depends on the
+    //! setup, no matter which thread renders which tile.
+    //!
+    //! @param  setup       Setup of the rendering.
+    void    StartRunning(ImageEvaluationSetup&& setup);
+
     //! @brief  Wait for the work evaluation to be done.
     //!
-    //! Ideally, if the task system supports it, it should take over the ownership of the main thread 
-    //! and converting it to a worker fiber. So that the rest of the system has no concept of main thread
-    //! at all. However, this doesn't seem to be supported in marl. I will have to workaround it to turn
-    //! the main thread into some sort of 'background' thread that gains lower priority.
+    //! The main thread is converted to a slave worker of the job system, so that the rest of the system has no
+    //! concept of main thread at all.
     //! This function will work synchronizely and once it returns the control back, the whole work is considered
     //! done.
     int     WaitForWorkToBeDone() override;
@@ -52,7 +74,19 @@ public:
     //! @bried  Update image
     //!
     //! This is only for bidirectional path tracing and light tracing.
-    void    UpdateImage(const Vector2i& coord, const Spectrum& value);
+    void    UpdateImage(const Vector2i& coord, const RGBSpectrum& value);
+
+    //! @brief  Get the generated image, it is only valid after the work is done.
+    const RenderTarget* GetRenderTarget() const { return m_render_target.get(); }
+
+    //! @brief  Time spent on rendering tiles, in milli-second.
+    unsigned            GetRenderingTime() const { return m_rendering_time; }
+
+    //! @brief  Time spent on constructing the spatial acceleration structure, in milli-second.
+    unsigned            GetAccelerationStructureTime() const { return m_accel_time; }
+
+    //! @brief  Total number of rays traced for all tiles, it is only available with stats collection.
+    StatsInt            GetRayCount() const;
 
 private:
     // Input file name
@@ -65,8 +99,26 @@ private:
     bool            m_enable_profiling = false;
     // No material mode
     bool            m_no_material_mode = false;
+    // NUMA mode, pin threads to NUMA nodes and keep memory close to the threads accessing it
+    bool            m_numa_mode = false;
     // whether we need a render target
     bool            m_need_render_target = false;
+    // Output per tile rendering cost as an extra image
+    bool            m_tile_heatmap = false;
+    // Split expensive tiles into smaller ones on the fly once there is no more tile left to be picked up
+    bool            m_adaptive_tiles = false;
+    // Keep the fast BVH the scene asks for instead of upgrading it to the widest one the CPU supports
+    bool            m_keep_accelerator = false;
+    // Whether the scene is generated in code instead of being loaded from the input file
+    bool            m_procedural_scene = false;
+    // Random numbers of each tile are seeded from this, it is only used for procedural scenes
+    unsigned        m_seed = 0;
+    // Type of the acceleration structure, it is only used for procedural scenes
+    StringID        m_accelerator;
+    // Filling the procedural scene
+    std::function<void(Scene&)> m_fill_scene;
+    // File to save the image to
+    std::string     m_output_file;
 
     std::string     m_resource_path;            // resource path
     std::string     m_display_server_ip;        // display server ip
@@ -79,12 +131,36 @@ private:
     float           m_clampping = 0.0f;         // radiance can't go higher than this, this is the cheapest way to do firefly reduction.
 
     std::unique_ptr<Integrator>         m_integrator;       // the algorithm used for ray tracing
-    std::atomic<int>                    m_tile_cnt;         // number of total tiles
+    WaitGroup                           m_tiles_done;       // tiles that are not done yet
     std::unique_ptr<RenderTarget>       m_render_target;    // a temporary buffer for saving out the result
-    std::unique_ptr<marl::Scheduler>    m_scheduler;        // job system scheduler
+    std::unique_ptr<Scheduler>          m_scheduler;        // job system scheduler
+    TaskGraph                           m_pipeline;         // all steps from loading the scene to rendering tiles
+    std::unique_ptr<IStreamBase>        m_stream;           // input stream, it is only alive until the scene is loaded
+    std::vector<std::unique_ptr<MaterialBase>>* m_materials = nullptr;  // materials loaded from the stream
     std::mutex                          m_image_lock;       // image lock, ideally we should have a lock for each pixel
     Timer                               m_timer;            // timer to evaluate the rendering time.
+    unsigned                            m_rendering_time = 0;   // time spent on rendering tiles, in milli-second.
+    unsigned                            m_accel_time = 0;   // time spent on constructing acceleration structure, in milli-second.
+
+    //! @brief  Cost of rendering a tile, sub-tiles split from a tile have their own records.
+    struct TileCost {
+        Vector2i            ori;            /**< Top left corner of the tile. */
+        Vector2i            size;           /**< Size of the tile. */
+        unsigned long long  time = 0;       /**< Time spent on rendering the tile in micro second. */
+        StatsInt            ray_cnt = 0;    /**< Number of rays traced for the tile, it is only available with stats collection. */
+    };
+
+    std::atomic<int>                    m_tiles_pending{0}; // tiles that are not picked up by any worker yet
+    std::atomic<int>                    m_tiles_split{0};   // number of times a tile is split during rendering
+    std::unique_ptr<RenderTarget>       m_tile_cost_target; // per pixel cost of the tile it belongs to
+    std::vector<TileCost>               m_tile_costs;       // cost of all rendered tiles
+    std::mutex                          m_tile_cost_lock;   // lock for updating tile costs
 
     void    parseCommandArgs(int argc, char** argv);
     void    loadConfig(IStreamBase& stream);
+    void    setupPipeline();
+    void    refreshDisplay();
+    void    renderTile(const Vector2i& ori, const Vector2i& size);
+    void    recordTileCost(const TileCost& cost);
+    void    reportTileCosts(const std::string& image_name);
 };
\ No newline at end of file
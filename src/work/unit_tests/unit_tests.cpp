@@ -17,11 +17,25 @@
 
 #include "thirdparty/gtest/gtest.h"
 #include "unit_tests.h"
+#include "simd/simd_dispatch.h"
 
 void UnitTests::StartRunning(int argc, char** argv) {
     // we don't care the about the stream anymore, which is probably not even valid depending on how we get here
     // simply run all unit tests and see what happens.
     ::testing::InitGoogleTest(&argc, argv);
+
+    // SIMD tests of all widths are compiled with runtime dispatch, skip the ones the CPU can't run.
+    std::string filter = ::testing::GTEST_FLAG(filter);
+    const auto skip = [&](const char* tests) {
+        filter += ( filter.find('-') == std::string::npos ? "-" : ":" );
+        filter += tests;
+    };
+    if (!IsSimdWidthSupported(8))
+        skip("SIMD_AVX.*");
+    if (!IsSimdWidthSupported(16))
+        skip("SIMD_AVX512.*");
+    ::testing::GTEST_FLAG(filter) = filter;
+
     m_result = RUN_ALL_TESTS();
 }
 
@@ -17,17 +17,19 @@
 
 #pragma once
 
+#include <unordered_map>
 #include "core/rtti.h"
 #include "core/scene.h"
 #include "material/tsl_system.h"
 #include "stream/stream.h"
+#include "job/numa.h"
 
 template<class Context>
 struct ContextHolder {
     std::mutex                            m_rc_mutex;                     // a mutex to make sure pool is not accessed by two threads at the same time.
     std::vector<std::unique_ptr<Context>> m_context_pool;                 // this only controls the life time of the contexts
-    std::list<Context*>                   m_available_context;            // the render context that are available
-    std::unordered_set<Context*>          m_running_context;              // the render context that are being ran
+    std::vector<std::list<Context*>>      m_available_context;            // the render context that are available on each NUMA node
+    std::unordered_map<Context*,unsigned> m_running_context;              // the render context that are being ran and the NUMA node they belong to
 };
 
 //! @brief  Work to be evaluated.
@@ -55,8 +57,7 @@ public:
     //!
     //! Ideally, if the task system supports it, it should take over the ownership of the main thread 
     //! and converting it to a worker fiber. So that the rest of the system has no concept of main thread
-    //! at all. However, this doesn't seem to be supported in marl. I will have to workaround it to turn
-    //! the main thread into some sort of 'background' thread that gains lower priority.
+    //! at all.
     //! This function will work synchronizely and once it returns the control back, the whole work is considered
     //! done.
     virtual int     WaitForWorkToBeDone() = 0;
@@ -72,21 +73,28 @@ protected:
         // make sure only one thread is accessing this
         std::lock_guard<std::mutex> lock(context_holder.m_rc_mutex);
 
+        // Contexts are only shared by threads on the same NUMA node. The memory of a context is allocated by the
+        // thread creating it, which keeps it on the node of the thread.
+        const auto node = GetCurrentNumaNode();
+        if (node >= context_holder.m_available_context.size())
+            context_holder.m_available_context.resize(node + 1);
+        auto& available_context = context_holder.m_available_context[node];
+
         // if we are running out of render context, just create one
-        if (context_holder.m_available_context.empty()) {
+        if (available_context.empty()) {
             // make sure it is initialized after it is born
             std::unique_ptr<Context> context = std::make_unique<Context>();
             context->Init();
 
             Context* pContext = context.get();
             context_holder.m_context_pool.push_back(std::move(context));
-            context_holder.m_available_context.push_back(pContext);
+            available_context.push_back(pContext);
         }
 
-        auto ret = context_holder.m_available_context.back();
-        context_holder.m_available_context.pop_back();
+        auto ret = available_context.back();
+        available_context.pop_back();
 
-        context_holder.m_running_context.insert(ret);
+        context_holder.m_running_context[ret] = node;
 
         // make sure this is a brand new render context before returning it
         return &(ret->Reset());
@@ -97,7 +105,9 @@ protected:
         // make sure only one thread is accessing this
         std::lock_guard<std::mutex> lock(context_holder.m_rc_mutex);
 
-        context_holder.m_running_context.erase(pContext);
-        context_holder.m_available_context.push_back(pContext);
+        auto it = context_holder.m_running_context.find(pContext);
+        const auto node = it->second;
+        context_holder.m_running_context.erase(it);
+        context_holder.m_available_context[node].push_back(pContext);
     }
 };
\ No newline at end of file